@@ -22,7 +22,6 @@
 */
 
 #include <stdio.h>
-#include <thread>
 
 #include "BandpassFilter.h"
 #include "BandpassFilterEditor.h"
@@ -31,28 +30,15 @@ void BandpassFilterSettings::createFilters (int numChannels, float sampleRate_,
 {
     sampleRate = sampleRate_;
 
-    filters.clear();
+    filter = std::make_unique<FilterType> (numChannels);
 
-    for (int n = 0; n < numChannels; ++n)
-    {
-        filters.add (new Dsp::SmoothedFilterDesign<Dsp::Butterworth::Design::BandPass // design type
-                                                   <2>, // order
-                                                   1, // number of channels (must be const)
-                                                   Dsp::DirectFormII> (1)); // realization
-    }
+    channelPointers.clearQuick();
+    channelPointers.insertMultiple (0, nullptr, numChannels);
 
     updateFilters (lowCut, highCut);
 }
 
 void BandpassFilterSettings::updateFilters (double lowCut, double highCut)
-{
-    for (int n = 0; n < filters.size(); n++)
-    {
-        setFilterParameters (lowCut, highCut, n);
-    }
-}
-
-void BandpassFilterSettings::setFilterParameters (double lowCut, double highCut, int channel)
 {
     Dsp::Params params;
     params[0] = sampleRate; // sample rate
@@ -60,33 +46,13 @@ void BandpassFilterSettings::setFilterParameters (double lowCut, double highCut,
     params[2] = (highCut + lowCut) / 2; // center frequency
     params[3] = highCut - lowCut; // bandwidth
 
-    filters[channel]->setParams (params);
-}
-
-FilterJob::FilterJob (String name, Array<Dsp::Filter*> filters_, Array<float*> channelPointers_, int numSamples_)
-    : ThreadPoolJob (name),
-      filters (filters_),
-      channelPointers (channelPointers_),
-      numSamples (numSamples_),
-      numChannels (channelPointers_.size())
-{
-}
-
-ThreadPoolJob::JobStatus FilterJob::runJob()
-{
-    for (int i = 0; i < numChannels; i++)
-    {
-        float* ptr = channelPointers[i];
-        filters[i]->process (numSamples, &ptr);
-    }
-
-    return ThreadPoolJob::jobHasFinished;
+    filter->setParams (params);
 }
 
 BandpassFilter::BandpassFilter (bool headless)
-    : GenericProcessor ("Bandpass Filter", headless)
+    : GenericProcessor ("Bandpass Filter", headless),
+      workerPool ("Bandpass Filter", jmin (4, SystemStats::getNumCpus()))
 {
-    threadPool = std::make_unique<ThreadPool> (4);
 }
 
 AudioProcessorEditor* BandpassFilter::createEditor()
@@ -168,13 +134,136 @@ void BandpassFilter::updateSettings()
 {
     settings.update (getDataStreams());
 
+    filterStreams.clearQuick();
+    int numChannels = 0;
+
     for (auto stream : getDataStreams())
     {
-        settings[stream->getStreamId()]->createFilters (
+        BandpassFilterSettings* streamSettings = settings[stream->getStreamId()];
+
+        streamSettings->createFilters (
             stream->getChannelCount(),
             stream->getSampleRate(),
             (*stream)["low_cut"],
             (*stream)["high_cut"]);
+
+        streamSettings->globalChannelIndices.clearQuick();
+
+        for (int i = 0; i < stream->getChannelCount(); i++)
+            streamSettings->globalChannelIndices.add (getGlobalChannelIndex (stream->getStreamId(), i));
+
+        filterStreams.add ({ stream, stream->getStreamId(), streamSettings, 0 });
+        numChannels += stream->getChannelCount();
+    }
+
+    // reserve enough space for any channel selection and thread count, so updatePartitions() can run in process()
+    selectedRuns.ensureStorageAllocated (numChannels);
+    filterRanges.ensureStorageAllocated (numChannels + maxThreads);
+    partitionStarts.ensureStorageAllocated (maxThreads + 1);
+
+    updatePartitions();
+}
+
+void BandpassFilter::updatePartitions()
+{
+    const int channelsPerGroup = Dsp::MultichannelCascade::getChannelsPerGroup();
+
+    // find the runs of adjacent selected channels, which can be filtered together
+    selectedRuns.clearQuick();
+
+    int numSelectedChannels = 0;
+    double totalSamples = 0;
+
+    for (int streamIndex = 0; streamIndex < filterStreams.size(); streamIndex++)
+    {
+        const DataStream* stream = filterStreams[streamIndex].stream;
+
+        for (auto localChannelIndex : *((*stream)["channels"].getArray()))
+        {
+            const int channel = (int) localChannelIndex;
+
+            if (selectedRuns.size() > 0
+                && selectedRuns.getLast().streamIndex == streamIndex
+                && selectedRuns.getLast().firstChannel + selectedRuns.getLast().numChannels == channel)
+            {
+                selectedRuns.getReference (selectedRuns.size() - 1).numChannels++;
+            }
+            else
+            {
+                selectedRuns.add ({ streamIndex, channel, 1 });
+            }
+
+            numSelectedChannels++;
+            totalSamples += stream->getSampleRate();
+        }
+    }
+
+    // split the runs into partitions with about the same number of samples each,
+    // cutting runs at multiples of the channel group size
+    const int numGroups = (numSelectedChannels + channelsPerGroup - 1) / channelsPerGroup;
+    const int numPartitions = jlimit (1, jmax (1, numGroups), workerPool.getNumThreads());
+    const double samplesPerPartition = totalSamples / numPartitions;
+
+    filterRanges.clearQuick();
+    partitionStarts.clearQuick();
+    partitionStarts.add (0);
+
+    double partitionSamples = 0;
+
+    for (auto run : selectedRuns)
+    {
+        const double sampleRate = filterStreams[run.streamIndex].stream->getSampleRate();
+
+        while (run.numChannels > 0)
+        {
+            int numChannels = run.numChannels;
+
+            if (partitionStarts.size() < numPartitions)
+            {
+                const int channelsToFill = int (std::ceil ((samplesPerPartition - partitionSamples) / sampleRate));
+                const int alignedChannels = (channelsToFill + channelsPerGroup - 1) / channelsPerGroup * channelsPerGroup;
+
+                numChannels = jlimit (1, numChannels, alignedChannels);
+            }
+
+            filterRanges.add ({ run.streamIndex, run.firstChannel, numChannels });
+
+            run.firstChannel += numChannels;
+            run.numChannels -= numChannels;
+            partitionSamples += numChannels * sampleRate;
+
+            if (partitionSamples >= samplesPerPartition && partitionStarts.size() < numPartitions)
+            {
+                partitionStarts.add (filterRanges.size());
+                partitionSamples = 0;
+            }
+        }
+    }
+
+    partitionStarts.add (filterRanges.size());
+}
+
+void BandpassFilter::filterPartition (int partition, float* const* bufferPointers)
+{
+    for (int i = partitionStarts[partition]; i < partitionStarts[partition + 1]; i++)
+    {
+        const FilterRange& range = filterRanges.getReference (i);
+        const FilterStream& filterStream = filterStreams.getReference (range.streamIndex);
+
+        if (filterStream.numSamples == 0)
+            continue;
+
+        BandpassFilterSettings* streamSettings = filterStream.settings;
+        float** channelPointers = streamSettings->channelPointers.getRawDataPointer();
+        const int* globalChannelIndices = streamSettings->globalChannelIndices.getRawDataPointer();
+
+        for (int chan = range.firstChannel; chan < range.firstChannel + range.numChannels; chan++)
+            channelPointers[chan] = bufferPointers[globalChannelIndices[chan]];
+
+        streamSettings->filter->process (int (filterStream.numSamples),
+                                         channelPointers,
+                                         range.firstChannel,
+                                         range.numChannels);
     }
 }
 
@@ -206,71 +295,39 @@ void BandpassFilter::parameterValueChanged (Parameter* param)
             (*getDataStream (currentStream))["low_cut"],
             (*getDataStream (currentStream))["high_cut"]);
     }
+    else if (param->getName().equalsIgnoreCase ("channels"))
+    {
+        partitionsNeedUpdate = true;
+    }
     else if (param->getName().equalsIgnoreCase ("threads"))
     {
-        if (threadPool->getNumJobs() > 0)
-        {
-            param->restorePreviousValue();
-            return;
-        }
+        // more threads than cores would only take turns on the same cores
+        int numThreads = jmin (param->getValueAsString().getIntValue(), SystemStats::getNumCpus());
+        workerPool.setNumThreads (numThreads);
 
-        int numThreads = param->getValueAsString().getIntValue();
-        threadPool.reset (new ThreadPool (numThreads));
+        partitionsNeedUpdate = true;
     }
 }
 
-bool BandpassFilter::stopAcquisition()
-{
-    return threadPool->removeAllJobs (true, 1000);
-}
-
 void BandpassFilter::process (AudioBuffer<float>& buffer)
 {
-    for (auto stream : getDataStreams())
-    {
-        if ((*stream)["enable_stream"])
-        {
-            BandpassFilterSettings* streamSettings = settings[stream->getStreamId()];
-
-            const uint16 streamId = stream->getStreamId();
-            const uint32 numSamples = getNumSamplesInBlock (streamId);
-
-            int i = 0;
-            Array<float*> channelPointers;
-            Array<Dsp::Filter*> filters;
-
-            for (auto localChannelIndex : *((*stream)["channels"].getArray()))
-            {
-                int globalChannelIndex = getGlobalChannelIndex (stream->getStreamId(), (int) localChannelIndex);
-
-                channelPointers.add (buffer.getWritePointer (globalChannelIndex));
-                filters.add (streamSettings->filters[localChannelIndex]);
-                i++;
+    if (partitionsNeedUpdate.exchange (false))
+        updatePartitions();
 
-                if (i % CHANNELS_PER_THREAD == 0)
-                {
-                    String jobName = String (streamId) + "_" + String (i++);
-
-                    FilterJob* job = new FilterJob (jobName, filters, channelPointers, numSamples);
-
-                    threadPool->addJob (job, true);
-
-                    channelPointers.clear();
-                    filters.clear();
-                }
-            }
-
-            if (channelPointers.size() > 0)
-            {
-                String jobName = String (streamId) + "_" + String (i++);
+    for (auto& filterStream : filterStreams)
+    {
+        if ((*filterStream.stream)["enable_stream"])
+            filterStream.numSamples = getNumSamplesInBlock (filterStream.streamId);
+        else
+            filterStream.numSamples = 0;
+    }
 
-                FilterJob* job = new FilterJob (jobName, filters, channelPointers, numSamples);
+    float* const* channelPointers = buffer.getArrayOfWritePointers();
 
-                threadPool->addJob (job, true);
-            }
-        }
-    }
+    auto filterTask = [this, channelPointers] (int partition)
+    {
+        filterPartition (partition, channelPointers);
+    };
 
-    while (threadPool->getNumJobs() > 0)
-        std::this_thread::sleep_for (std::chrono::microseconds (50));
+    workerPool.parallelFor (partitionStarts.size() - 1, filterTask);
 }
@@ -27,47 +27,36 @@
 #include <ProcessorHeaders.h>
 #include <DspLib.h>
 
-#define CHANNELS_PER_THREAD 32
+#include <atomic>
 
 /** Holds settings for one stream's filters */
 
 class BandpassFilterSettings
 {
 public:
+    /** Filters all channels of a stream in lockstep */
+    typedef Dsp::MultichannelFilterDesign<Dsp::Butterworth::Design::BandPass<2>> FilterType;
+
     /** Constructor -- sets default values*/
     BandpassFilterSettings() {}
 
     /** Holds the sample rate for this stream*/
     float sampleRate;
 
-    /** Holds the filters for one stream*/
-    OwnedArray<Dsp::Filter> filters;
-
-    /** Creates new filters when input settings change*/
-    void createFilters (int numChannels, float sampleRate, double lowCut, double highCut);
-
-    /** Updates filters when parameters change*/
-    void updateFilters (double lowCut, double highCut);
+    /** Holds the filter for this stream's channels*/
+    std::unique_ptr<FilterType> filter;
 
-    /** Sets filter parameters for one channel*/
-    void setFilterParameters (double lowCut, double highCut, int channel);
-};
+    /** Global index of each of this stream's channels*/
+    Array<int> globalChannelIndices;
 
-/** Allows multi-threaded filtering */
-class FilterJob : public ThreadPoolJob
-{
-public:
-    /** Constructor */
-    FilterJob (String name, Array<Dsp::Filter*> filters, Array<float*> channelPointer, int numSamples);
+    /** Write pointer for each of this stream's channels in the current block*/
+    Array<float*> channelPointers;
 
-    /** Runs the job inside a thread */
-    JobStatus runJob();
+    /** Creates a new filter when input settings change*/
+    void createFilters (int numChannels, float sampleRate, double lowCut, double highCut);
 
-private:
-    Array<Dsp::Filter*> filters;
-    Array<float*> channelPointers;
-    int numSamples;
-    int numChannels;
+    /** Updates the filter when parameters change*/
+    void updateFilters (double lowCut, double highCut);
 };
 
 /**
@@ -102,13 +91,52 @@ public:
     /** Called when upstream settings are changed.*/
     void updateSettings() override;
 
-    /** Stops any ongoing worker threads */
-    bool stopAcquisition() override;
-
 private:
+    /** A stream with filtered channels */
+    struct FilterStream
+    {
+        const DataStream* stream;
+        uint16 streamId;
+        BandpassFilterSettings* settings;
+        uint32 numSamples; // in the current block (0 if the stream is disabled)
+    };
+
+    /** Adjacent channels of one stream, filtered by one of the threads */
+    struct FilterRange
+    {
+        int streamIndex;
+        int firstChannel;
+        int numChannels;
+    };
+
+    /** Highest value of the "threads" parameter */
+    static constexpr int maxThreads = 64;
+
+    /** Splits the selected channels of all streams into one partition per thread,
+        with about the same number of samples in each. Does not allocate once
+        updateSettings() has been called. */
+    void updatePartitions();
+
+    /** Filters the channels in one partition */
+    void filterPartition (int partition, float* const* bufferPointers);
+
     StreamSettings<BandpassFilterSettings> settings;
 
-    std::unique_ptr<ThreadPool> threadPool;
+    WorkerPool workerPool;
+
+    Array<FilterStream> filterStreams;
+
+    /** Runs of adjacent selected channels */
+    Array<FilterRange> selectedRuns;
+
+    /** Selected channels, split into ranges that each belong to one partition */
+    Array<FilterRange> filterRanges;
+
+    /** Index of the first range of each partition in filterRanges, followed by filterRanges.size() */
+    Array<int> partitionStarts;
+
+    /** Set when the selected channels change, so that the partitions are rebuilt before the next block */
+    std::atomic<bool> partitionsNeedUpdate { false };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BandpassFilter);
 };
@@ -32,4 +32,5 @@ Should be included in the source files which declare a processor class.
 #include "../../Source/Processors/GenericProcessor/GenericProcessor.h"
 #include "../../Source/TestableExport.h"
 #include "../../Source/Utils/BroadcastParser.h"
+#include "../../Source/Utils/WorkerPool.h"
 #include "DspLib.h"
\ No newline at end of file
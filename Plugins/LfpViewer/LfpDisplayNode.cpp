@@ -302,8 +302,6 @@ void LfpDisplayNode::process (AudioBuffer<float>& buffer)
 
         const uint32 nSamples = getNumSamplesInBlock (streamId);
 
-        String streamKey = getDataStream (streamId)->getKey();
-
         displayBufferMap[streamId]->addData (buffer, chan, nSamples);
     }
 }
@@ -0,0 +1,142 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "CrossingDetector.h"
+
+namespace
+{
+typedef int (*SearchKernel) (const float*, int, float);
+
+#if DSP_KERNELS_SSE2
+
+/** Compares 8 samples per iteration */
+int findFirstBelowSSE2 (const float* samples, int numSamples, float threshold)
+{
+    const __m128 target = _mm_set1_ps (threshold);
+
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const __m128 belowA = _mm_cmplt_ps (_mm_loadu_ps (samples + i), target);
+        const __m128 belowB = _mm_cmplt_ps (_mm_loadu_ps (samples + i + 4), target);
+
+        if (_mm_movemask_ps (_mm_or_ps (belowA, belowB)) != 0)
+            return i + CrossingDetector::findFirstBelowScalar (samples + i, 8, threshold);
+    }
+
+    return i + CrossingDetector::findFirstBelowScalar (samples + i, numSamples - i, threshold);
+}
+
+/** Compares 16 samples per iteration; ordered, quiet comparisons match the scalar operator
+    for NaNs */
+DSP_KERNELS_AVX2_TARGET int findFirstBelowAVX2 (const float* samples, int numSamples, float threshold)
+{
+    const __m256 target = _mm256_set1_ps (threshold);
+
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        const __m256 belowA = _mm256_cmp_ps (_mm256_loadu_ps (samples + i), target, _CMP_LT_OQ);
+        const __m256 belowB = _mm256_cmp_ps (_mm256_loadu_ps (samples + i + 8), target, _CMP_LT_OQ);
+
+        if (_mm256_movemask_ps (_mm256_or_ps (belowA, belowB)) != 0)
+            return i + CrossingDetector::findFirstBelowScalar (samples + i, 16, threshold);
+    }
+
+    return i + CrossingDetector::findFirstBelowScalar (samples + i, numSamples - i, threshold);
+}
+
+#endif // DSP_KERNELS_SSE2
+
+#if DSP_KERNELS_NEON
+
+/** Compares 8 samples per iteration */
+int findFirstBelowNEON (const float* samples, int numSamples, float threshold)
+{
+    const float32x4_t target = vdupq_n_f32 (threshold);
+
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const uint32x4_t below = vorrq_u32 (vcltq_f32 (vld1q_f32 (samples + i), target),
+                                            vcltq_f32 (vld1q_f32 (samples + i + 4), target));
+
+        if (vmaxvq_u32 (below) != 0)
+            return i + CrossingDetector::findFirstBelowScalar (samples + i, 8, threshold);
+    }
+
+    return i + CrossingDetector::findFirstBelowScalar (samples + i, numSamples - i, threshold);
+}
+
+#endif // DSP_KERNELS_NEON
+
+const Dsp::KernelSet<SearchKernel>& getKernels()
+{
+    static const Dsp::KernelSet<SearchKernel> kernels { { CrossingDetector::Kernel::Scalar, CrossingDetector::findFirstBelowScalar },
+#if DSP_KERNELS_SSE2
+                                                        { CrossingDetector::Kernel::SSE2, findFirstBelowSSE2 },
+                                                        { CrossingDetector::Kernel::AVX2, findFirstBelowAVX2 },
+#endif
+#if DSP_KERNELS_NEON
+                                                        { CrossingDetector::Kernel::NEON, findFirstBelowNEON },
+#endif
+    };
+
+    return kernels;
+}
+} // namespace
+
+int CrossingDetector::findFirstBelow (const float* samples, int numSamples, float threshold)
+{
+    return getKernels().getSelected() (samples, numSamples, threshold);
+}
+
+int CrossingDetector::findFirstBelowScalar (const float* samples, int numSamples, float threshold)
+{
+    for (int i = 0; i < numSamples; i++)
+    {
+        if (samples[i] < threshold)
+            return i;
+    }
+
+    return numSamples;
+}
+
+bool CrossingDetector::isKernelSupported (Kernel kernel)
+{
+    return getKernels().isSupported (kernel);
+}
+
+int CrossingDetector::findFirstBelow (Kernel kernel, const float* samples, int numSamples, float threshold)
+{
+    return getKernels().getOrScalar (kernel) (samples, numSamples, threshold);
+}
+
+String CrossingDetector::getKernelName()
+{
+    return getKernels().getSelectedName();
+}
@@ -0,0 +1,60 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __CROSSINGDETECTOR_H__
+#define __CROSSINGDETECTOR_H__
+
+#include <ProcessorHeaders.h>
+
+/**
+    Finds threshold crossings in a block of samples.
+
+    Samples are compared against the threshold several at a time
+    (SSE2 / AVX2 / NEON, depending on the CPU), using the same
+    comparison as Thresholder::checkSample(), so the result is
+    identical to checking each sample in turn.
+*/
+class CrossingDetector
+{
+public:
+    /** The available search kernels */
+    using Kernel = Dsp::KernelType;
+
+    /** Returns the index of the first sample below threshold, or numSamples if there is none */
+    static int findFirstBelow (const float* samples, int numSamples, float threshold);
+
+    /** Scalar version of findFirstBelow (used for the remainder of a block and for testing) */
+    static int findFirstBelowScalar (const float* samples, int numSamples, float threshold);
+
+    /** Returns true if a kernel was built in and can run on the host CPU */
+    static bool isKernelSupported (Kernel kernel);
+
+    /** Searches with a specific kernel, which must be supported (used to test each kernel against the scalar one) */
+    static int findFirstBelow (Kernel kernel, const float* samples, int numSamples, float threshold);
+
+    /** Returns the name of the kernel used by findFirstBelow ("AVX2", "SSE2", "NEON" or "Scalar") */
+    static String getKernelName();
+};
+
+#endif // __CROSSINGDETECTOR_H__
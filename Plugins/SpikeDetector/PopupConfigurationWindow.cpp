@@ -82,6 +82,7 @@ PopupThresholdComponent::PopupThresholdComponent (SpikeDetectorTableModel* table
                                                   Array<FloatParameter*> abs_thresholds_,
                                                   Array<FloatParameter*> std_thresholds_,
                                                   Array<FloatParameter*> dyn_thresholds_,
+                                                  Array<FloatParameter*> adp_thresholds_,
                                                   bool lockThresholds) : PopupComponent (owner_),
                                                                          table (table_),
                                                                          owner (owner_),
@@ -89,7 +90,8 @@ PopupThresholdComponent::PopupThresholdComponent (SpikeDetectorTableModel* table
                                                                          thresholdType (type),
                                                                          abs_thresholds (abs_thresholds_),
                                                                          dyn_thresholds (dyn_thresholds_),
-                                                                         std_thresholds (std_thresholds_)
+                                                                         std_thresholds (std_thresholds_),
+                                                                         adp_thresholds (adp_thresholds_)
 {
     const int sliderWidth = 20;
 
@@ -99,26 +101,33 @@ PopupThresholdComponent::PopupThresholdComponent (SpikeDetectorTableModel* table
     addAndMakeVisible (label.get());
 
     absButton = std::make_unique<UtilityButton> ("uV");
-    absButton->setBounds (7, 25, 40, 25);
+    absButton->setBounds (7, 22, 40, 20);
     absButton->setTooltip ("Detection threshold = microvolt value");
     absButton->setToggleState (type == ThresholderType::ABS, dontSendNotification);
     absButton->addListener (this);
     addAndMakeVisible (absButton.get());
 
     stdButton = std::make_unique<UtilityButton> ("STD");
-    stdButton->setBounds (7, 55, 40, 25);
+    stdButton->setBounds (7, 45, 40, 20);
     stdButton->setTooltip ("Detection threshold = multiple of the channel's standard deviation");
     stdButton->setToggleState (type == ThresholderType::STD, dontSendNotification);
     stdButton->addListener (this);
     addAndMakeVisible (stdButton.get());
 
     dynButton = std::make_unique<UtilityButton> ("MED");
-    dynButton->setBounds (7, 85, 40, 25);
+    dynButton->setBounds (7, 68, 40, 20);
     dynButton->setTooltip ("Detection threshold = multiple of the median of the channel's absolute value");
     dynButton->setToggleState (type == ThresholderType::DYN, dontSendNotification);
     dynButton->addListener (this);
     addAndMakeVisible (dynButton.get());
 
+    adpButton = std::make_unique<UtilityButton> ("ADP");
+    adpButton->setBounds (7, 91, 40, 20);
+    adpButton->setTooltip ("Detection threshold = multiple of the channel's noise level, estimated continuously from the median absolute deviation");
+    adpButton->setToggleState (type == ThresholderType::ADP, dontSendNotification);
+    adpButton->addListener (this);
+    addAndMakeVisible (adpButton.get());
+
     createSliders();
 
     lockButton = std::make_unique<UtilityButton> ("LOCK");
@@ -181,6 +190,11 @@ void PopupThresholdComponent::createSliders()
                 slider->setRange (2, 10, 0.1);
                 slider->setValue (dyn_thresholds[i]->getFloatValue(), dontSendNotification);
                 break;
+
+            case ADP:
+                slider->setRange (2, 10, 0.1);
+                slider->setValue (adp_thresholds[i]->getFloatValue(), dontSendNotification);
+                break;
         }
         slider->addListener (this);
         slider->setSize (sliderWidth - 2, 100);
@@ -224,6 +238,7 @@ void PopupThresholdComponent::buttonClicked (Button* button)
     absButton->setToggleState (button == absButton.get(), dontSendNotification);
     stdButton->setToggleState (button == stdButton.get(), dontSendNotification);
     dynButton->setToggleState (button == dynButton.get(), dontSendNotification);
+    adpButton->setToggleState (button == adpButton.get(), dontSendNotification);
 
     if (button == absButton.get())
     {
@@ -237,6 +252,10 @@ void PopupThresholdComponent::buttonClicked (Button* button)
     {
         thresholdType = DYN;
     }
+    else if (button == adpButton.get())
+    {
+        thresholdType = ADP;
+    }
 
     table->broadcastThresholdTypeToSelectedRows (row, // original row
                                                  thresholdType); // threshold type
@@ -255,6 +274,7 @@ ThresholdSelectorCustomComponent::ThresholdSelectorCustomComponent (SpikeChannel
         abs_thresholds.add ((FloatParameter*) channel->getParameter ("abs_threshold" + String (ch + 1)));
         std_thresholds.add ((FloatParameter*) channel->getParameter ("std_threshold" + String (ch + 1)));
         dyn_thresholds.add ((FloatParameter*) channel->getParameter ("dyn_threshold" + String (ch + 1)));
+        adp_thresholds.add ((FloatParameter*) channel->getParameter ("adp_threshold" + String (ch + 1)));
     }
 }
 
@@ -275,6 +295,7 @@ void ThresholdSelectorCustomComponent::mouseDown (const MouseEvent& event)
                                                         abs_thresholds,
                                                         std_thresholds,
                                                         dyn_thresholds,
+                                                        adp_thresholds,
                                                         true);
 
     CoreServices::getPopupManager()->showPopup (std::unique_ptr<Component> (popupComponent), this);
@@ -292,12 +313,14 @@ void ThresholdSelectorCustomComponent::setSpikeChannel (SpikeChannel* ch)
     abs_thresholds.clear();
     std_thresholds.clear();
     dyn_thresholds.clear();
+    adp_thresholds.clear();
 
     for (int ch = 0; ch < channel->getNumChannels(); ch++)
     {
         abs_thresholds.add ((FloatParameter*) channel->getParameter ("abs_threshold" + String (ch + 1)));
         std_thresholds.add ((FloatParameter*) channel->getParameter ("std_threshold" + String (ch + 1)));
         dyn_thresholds.add ((FloatParameter*) channel->getParameter ("dyn_threshold" + String (ch + 1)));
+        adp_thresholds.add ((FloatParameter*) channel->getParameter ("adp_threshold" + String (ch + 1)));
     }
 }
 
@@ -325,6 +348,9 @@ void ThresholdSelectorCustomComponent::paint (Graphics& g)
         case 2:
             thresholdString += "MED: ";
             break;
+        case 3:
+            thresholdString += "ADP: ";
+            break;
     }
 
     for (int i = 0; i < channel->getNumChannels(); i++)
@@ -340,6 +366,9 @@ void ThresholdSelectorCustomComponent::paint (Graphics& g)
             case 2:
                 thresholdString += String (dyn_thresholds[i]->getFloatValue(), 1);
                 break;
+            case 3:
+                thresholdString += String (adp_thresholds[i]->getFloatValue(), 1);
+                break;
         }
 
         thresholdString += ",";
@@ -367,6 +396,9 @@ void ThresholdSelectorCustomComponent::setThreshold (ThresholderType type, int c
         case DYN:
             dyn_thresholds[channelNum]->setNextValue (value);
             break;
+        case ADP:
+            adp_thresholds[channelNum]->setNextValue (value);
+            break;
     }
 
     repaint();
@@ -583,6 +615,9 @@ void SpikeDetectorTableModel::broadcastThresholdTypeToSelectedRows (int rowThatW
                 case DYN:
                     spikeChannels[i]->getParameter ("thrshlder_type")->setNextValue (2);
                     break;
+                case ADP:
+                    spikeChannels[i]->getParameter ("thrshlder_type")->setNextValue (3);
+                    break;
             }
 
             Component* c = table->getCellComponent (SpikeDetectorTableModel::Columns::THRESHOLD, i);
@@ -631,6 +666,10 @@ void SpikeDetectorTableModel::broadcastThresholdToSelectedRows (int rowThatWasCl
                     parameterString = "dyn_threshold";
                     actualValue = value;
                     break;
+                case ADP:
+                    parameterString = "adp_threshold";
+                    actualValue = value;
+                    break;
             }
 
             //std::cout << "Type = " << parameterString << std::endl;
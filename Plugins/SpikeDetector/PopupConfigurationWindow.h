@@ -156,6 +156,7 @@ public:
                              Array<FloatParameter*> abs_thresholds,
                              Array<FloatParameter*> dyn_thresholds,
                              Array<FloatParameter*> std_thresholds,
+                             Array<FloatParameter*> adp_thresholds,
                              bool isLocked);
 
     /** Destructor */
@@ -191,12 +192,14 @@ private:
     std::unique_ptr<UtilityButton> absButton;
     std::unique_ptr<UtilityButton> stdButton;
     std::unique_ptr<UtilityButton> dynButton;
+    std::unique_ptr<UtilityButton> adpButton;
     std::unique_ptr<Label> label;
     OwnedArray<Slider> sliders;
 
     Array<FloatParameter*> abs_thresholds;
     Array<FloatParameter*> dyn_thresholds;
     Array<FloatParameter*> std_thresholds;
+    Array<FloatParameter*> adp_thresholds;
 
     ThresholderType thresholdType;
     SpikeDetectorTableModel* table;
@@ -251,6 +254,7 @@ private:
     Array<FloatParameter*> dyn_thresholds;
     Array<FloatParameter*> abs_thresholds;
     Array<FloatParameter*> std_thresholds;
+    Array<FloatParameter*> adp_thresholds;
 
     CategoricalParameter* thresholder_type;
 
@@ -24,6 +24,7 @@
 #include "SpikeDetector.h"
 #include <stdio.h>
 
+#include "CrossingDetector.h"
 #include "SpikeDetectorEditor.h"
 
 #define OVERFLOW_BUFFER_SAMPLES 200
@@ -74,6 +75,7 @@ StdDevThresholder::StdDevThresholder (int numChannels) : Thresholder()
         thresholds.set (i, -50.0f);
         sampleBuffer.add (new Array<float>());
         bufferIndex.add (-1);
+        skipIndex.add (0);
     }
 }
 
@@ -98,22 +100,13 @@ float StdDevThresholder::getThreshold (int channel)
 
 bool StdDevThresholder::checkSample (int channel, float sample)
 {
-    index += 1;
-    index %= skipSamples;
+    int index = (skipIndex[channel] + 1) % skipSamples;
 
-    if (index == 0)
-    {
-        // update buffer
-        int nextIndex = (bufferIndex[channel] + 1) % bufferSize;
-
-        sampleBuffer[channel]->set (nextIndex, sample);
+    skipIndex.set (channel, index);
 
-        bufferIndex.set (channel, nextIndex);
-
-        // compute threshold
-        if (nextIndex == bufferSize - 1)
-            computeStd (channel);
-    }
+    // update buffer and compute threshold
+    if (index == 0 && bufferSample (channel, sample))
+        computeStd (channel);
 
     if (sample < thresholds[channel])
         return true;
@@ -121,6 +114,34 @@ bool StdDevThresholder::checkSample (int channel, float sample)
     return false;
 }
 
+bool StdDevThresholder::bufferSample (int channel, float sample)
+{
+    int nextIndex = (bufferIndex[channel] + 1) % bufferSize;
+
+    sampleBuffer[channel]->set (nextIndex, sample);
+
+    bufferIndex.set (channel, nextIndex);
+
+    return nextIndex == bufferSize - 1;
+}
+
+int StdDevThresholder::getNumSamplesWithFixedThreshold (int channel)
+{
+    // samples before the next one is buffered, then a full interval for each
+    // buffered sample before the one that fills the buffer
+    const int buffersBeforeUpdate = (2 * bufferSize - 2 - bufferIndex[channel]) % bufferSize;
+
+    return skipSamples - 1 - skipIndex[channel] + buffersBeforeUpdate * skipSamples;
+}
+
+void StdDevThresholder::advance (int channel, const float* samples, int numSamples)
+{
+    for (int i = skipSamples - 1 - skipIndex[channel]; i < numSamples; i += skipSamples)
+        bufferSample (channel, samples[i]);
+
+    skipIndex.set (channel, (skipIndex[channel] + numSamples) % skipSamples);
+}
+
 void StdDevThresholder::computeStd (int channel)
 {
     float mean = 0;
@@ -153,6 +174,7 @@ DynamicThresholder::DynamicThresholder (int numChannels) : Thresholder()
         thresholds.set (i, -50.0f);
         sampleBuffer.add (new std::vector<float> (bufferSize));
         bufferIndex.add (-1);
+        skipIndex.add (0);
     }
 }
 
@@ -175,22 +197,13 @@ float DynamicThresholder::getThreshold (int channel)
 
 bool DynamicThresholder::checkSample (int channel, float sample)
 {
-    index += 1;
-    index %= skipSamples;
+    int index = (skipIndex[channel] + 1) % skipSamples;
 
-    if (index == 0)
-    {
-        // update buffer
-        int nextIndex = (bufferIndex[channel] + 1) % bufferSize;
-
-        sampleBuffer.getUnchecked (channel)->at (nextIndex) = abs (sample) / scalar;
+    skipIndex.set (channel, index);
 
-        bufferIndex.set (channel, nextIndex);
-
-        // compute threshold
-        if (nextIndex == bufferSize - 1)
-            computeSigma (channel);
-    }
+    // update buffer and compute threshold
+    if (index == 0 && bufferSample (channel, sample))
+        computeSigma (channel);
 
     if (sample < thresholds[channel])
         return true;
@@ -198,6 +211,32 @@ bool DynamicThresholder::checkSample (int channel, float sample)
     return false;
 }
 
+bool DynamicThresholder::bufferSample (int channel, float sample)
+{
+    int nextIndex = (bufferIndex[channel] + 1) % bufferSize;
+
+    sampleBuffer.getUnchecked (channel)->at (nextIndex) = abs (sample) / scalar;
+
+    bufferIndex.set (channel, nextIndex);
+
+    return nextIndex == bufferSize - 1;
+}
+
+int DynamicThresholder::getNumSamplesWithFixedThreshold (int channel)
+{
+    const int buffersBeforeUpdate = (2 * bufferSize - 2 - bufferIndex[channel]) % bufferSize;
+
+    return skipSamples - 1 - skipIndex[channel] + buffersBeforeUpdate * skipSamples;
+}
+
+void DynamicThresholder::advance (int channel, const float* samples, int numSamples)
+{
+    for (int i = skipSamples - 1 - skipIndex[channel]; i < numSamples; i += skipSamples)
+        bufferSample (channel, samples[i]);
+
+    skipIndex.set (channel, (skipIndex[channel] + numSamples) % skipSamples);
+}
+
 void DynamicThresholder::computeSigma (int channel)
 {
     std::sort (sampleBuffer.getUnchecked (channel)->begin(),
@@ -212,8 +251,218 @@ void DynamicThresholder::computeSigma (int channel)
     thresholds.set (channel, threshold);
 }
 
+void AdaptiveThresholder::StreamingMedian::reset()
+{
+    count = 0;
+}
+
+void AdaptiveThresholder::StreamingMedian::add (double x)
+{
+    if (count < 5)
+    {
+        // keep the first observations sorted
+        int i = count++;
+
+        for (; i > 0 && heights[i - 1] > x; i--)
+            heights[i] = heights[i - 1];
+
+        heights[i] = x;
+
+        if (count == 5)
+        {
+            for (int j = 0; j < 5; j++)
+            {
+                positions[j] = j + 1;
+                desiredPositions[j] = 1.0 + j;
+            }
+        }
+
+        return;
+    }
+
+    // find the cell that contains x, extending the extreme markers if needed
+    int cell;
+
+    if (x < heights[0])
+    {
+        heights[0] = x;
+        cell = 0;
+    }
+    else if (x >= heights[4])
+    {
+        heights[4] = x;
+        cell = 3;
+    }
+    else
+    {
+        cell = 0;
+
+        while (x >= heights[cell + 1])
+            cell++;
+    }
+
+    for (int i = cell + 1; i < 5; i++)
+        positions[i] += 1.0;
+
+    // desired positions of the min, quartiles, median and max
+    desiredPositions[1] += 0.25;
+    desiredPositions[2] += 0.5;
+    desiredPositions[3] += 0.75;
+    desiredPositions[4] += 1.0;
+
+    // move the middle markers towards their desired positions
+    for (int i = 1; i < 4; i++)
+    {
+        const double d = desiredPositions[i] - positions[i];
+
+        if ((d >= 1.0 && positions[i + 1] - positions[i] > 1.0)
+            || (d <= -1.0 && positions[i - 1] - positions[i] < -1.0))
+        {
+            const int step = d > 0 ? 1 : -1;
+
+            // piecewise-parabolic prediction
+            double height = heights[i]
+                            + step / (positions[i + 1] - positions[i - 1])
+                                  * ((positions[i] - positions[i - 1] + step) * (heights[i + 1] - heights[i]) / (positions[i + 1] - positions[i])
+                                     + (positions[i + 1] - positions[i] - step) * (heights[i] - heights[i - 1]) / (positions[i] - positions[i - 1]));
+
+            // fall back to linear prediction if the parabola leaves the neighbouring markers
+            if (height <= heights[i - 1] || height >= heights[i + 1])
+                height = heights[i] + step * (heights[i + step] - heights[i]) / (positions[i + step] - positions[i]);
+
+            heights[i] = height;
+            positions[i] += step;
+        }
+    }
+}
+
+double AdaptiveThresholder::StreamingMedian::getMedian() const
+{
+    if (count >= 5)
+        return heights[2];
+
+    if (count == 0)
+        return 0.0;
+
+    return heights[count / 2];
+}
+
+AdaptiveThresholder::AdaptiveThresholder (int numChannels) : Thresholder(),
+                                                             channelStates ((size_t) numChannels)
+{
+    for (int i = 0; i < numChannels; i++)
+    {
+        sigmaLevels.set (i, 4.0f);
+        thresholds.set (i, -50.0f);
+    }
+}
+
+void AdaptiveThresholder::setThreshold (int channel, float threshold)
+{
+    if (channel >= 0 && channel < sigmaLevels.size())
+    {
+        const ChannelState& state = channelStates[(size_t) channel];
+
+        sigmaLevels.set (channel, threshold);
+        thresholds.set (channel, state.windowMean - state.noiseLevel * threshold);
+    }
+}
+
+float AdaptiveThresholder::getThreshold (int channel)
+{
+    if (channel >= 0 && channel < sigmaLevels.size())
+        return sigmaLevels[channel];
+
+    return 0.0f;
+}
+
+float AdaptiveThresholder::getNoiseLevel (int channel)
+{
+    if (channel >= 0 && channel < sigmaLevels.size())
+        return channelStates[(size_t) channel].noiseLevel;
+
+    return 0.0f;
+}
+
+bool AdaptiveThresholder::checkSample (int channel, float sample)
+{
+    ChannelState& state = channelStates[(size_t) channel];
+
+    if (++state.skipIndex == skipSamples)
+    {
+        state.skipIndex = 0;
+
+        addSample (state, sample);
+
+        if (state.count == windowSize)
+            updateThreshold (channel);
+    }
+
+    return sample < thresholds.getUnchecked (channel);
+}
+
+int AdaptiveThresholder::getNumSamplesWithFixedThreshold (int channel)
+{
+    const ChannelState& state = channelStates[(size_t) channel];
+
+    return skipSamples - 1 - state.skipIndex + (windowSize - 1 - state.count) * skipSamples;
+}
+
+void AdaptiveThresholder::advance (int channel, const float* samples, int numSamples)
+{
+    ChannelState& state = channelStates[(size_t) channel];
+
+    for (int i = skipSamples - 1 - state.skipIndex; i < numSamples; i += skipSamples)
+        addSample (state, samples[i]);
+
+    state.skipIndex = (state.skipIndex + numSamples) % skipSamples;
+}
+
+void AdaptiveThresholder::addSample (ChannelState& state, float sample)
+{
+    state.count++;
+
+    const double delta = sample - state.mean;
+    state.mean += delta / state.count;
+    state.m2 += delta * (sample - state.mean);
+
+    // deviations are measured from the previous window's mean, which is fixed during the window
+    state.median.add (std::abs (sample - state.windowMean));
+}
+
+void AdaptiveThresholder::updateThreshold (int channel)
+{
+    ChannelState& state = channelStates[(size_t) channel];
+
+    // the deviations of the first window were measured from a mean of 0, so on a
+    // channel with an offset they would overestimate the noise; that window only
+    // sets the mean, and the initial threshold is kept until the next one completes
+    if (state.hasWindowMean)
+    {
+        const double median = state.median.getMedian();
+
+        if (median > 0.0)
+            state.noiseLevel = float (median / scalar);
+        else
+            state.noiseLevel = float (std::sqrt (state.m2 / state.count));
+    }
+
+    state.windowMean = float (state.mean);
+
+    if (state.hasWindowMean)
+        thresholds.set (channel, state.windowMean - state.noiseLevel * sigmaLevels[channel]);
+
+    state.hasWindowMean = true;
+
+    state.count = 0;
+    state.mean = 0.0;
+    state.m2 = 0.0;
+    state.median.reset();
+}
+
 SpikeDetector::SpikeDetector()
     : GenericProcessor ("Spike Detector"),
+      workerPool ("Spike Detector", 1),
       nextAvailableChannel (0),
       singleElectrodeCount (0),
       stereotrodeCount (0),
@@ -226,6 +475,12 @@ SpikeDetector::~SpikeDetector()
     //addMaskChannelsParameter(Parameter::STREAM_SCOPE, "channels", "Channels", "Channels to use for configuring next spike channels");
 }
 
+void SpikeDetector::registerParameters()
+{
+    Array<String> numThreads { "1", "2", "4", "8" };
+    addCategoricalParameter (Parameter::PROCESSOR_SCOPE, "threads", "Threads", "Number of threads used to detect spikes", numThreads, 0, true);
+}
+
 AudioProcessorEditor* SpikeDetector::createEditor()
 {
     editor = std::make_unique<SpikeDetectorEditor> (this);
@@ -234,7 +489,11 @@ AudioProcessorEditor* SpikeDetector::createEditor()
 
 void SpikeDetector::parameterValueChanged (Parameter* p)
 {
-    if (p->getName().equalsIgnoreCase ("name"))
+    if (p->getName().equalsIgnoreCase ("threads"))
+    {
+        workerPool.setNumThreads (p->getValueAsString().getIntValue());
+    }
+    else if (p->getName().equalsIgnoreCase ("name"))
     {
         ((SpikeChannel*) p->getOwner())->setName (p->getValueAsString());
 
@@ -304,7 +563,7 @@ void SpikeDetector::parameterValueChanged (Parameter* p)
                     (float) spikeChannel->getParameter ("std_threshold" + String (ch + 1))->getValue());
             }
         }
-        else if (param->getSelectedString().equalsIgnoreCase ("STD"))
+        else if (param->getSelectedString().equalsIgnoreCase ("DYN"))
         {
             spikeChannel->thresholder.reset();
             spikeChannel->thresholder =
@@ -318,6 +577,20 @@ void SpikeDetector::parameterValueChanged (Parameter* p)
                     (float) spikeChannel->getParameter ("dyn_threshold" + String (ch + 1))->getValue());
             }
         }
+        else if (param->getSelectedString().equalsIgnoreCase ("ADP"))
+        {
+            spikeChannel->thresholder.reset();
+            spikeChannel->thresholder =
+                std::make_unique<AdaptiveThresholder> (
+                    spikeChannel->getNumChannels());
+
+            for (int ch = 0; ch < int (spikeChannel->getNumChannels()); ch++)
+            {
+                spikeChannel->thresholder->setThreshold (
+                    ch,
+                    (float) spikeChannel->getParameter ("adp_threshold" + String (ch + 1))->getValue());
+            }
+        }
     }
 }
 
@@ -330,6 +603,49 @@ void SpikeDetector::updateSettings()
         overflowBuffer.setSize (getNumInputs(), OVERFLOW_BUFFER_SAMPLES);
         overflowBuffer.clear();
     }
+
+    // allocate the spike packets here, so no memory is allocated per spike
+    spikePackets.clear();
+
+    for (auto spikeChannel : spikeChannels)
+    {
+        if (spikeChannel->getEventMetadataCount() == 0)
+            spikePackets.add (new Spike::Packet (spikeChannel));
+        else
+            spikePackets.add (nullptr);
+    }
+
+    activeSpikeChannels.ensureStorageAllocated (spikeChannels.size());
+    activeSpikePackets.ensureStorageAllocated (spikeChannels.size());
+
+    // the block size is only known once the graph has been prepared
+    // (prepareToPlay reserves again for the actual block size)
+    reserveDetectedSpikes (getBlockSize());
+}
+
+void SpikeDetector::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    reserveDetectedSpikes (maximumExpectedSamplesPerBlock);
+}
+
+void SpikeDetector::reserveDetectedSpikes (int blockSize)
+{
+    detectedSpikes.resize (size_t (spikeChannels.size()));
+
+    if (spikeChannels.isEmpty() || blockSize <= 0)
+        return;
+
+    // consecutive spikes are at least getPostPeakSamples() + 1 samples apart, and a block
+    // scans up to half the overflow buffer before its first sample
+    unsigned int minSpikeSpacing = std::numeric_limits<unsigned int>::max();
+
+    for (auto spikeChannel : spikeChannels)
+        minSpikeSpacing = jmin (minSpikeSpacing, spikeChannel->getPostPeakSamples() + 1);
+
+    const size_t maxSpikesPerBlock = size_t (blockSize + OVERFLOW_BUFFER_SAMPLES / 2) / minSpikeSpacing + 1;
+
+    for (auto& spikes : detectedSpikes)
+        spikes.reserve (maxSpikesPerBlock);
 }
 
 int SpikeDetector::getNextAvailableChannelForStream (uint16 streamId)
@@ -549,7 +865,7 @@ SpikeChannel* SpikeDetector::addSpikeChannel (SpikeChannel::Type type,
                                                           "thrshlder_type",
                                                           "Threshold type",
                                                           "The type of thresholder to use",
-                                                          { "ABS", "STD", "DYN" },
+                                                          { "ABS", "STD", "DYN", "ADP" },
                                                           0));
 
     for (int ch = 0; ch < SpikeChannel::getNumChannels (type); ch++)
@@ -586,6 +902,17 @@ SpikeChannel* SpikeDetector::addSpikeChannel (SpikeChannel::Type type,
                                                         1.0f,
                                                         10.0f,
                                                         0.01f));
+
+        spikeChannel->addParameter (new FloatParameter (this,
+                                                        Parameter::SPIKE_CHANNEL_SCOPE,
+                                                        "adp_threshold" + String (ch + 1),
+                                                        "Adp. thresh " + String (ch + 1),
+                                                        "Threshold for one channel when the adaptive thresholder is active",
+                                                        "uV",
+                                                        4.0f,
+                                                        1.0f,
+                                                        10.0f,
+                                                        0.01f));
     }
 
     spikeChannel->addParameter (new SelectedChannelsParameter (this,
@@ -720,113 +1047,301 @@ void SpikeDetector::addWaveformToSpikeBuffer (Spike::Buffer& s,
     }
 }
 
+void SpikeDetector::addWaveformToSpikePacket (Spike::Packet& packet,
+                                              int sampleIndex,
+                                              AudioBuffer<float>& buffer)
+{
+    const SpikeChannel* spikeChannel = packet.spikeChannel;
+    int spikeLength = spikeChannel->getTotalSamples();
+
+    if (spikeLength == 1)
+    {
+        sampleIndex += spikeChannel->getPrePeakSamples();
+    }
+
+    for (int ch = 0; ch < int (spikeChannel->getNumChannels()); ch++)
+    {
+        if (spikeChannel->detectSpikesOnChannel (ch))
+        {
+            const int globalChannelIndex = spikeChannel->globalChannelIndexes[ch];
+
+            for (int sample = 0; sample < spikeLength; ++sample)
+                packet.set (ch, sample, getSample (globalChannelIndex, sampleIndex + sample, buffer));
+        }
+        else
+        {
+            for (int sample = 0; sample < spikeLength; ++sample)
+                packet.set (ch, sample, 0);
+        }
+    }
+}
+
 void SpikeDetector::process (AudioBuffer<float>& buffer)
 {
     totalCallbacks++;
 
-    // cycle through streams
-    for (auto spikeChannel : spikeChannels)
+    activeSpikeChannels.clearQuick();
+    activeSpikePackets.clearQuick();
+
+    for (int i = 0; i < spikeChannels.size(); i++)
     {
+        SpikeChannel* spikeChannel = spikeChannels.getUnchecked (i);
+
         if (spikeChannel->isLocal() && spikeChannel->isValid())
         {
-            const uint16 streamId = spikeChannel->getStreamId();
+            Spike::Packet* packet = spikePackets[i];
 
-            const int nSamples = getNumSamplesInBlock (streamId);
+            activeSpikeChannels.add (spikeChannel);
+            activeSpikePackets.add (packet != nullptr && packet->spikeChannel == spikeChannel ? packet : nullptr);
+        }
+    }
+
+    // one list per spike channel is reserved in updateSettings(), so this
+    // only allocates if spike channels were added without a settings update
+    if (detectedSpikes.size() < size_t (activeSpikeChannels.size()))
+        detectedSpikes.resize (size_t (activeSpikeChannels.size()));
+
+    // detect spikes on each spike channel (in parallel if more than one thread is used)
+    auto detectionTask = [this, &buffer] (int index)
+    {
+        detectSpikes (activeSpikeChannels.getUnchecked (index), buffer, detectedSpikes[size_t (index)]);
+    };
+
+    workerPool.parallelFor (activeSpikeChannels.size(), detectionTask);
+
+    // add spikes to the outgoing EventBuffer, in order of spike channel and sample number
+    for (int index = 0; index < activeSpikeChannels.size(); index++)
+    {
+        SpikeChannel* spikeChannel = activeSpikeChannels.getUnchecked (index);
+        Spike::Packet* packet = activeSpikePackets.getUnchecked (index);
+
+        const int64 firstSampleNumber = getFirstSampleNumberForBlock (spikeChannel->getStreamId());
 
-            int sampleIndex = spikeChannel->currentSampleIndex - 1;
+        for (const auto& detectedSpike : detectedSpikes[size_t (index)])
+        {
+            spikeCount++;
 
-            // cycle through samples
-            while (sampleIndex < nSamples - OVERFLOW_BUFFER_SAMPLES / 2)
+            if (packet != nullptr)
             {
-                ++sampleIndex;
+                // write the spike in place (the timestamp is aligned to the peak index)
+                packet->setHeader (firstSampleNumber + detectedSpike.peakIndex);
 
-                // cycle through channels
-                for (int ch = 0; ch < spikeChannel->getNumChannels(); ch++)
-                {
-                    // check whether spike detection is active
-                    if (spikeChannel->detectSpikesOnChannel (ch))
-                    {
-                        int currentChannel = spikeChannel->globalChannelIndexes[ch];
+                for (int ch = 0; ch < int (spikeChannel->getNumChannels()); ch++)
+                    packet->setThreshold (ch, detectedSpike.thresholds[ch]);
 
-                        float currentSample = getSample (currentChannel, sampleIndex, buffer);
+                addWaveformToSpikePacket (*packet,
+                                          detectedSpike.peakIndex - (spikeChannel->getPrePeakSamples() + 1),
+                                          buffer);
 
-                        if (spikeChannel->thresholder->checkSample (ch, currentSample))
-                        {
-                            // find the peak
-                            int peakIndex = sampleIndex;
+                // the event buffer copies the packet, so it can be reused for the next spike
+                addSpike (*packet);
 
-                            while (getSample (currentChannel, sampleIndex, buffer) > getSample (currentChannel, sampleIndex + 1, buffer)
-                                   && sampleIndex < peakIndex + spikeChannel->getPostPeakSamples())
-                            {
-                                ++sampleIndex;
-                            }
+                continue;
+            }
 
-                            peakIndex = sampleIndex;
+            // create a buffer to hold the spike data
+            Spike::Buffer spikeBuffer (spikeChannel);
 
-                            sampleIndex -= (spikeChannel->getPrePeakSamples() + 1);
+            // add the waveform
+            addWaveformToSpikeBuffer (spikeBuffer,
+                                      detectedSpike.peakIndex - (spikeChannel->getPrePeakSamples() + 1),
+                                      buffer);
 
-                            // create a buffer to hold the spike data
-                            Spike::Buffer spikeBuffer (spikeChannel);
+            // create a spike object (the timestamp is aligned to the peak index)
+            SpikePtr newSpike = Spike::createSpike (spikeChannel,
+                                                    firstSampleNumber + detectedSpike.peakIndex,
+                                                    Array<float> (detectedSpike.thresholds, spikeChannel->getNumChannels()),
+                                                    spikeBuffer);
 
-                            // add the waveform
-                            addWaveformToSpikeBuffer (spikeBuffer,
-                                                      sampleIndex,
-                                                      buffer);
+            // add spike to the outgoing EventBuffer
+            addSpike (newSpike);
+        }
+    }
 
-                            // get the spike timestamp (aligned to the peak index)
-                            int64 sampleNumber = getFirstSampleNumberForBlock (streamId) + peakIndex;
+    // the overflow buffer is only updated once every spike channel has been processed
+    for (auto spikeChannel : activeSpikeChannels)
+    {
+        const int nSamples = getNumSamplesInBlock (spikeChannel->getStreamId());
 
-                            // create a spike object
-                            SpikePtr newSpike = Spike::createSpike (spikeChannel,
-                                                                    sampleNumber,
-                                                                    spikeChannel->thresholder->getThresholds(),
-                                                                    spikeBuffer);
+        if (nSamples > OVERFLOW_BUFFER_SAMPLES)
+        {
+            for (int j = 0; j < int (spikeChannel->getNumChannels()); ++j)
+            {
+                overflowBuffer.copyFrom (spikeChannel->globalChannelIndexes[j],
+                                         0,
+                                         buffer,
+                                         spikeChannel->globalChannelIndexes[j],
+                                         nSamples - OVERFLOW_BUFFER_SAMPLES,
+                                         OVERFLOW_BUFFER_SAMPLES);
+            }
 
-                            spikeCount++;
+            spikeChannel->useOverflowBuffer = true;
+        }
+        else
+        {
+            spikeChannel->useOverflowBuffer = false;
+        }
+    }
+}
 
-                            // add spike to the outgoing EventBuffer
-                            addSpike (newSpike);
+void SpikeDetector::detectSpikes (SpikeChannel* spikeChannel,
+                                  AudioBuffer<float>& buffer,
+                                  std::vector<DetectedSpike>& spikes)
+{
+    spikes.clear();
 
-                            // advance the sample index
-                            sampleIndex = peakIndex + spikeChannel->getPostPeakSamples();
+    const int nSamples = getNumSamplesInBlock (spikeChannel->getStreamId());
+    const int lastSample = nSamples - OVERFLOW_BUFFER_SAMPLES / 2;
 
-                            break; // quit channels "for" loop
-                        }
+    // channels with spike detection active, and their samples before and within the block
+    int channels[4];
+    const float* overflowData[4];
+    const float* blockData[4];
+    int numChannels = 0;
 
-                    } // if detectSpikesOnChannel
+    jassert (spikeChannel->getNumChannels() <= 4);
 
-                } // cycle through channels
+    for (int ch = 0; ch < int (spikeChannel->getNumChannels()); ch++)
+    {
+        if (spikeChannel->detectSpikesOnChannel (ch))
+        {
+            const int currentChannel = spikeChannel->globalChannelIndexes[ch];
+
+            channels[numChannels] = ch;
+            overflowData[numChannels] = overflowBuffer.getReadPointer (currentChannel) + OVERFLOW_BUFFER_SAMPLES;
+            blockData[numChannels] = buffer.getReadPointer (currentChannel);
+            numChannels++;
+        }
+    }
 
-            } // while (sampleIndex < nSamples - OVERFLOW_BUFFER_SAMPLES)
+    int sampleIndex = spikeChannel->currentSampleIndex - 1;
+
+    // cycle through samples
+    while (sampleIndex < lastSample)
+    {
+        // negative sample indices are read from the overflow buffer
+        const int firstSample = sampleIndex + 1;
+        const bool inOverflowBuffer = firstSample < 0;
+        const int segmentEnd = inOverflowBuffer ? jmin (lastSample, -1) : lastSample;
+
+        int crossingChannel;
+
+        sampleIndex = findNextCrossing (spikeChannel->thresholder.get(),
+                                        channels,
+                                        inOverflowBuffer ? overflowData : blockData,
+                                        numChannels,
+                                        firstSample,
+                                        segmentEnd,
+                                        crossingChannel);
+
+        if (sampleIndex > segmentEnd)
+        {
+            sampleIndex = segmentEnd;
+            continue;
+        }
 
-            spikeChannel->currentSampleIndex = sampleIndex - nSamples; // should be negative
+        const int currentChannel = spikeChannel->globalChannelIndexes[channels[crossingChannel]];
 
-            //std::cout << spikeChannel->currentSampleIndex << std::endl;
+        // find the peak
+        int peakIndex = sampleIndex;
 
-            if (nSamples > OVERFLOW_BUFFER_SAMPLES)
+        while (getSample (currentChannel, sampleIndex, buffer) > getSample (currentChannel, sampleIndex + 1, buffer)
+               && sampleIndex < peakIndex + int (spikeChannel->getPostPeakSamples()))
+        {
+            ++sampleIndex;
+        }
+
+        peakIndex = sampleIndex;
+
+        // keep the thresholds that were in use when the spike was detected
+        DetectedSpike spike;
+        spike.peakIndex = peakIndex;
+
+        const Array<float>& thresholds = spikeChannel->thresholder->getThresholds();
+
+        for (int ch = 0; ch < thresholds.size() && ch < 4; ch++)
+            spike.thresholds[ch] = thresholds.getUnchecked (ch);
+
+        spikes.push_back (spike);
+
+        // advance the sample index
+        sampleIndex = peakIndex + spikeChannel->getPostPeakSamples();
+    }
+
+    spikeChannel->currentSampleIndex = sampleIndex - nSamples; // should be negative
+}
+
+int SpikeDetector::findNextCrossing (Thresholder* thresholder,
+                                     const int* channels,
+                                     const float* const* channelData,
+                                     int numChannels,
+                                     int firstSample,
+                                     int lastSample,
+                                     int& crossingChannel)
+{
+    int sampleIndex = firstSample;
+
+    crossingChannel = -1;
+
+    while (sampleIndex <= lastSample)
+    {
+        // scan the samples for which no threshold can change
+        int numSamples = lastSample + 1 - sampleIndex;
+
+        for (int i = 0; i < numChannels; i++)
+            numSamples = jmin (numSamples, thresholder->getNumSamplesWithFixedThreshold (channels[i]));
+
+        if (numSamples > 0)
+        {
+            const Array<float>& thresholds = thresholder->getThresholds();
+
+            // on a tie, the earlier channel wins, as it would be checked first
+            int crossing = sampleIndex + numSamples;
+
+            for (int i = 0; i < numChannels; i++)
             {
-                for (int j = 0; j < spikeChannel->getNumChannels(); ++j)
+                const int offset = CrossingDetector::findFirstBelow (channelData[i] + sampleIndex,
+                                                                     crossing - sampleIndex,
+                                                                     thresholds[channels[i]]);
+
+                if (sampleIndex + offset < crossing)
                 {
-                    overflowBuffer.copyFrom (spikeChannel->globalChannelIndexes[j],
-                                             0,
-                                             buffer,
-                                             spikeChannel->globalChannelIndexes[j],
-                                             nSamples - OVERFLOW_BUFFER_SAMPLES,
-                                             OVERFLOW_BUFFER_SAMPLES);
+                    crossing = sampleIndex + offset;
+                    crossingChannel = i;
                 }
+            }
 
-                spikeChannel->useOverflowBuffer = true;
-                //spikeChannel->currentSampleIndex = -OVERFLOW_BUFFER_SAMPLES / 2;
+            // update each thresholder channel with the samples checkSample() would have seen
+            for (int i = 0; i < numChannels; i++)
+            {
+                thresholder->advance (channels[i],
+                                      channelData[i] + sampleIndex,
+                                      crossing - sampleIndex + (i <= crossingChannel ? 1 : 0));
             }
-            else
+
+            if (crossingChannel >= 0)
+                return crossing;
+
+            sampleIndex = crossing;
+        }
+
+        // a threshold can change at this sample, so each channel is checked individually
+        if (sampleIndex <= lastSample)
+        {
+            for (int i = 0; i < numChannels; i++)
             {
-                spikeChannel->useOverflowBuffer = false;
-                //spikeChannel->currentSampleIndex = 0;
+                if (thresholder->checkSample (channels[i], channelData[i][sampleIndex]))
+                {
+                    crossingChannel = i;
+                    return sampleIndex;
+                }
             }
 
-        } // local channels
+            ++sampleIndex;
+        }
+    }
 
-    } // spikeChannel loop
+    return lastSample + 1;
 }
 
 float SpikeDetector::getSample (int globalChannelIndex, int sampleIndex, AudioBuffer<float>& buffer)
@@ -884,6 +1399,7 @@ void SpikeDetector::saveCustomParametersToXml (XmlElement* xml)
                 spikeChannel->getParameter ("abs_threshold" + String (ch + 1))->toXml (spikeParamsXml);
                 spikeChannel->getParameter ("std_threshold" + String (ch + 1))->toXml (spikeParamsXml);
                 spikeChannel->getParameter ("dyn_threshold" + String (ch + 1))->toXml (spikeParamsXml);
+                spikeChannel->getParameter ("adp_threshold" + String (ch + 1))->toXml (spikeParamsXml);
             }
 
             spikeChannel->getParameter ("waveform_type")->toXml (spikeParamsXml);
@@ -934,6 +1450,7 @@ void SpikeDetector::loadCustomParametersFromXml (XmlElement* xml)
                         spikeChannel->getParameter ("abs_threshold" + String (ch + 1))->fromXml (spikeParamsXml);
                         spikeChannel->getParameter ("std_threshold" + String (ch + 1))->fromXml (spikeParamsXml);
                         spikeChannel->getParameter ("dyn_threshold" + String (ch + 1))->fromXml (spikeParamsXml);
+                        spikeChannel->getParameter ("adp_threshold" + String (ch + 1))->fromXml (spikeParamsXml);
                     }
 
                     spikeChannel->getParameter ("thrshlder_type")->fromXml (spikeParamsXml);
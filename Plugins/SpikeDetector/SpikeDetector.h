@@ -43,7 +43,8 @@ enum ThresholderType
 {
     ABS = 0,
     STD,
-    DYN
+    DYN,
+    ADP
 };
 
 /** 
@@ -74,6 +75,12 @@ public:
     /** Gets an array of thresholds for all channels*/
     Array<float>& getThresholds() { return thresholds; }
 
+    /** The threshold never changes while samples are checked*/
+    int getNumSamplesWithFixedThreshold (int channel) { return std::numeric_limits<int>::max(); }
+
+    /** No state to update*/
+    void advance (int channel, const float* samples, int numSamples) {}
+
 private:
     Array<float> thresholds;
 };
@@ -107,7 +114,16 @@ public:
     /** Gets an array of thresholds for all channels*/
     Array<float>& getThresholds() { return thresholds; }
 
+    /** Returns the number of samples before the threshold of a channel can change*/
+    int getNumSamplesWithFixedThreshold (int channel);
+
+    /** Updates the state of a channel without checking the samples against the threshold*/
+    void advance (int channel, const float* samples, int numSamples);
+
 private:
+    /** Adds a sample to the buffer of a given channel; returns true if the buffer is full*/
+    bool bufferSample (int channel, float sample);
+
     /** Computes the standard deviation of a given channel*/
     void computeStd (int channel);
 
@@ -120,7 +136,7 @@ private:
     const int bufferSize = 4000;
     const int skipSamples = 50;
 
-    int index;
+    Array<int> skipIndex;
 };
 
 /**
@@ -151,7 +167,16 @@ public:
     /** Gets an array of thresholds for all channels*/
     Array<float>& getThresholds() { return thresholds; }
 
+    /** Returns the number of samples before the threshold of a channel can change*/
+    int getNumSamplesWithFixedThreshold (int channel);
+
+    /** Updates the state of a channel without checking the samples against the threshold*/
+    void advance (int channel, const float* samples, int numSamples);
+
 private:
+    /** Adds a sample to the buffer of a given channel; returns true if the buffer is full*/
+    bool bufferSample (int channel, float sample);
+
     /** Computes sigma value used for dynamic thresholding*/
     void computeSigma (int channel);
 
@@ -166,7 +191,111 @@ private:
 
     const float scalar = 0.6745f;
 
-    int index;
+    Array<int> skipIndex;
+};
+
+/**
+    Thresholder based on a running estimate of each channel's noise level,
+    using the same estimator as the DynamicThresholder:
+
+    Thr = mean - k * s
+    s = median{ |x - mean| } / 0.6745
+
+    The median is tracked with the P² algorithm (Jain & Chlamtac, 1985)
+    and the mean and variance with Welford's algorithm, so every sample
+    costs a fixed amount of work, and no samples are stored or sorted.
+    Estimates are updated at the end of each window of samples, with
+    deviations measured from the previous window's mean (so the first
+    window only sets the mean); if the median is zero (e.g. for a heavily
+    quantized signal), the standard deviation is used instead.
+*/
+class AdaptiveThresholder : public Thresholder
+{
+public:
+    /** Constructor */
+    AdaptiveThresholder (int numChannels);
+
+    /** Destructor */
+    virtual ~AdaptiveThresholder() {}
+
+    /** Checks whether a sample should trigger a spike*/
+    bool checkSample (int channel, float sample);
+
+    /** Sets the threshold for a given channel*/
+    void setThreshold (int channel, float threshold);
+
+    /** Gets the threshold for a given channel*/
+    float getThreshold (int channel);
+
+    /** Gets an array of thresholds for all channels*/
+    Array<float>& getThresholds() { return thresholds; }
+
+    /** Returns the number of samples before the threshold of a channel can change*/
+    int getNumSamplesWithFixedThreshold (int channel);
+
+    /** Updates the state of a channel without checking the samples against the threshold*/
+    void advance (int channel, const float* samples, int numSamples);
+
+    /** Gets the most recent noise estimate (s) for a given channel*/
+    float getNoiseLevel (int channel);
+
+    /** Number of samples between updates of the noise estimate*/
+    static const int skipSamples = 10;
+
+    /** Number of (subsampled) samples in each estimation window*/
+    static const int windowSize = 20000;
+
+private:
+    /** Estimates the median of a sequence with five markers (P² algorithm)*/
+    class StreamingMedian
+    {
+    public:
+        /** Discards all observations*/
+        void reset();
+
+        /** Adds an observation*/
+        void add (double x);
+
+        /** Returns the current estimate of the median*/
+        double getMedian() const;
+
+    private:
+        double heights[5];
+        double positions[5];
+        double desiredPositions[5];
+        int count = 0;
+    };
+
+    struct ChannelState
+    {
+        StreamingMedian median; // median of |x - mean|
+
+        // Welford accumulators for the current window
+        int count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+
+        // estimates from the previous window
+        float windowMean = 0.0f;
+        float noiseLevel = 50.0f / 4.0f;
+
+        // false until a window has completed, before which windowMean isn't valid
+        bool hasWindowMean = false;
+
+        int skipIndex = 0;
+    };
+
+    /** Adds a sample to the running estimates of a channel*/
+    void addSample (ChannelState& state, float sample);
+
+    /** Publishes the estimates of a channel at the end of a window*/
+    void updateThreshold (int channel);
+
+    Array<float> thresholds;
+    Array<float> sigmaLevels;
+    std::vector<ChannelState> channelStates;
+
+    const float scalar = 0.6745f;
 };
 
 /**
@@ -183,12 +312,18 @@ public:
     /** Destructor*/
     ~SpikeDetector();
 
+    /** Registers the parameters of the Spike Detector */
+    void registerParameters() override;
+
     /** Processes an incoming continuous buffer and places new spikes into the event buffer. */
     void process (AudioBuffer<float>& buffer) override;
 
     /** Called whenever the signal chain is altered. */
     void updateSettings() override;
 
+    /** Called before acquisition starts, with the largest block size that will be processed */
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+
     /** Parameter changed */
     void parameterValueChanged (Parameter* p) override;
 
@@ -234,6 +369,36 @@ public:
     bool alreadyLoaded (String name, SpikeChannel::Type type, int stream_source, String stream_name);
 
 private:
+    /** A spike that has been detected, but not yet added to the event buffer */
+    struct DetectedSpike
+    {
+        int peakIndex;
+        float thresholds[4];
+    };
+
+    /** Makes room in detectedSpikes for the most spikes that any spike channel can
+        detect in a block of blockSize samples, so none are allocated while processing */
+    void reserveDetectedSpikes (int blockSize);
+
+    /** Finds the spikes of one spike channel in the current block.
+
+        Spike channels are independent, so they can be processed on
+        different threads; the spike objects are created afterwards. */
+    void detectSpikes (SpikeChannel* spikeChannel,
+                       AudioBuffer<float>& buffer,
+                       std::vector<DetectedSpike>& spikes);
+
+    /** Returns the first sample in [firstSample, lastSample] at which one of the channels
+        crosses its threshold (or lastSample + 1), checking channels in order at each sample.
+        channelData[i] must be readable at every index in that range. */
+    static int findNextCrossing (Thresholder* thresholder,
+                                 const int* channels,
+                                 const float* const* channelData,
+                                 int numChannels,
+                                 int firstSample,
+                                 int lastSample,
+                                 int& crossingChannel);
+
     // INTERNAL BUFFERS
     // =====================================================================
     /** Extra samples are placed in this buffer to allow seamless
@@ -250,8 +415,29 @@ private:
                                    int sampleIndex,
                                    AudioBuffer<float>& buffer);
 
+    /** Writes a waveform (starting at a given sample) directly into a spike packet*/
+    void addWaveformToSpikePacket (Spike::Packet& packet,
+                                   int sampleIndex,
+                                   AudioBuffer<float>& buffer);
+
     StreamSettings<SpikeDetectorSettings> settings;
 
+    /** Spike channels that detect spikes in the current block */
+    Array<SpikeChannel*> activeSpikeChannels;
+
+    /** A reusable packet for each spike channel (in the same order), allocated in updateSettings();
+        null for channels with event metadata, whose spikes are created as Spike objects */
+    OwnedArray<Spike::Packet> spikePackets;
+
+    /** The packet of each active spike channel */
+    Array<Spike::Packet*> activeSpikePackets;
+
+    /** Spikes detected in the current block, for each active spike channel
+        (one list per spike channel, reserved in reserveDetectedSpikes()) */
+    std::vector<std::vector<DetectedSpike>> detectedSpikes;
+
+    WorkerPool workerPool;
+
     int totalCallbacks;
     int spikeCount;
 
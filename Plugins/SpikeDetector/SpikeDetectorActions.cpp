@@ -144,6 +144,7 @@ RemoveSpikeChannels::RemoveSpikeChannels (SpikeDetector* processor_,
                 spikeChannel->getParameter ("abs_threshold" + String (ch + 1))->toXml (spikeParamsXml);
                 spikeChannel->getParameter ("std_threshold" + String (ch + 1))->toXml (spikeParamsXml);
                 spikeChannel->getParameter ("dyn_threshold" + String (ch + 1))->toXml (spikeParamsXml);
+                spikeChannel->getParameter ("adp_threshold" + String (ch + 1))->toXml (spikeParamsXml);
             }
 
             spikeChannel->getParameter ("waveform_type")->toXml (spikeParamsXml);
@@ -204,6 +205,7 @@ bool RemoveSpikeChannels::undo()
                 spikeChannel->getParameter ("abs_threshold" + String (ch + 1))->fromXml (spikeParamsXml);
                 spikeChannel->getParameter ("std_threshold" + String (ch + 1))->fromXml (spikeParamsXml);
                 spikeChannel->getParameter ("dyn_threshold" + String (ch + 1))->fromXml (spikeParamsXml);
+                spikeChannel->getParameter ("adp_threshold" + String (ch + 1))->fromXml (spikeParamsXml);
             }
 
             spikeChannel->getParameter ("waveform_type")->fromXml (spikeParamsXml);
@@ -39,8 +39,10 @@ SpikeDetectorEditor::SpikeDetectorEditor (GenericProcessor* parentNode)
     configureButton->setFont (FontOptions (14.0f));
     configureButton->setComponentID ("config_spikes");
     configureButton->addListener (this);
-    configureButton->setBounds (70, 60, 80, 30);
+    configureButton->setBounds (70, 45, 80, 30);
     addAndMakeVisible (configureButton.get());
+
+    addComboBoxParameterEditor (Parameter::PROCESSOR_SCOPE, "threads", 25, 95);
 }
 
 SpikeDetectorEditor::~SpikeDetectorEditor()
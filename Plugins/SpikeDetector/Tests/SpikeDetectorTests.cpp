@@ -25,6 +25,7 @@
 
 #include "gtest/gtest.h"
 
+#include "../CrossingDetector.h"
 #include "../SpikeDetector.h"
 #include <ModelApplication.h>
 #include <ModelProcessors.h>
@@ -50,3 +51,291 @@ protected:
     {
     }
 };
+
+/*
+The adaptive thresholder converges to the noise level of Gaussian noise
+on every channel, centered on the channel's DC offset, without sorting
+any samples.
+*/
+TEST (AdaptiveThresholderTest, EstimatesNoiseLevel)
+{
+    const int numChannels = 2;
+    const float sigma[numChannels] = { 10.0f, 40.0f };
+    const float offset[numChannels] = { 0.0f, 500.0f };
+
+    AdaptiveThresholder thresholder (numChannels);
+
+    for (int ch = 0; ch < numChannels; ch++)
+        thresholder.setThreshold (ch, 5.0f);
+
+    Random random (1);
+
+    const int numSamples = AdaptiveThresholder::skipSamples * AdaptiveThresholder::windowSize * 2;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            // Box-Muller transform
+            const double u1 = 1.0 - random.nextDouble();
+            const double u2 = random.nextDouble();
+            const float sample = offset[ch] + sigma[ch] * float (std::sqrt (-2.0 * std::log (u1)) * std::cos (2.0 * MathConstants<double>::pi * u2));
+
+            thresholder.checkSample (ch, sample);
+        }
+    }
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        EXPECT_NEAR (thresholder.getNoiseLevel (ch), sigma[ch], 0.05f * sigma[ch]);
+        EXPECT_NEAR (thresholder.getThresholds()[ch], offset[ch] - 5.0f * sigma[ch], 0.3f * sigma[ch]);
+    }
+
+    // samples far below the threshold trigger spikes, samples at the offset do not
+    EXPECT_TRUE (thresholder.checkSample (1, offset[1] - 10.0f * sigma[1]));
+    EXPECT_FALSE (thresholder.checkSample (1, offset[1]));
+}
+
+/*
+On a channel with a large DC offset, the threshold stays at its initial
+value until the window mean is known, instead of being set from deviations
+measured from 0, and then follows the noise around the offset.
+*/
+TEST (AdaptiveThresholderTest, WaitsForMeanOfOffsetChannel)
+{
+    const float sigma = 10.0f;
+    const float offset = 2000.0f;
+
+    AdaptiveThresholder thresholder (1);
+    thresholder.setThreshold (0, 4.0f);
+
+    const float initialThreshold = thresholder.getThresholds()[0];
+
+    Random random (3);
+
+    const int windowSamples = AdaptiveThresholder::skipSamples * AdaptiveThresholder::windowSize;
+
+    auto addWindow = [&]
+    {
+        for (int i = 0; i < windowSamples; i++)
+        {
+            const double u1 = 1.0 - random.nextDouble();
+            const double u2 = random.nextDouble();
+
+            thresholder.checkSample (0, offset + sigma * float (std::sqrt (-2.0 * std::log (u1)) * std::cos (2.0 * MathConstants<double>::pi * u2)));
+        }
+    };
+
+    addWindow();
+
+    EXPECT_FLOAT_EQ (thresholder.getThresholds()[0], initialThreshold);
+    EXPECT_FLOAT_EQ (thresholder.getNoiseLevel (0), 50.0f / 4.0f);
+
+    addWindow();
+
+    EXPECT_NEAR (thresholder.getNoiseLevel (0), sigma, 0.05f * sigma);
+    EXPECT_NEAR (thresholder.getThresholds()[0], offset - 4.0f * sigma, 0.3f * sigma);
+
+    // a spike below the offset is detected in the window after that
+    EXPECT_TRUE (thresholder.checkSample (0, offset - 10.0f * sigma));
+    EXPECT_FALSE (thresholder.checkSample (0, offset));
+}
+
+/*
+Each channel is subsampled independently, so channels that are checked
+a different number of times still get their own estimates.
+*/
+TEST (AdaptiveThresholderTest, SubsamplesChannelsIndependently)
+{
+    AdaptiveThresholder thresholder (2);
+
+    // the first window only sets the mean
+    const int numSamples = AdaptiveThresholder::skipSamples * AdaptiveThresholder::windowSize * 2;
+
+    // only channel 0 receives two full windows of alternating samples
+    for (int i = 0; i < numSamples; i++)
+        thresholder.checkSample (0, i % (2 * AdaptiveThresholder::skipSamples) < AdaptiveThresholder::skipSamples ? 20.0f : -20.0f);
+
+    EXPECT_NEAR (thresholder.getNoiseLevel (0), 20.0f / 0.6745f, 0.5f);
+
+    // channel 1 keeps its initial estimate
+    EXPECT_FLOAT_EQ (thresholder.getNoiseLevel (1), 50.0f / 4.0f);
+    EXPECT_FLOAT_EQ (thresholder.getThresholds()[1], -50.0f);
+}
+
+/*
+The vectorized crossing search returns the same index as checking each
+sample in turn, for every block length and crossing position.
+*/
+TEST (CrossingDetectorTest, MatchesScalarSearch)
+{
+    std::vector<float> samples (200, 0.0f);
+
+    for (int crossing = 0; crossing <= 100; crossing++)
+    {
+        std::fill (samples.begin(), samples.end(), 0.0f);
+
+        if (crossing < 100)
+            samples[size_t (crossing)] = -100.0f;
+
+        for (int numSamples = 0; numSamples <= 100; numSamples++)
+        {
+            ASSERT_EQ (CrossingDetector::findFirstBelow (samples.data(), numSamples, -50.0f),
+                       CrossingDetector::findFirstBelowScalar (samples.data(), numSamples, -50.0f))
+                << crossing << ", " << numSamples;
+        }
+    }
+
+    // samples equal to the threshold do not cross it
+    std::fill (samples.begin(), samples.end(), -50.0f);
+    EXPECT_EQ (CrossingDetector::findFirstBelow (samples.data(), 200, -50.0f), 200);
+}
+
+namespace
+{
+using CrossingKernel = CrossingDetector::Kernel;
+
+std::string getCrossingKernelName (const testing::TestParamInfo<CrossingKernel>& info)
+{
+    return Dsp::getKernelTypeName (info.param);
+}
+
+class CrossingDetectorKernelTest : public testing::TestWithParam<CrossingKernel>
+{
+protected:
+    void SetUp() override
+    {
+        if (! CrossingDetector::isKernelSupported (GetParam()))
+            GTEST_SKIP() << "Kernel not supported on this CPU";
+    }
+
+    /** Checks that the kernel under test returns the same index as the scalar search */
+    void compareWithScalar (const std::vector<float>& samples, int numSamples, float threshold)
+    {
+        ASSERT_EQ (CrossingDetector::findFirstBelow (GetParam(), samples.data(), numSamples, threshold),
+                   CrossingDetector::findFirstBelowScalar (samples.data(), numSamples, threshold))
+            << numSamples << " samples";
+    }
+};
+} // namespace
+
+/*
+Every kernel returns the same index as the scalar search, for block lengths
+that aren't multiples of the vector width and crossings in either half of
+an unrolled iteration, including several crossings in one iteration.
+*/
+TEST_P (CrossingDetectorKernelTest, MatchesScalarForEveryPosition)
+{
+    std::vector<float> samples (200, 0.0f);
+
+    for (int crossing = 0; crossing <= 100; crossing++)
+    {
+        std::fill (samples.begin(), samples.end(), 0.0f);
+
+        if (crossing < 100)
+        {
+            samples[size_t (crossing)] = -100.0f;
+            samples[size_t (crossing + 3)] = -100.0f;
+        }
+
+        for (int numSamples = 0; numSamples <= 100; numSamples++)
+            compareWithScalar (samples, numSamples, -50.0f);
+    }
+}
+
+/*
+Samples equal to the threshold don't cross it, and NaNs never do, as with
+the scalar comparison; infinities compare normally.
+*/
+TEST_P (CrossingDetectorKernelTest, MatchesScalarForSpecialValues)
+{
+    std::vector<float> samples (64, -50.0f);
+
+    EXPECT_EQ (CrossingDetector::findFirstBelow (GetParam(), samples.data(), 64, -50.0f), 64);
+
+    std::fill (samples.begin(), samples.end(), std::numeric_limits<float>::quiet_NaN());
+    samples[37] = -std::numeric_limits<float>::infinity();
+
+    for (int numSamples : { 8, 16, 37, 38, 64 })
+        compareWithScalar (samples, numSamples, -50.0f);
+
+    EXPECT_EQ (CrossingDetector::findFirstBelow (GetParam(), samples.data(), 64, -50.0f), 37);
+
+    // a NaN threshold is never crossed
+    std::fill (samples.begin(), samples.end(), -100.0f);
+    EXPECT_EQ (CrossingDetector::findFirstBelow (GetParam(), samples.data(), 64, std::numeric_limits<float>::quiet_NaN()), 64);
+}
+
+INSTANTIATE_TEST_SUITE_P (Kernels,
+                          CrossingDetectorKernelTest,
+                          testing::Values (CrossingKernel::Scalar, CrossingKernel::SSE2, CrossingKernel::AVX2, CrossingKernel::NEON),
+                          getCrossingKernelName);
+
+/*
+Scanning the samples for which a thresholder's threshold is fixed, and
+advancing its state over them, finds the same crossings and leaves the
+same thresholds as calling checkSample on every sample.
+*/
+TEST (ThresholderTest, ScanningMatchesCheckSample)
+{
+    const int numSamples = 2500000;
+
+    std::vector<float> samples (numSamples);
+    Random random (2);
+
+    for (int i = 0; i < numSamples; i++)
+        samples[size_t (i)] = (random.nextFloat() - 0.5f) * 60.0f + (random.nextInt (5000) == 0 ? -300.0f : 0.0f);
+
+    std::vector<std::unique_ptr<Thresholder>> checked;
+    std::vector<std::unique_ptr<Thresholder>> scanned;
+
+    checked.push_back (std::make_unique<AbsValueThresholder> (1));
+    scanned.push_back (std::make_unique<AbsValueThresholder> (1));
+    checked.push_back (std::make_unique<StdDevThresholder> (1));
+    scanned.push_back (std::make_unique<StdDevThresholder> (1));
+    checked.push_back (std::make_unique<DynamicThresholder> (1));
+    scanned.push_back (std::make_unique<DynamicThresholder> (1));
+    checked.push_back (std::make_unique<AdaptiveThresholder> (1));
+    scanned.push_back (std::make_unique<AdaptiveThresholder> (1));
+
+    for (size_t type = 0; type < checked.size(); type++)
+    {
+        std::vector<int> expectedCrossings;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            if (checked[type]->checkSample (0, samples[size_t (i)]))
+                expectedCrossings.push_back (i);
+        }
+
+        std::vector<int> crossings;
+
+        for (int i = 0; i < numSamples;)
+        {
+            const int fixed = jmin (numSamples - i, scanned[type]->getNumSamplesWithFixedThreshold (0));
+
+            if (fixed > 0)
+            {
+                const int offset = CrossingDetector::findFirstBelow (samples.data() + i, fixed, scanned[type]->getThresholds()[0]);
+                const int count = offset < fixed ? offset + 1 : fixed;
+
+                scanned[type]->advance (0, samples.data() + i, count);
+
+                if (offset < fixed)
+                    crossings.push_back (i + offset);
+
+                i += count;
+            }
+            else
+            {
+                if (scanned[type]->checkSample (0, samples[size_t (i)]))
+                    crossings.push_back (i);
+
+                i++;
+            }
+        }
+
+        EXPECT_EQ (crossings, expectedCrossings) << "thresholder " << type;
+        EXPECT_EQ (scanned[type]->getThresholds()[0], checked[type]->getThresholds()[0]) << "thresholder " << type;
+    }
+}
@@ -162,6 +162,7 @@ void SpikeDisplayNode::addSpikePlotForElectrode (SpikePlot* sp, int i)
 {
     Electrode* electrode = electrodes[i];
     electrode->spikePlot = sp;
+    sp->setSpikeChannel (electrode->spikeChannel);
 
     electrodeMap[electrode->spikeChannel] = sp;
 }
@@ -187,8 +188,10 @@ void SpikeDisplayNode::process (AudioBuffer<float>& buffer)
     totalCallbacks++;
 }
 
-void SpikeDisplayNode::handleSpike (SpikePtr spike)
+void SpikeDisplayNode::handleSpikeView (const Spike::View& spike)
 {
-    if (electrodeMap.count (spike->getChannelInfo()) > 0)
-        electrodeMap.at (spike->getChannelInfo())->addSpikeToBuffer (spike);
+    auto it = electrodeMap.find (spike.getChannelInfo());
+
+    if (it != electrodeMap.end())
+        it->second->addSpikeToBuffer (spike);
 }
@@ -53,7 +53,7 @@ public:
     void setParameter (int, float) override;
 
     /** Called for each incoming spike*/
-    void handleSpike (SpikePtr spike) override;
+    void handleSpikeView (const Spike::View& spike) override;
 
     /** Creates a display for each incoming spike channel*/
     void updateSettings() override;
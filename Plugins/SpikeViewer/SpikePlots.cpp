@@ -97,8 +97,6 @@ SpikePlot::SpikePlot (SpikeDisplayCanvas* sdc,
     channelNameLabel->setFont (font);
     channelNameLabel->setBounds (10, 0, 200, 20);
     addAndMakeVisible (channelNameLabel.get());
-
-    mostRecentSpikes.ensureStorageAllocated (MAX_BUFFER_SIZE);
 }
 
 SpikePlot::~SpikePlot()
@@ -126,12 +124,14 @@ void SpikePlot::refresh()
     {
         const ScopedLock myScopedLock (spikeArrayLock);
 
-        for (auto spike : mostRecentSpikes)
+        for (int i = 0; i < spikesInBuffer; i++)
         {
-            processSpikeObject (spike);
+            SpikePtr spike = Spike::deserialize (mostRecentSpikes + i * spikePacketSize, spikeChannel);
+
+            if (spike != nullptr)
+                processSpikeObject (spike);
         }
 
-        mostRecentSpikes.clearQuick (true);
         spikesInBuffer = 0;
     }
 
@@ -163,13 +163,30 @@ void SpikePlot::processSpikeObject (const Spike* s)
     }
 }
 
-void SpikePlot::addSpikeToBuffer (const Spike* spike)
+void SpikePlot::setSpikeChannel (const SpikeChannel* channel)
+{
+    const ScopedLock myScopedLock (spikeArrayLock);
+
+    spikeChannel = channel;
+    spikePacketSize = SPIKE_BASE_SIZE
+                      + channel->getDataSize()
+                      + channel->getNumChannels() * sizeof (float)
+                      + channel->getTotalEventMetadataSize();
+
+    mostRecentSpikes.calloc (bufferSize * spikePacketSize);
+    spikesInBuffer = 0;
+}
+
+void SpikePlot::addSpikeToBuffer (const Spike::View& spike)
 {
     if (spikesInBuffer < bufferSize)
     {
         const ScopedLock myScopedLock (spikeArrayLock);
 
-        mostRecentSpikes.add (new Spike (*spike));
+        if (spike.getChannelInfo() != spikeChannel || spike.getSize() != spikePacketSize)
+            return;
+
+        memcpy (mostRecentSpikes + spikesInBuffer * spikePacketSize, spike.getRawData(), spikePacketSize);
         spikesInBuffer++;
     }
 }
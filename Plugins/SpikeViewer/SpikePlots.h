@@ -170,7 +170,11 @@ public:
 
     SpikeDisplayCanvas* canvas;
 
-    void addSpikeToBuffer (const Spike* spike);
+    /** Allocates storage for the most recent spikes on a channel; called on the message thread */
+    void setSpikeChannel (const SpikeChannel* channel);
+
+    /** Copies a serialized spike into preallocated storage; called on the audio thread */
+    void addSpikeToBuffer (const Spike::View& spike);
 
     int electrodeNumber;
 
@@ -188,9 +192,11 @@ private:
     int nProjAx;
 
     const int bufferSize = 5;
-    int spikesInBuffer;
+    int spikesInBuffer = 0;
 
-    OwnedArray<Spike> mostRecentSpikes;
+    const SpikeChannel* spikeChannel = nullptr;
+    HeapBlock<uint8> mostRecentSpikes;
+    size_t spikePacketSize = 0;
 
     bool limitsChanged;
 
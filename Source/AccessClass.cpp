@@ -181,7 +181,10 @@ MidiBuffer* ExternalProcessorAccessor::getMidiBuffer (GenericProcessor* proc)
 
 void ExternalProcessorAccessor::injectNumSamples (GenericProcessor* proc, uint16_t dataStream, uint32_t numSamples)
 {
-    proc->numSamplesInBlock[dataStream] = numSamples;
+    const int streamIndex = proc->blockTable.getIndex (dataStream);
+
+    if (streamIndex >= 0)
+        proc->blockTable.numSamplesInBlock[streamIndex] = numSamples;
 }
 
 //**Set the MessageCenter for testing only**//
@@ -29,7 +29,10 @@
 #include "../CoreServices.h"
 #include "../Utils/Utils.h"
 
-AudioComponent::AudioComponent() : isPlaying (false)
+AudioComponent::AudioComponent() : isPlaying (false),
+                                   offlineRendering (false),
+                                   offlineBlockSize (0),
+                                   processorGraph (nullptr)
 {
     AccessClass::setAudioComponent (this);
 
@@ -114,6 +117,7 @@ AudioComponent::AudioComponent() : isPlaying (false)
     std::cout << std::endl;
 
     graphPlayer = std::make_unique<AudioProcessorPlayer>();
+    offlineRenderer = std::make_unique<OfflineRenderer>();
 }
 
 AudioComponent::~AudioComponent()
@@ -233,14 +237,16 @@ Array<int> AudioComponent::getAvailableBufferSizes()
     return deviceManager.getCurrentAudioDevice()->getAvailableBufferSizes();
 }
 
-void AudioComponent::connectToProcessorGraph (AudioProcessorGraph* processorGraph)
+void AudioComponent::connectToProcessorGraph (ProcessorGraph* processorGraph_)
 {
+    processorGraph = processorGraph_;
     graphPlayer->setProcessor (processorGraph);
 }
 
 void AudioComponent::disconnectProcessorGraph()
 {
     graphPlayer->setProcessor (0);
+    processorGraph = nullptr;
 }
 
 bool AudioComponent::callbacksAreActive()
@@ -248,6 +254,43 @@ bool AudioComponent::callbacksAreActive()
     return isPlaying;
 }
 
+bool AudioComponent::setOfflineRendering (bool shouldRenderOffline, int blockSize)
+{
+    if (callbacksAreActive())
+    {
+        CoreServices::sendStatusMessage ("Cannot change rendering mode while acquisition is active.");
+        return false;
+    }
+
+    offlineRendering = shouldRenderOffline;
+    offlineBlockSize = jmax (0, blockSize);
+
+    LOGC ("Acquisition mode: ", offlineRendering ? "offline rendering" : "real time");
+
+    return true;
+}
+
+bool AudioComponent::isOfflineRendering() const
+{
+    return offlineRendering;
+}
+
+int AudioComponent::getOfflineBlockSize()
+{
+    if (offlineBlockSize > 0)
+        return offlineBlockSize;
+
+    return getBufferSize();
+}
+
+double AudioComponent::getRealtimeFactor() const
+{
+    if (offlineRendering)
+        return offlineRenderer->getRealtimeFactor();
+
+    return isPlaying ? 1.0 : 0.0;
+}
+
 bool AudioComponent::checkForDevice()
 {
     if (deviceManager.getCurrentAudioDevice() == nullptr)
@@ -285,6 +328,16 @@ bool AudioComponent::beginCallbacks()
 {
     if (! isPlaying)
     {
+        if (offlineRendering)
+        {
+            AudioDeviceManager::AudioDeviceSetup setup;
+            deviceManager.getAudioDeviceSetup (setup);
+
+            offlineRenderer->start (processorGraph, setup.sampleRate, getOfflineBlockSize());
+            isPlaying = true;
+            return true;
+        }
+
         if (restartDevice())
         {
             int64 ms = Time::getCurrentTime().toMilliseconds();
@@ -314,8 +367,16 @@ bool AudioComponent::beginCallbacks()
 
 void AudioComponent::endCallbacks()
 {
-    LOGD ("Removing audio callback.");
-    deviceManager.removeAudioCallback (graphPlayer.get());
+    if (offlineRenderer->isThreadRunning())
+    {
+        offlineRenderer->stop();
+    }
+    else
+    {
+        LOGD ("Removing audio callback.");
+        deviceManager.removeAudioCallback (graphPlayer.get());
+    }
+
     isPlaying = false;
 }
 
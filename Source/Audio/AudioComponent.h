@@ -26,6 +26,10 @@
 
 #include "../../JuceLibraryCode/JuceHeader.h"
 #include "../TestableExport.h"
+#include "OfflineRenderer.h"
+
+class ProcessorGraph;
+
 /**
 
   Interfaces with system audio hardware.
@@ -35,6 +39,10 @@
 
   Sends output to the audio card for audio monitoring.
 
+  In offline rendering mode, the ProcessorGraph is instead driven by an
+  OfflineRenderer thread, which processes data as fast as the sources
+  can supply it (using the sample rate and buffer size of the audio device).
+
   Determines the initial size of the sample buffer (crucial for
   real-time feedback latency).
 
@@ -60,7 +68,7 @@ public:
 
     /** Connects the AudioComponent to the ProcessorGraph (crucial for any sort of
     data acquisition; done at startup).*/
-    void connectToProcessorGraph (AudioProcessorGraph* processorGraph);
+    void connectToProcessorGraph (ProcessorGraph* processorGraph);
 
     /** Disconnects the AudioComponent to the ProcessorGraph (only done when the application
     is about to close).*/
@@ -69,6 +77,23 @@ public:
     /** Returns true if the audio callbacks are active, false otherwise.*/
     bool callbacksAreActive();
 
+    /** Switches between real-time acquisition (driven by the audio device) and
+    offline rendering (as fast as possible). Can't be changed while callbacks are active.
+
+    Offline blocks have blockSize samples, or the audio device's buffer size if blockSize
+    is 0; larger blocks reduce the per-block overhead of throughput-oriented chains.*/
+    bool setOfflineRendering (bool shouldRenderOffline, int blockSize = 0);
+
+    /** Returns true if acquisition will run in offline rendering mode.*/
+    bool isOfflineRendering() const;
+
+    /** Returns the number of samples per block in offline rendering mode.*/
+    int getOfflineBlockSize();
+
+    /** Returns the ratio between the data processed and the elapsed time
+    (1.0 for real-time acquisition, 0.0 if callbacks have not been started).*/
+    double getRealtimeFactor() const;
+
     /** Checks whether a device is available*/
     bool checkForDevice();
 
@@ -123,8 +148,13 @@ public:
 
 private:
     bool isPlaying;
+    bool offlineRendering;
+    int offlineBlockSize;
+
+    ProcessorGraph* processorGraph;
 
     std::unique_ptr<AudioProcessorPlayer> graphPlayer;
+    std::unique_ptr<OfflineRenderer> offlineRenderer;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioComponent);
 };
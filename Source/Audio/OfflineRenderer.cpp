@@ -0,0 +1,153 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "OfflineRenderer.h"
+
+#include "../Processors/ProcessorGraph/ProcessorGraph.h"
+#include "../Processors/RecordNode/RecordNode.h"
+#include "../Utils/Utils.h"
+
+// pause rendering while a recording queue is fuller than this
+// (Record Nodes stop recording at 90%)
+#define MAX_RECORD_BUFFER_USAGE 0.5f
+
+OfflineRenderer::OfflineRenderer() : Thread ("Offline Renderer"),
+                                     graph (nullptr),
+                                     sampleRate (44100.0),
+                                     blockSize (1024),
+                                     samplesRendered (0),
+                                     startTicks (0),
+                                     stopTicks (0)
+{
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+    stop();
+}
+
+void OfflineRenderer::start (ProcessorGraph* graph_, double sampleRate_, int blockSize_)
+{
+    stop();
+
+    graph = graph_;
+    sampleRate = sampleRate_ > 0 ? sampleRate_ : 44100.0;
+    blockSize = blockSize_ > 0 ? blockSize_ : 1024;
+
+    // the graph can't change while acquisition is active
+    recordNodes = graph->getRecordNodes();
+
+    graph->setNonRealtime (true);
+    graph->setRateAndBufferSizeDetails (sampleRate, blockSize);
+    graph->prepareToPlay (sampleRate, blockSize);
+
+    samplesRendered = 0;
+    startTicks = Time::getHighResolutionTicks();
+    stopTicks = 0;
+
+    LOGC ("Starting offline rendering (", sampleRate, " Hz, ", blockSize, " samples per block)");
+
+    startThread();
+}
+
+void OfflineRenderer::stop()
+{
+    if (graph == nullptr)
+        return;
+
+    stopThread (5000);
+    stopTicks = Time::getHighResolutionTicks();
+
+    graph->releaseResources();
+    graph->setNonRealtime (false);
+    graph = nullptr;
+
+    recordNodes.clear();
+
+    LOGC ("Offline rendering processed ", String (getRenderedSeconds(), 1), " s of data at ", String (getRealtimeFactor(), 1), "x real time");
+}
+
+double OfflineRenderer::getRenderedSeconds() const
+{
+    return double (samplesRendered.load()) / sampleRate;
+}
+
+double OfflineRenderer::getRealtimeFactor() const
+{
+    const int64 start = startTicks.load();
+
+    if (start == 0)
+        return 0.0;
+
+    const int64 stop = stopTicks.load();
+    const double elapsed = Time::highResolutionTicksToSeconds ((stop > 0 ? stop : Time::getHighResolutionTicks()) - start);
+
+    return elapsed > 0.0 ? getRenderedSeconds() / elapsed : 0.0;
+}
+
+bool OfflineRenderer::isRecordingBehind() const
+{
+    for (auto recordNode : recordNodes)
+    {
+        if (recordNode->getQueueUsage() > MAX_RECORD_BUFFER_USAGE)
+            return true;
+    }
+
+    return false;
+}
+
+void OfflineRenderer::run()
+{
+    AudioBuffer<float> buffer (jmax (graph->getTotalNumInputChannels(), graph->getTotalNumOutputChannels()), blockSize);
+    MidiBuffer midiMessages;
+
+    while (! threadShouldExit())
+    {
+        if (isRecordingBehind())
+        {
+            wait (1);
+            continue;
+        }
+
+        buffer.clear();
+        midiMessages.clear();
+
+        bool processed = false;
+
+        {
+            const ScopedLock sl (graph->getCallbackLock());
+
+            if (! graph->isSuspended())
+            {
+                graph->processBlock (buffer, midiMessages);
+                processed = true;
+            }
+        }
+
+        if (processed)
+            samplesRendered += blockSize;
+        else
+            wait (1);
+    }
+}
@@ -0,0 +1,91 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef OFFLINERENDERER_H_INCLUDED
+#define OFFLINERENDERER_H_INCLUDED
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+#include "../TestableExport.h"
+
+#include <atomic>
+
+class ProcessorGraph;
+class RecordNode;
+
+/**
+
+  Drives the ProcessorGraph from a dedicated thread instead of the audio device,
+  processing blocks as fast as the sources can supply data.
+
+  Blocks have the size and sample rate of the current audio device setup, so
+  processors see the same settings as they would during real-time acquisition.
+  While a Record Node's buffer is more than half full, rendering pauses until
+  the disk writers catch up, so no data is dropped.
+
+  @see AudioComponent
+
+*/
+
+class TESTABLE OfflineRenderer : public Thread
+{
+public:
+    /** Constructor */
+    OfflineRenderer();
+
+    /** Destructor. Stops rendering if it is active. */
+    ~OfflineRenderer();
+
+    /** Prepares the graph for processing and starts the render thread */
+    void start (ProcessorGraph* graph, double sampleRate, int blockSize);
+
+    /** Stops the render thread and releases the graph's resources */
+    void stop();
+
+    /** Returns the number of seconds of data processed since rendering started */
+    double getRenderedSeconds() const;
+
+    /** Returns the ratio between the data processed and the elapsed wall-clock time */
+    double getRealtimeFactor() const;
+
+    /** Renders blocks until the thread is asked to exit */
+    void run() override;
+
+private:
+    /** Returns true if any Record Node's data, event or spike queue is too full to accept another block */
+    bool isRecordingBehind() const;
+
+    ProcessorGraph* graph;
+    Array<RecordNode*> recordNodes;
+
+    double sampleRate;
+    int blockSize;
+
+    std::atomic<int64> samplesRendered;
+    std::atomic<int64> startTicks;
+    std::atomic<int64> stopTicks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer);
+};
+
+#endif
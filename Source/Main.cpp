@@ -28,6 +28,7 @@
 #define _MAIN
 #endif
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "AccessClass.h"
 #include "MainWindow.h"
 
 #include <fstream>
@@ -105,6 +106,8 @@ public:
         if (! parameters.isEmpty())
         {
             bool isConsoleApp = false;
+            bool renderOffline = false;
+            int offlineBlockSize = 0;
             File fileToLoad;
 
             for (auto param : parameters)
@@ -113,6 +116,14 @@ public:
                 {
                     isConsoleApp = true;
                 }
+                else if (param.equalsIgnoreCase ("--offline"))
+                {
+                    renderOffline = true;
+                }
+                else if (param.startsWithIgnoreCase ("--block-size="))
+                {
+                    offlineBlockSize = param.fromFirstOccurrenceOf ("=", false, false).getIntValue();
+                }
                 else if (fileToLoad.getFullPathName().isEmpty())
                 {
                     File localPath (File::getCurrentWorkingDirectory().getChildFile (param));
@@ -131,6 +142,10 @@ public:
             }
 
             mainWindow = std::make_unique<MainWindow> (fileToLoad, isConsoleApp);
+
+            // process data as fast as possible instead of at the rate of the audio device
+            if (renderOffline)
+                AccessClass::getAudioComponent()->setOfflineRendering (true, offlineBlockSize);
         }
         else
         {
@@ -45,6 +45,8 @@ THE SOFTWARE.
 #include "Biquad.h"
 #include "Cascade.h"
 #include "Filter.h"
+#include "KernelDispatch.h"
+#include "Multichannel.h"
 #include "PoleFilter.h"
 #include "SmoothedFilter.h"
 #include "State.h"
@@ -0,0 +1,194 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DSPFILTERS_KERNELDISPATCH_H
+#define DSPFILTERS_KERNELDISPATCH_H
+
+#include "Common.h"
+
+#include <initializer_list>
+
+// SSE2 kernels are built on every x86-64 target; AVX2 kernels are built
+// with a per-function target attribute and only run if the CPU has AVX2
+#if JUCE_INTEL && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define DSP_KERNELS_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && ! defined(__clang__)
+#define DSP_KERNELS_AVX2_TARGET
+#else
+#define DSP_KERNELS_AVX2_TARGET __attribute__ ((target ("avx2")))
+#endif
+#endif
+
+#if JUCE_ARM && defined(__aarch64__)
+#define DSP_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace Dsp
+{
+
+// The instruction sets a vectorized kernel can be written for
+enum class KernelType
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON
+};
+
+// Returns "Scalar", "SSE2", "AVX2" or "NEON"
+inline const char* getKernelTypeName (KernelType type)
+{
+    switch (type)
+    {
+        case KernelType::SSE2:
+            return "SSE2";
+        case KernelType::AVX2:
+            return "AVX2";
+        case KernelType::NEON:
+            return "NEON";
+        default:
+            return "Scalar";
+    }
+}
+
+// Returns true if kernels of a type are built in and can run on the host CPU
+inline bool isKernelTypeSupported (KernelType type)
+{
+    switch (type)
+    {
+        case KernelType::Scalar:
+            return true;
+#if DSP_KERNELS_SSE2
+        case KernelType::SSE2:
+            return true;
+        case KernelType::AVX2:
+            return juce::SystemStats::hasAVX2();
+#endif
+#if DSP_KERNELS_NEON
+        case KernelType::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+/*
+ * Holds the implementations of one function for each kernel type,
+ * and selects the fastest one the host CPU supports.
+ *
+ * Each module keeps a single set, created the first time it's used:
+ *
+ *   const KernelSet<Function>& getKernels()
+ *   {
+ *       static const KernelSet<Function> kernels { { KernelType::Scalar, processScalar },
+ *   #if DSP_KERNELS_SSE2
+ *                                                  { KernelType::SSE2, processSSE2 },
+ *                                                  { KernelType::AVX2, processAVX2 },
+ *   #endif
+ *                                                };
+ *       return kernels;
+ *   }
+ *
+ * A Scalar implementation must always be given.
+ *
+ */
+template <typename Function>
+class KernelSet
+{
+public:
+    struct Kernel
+    {
+        KernelType type;
+        Function function;
+    };
+
+    KernelSet (std::initializer_list<Kernel> kernels)
+    {
+        for (const Kernel& kernel : kernels)
+            m_functions[int (kernel.type)] = kernel.function;
+
+        assert (m_functions[int (KernelType::Scalar)] != nullptr);
+
+        const KernelType fastestFirst[] = { KernelType::AVX2, KernelType::SSE2, KernelType::NEON, KernelType::Scalar };
+
+        for (KernelType type : fastestFirst)
+        {
+            if (get (type) != nullptr)
+            {
+                m_selected = type;
+                break;
+            }
+        }
+    }
+
+    // Returns the implementation for a kernel type, or nullptr if there
+    // is none or the host CPU can't run it
+    Function get (KernelType type) const
+    {
+        return isKernelTypeSupported (type) ? m_functions[int (type)] : nullptr;
+    }
+
+    // Returns true if there is an implementation the host CPU can run
+    bool isSupported (KernelType type) const
+    {
+        return get (type) != nullptr;
+    }
+
+    // Returns the implementation for a kernel type, falling back to the
+    // scalar one if there is none or the host CPU can't run it
+    Function getOrScalar (KernelType type) const
+    {
+        Function function = get (type);
+
+        assert (function != nullptr);
+
+        return function != nullptr ? function : m_functions[int (KernelType::Scalar)];
+    }
+
+    // Returns the fastest implementation the host CPU supports
+    Function getSelected() const
+    {
+        return m_functions[int (m_selected)];
+    }
+
+    KernelType getSelectedType() const
+    {
+        return m_selected;
+    }
+
+    const char* getSelectedName() const
+    {
+        return getKernelTypeName (m_selected);
+    }
+
+private:
+    Function m_functions[4] = {};
+    KernelType m_selected = KernelType::Scalar;
+};
+
+} // namespace Dsp
+
+#endif
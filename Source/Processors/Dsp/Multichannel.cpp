@@ -0,0 +1,554 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "Multichannel.h"
+#include "Common.h"
+#include "KernelDispatch.h"
+#include "MathSupplement.h"
+
+namespace Dsp
+{
+
+namespace
+{
+
+// Coefficients stored per stage
+const int coefficientsPerStage = 5;
+
+// Filters samples [startSample, numSamples) of each channel, one channel at a time.
+// state points to s1 of the first stage for the first channel; successive state
+// rows (s1 and s2 of each stage) are stride values apart.
+template <typename Sample>
+void processScalar (int startSample,
+                    int numSamples,
+                    Sample* const* channels,
+                    int numChannels,
+                    const double* coefficients,
+                    int numStages,
+                    double* state,
+                    double* vsa,
+                    int stride)
+{
+    for (int c = 0; c < numChannels; ++c)
+    {
+        Sample* dest = channels[c];
+        double v = vsa[c];
+
+        for (int n = startSample; n < numSamples; ++n)
+        {
+            v = -v;
+
+            double in = dest[n];
+
+            for (int s = 0; s < numStages; ++s)
+            {
+                const double* k = coefficients + s * coefficientsPerStage;
+                double& s1 = state[(2 * s) * stride + c];
+                double& s2 = state[(2 * s + 1) * stride + c];
+
+                const double out = s1 + k[0] * in + (s == 0 ? v : 0);
+                s1 = s2 + k[1] * in - k[3] * out;
+                s2 = k[2] * in - k[4] * out;
+
+                in = out;
+            }
+
+            dest[n] = static_cast<Sample> (in);
+        }
+
+        vsa[c] = v;
+    }
+}
+
+typedef void (*FloatKernel) (int, float* const*, int, const double*, int, double*, double*, int);
+
+void processFloatScalar (int numSamples,
+                         float* const* channels,
+                         int numChannels,
+                         const double* coefficients,
+                         int numStages,
+                         double* state,
+                         double* vsa,
+                         int stride)
+{
+    processScalar (0, numSamples, channels, numChannels, coefficients, numStages, state, vsa, stride);
+}
+
+#if DSP_KERNELS_SSE2
+
+// Runs one sample of 4 channels (2 per register) through every stage
+inline void processStagesSSE2 (__m128d& lo,
+                               __m128d& hi,
+                               const __m128d vsaLo,
+                               const __m128d vsaHi,
+                               const double* coefficients,
+                               int numStages,
+                               double* state,
+                               int stride)
+{
+    for (int s = 0; s < numStages; ++s)
+    {
+        const double* k = coefficients + s * coefficientsPerStage;
+        const __m128d b0 = _mm_set1_pd (k[0]);
+        const __m128d b1 = _mm_set1_pd (k[1]);
+        const __m128d b2 = _mm_set1_pd (k[2]);
+        const __m128d a1 = _mm_set1_pd (k[3]);
+        const __m128d a2 = _mm_set1_pd (k[4]);
+
+        double* s1 = state + (2 * s) * stride;
+        double* s2 = state + (2 * s + 1) * stride;
+
+        __m128d outLo = _mm_add_pd (_mm_loadu_pd (s1), _mm_mul_pd (b0, lo));
+        __m128d outHi = _mm_add_pd (_mm_loadu_pd (s1 + 2), _mm_mul_pd (b0, hi));
+
+        if (s == 0)
+        {
+            outLo = _mm_add_pd (outLo, vsaLo);
+            outHi = _mm_add_pd (outHi, vsaHi);
+        }
+
+        _mm_storeu_pd (s1, _mm_sub_pd (_mm_add_pd (_mm_loadu_pd (s2), _mm_mul_pd (b1, lo)), _mm_mul_pd (a1, outLo)));
+        _mm_storeu_pd (s1 + 2, _mm_sub_pd (_mm_add_pd (_mm_loadu_pd (s2 + 2), _mm_mul_pd (b1, hi)), _mm_mul_pd (a1, outHi)));
+        _mm_storeu_pd (s2, _mm_sub_pd (_mm_mul_pd (b2, lo), _mm_mul_pd (a2, outLo)));
+        _mm_storeu_pd (s2 + 2, _mm_sub_pd (_mm_mul_pd (b2, hi), _mm_mul_pd (a2, outHi)));
+
+        lo = outLo;
+        hi = outHi;
+    }
+}
+
+// Filters groups of 4 channels, 4 samples at a time
+void processFloatSSE2 (int numSamples,
+                       float* const* channels,
+                       int numChannels,
+                       const double* coefficients,
+                       int numStages,
+                       double* state,
+                       double* vsa,
+                       int stride)
+{
+    const __m128d signBit = _mm_set1_pd (-0.0);
+
+    int c = 0;
+
+    for (; c + 4 <= numChannels; c += 4)
+    {
+        float* const* group = channels + c;
+        double* groupState = state + c;
+
+        __m128d vsaLo = _mm_loadu_pd (vsa + c);
+        __m128d vsaHi = _mm_loadu_pd (vsa + c + 2);
+
+        int n = 0;
+
+        for (; n + 4 <= numSamples; n += 4)
+        {
+            __m128 r[4];
+
+            for (int i = 0; i < 4; ++i)
+                r[i] = _mm_loadu_ps (group[i] + n);
+
+            // r[j] now holds sample j of the 4 channels
+            _MM_TRANSPOSE4_PS (r[0], r[1], r[2], r[3]);
+
+            for (int j = 0; j < 4; ++j)
+            {
+                vsaLo = _mm_xor_pd (vsaLo, signBit);
+                vsaHi = _mm_xor_pd (vsaHi, signBit);
+
+                __m128d lo = _mm_cvtps_pd (r[j]);
+                __m128d hi = _mm_cvtps_pd (_mm_movehl_ps (r[j], r[j]));
+
+                processStagesSSE2 (lo, hi, vsaLo, vsaHi, coefficients, numStages, groupState, stride);
+
+                r[j] = _mm_movelh_ps (_mm_cvtpd_ps (lo), _mm_cvtpd_ps (hi));
+            }
+
+            _MM_TRANSPOSE4_PS (r[0], r[1], r[2], r[3]);
+
+            for (int i = 0; i < 4; ++i)
+                _mm_storeu_ps (group[i] + n, r[i]);
+        }
+
+        _mm_storeu_pd (vsa + c, vsaLo);
+        _mm_storeu_pd (vsa + c + 2, vsaHi);
+
+        processScalar (n, numSamples, group, 4, coefficients, numStages, groupState, vsa + c, stride);
+    }
+
+    processScalar (0, numSamples, channels + c, numChannels - c, coefficients, numStages, state + c, vsa + c, stride);
+}
+
+// Runs one sample of 8 channels (4 per register) through every stage
+DSP_KERNELS_AVX2_TARGET inline void processStagesAVX2 (__m256d& lo,
+                                                       __m256d& hi,
+                                                       const __m256d vsaLo,
+                                                       const __m256d vsaHi,
+                                                       const double* coefficients,
+                                                       int numStages,
+                                                       double* state,
+                                                       int stride)
+{
+    for (int s = 0; s < numStages; ++s)
+    {
+        const double* k = coefficients + s * coefficientsPerStage;
+        const __m256d b0 = _mm256_set1_pd (k[0]);
+        const __m256d b1 = _mm256_set1_pd (k[1]);
+        const __m256d b2 = _mm256_set1_pd (k[2]);
+        const __m256d a1 = _mm256_set1_pd (k[3]);
+        const __m256d a2 = _mm256_set1_pd (k[4]);
+
+        double* s1 = state + (2 * s) * stride;
+        double* s2 = state + (2 * s + 1) * stride;
+
+        __m256d outLo = _mm256_add_pd (_mm256_loadu_pd (s1), _mm256_mul_pd (b0, lo));
+        __m256d outHi = _mm256_add_pd (_mm256_loadu_pd (s1 + 4), _mm256_mul_pd (b0, hi));
+
+        if (s == 0)
+        {
+            outLo = _mm256_add_pd (outLo, vsaLo);
+            outHi = _mm256_add_pd (outHi, vsaHi);
+        }
+
+        _mm256_storeu_pd (s1, _mm256_sub_pd (_mm256_add_pd (_mm256_loadu_pd (s2), _mm256_mul_pd (b1, lo)), _mm256_mul_pd (a1, outLo)));
+        _mm256_storeu_pd (s1 + 4, _mm256_sub_pd (_mm256_add_pd (_mm256_loadu_pd (s2 + 4), _mm256_mul_pd (b1, hi)), _mm256_mul_pd (a1, outHi)));
+        _mm256_storeu_pd (s2, _mm256_sub_pd (_mm256_mul_pd (b2, lo), _mm256_mul_pd (a2, outLo)));
+        _mm256_storeu_pd (s2 + 4, _mm256_sub_pd (_mm256_mul_pd (b2, hi), _mm256_mul_pd (a2, outHi)));
+
+        lo = outLo;
+        hi = outHi;
+    }
+}
+
+// Filters groups of 8 channels, 4 samples at a time
+DSP_KERNELS_AVX2_TARGET void processFloatAVX2 (int numSamples,
+                                               float* const* channels,
+                                               int numChannels,
+                                               const double* coefficients,
+                                               int numStages,
+                                               double* state,
+                                               double* vsa,
+                                               int stride)
+{
+    const __m256d signBit = _mm256_set1_pd (-0.0);
+
+    int c = 0;
+
+    for (; c + 8 <= numChannels; c += 8)
+    {
+        float* const* group = channels + c;
+        double* groupState = state + c;
+
+        __m256d vsaLo = _mm256_loadu_pd (vsa + c);
+        __m256d vsaHi = _mm256_loadu_pd (vsa + c + 4);
+
+        int n = 0;
+
+        for (; n + 4 <= numSamples; n += 4)
+        {
+            __m128 r[8];
+
+            for (int i = 0; i < 8; ++i)
+                r[i] = _mm_loadu_ps (group[i] + n);
+
+            // r[j] and r[4 + j] now hold sample j of channels 0-3 and 4-7
+            _MM_TRANSPOSE4_PS (r[0], r[1], r[2], r[3]);
+            _MM_TRANSPOSE4_PS (r[4], r[5], r[6], r[7]);
+
+            for (int j = 0; j < 4; ++j)
+            {
+                vsaLo = _mm256_xor_pd (vsaLo, signBit);
+                vsaHi = _mm256_xor_pd (vsaHi, signBit);
+
+                __m256d lo = _mm256_cvtps_pd (r[j]);
+                __m256d hi = _mm256_cvtps_pd (r[4 + j]);
+
+                processStagesAVX2 (lo, hi, vsaLo, vsaHi, coefficients, numStages, groupState, stride);
+
+                r[j] = _mm256_cvtpd_ps (lo);
+                r[4 + j] = _mm256_cvtpd_ps (hi);
+            }
+
+            _MM_TRANSPOSE4_PS (r[0], r[1], r[2], r[3]);
+            _MM_TRANSPOSE4_PS (r[4], r[5], r[6], r[7]);
+
+            for (int i = 0; i < 8; ++i)
+                _mm_storeu_ps (group[i] + n, r[i]);
+        }
+
+        _mm256_storeu_pd (vsa + c, vsaLo);
+        _mm256_storeu_pd (vsa + c + 4, vsaHi);
+
+        processScalar (n, numSamples, group, 8, coefficients, numStages, groupState, vsa + c, stride);
+    }
+
+    // fewer than 8 channels left
+    processFloatSSE2 (numSamples, channels + c, numChannels - c, coefficients, numStages, state + c, vsa + c, stride);
+}
+
+#endif // DSP_KERNELS_SSE2
+
+#if DSP_KERNELS_NEON
+
+// Runs one sample of 4 channels (2 per register) through every stage
+inline void processStagesNEON (float64x2_t& lo,
+                               float64x2_t& hi,
+                               const float64x2_t vsaLo,
+                               const float64x2_t vsaHi,
+                               const double* coefficients,
+                               int numStages,
+                               double* state,
+                               int stride)
+{
+    for (int s = 0; s < numStages; ++s)
+    {
+        const double* k = coefficients + s * coefficientsPerStage;
+        const float64x2_t b0 = vdupq_n_f64 (k[0]);
+        const float64x2_t b1 = vdupq_n_f64 (k[1]);
+        const float64x2_t b2 = vdupq_n_f64 (k[2]);
+        const float64x2_t a1 = vdupq_n_f64 (k[3]);
+        const float64x2_t a2 = vdupq_n_f64 (k[4]);
+
+        double* s1 = state + (2 * s) * stride;
+        double* s2 = state + (2 * s + 1) * stride;
+
+        float64x2_t outLo = vaddq_f64 (vld1q_f64 (s1), vmulq_f64 (b0, lo));
+        float64x2_t outHi = vaddq_f64 (vld1q_f64 (s1 + 2), vmulq_f64 (b0, hi));
+
+        if (s == 0)
+        {
+            outLo = vaddq_f64 (outLo, vsaLo);
+            outHi = vaddq_f64 (outHi, vsaHi);
+        }
+
+        vst1q_f64 (s1, vsubq_f64 (vaddq_f64 (vld1q_f64 (s2), vmulq_f64 (b1, lo)), vmulq_f64 (a1, outLo)));
+        vst1q_f64 (s1 + 2, vsubq_f64 (vaddq_f64 (vld1q_f64 (s2 + 2), vmulq_f64 (b1, hi)), vmulq_f64 (a1, outHi)));
+        vst1q_f64 (s2, vsubq_f64 (vmulq_f64 (b2, lo), vmulq_f64 (a2, outLo)));
+        vst1q_f64 (s2 + 2, vsubq_f64 (vmulq_f64 (b2, hi), vmulq_f64 (a2, outHi)));
+
+        lo = outLo;
+        hi = outHi;
+    }
+}
+
+// Transposes a 4 x 4 tile of floats (rows become columns)
+inline void transpose4x4 (float32x4_t* r)
+{
+    const float32x4x2_t t01 = vtrnq_f32 (r[0], r[1]);
+    const float32x4x2_t t23 = vtrnq_f32 (r[2], r[3]);
+
+    r[0] = vcombine_f32 (vget_low_f32 (t01.val[0]), vget_low_f32 (t23.val[0]));
+    r[1] = vcombine_f32 (vget_low_f32 (t01.val[1]), vget_low_f32 (t23.val[1]));
+    r[2] = vcombine_f32 (vget_high_f32 (t01.val[0]), vget_high_f32 (t23.val[0]));
+    r[3] = vcombine_f32 (vget_high_f32 (t01.val[1]), vget_high_f32 (t23.val[1]));
+}
+
+// Filters groups of 4 channels, 4 samples at a time
+void processFloatNEON (int numSamples,
+                       float* const* channels,
+                       int numChannels,
+                       const double* coefficients,
+                       int numStages,
+                       double* state,
+                       double* vsa,
+                       int stride)
+{
+    int c = 0;
+
+    for (; c + 4 <= numChannels; c += 4)
+    {
+        float* const* group = channels + c;
+        double* groupState = state + c;
+
+        float64x2_t vsaLo = vld1q_f64 (vsa + c);
+        float64x2_t vsaHi = vld1q_f64 (vsa + c + 2);
+
+        int n = 0;
+
+        for (; n + 4 <= numSamples; n += 4)
+        {
+            float32x4_t r[4];
+
+            for (int i = 0; i < 4; ++i)
+                r[i] = vld1q_f32 (group[i] + n);
+
+            transpose4x4 (r);
+
+            for (int j = 0; j < 4; ++j)
+            {
+                vsaLo = vnegq_f64 (vsaLo);
+                vsaHi = vnegq_f64 (vsaHi);
+
+                float64x2_t lo = vcvt_f64_f32 (vget_low_f32 (r[j]));
+                float64x2_t hi = vcvt_high_f64_f32 (r[j]);
+
+                processStagesNEON (lo, hi, vsaLo, vsaHi, coefficients, numStages, groupState, stride);
+
+                r[j] = vcvt_high_f32_f64 (vcvt_f32_f64 (lo), hi);
+            }
+
+            transpose4x4 (r);
+
+            for (int i = 0; i < 4; ++i)
+                vst1q_f32 (group[i] + n, r[i]);
+        }
+
+        vst1q_f64 (vsa + c, vsaLo);
+        vst1q_f64 (vsa + c + 2, vsaHi);
+
+        processScalar (n, numSamples, group, 4, coefficients, numStages, groupState, vsa + c, stride);
+    }
+
+    processScalar (0, numSamples, channels + c, numChannels - c, coefficients, numStages, state + c, vsa + c, stride);
+}
+
+#endif // DSP_KERNELS_NEON
+
+const KernelSet<FloatKernel>& getKernels()
+{
+    static const KernelSet<FloatKernel> kernels { { KernelType::Scalar, processFloatScalar },
+#if DSP_KERNELS_SSE2
+                                                  { KernelType::SSE2, processFloatSSE2 },
+                                                  { KernelType::AVX2, processFloatAVX2 },
+#endif
+#if DSP_KERNELS_NEON
+                                                  { KernelType::NEON, processFloatNEON },
+#endif
+    };
+
+    return kernels;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+
+MultichannelCascade::MultichannelCascade()
+    : m_numChannels (0), m_numStages (0)
+{
+}
+
+void MultichannelCascade::setNumChannels (int numChannels)
+{
+    m_numChannels = numChannels;
+    reset();
+}
+
+void MultichannelCascade::setStages (const Cascade& cascade)
+{
+    const int numStages = cascade.getNumStages();
+
+    m_coefficients.resize (numStages * coefficientsPerStage);
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        const Cascade::Stage& stage = cascade[s];
+        double* k = &m_coefficients[s * coefficientsPerStage];
+
+        k[0] = stage.m_b0;
+        k[1] = stage.m_b1;
+        k[2] = stage.m_b2;
+        k[3] = stage.m_a1;
+        k[4] = stage.m_a2;
+    }
+
+    if (numStages != m_numStages)
+    {
+        m_numStages = numStages;
+        reset();
+    }
+}
+
+void MultichannelCascade::reset()
+{
+    m_state.assign (2 * m_numStages * m_numChannels, 0.0);
+
+    // matches the first value returned by DenormalPrevention::ac()
+    m_vsa.assign (m_numChannels, anti_denormal_vsa);
+}
+
+void MultichannelCascade::process (int numSamples, float* const* arrayOfChannels, int firstChannel, int numChannels)
+{
+    process (getKernels().getSelectedType(), numSamples, arrayOfChannels, firstChannel, numChannels);
+}
+
+void MultichannelCascade::process (KernelType kernel, int numSamples, float* const* arrayOfChannels, int firstChannel, int numChannels)
+{
+    assert (firstChannel >= 0 && firstChannel + numChannels <= m_numChannels);
+
+    if (m_numStages == 0)
+        return;
+
+    getKernels().getOrScalar (kernel) (numSamples,
+                                       arrayOfChannels + firstChannel,
+                                       numChannels,
+                                       m_coefficients.data(),
+                                       m_numStages,
+                                       m_state.data() + firstChannel,
+                                       m_vsa.data() + firstChannel,
+                                       m_numChannels);
+}
+
+void MultichannelCascade::process (int numSamples, double* const* arrayOfChannels, int firstChannel, int numChannels)
+{
+    assert (firstChannel >= 0 && firstChannel + numChannels <= m_numChannels);
+
+    if (m_numStages == 0)
+        return;
+
+    processScalar (0,
+                   numSamples,
+                   arrayOfChannels + firstChannel,
+                   numChannels,
+                   m_coefficients.data(),
+                   m_numStages,
+                   m_state.data() + firstChannel,
+                   m_vsa.data() + firstChannel,
+                   m_numChannels);
+}
+
+bool MultichannelCascade::isKernelSupported (KernelType kernel)
+{
+    return getKernels().isSupported (kernel);
+}
+
+int MultichannelCascade::getChannelsPerGroup()
+{
+    switch (getKernels().getSelectedType())
+    {
+        case KernelType::AVX2:
+            return 8;
+        case KernelType::SSE2:
+        case KernelType::NEON:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+const char* MultichannelCascade::getKernelName()
+{
+    return getKernels().getSelectedName();
+}
+
+} // namespace Dsp
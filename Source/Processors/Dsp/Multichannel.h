@@ -0,0 +1,162 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DSPFILTERS_MULTICHANNEL_H
+#define DSPFILTERS_MULTICHANNEL_H
+
+#include "Cascade.h"
+#include "Common.h"
+#include "Filter.h"
+#include "KernelDispatch.h"
+
+namespace Dsp
+{
+
+/*
+ * Applies one cascade of second order sections to many channels.
+ *
+ * All channels share the same coefficients, so groups of adjacent
+ * channels are filtered in lockstep: 8 channels per group with AVX2,
+ * 4 with SSE2 or NEON. Within a group, blocks of 4 samples are
+ * transposed so that each vector holds the same sample of every channel,
+ * and the state of each stage is stored channel-interleaved.
+ *
+ * Sections are realized in Transposed Direct Form II, and the output is
+ * identical to running a Cascade with TransposedDirectFormII state on each
+ * channel separately (up to floating point contraction on some platforms).
+ *
+ * Float data goes through the vectorized kernels; double data, and the
+ * channels and samples left over after whole groups, are filtered with
+ * scalar code.
+ *
+ */
+class PLUGIN_API MultichannelCascade
+{
+public:
+    MultichannelCascade();
+
+    // Allocates and clears the state for numChannels channels
+    void setNumChannels (int numChannels);
+
+    int getNumChannels() const
+    {
+        return m_numChannels;
+    }
+
+    // Copies the coefficients of every stage of a cascade
+    void setStages (const Cascade& cascade);
+
+    void reset();
+
+    // Filters channels [firstChannel, firstChannel + numChannels) of arrayOfChannels.
+    // Different channel ranges can be processed concurrently from different threads.
+    void process (int numSamples, float* const* arrayOfChannels, int firstChannel, int numChannels);
+    void process (int numSamples, double* const* arrayOfChannels, int firstChannel, int numChannels);
+
+    // Filters float channels with a specific kernel, which must be supported
+    // (used to test each kernel against the scalar one)
+    void process (KernelType kernel, int numSamples, float* const* arrayOfChannels, int firstChannel, int numChannels);
+
+    // Returns true if a kernel is built in and can run on the host CPU
+    static bool isKernelSupported (KernelType kernel);
+
+    // Number of channels filtered together by the selected kernel
+    static int getChannelsPerGroup();
+
+    // Name of the selected kernel ("AVX2", "SSE2", "NEON" or "Scalar")
+    static const char* getKernelName();
+
+private:
+    int m_numChannels;
+    int m_numStages;
+
+    // b0, b1, b2, a1, a2 for each stage (normalized by a0)
+    std::vector<double> m_coefficients;
+
+    // s1 and s2 of each stage, each holding one value per channel
+    std::vector<double> m_state;
+
+    // anti-denormal offset of each channel, which alternates in sign every sample
+    std::vector<double> m_vsa;
+};
+
+//------------------------------------------------------------------------------
+
+/*
+ * A Filter that applies a Design to any number of channels
+ * with a MultichannelCascade.
+ *
+ * Unlike SmoothedFilterDesign, parameter changes take effect
+ * immediately, without interpolation.
+ *
+ */
+template <class DesignClass>
+class MultichannelFilterDesign : public FilterDesignBase<DesignClass>
+{
+public:
+    explicit MultichannelFilterDesign (int numChannels)
+    {
+        m_cascade.setNumChannels (numChannels);
+    }
+
+    int getNumChannels()
+    {
+        return m_cascade.getNumChannels();
+    }
+
+    void reset()
+    {
+        m_cascade.reset();
+    }
+
+    void process (int numSamples, float* const* arrayOfChannels)
+    {
+        m_cascade.process (numSamples, arrayOfChannels, 0, m_cascade.getNumChannels());
+    }
+
+    void process (int numSamples, double* const* arrayOfChannels)
+    {
+        m_cascade.process (numSamples, arrayOfChannels, 0, m_cascade.getNumChannels());
+    }
+
+    // Filters a range of channels only; see MultichannelCascade::process()
+    template <typename Sample>
+    void process (int numSamples, Sample* const* arrayOfChannels, int firstChannel, int numChannels)
+    {
+        m_cascade.process (numSamples, arrayOfChannels, firstChannel, numChannels);
+    }
+
+protected:
+    void doSetParams (const Params& parameters)
+    {
+        FilterDesignBase<DesignClass>::doSetParams (parameters);
+        m_cascade.setStages (this->m_design);
+    }
+
+protected:
+    MultichannelCascade m_cascade;
+};
+
+} // namespace Dsp
+
+#endif
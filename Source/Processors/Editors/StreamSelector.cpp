@@ -244,6 +244,11 @@ String StreamTableModel::getCellTooltip (int rowNumber, int columnId)
     {
         return streams[rowNumber]->getName();
     }
+    else if (columnId == StreamTableModel::Columns::SYNC_ACCURACY)
+    {
+        if (SyncAccuracyMonitor* monitor = owner->getSyncAccuracyMonitor (streams[rowNumber]))
+            return monitor->getStatisticsText();
+    }
 
     return String();
 }
@@ -25,6 +25,7 @@
 #include "EventTranslatorEditor.h"
 
 EventTranslatorSettings::EventTranslatorSettings()
+    : syncStream (-1)
 {
 }
 
@@ -93,7 +94,7 @@ void EventTranslator::updateSettings()
 
         TtlLineParameter* syncLineParam = static_cast<TtlLineParameter*> (stream->getParameter ("sync_line"));
         int syncLine = syncLineParam->getSelectedLine();
-        synchronizer.addDataStream (stream->getKey(), stream->getSampleRate(), syncLine, stream->generatesTimestamps());
+        settings[streamId]->syncStream = synchronizer.addDataStream (stream->getKey(), stream->getSampleRate(), syncLine, stream->generatesTimestamps());
 
         EventChannel::Settings s {
             EventChannel::Type::TTL,
@@ -227,40 +228,40 @@ void EventTranslator::process (AudioBuffer<float>& buffer)
 void EventTranslator::handleTTLEvent (TTLEventPtr event)
 {
     const uint16 eventStream = event->getStreamId();
-    const String eventStreamKey = getDataStream (eventStream)->getKey();
+    const int eventSyncStream = settings[eventStream]->syncStream;
     const int ttlLine = event->getLine();
     const int64 sampleNumber = event->getSampleNumber();
     const bool state = event->getState();
 
-    if (synchronizer.getSyncLine (eventStreamKey) == ttlLine)
+    if (synchronizer.getSyncLine (eventSyncStream) == ttlLine)
     {
-        synchronizer.addEvent (eventStreamKey, ttlLine, sampleNumber, state);
+        synchronizer.addEvent (eventSyncStream, ttlLine, sampleNumber, state);
 
         return;
     }
 
-    if (eventStreamKey == synchronizer.mainStreamKey && synchronizer.isStreamSynced (eventStreamKey))
+    if (eventSyncStream == synchronizer.getMainStreamHandle() && synchronizer.isStreamSynced (eventSyncStream))
     {
         //std::cout << "TRANSLATE!" << std::endl;
 
         const bool state = event->getState();
 
-        double timestamp = synchronizer.convertSampleNumberToTimestamp (eventStreamKey, sampleNumber);
+        double timestamp = synchronizer.convertSampleNumberToTimestamp (eventSyncStream, sampleNumber);
 
         for (auto stream : getDataStreams())
         {
             const uint16 streamId = stream->getStreamId();
-            const String streamKey = stream->getKey();
+            const int syncStream = settings[streamId]->syncStream;
 
-            if (streamKey == eventStreamKey)
+            if (syncStream == eventSyncStream)
                 continue; // don't translate events back to the main stream
 
-            if (synchronizer.isStreamSynced (streamKey) && ! synchronizer.streamGeneratesTimestamps (streamKey))
+            if (synchronizer.isStreamSynced (syncStream) && ! synchronizer.streamGeneratesTimestamps (syncStream))
             {
                 // std::cout << "original sample number: " << sampleNumber << std::endl;
                 //std::cout << "original timestamp: " << timestamp << std::endl;
 
-                int64 newSampleNumber = synchronizer.convertTimestampToSampleNumber (streamKey, timestamp);
+                int64 newSampleNumber = synchronizer.convertTimestampToSampleNumber (syncStream, timestamp);
 
                 // std::cout << "new sample number (" << streamId << "): " << newSampleNumber << std::endl;
 
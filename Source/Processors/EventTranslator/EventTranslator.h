@@ -43,6 +43,9 @@ public:
     TTLEventPtr createEvent (int64 sample_number, double timestamp, int line, bool state);
 
     EventChannel* eventChannel;
+
+    /** Handle of this stream in the synchronizer */
+    int syncStream;
 };
 
 /**
@@ -204,18 +204,37 @@ size_t SystemEvent::fillTimestampAndSamplesData (HeapBlock<char>& data,
                                                  int64 processStartTime,
                                                  uint16 syncStreamId)
 {
-    const int eventSize = EVENT_BASE_SIZE + 4 + 8;
-    data.malloc (eventSize);
+    data.malloc (TIMESTAMP_AND_SAMPLES_SIZE);
+
+    return fillTimestampAndSamplesData (data.getData(),
+                                        proc,
+                                        streamId,
+                                        startSampleForBlock,
+                                        startTimestampForBlock,
+                                        nSamplesInBlock,
+                                        processStartTime,
+                                        syncStreamId);
+}
+
+size_t SystemEvent::fillTimestampAndSamplesData (char* data,
+                                                 const GenericProcessor* proc,
+                                                 uint16 streamId,
+                                                 int64 startSampleForBlock,
+                                                 double startTimestampForBlock,
+                                                 uint32 nSamplesInBlock,
+                                                 int64 processStartTime,
+                                                 uint16 syncStreamId)
+{
     data[0] = SYSTEM_EVENT; // 1 byte
     data[1] = TIMESTAMP_AND_SAMPLES; // 1 byte
-    *reinterpret_cast<uint16*> (data.getData() + 2) = proc->getNodeId(); // 2 bytes
-    *reinterpret_cast<uint16*> (data.getData() + 4) = streamId; // 2 bytes
-    *reinterpret_cast<uint16*> (data.getData() + 6) = syncStreamId; // 2 bytes
-    *reinterpret_cast<int64*> (data.getData() + 8) = startSampleForBlock; // 8 bytes
-    *reinterpret_cast<double*> (data.getData() + 16) = startTimestampForBlock; // 8 bytes
-    *reinterpret_cast<uint32*> (data.getData() + EVENT_BASE_SIZE) = nSamplesInBlock; // 8 bytes
-    *reinterpret_cast<int64*> (data.getData() + EVENT_BASE_SIZE + 4) = processStartTime; // 8 bytes
-    return eventSize;
+    *reinterpret_cast<uint16*> (data + 2) = proc->getNodeId(); // 2 bytes
+    *reinterpret_cast<uint16*> (data + 4) = streamId; // 2 bytes
+    *reinterpret_cast<uint16*> (data + 6) = syncStreamId; // 2 bytes
+    *reinterpret_cast<int64*> (data + 8) = startSampleForBlock; // 8 bytes
+    *reinterpret_cast<double*> (data + 16) = startTimestampForBlock; // 8 bytes
+    *reinterpret_cast<uint32*> (data + EVENT_BASE_SIZE) = nSamplesInBlock; // 8 bytes
+    *reinterpret_cast<int64*> (data + EVENT_BASE_SIZE + 4) = processStartTime; // 8 bytes
+    return TIMESTAMP_AND_SAMPLES_SIZE;
 }
 
 size_t SystemEvent::fillTimestampSyncTextData (
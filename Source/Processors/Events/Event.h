@@ -29,6 +29,9 @@
 
 #define EVENT_BASE_SIZE 24
 
+/** Size of a serialized TIMESTAMP_AND_SAMPLES system event */
+#define TIMESTAMP_AND_SAMPLES_SIZE (EVENT_BASE_SIZE + 4 + 8)
+
 typedef MidiMessage EventPacket;
 
 class GenericProcessor;
@@ -233,6 +236,16 @@ public:
                                                int64 processStartTime,
                                                uint16 syncStreamId = 0);
 
+    /* Write a TIMESTAMP_AND_SAMPLES event into a buffer of TIMESTAMP_AND_SAMPLES_SIZE bytes */
+    static size_t fillTimestampAndSamplesData (char* data,
+                                               const GenericProcessor* proc,
+                                               uint16 streamId,
+                                               int64 startSampleForBlock,
+                                               double timestamp,
+                                               uint32 nSamplesInBlock,
+                                               int64 processStartTime,
+                                               uint16 syncStreamId = 0);
+
     /* Create a TIMESTAMP_SYNC_TEXT event (used by Record Node) */
     static size_t fillTimestampSyncTextData (HeapBlock<char>& data,
                                              const GenericProcessor* proc,
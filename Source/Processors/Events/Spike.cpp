@@ -107,9 +107,9 @@ void Spike::serialize (void* destinationBuffer, size_t bufferSize) const
     *(reinterpret_cast<uint16*> (buffer + 2)) = spikeChannel->getSourceNodeId();
     *(reinterpret_cast<uint16*> (buffer + 4)) = spikeChannel->getStreamId();
     *(reinterpret_cast<uint16*> (buffer + 6)) = spikeChannel->getLocalIndex();
-    *(reinterpret_cast<juce::int64*> (buffer + 8)) = m_sampleNumber;
-    *(reinterpret_cast<double*> (buffer + 16)) = m_timestamp;
-    *(reinterpret_cast<uint16*> (buffer + 24)) = m_sortedID;
+    *(reinterpret_cast<juce::int64*> (buffer + SPIKE_SAMPLE_NUMBER_OFFSET)) = m_sampleNumber;
+    *(reinterpret_cast<double*> (buffer + SPIKE_TIMESTAMP_OFFSET)) = m_timestamp;
+    *(reinterpret_cast<uint16*> (buffer + SPIKE_SORTED_ID_OFFSET)) = m_sortedID;
 
     int memIdx = SPIKE_BASE_SIZE;
 
@@ -223,7 +223,7 @@ void Spike::setSortedId (uint16 sortedId)
 {
     uint8* modifiableBuffer = const_cast<uint8*> (buffer);
 
-    *(reinterpret_cast<uint16*> (modifiableBuffer + 24)) = sortedId;
+    *(reinterpret_cast<uint16*> (modifiableBuffer + SPIKE_SORTED_ID_OFFSET)) = sortedId;
 }
 
 void Spike::setTimestampInSeconds (double timestamp)
@@ -267,9 +267,9 @@ SpikePtr Spike::deserialize (const uint8* buffer, const SpikeChannel* channelInf
         return nullptr;
     }
 
-    int64 sampleNumber = *(reinterpret_cast<const int64*> (buffer + 8));
-    double timestamp = *(reinterpret_cast<const double*> (buffer + 16));
-    uint16 sortedID = *(reinterpret_cast<const uint16*> (buffer + 24));
+    int64 sampleNumber = *(reinterpret_cast<const int64*> (buffer + SPIKE_SAMPLE_NUMBER_OFFSET));
+    double timestamp = *(reinterpret_cast<const double*> (buffer + SPIKE_TIMESTAMP_OFFSET));
+    uint16 sortedID = *(reinterpret_cast<const uint16*> (buffer + SPIKE_SORTED_ID_OFFSET));
     Array<float> thresholds;
     thresholds.addArray (reinterpret_cast<const float*> (buffer + SPIKE_BASE_SIZE), nChans);
     HeapBlock<float> data;
@@ -292,6 +292,11 @@ SpikePtr Spike::deserialize (const uint8* buffer, const SpikeChannel* channelInf
     }
 }
 
+SpikePtr Spike::deserialize (const View& view)
+{
+    return deserialize (view.getRawData(), view.getChannelInfo());
+}
+
 SpikePtr Spike::deserialize (const EventPacket& packet, const SpikeChannel* channelInfo)
 {
     if (channelInfo->getChannelType() == SpikeChannel::INVALID)
@@ -386,3 +391,140 @@ const float* Spike::Buffer::getRawPointer()
     }
     return m_data.getData();
 }
+
+Spike::Packet::Packet (const SpikeChannel* channelInfo)
+    : spikeChannel (channelInfo),
+      m_nChans (channelInfo->getNumChannels()),
+      m_nSamps (channelInfo->getTotalSamples()),
+      m_size (SPIKE_BASE_SIZE + channelInfo->getNumChannels() * sizeof (float) + channelInfo->getDataSize())
+{
+    // metadata values cannot be written in place
+    jassert (channelInfo->getEventMetadataCount() == 0);
+
+    m_data.calloc (m_size);
+    setHeader (0);
+}
+
+void Spike::Packet::setHeader (int64 sampleNumber, uint16 sortedID, double timestamp)
+{
+    uint8* buffer = m_data.getData();
+
+    // same layout as Spike::serialize()
+    *(buffer + 0) = SPIKE_EVENT;
+    *(buffer + 1) = static_cast<uint8> (spikeChannel->getChannelType());
+    writeUnaligned<uint16> (buffer + 2, spikeChannel->getSourceNodeId());
+    writeUnaligned<uint16> (buffer + 4, spikeChannel->getStreamId());
+    writeUnaligned<uint16> (buffer + 6, spikeChannel->getLocalIndex());
+    writeUnaligned<int64> (buffer + SPIKE_SAMPLE_NUMBER_OFFSET, sampleNumber);
+    writeUnaligned<double> (buffer + SPIKE_TIMESTAMP_OFFSET, timestamp);
+    writeUnaligned<uint16> (buffer + SPIKE_SORTED_ID_OFFSET, sortedID);
+}
+
+void Spike::Packet::setThreshold (const int chan, const float threshold)
+{
+    jassert (chan >= 0 && chan < m_nChans);
+
+    // the thresholds start at an odd offset, so they are never aligned
+    writeUnaligned<float> (m_data.getData() + SPIKE_BASE_SIZE + chan * sizeof (float), threshold);
+}
+
+void Spike::Packet::set (const int chan, const int samp, const float value)
+{
+    jassert (chan >= 0 && samp >= 0 && chan < m_nChans && samp < m_nSamps);
+
+    const size_t index = size_t (samp + chan * m_nSamps);
+    writeUnaligned<float> (m_data.getData() + SPIKE_BASE_SIZE + (m_nChans + index) * sizeof (float), value);
+}
+
+const uint8* Spike::Packet::getRawData() const
+{
+    return m_data.getData();
+}
+
+size_t Spike::Packet::getSize() const
+{
+    return m_size;
+}
+
+Spike::View::View (const uint8* data, const SpikeChannel* channelInfo)
+    : m_data (data),
+      m_channel (channelInfo)
+{
+}
+
+bool Spike::View::isValid() const
+{
+    return m_data != nullptr
+           && m_channel != nullptr
+           && m_channel->getChannelType() != SpikeChannel::INVALID
+           && static_cast<Event::Type> (*(m_data)) == SPIKE_EVENT
+           && static_cast<SpikeChannel::Type> (*(m_data + 1)) == m_channel->getChannelType()
+           && readUnaligned<uint16> (m_data + 2) == m_channel->getSourceNodeId()
+           && readUnaligned<uint16> (m_data + 4) == m_channel->getStreamId()
+           && readUnaligned<uint16> (m_data + 6) == m_channel->getLocalIndex();
+}
+
+const SpikeChannel* Spike::View::getChannelInfo() const
+{
+    return m_channel;
+}
+
+int64 Spike::View::getSampleNumber() const
+{
+    return readUnaligned<int64> (m_data + SPIKE_SAMPLE_NUMBER_OFFSET);
+}
+
+double Spike::View::getTimestampInSeconds() const
+{
+    return readUnaligned<double> (m_data + SPIKE_TIMESTAMP_OFFSET);
+}
+
+uint16 Spike::View::getSortedId() const
+{
+    return readUnaligned<uint16> (m_data + SPIKE_SORTED_ID_OFFSET);
+}
+
+float Spike::View::getThreshold (int chan) const
+{
+    jassert (chan >= 0 && chan < int (m_channel->getNumChannels()));
+    return readUnaligned<float> (m_data + SPIKE_BASE_SIZE + chan * sizeof (float));
+}
+
+float Spike::View::getSample (int chan, int samp) const
+{
+    const int numChannels = int (m_channel->getNumChannels());
+    const int numSamples = int (m_channel->getTotalSamples());
+
+    jassert (chan >= 0 && samp >= 0 && chan < numChannels && samp < numSamples);
+
+    const size_t index = size_t (samp + chan * numSamples);
+    return readUnaligned<float> (m_data + SPIKE_BASE_SIZE + (numChannels + index) * sizeof (float));
+}
+
+void Spike::View::copyChannelData (int chan, float* destination) const
+{
+    const int numChannels = int (m_channel->getNumChannels());
+    const int numSamples = int (m_channel->getTotalSamples());
+
+    if ((chan < 0) || (chan >= numChannels))
+    {
+        jassertfalse;
+        return;
+    }
+
+    const size_t offset = SPIKE_BASE_SIZE + (numChannels + size_t (chan * numSamples)) * sizeof (float);
+    memcpy (destination, m_data + offset, numSamples * sizeof (float));
+}
+
+const uint8* Spike::View::getRawData() const
+{
+    return m_data;
+}
+
+size_t Spike::View::getSize() const
+{
+    return SPIKE_BASE_SIZE
+           + m_channel->getNumChannels() * sizeof (float)
+           + m_channel->getDataSize()
+           + m_channel->getTotalEventMetadataSize();
+}
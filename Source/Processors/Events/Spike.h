@@ -32,6 +32,11 @@
 
 #define SPIKE_BASE_SIZE 26
 
+/** Byte offsets of the header fields of a serialized spike (see the packet structure below) */
+#define SPIKE_SAMPLE_NUMBER_OFFSET 8
+#define SPIKE_TIMESTAMP_OFFSET 16
+#define SPIKE_SORTED_ID_OFFSET 24
+
 class GenericProcessor;
 class Spike;
 
@@ -116,6 +121,83 @@ public:
         bool m_ready { true };
     };
 
+    /**
+    * A serialized spike packet that is written in place.
+    * 
+    * The packet is allocated once for a SpikeChannel (without event metadata)
+    * and can be reused for every spike on that channel, so no memory is
+    * allocated per spike. It holds the same bytes as Spike::serialize().
+    * 
+    * Example:
+    * Spike::Packet packet(spikeChannel);
+    * 
+    * packet.setHeader(sampleNumber);
+    * packet.setThreshold(0, threshold);
+    * packet.set(0, 0, value);
+    * addSpike(packet);
+    * 
+    */
+    class PLUGIN_API Packet
+    {
+    public:
+        Packet (const SpikeChannel* channelInfo);
+
+        /** Writes the event header for a spike on this channel */
+        void setHeader (int64 sampleNumber, uint16 sortedID = 0, double timestamp = -1.0);
+        void setThreshold (const int chan, const float threshold);
+        void set (const int chan, const int samp, const float value);
+
+        const uint8* getRawData() const;
+        size_t getSize() const;
+
+        const SpikeChannel* spikeChannel;
+
+    private:
+        Packet() = delete;
+        HeapBlock<uint8> m_data;
+        const int m_nChans;
+        const int m_nSamps;
+        const size_t m_size;
+    };
+
+    /**
+    * A read-only view of a serialized spike, such as a packet in an event buffer.
+    * 
+    * Nothing is copied or allocated, so the view is only valid as long as the
+    * underlying bytes are. Packets in an event buffer are not necessarily
+    * aligned, so values are read byte-wise rather than through typed pointers.
+    * 
+    */
+    class PLUGIN_API View
+    {
+    public:
+        View (const uint8* data, const SpikeChannel* channelInfo);
+
+        /** Returns true if the packet header matches the SpikeChannel */
+        bool isValid() const;
+
+        const SpikeChannel* getChannelInfo() const;
+        int64 getSampleNumber() const;
+        double getTimestampInSeconds() const;
+        uint16 getSortedId() const;
+        float getThreshold (int chan) const;
+
+        /** Returns one sample of one channel */
+        float getSample (int chan, int samp) const;
+
+        /** Copies the samples of one channel into destination, which must hold
+            getTotalSamples() values of the SpikeChannel */
+        void copyChannelData (int chan, float* destination) const;
+
+        const uint8* getRawData() const;
+        size_t getSize() const;
+
+    private:
+        View() = delete;
+        const uint8* m_data;
+        const SpikeChannel* m_channel;
+    };
+
     /* Copy constructor*/
     Spike (const Spike& other);
 
@@ -176,6 +258,9 @@ public:
     /* Deserialize a Spike object from a raw byte buffer*/
     static SpikePtr deserialize (const uint8* buffer, const SpikeChannel* channelInfo);
 
+    /* Deserialize a Spike object from a view of a serialized spike*/
+    static SpikePtr deserialize (const View& view);
+
     /* The SpikeChannel object associated with this spike */
     const SpikeChannel* spikeChannel;
 
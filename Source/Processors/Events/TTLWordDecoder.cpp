@@ -0,0 +1,174 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "TTLWordDecoder.h"
+
+namespace
+{
+typedef int (*SearchKernel) (const uint64*, int, int, uint64);
+
+#if DSP_KERNELS_SSE2
+
+/** Compares 4 words per iteration; SSE2 has no 64-bit compare, so a word
+    is unchanged only if both of its 32-bit halves are */
+int findNextChangeSSE2 (const uint64* words, int startSample, int numSamples, uint64 previousWord)
+{
+    const __m128i target = _mm_set1_epi64x ((long long) previousWord);
+
+    int i = startSample;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        __m128i equalA = _mm_cmpeq_epi32 (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (words + i)), target);
+        __m128i equalB = _mm_cmpeq_epi32 (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (words + i + 2)), target);
+
+        equalA = _mm_and_si128 (equalA, _mm_shuffle_epi32 (equalA, _MM_SHUFFLE (2, 3, 0, 1)));
+        equalB = _mm_and_si128 (equalB, _mm_shuffle_epi32 (equalB, _MM_SHUFFLE (2, 3, 0, 1)));
+
+        const int mask = _mm_movemask_pd (_mm_castsi128_pd (equalA))
+                         | (_mm_movemask_pd (_mm_castsi128_pd (equalB)) << 2);
+
+        if (mask != 0xF)
+            return TTLWordDecoder::findNextChangeScalar (words, i, i + 4, previousWord);
+    }
+
+    return TTLWordDecoder::findNextChangeScalar (words, i, numSamples, previousWord);
+}
+
+/** Compares 8 words per iteration */
+DSP_KERNELS_AVX2_TARGET int findNextChangeAVX2 (const uint64* words, int startSample, int numSamples, uint64 previousWord)
+{
+    const __m256i target = _mm256_set1_epi64x ((long long) previousWord);
+
+    int i = startSample;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const __m256i equalA = _mm256_cmpeq_epi64 (_mm256_loadu_si256 (reinterpret_cast<const __m256i*> (words + i)), target);
+        const __m256i equalB = _mm256_cmpeq_epi64 (_mm256_loadu_si256 (reinterpret_cast<const __m256i*> (words + i + 4)), target);
+
+        const int mask = _mm256_movemask_pd (_mm256_castsi256_pd (equalA))
+                         | (_mm256_movemask_pd (_mm256_castsi256_pd (equalB)) << 4);
+
+        if (mask != 0xFF)
+            return TTLWordDecoder::findNextChangeScalar (words, i, i + 8, previousWord);
+    }
+
+    return TTLWordDecoder::findNextChangeScalar (words, i, numSamples, previousWord);
+}
+
+#endif // DSP_KERNELS_SSE2
+
+#if DSP_KERNELS_NEON
+
+/** Compares 4 words per iteration */
+int findNextChangeNEON (const uint64* words, int startSample, int numSamples, uint64 previousWord)
+{
+    const uint64x2_t target = vdupq_n_u64 (previousWord);
+
+    int i = startSample;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const uint64x2_t equal = vandq_u64 (vceqq_u64 (vld1q_u64 (words + i), target),
+                                            vceqq_u64 (vld1q_u64 (words + i + 2), target));
+
+        if ((vgetq_lane_u64 (equal, 0) & vgetq_lane_u64 (equal, 1)) != ~0ULL)
+            return TTLWordDecoder::findNextChangeScalar (words, i, i + 4, previousWord);
+    }
+
+    return TTLWordDecoder::findNextChangeScalar (words, i, numSamples, previousWord);
+}
+
+#endif // DSP_KERNELS_NEON
+
+const Dsp::KernelSet<SearchKernel>& getKernels()
+{
+    static const Dsp::KernelSet<SearchKernel> kernels { { TTLWordDecoder::Kernel::Scalar, TTLWordDecoder::findNextChangeScalar },
+#if DSP_KERNELS_SSE2
+                                                        { TTLWordDecoder::Kernel::SSE2, findNextChangeSSE2 },
+                                                        { TTLWordDecoder::Kernel::AVX2, findNextChangeAVX2 },
+#endif
+#if DSP_KERNELS_NEON
+                                                        { TTLWordDecoder::Kernel::NEON, findNextChangeNEON },
+#endif
+    };
+
+    return kernels;
+}
+} // namespace
+
+int TTLWordDecoder::findNextChange (const uint64* words, int startSample, int numSamples, uint64 previousWord)
+{
+    return getKernels().getSelected() (words, startSample, numSamples, previousWord);
+}
+
+int TTLWordDecoder::findNextChangeScalar (const uint64* words, int startSample, int numSamples, uint64 previousWord)
+{
+    for (int i = startSample; i < numSamples; i++)
+    {
+        if (words[i] != previousWord)
+            return i;
+    }
+
+    return numSamples;
+}
+
+bool TTLWordDecoder::isKernelSupported (Kernel kernel)
+{
+    return getKernels().isSupported (kernel);
+}
+
+int TTLWordDecoder::findNextChange (Kernel kernel, const uint64* words, int startSample, int numSamples, uint64 previousWord)
+{
+    return getKernels().getOrScalar (kernel) (words, startSample, numSamples, previousWord);
+}
+
+String TTLWordDecoder::getKernelName()
+{
+    return getKernels().getSelectedName();
+}
+
+void TTLWordDecoder::writePacket (uint8* destination,
+                                  const EventChannel* channel,
+                                  int64 sampleNumber,
+                                  int line,
+                                  bool state,
+                                  uint64 word)
+{
+    jassert (channel->getDataSize() + EVENT_BASE_SIZE == TTL_PACKET_SIZE);
+
+    // same layout as Event::serializeHeader() + TTLEvent::serialize()
+    destination[0] = EventBase::PROCESSOR_EVENT;
+    destination[1] = uint8 (EventChannel::TTL);
+    *reinterpret_cast<uint16*> (destination + 2) = channel->getSourceNodeId();
+    *reinterpret_cast<uint16*> (destination + 4) = channel->getStreamId();
+    *reinterpret_cast<uint16*> (destination + 6) = channel->getLocalIndex();
+    *reinterpret_cast<int64*> (destination + 8) = sampleNumber;
+    *reinterpret_cast<double*> (destination + 16) = -1.0;
+
+    destination[EVENT_BASE_SIZE] = uint8 (line);
+    destination[EVENT_BASE_SIZE + 1] = state ? 1 : 0;
+    memcpy (destination + EVENT_BASE_SIZE + 2, &word, sizeof (uint64));
+}
@@ -0,0 +1,133 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef TTLWORDDECODER_H_INCLUDED
+#define TTLWORDDECODER_H_INCLUDED
+
+#include <JuceHeader.h>
+
+#include "../../TestableExport.h"
+#include "../Dsp/KernelDispatch.h"
+#include "../Settings/EventChannel.h"
+#include "Event.h"
+
+#if JUCE_MSVC
+#include <intrin.h>
+#endif
+
+/** Size of a serialized TTL event packet (without metadata) */
+#define TTL_PACKET_SIZE (EVENT_BASE_SIZE + 10)
+
+/**
+ *
+ * Converts per-sample TTL words into TTL event packets.
+ *
+ * Changed samples are located with a vectorized comparison of the words
+ * (SSE2 / AVX2 / NEON, depending on the CPU), and the lines that changed
+ * are extracted from the XOR of consecutive words. Packets are serialized
+ * straight into a MidiBuffer, producing the same bytes as TTLEvent::serialize()
+ * without allocating a TTLEvent for each line.
+ *
+ * */
+class TESTABLE TTLWordDecoder
+{
+public:
+    /** The available search kernels */
+    using Kernel = Dsp::KernelType;
+
+    /** Returns the index of the first sample in [startSample, numSamples) whose
+        word differs from previousWord, or numSamples if there is none */
+    static int findNextChange (const uint64* words, int startSample, int numSamples, uint64 previousWord);
+
+    /** Scalar version of findNextChange (used for the remainder of a block and for testing) */
+    static int findNextChangeScalar (const uint64* words, int startSample, int numSamples, uint64 previousWord);
+
+    /** Returns true if a kernel was built in and can run on the host CPU */
+    static bool isKernelSupported (Kernel kernel);
+
+    /** Searches with a specific kernel, which must be supported (used to test each kernel against the scalar one) */
+    static int findNextChange (Kernel kernel, const uint64* words, int startSample, int numSamples, uint64 previousWord);
+
+    /** Returns the name of the kernel used by findNextChange ("AVX2", "SSE2", "NEON" or "Scalar") */
+    static String getKernelName();
+
+    /** Writes a TTL event packet (header + data) for a channel without metadata.
+        The destination must hold TTL_PACKET_SIZE bytes. */
+    static void writePacket (uint8* destination,
+                             const EventChannel* channel,
+                             int64 sampleNumber,
+                             int line,
+                             bool state,
+                             uint64 word);
+
+    /** Adds a packet to buffer for each line that differs between oldWord and newWord,
+        in order of increasing line number, and calls lineChanged (line, state) for each one.
+
+        Returns the number of packets added. */
+    template <typename Callback>
+    static int addLineChanges (MidiBuffer& buffer,
+                               const EventChannel* channel,
+                               int64 sampleNumber,
+                               int sampleIndex,
+                               uint64 oldWord,
+                               uint64 newWord,
+                               Callback&& lineChanged)
+    {
+        uint8 packet[TTL_PACKET_SIZE];
+
+        uint64 changedLines = oldWord ^ newWord;
+        int numPackets = 0;
+
+        while (changedLines != 0)
+        {
+            const int line = countTrailingZeros (changedLines);
+            const bool state = ((newWord >> line) & 1) != 0;
+
+            writePacket (packet, channel, sampleNumber, line, state, newWord);
+            buffer.addEvent (packet, TTL_PACKET_SIZE, sampleIndex);
+
+            lineChanged (line, state);
+
+            changedLines &= changedLines - 1;
+            numPackets++;
+        }
+
+        return numPackets;
+    }
+
+private:
+    /** Returns the index of the lowest set bit (value must not be 0) */
+    static int countTrailingZeros (uint64 value)
+    {
+#if JUCE_MSVC
+        unsigned long index;
+        _BitScanForward64 (&index, value);
+        return int (index);
+#else
+        return __builtin_ctzll (value);
+#endif
+    }
+};
+
+#endif // TTLWORDDECODER_H_INCLUDED
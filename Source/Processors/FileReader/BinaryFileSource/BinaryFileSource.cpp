@@ -27,7 +27,9 @@ using namespace BinarySource;
 
 BinaryFileSource::BinaryFileSource()
     : m_samplePos (0),
-      hasEventData (false)
+      hasEventData (false),
+      m_messageEvents (nullptr),
+      m_messageEventCursor (0)
 {
 }
 
@@ -103,6 +105,7 @@ void BinaryFileSource::fillRecordInfo()
     Identifier idChannelName ("channel_name");
     Identifier idBitVolts ("bit_volts");
     Identifier idType ("type");
+    Identifier idCompression ("compression");
 
     int numProcessors = continuousData.size();
 
@@ -123,12 +126,37 @@ void BinaryFileSource::fillRecordInfo()
         String streamName = record[idFolder];
         streamName = streamName.trimCharactersAtEnd ("/");
 
-        File dataFile = m_rootPath.getChildFile ("continuous").getChildFile (streamName).getChildFile ("continuous.dat");
-        if (! dataFile.existsAsFile())
-            continue;
+        File streamFolder = m_rootPath.getChildFile ("continuous").getChildFile (streamName);
+        File dataFile = streamFolder.getChildFile ("continuous.dat");
 
         int numChannels = record[idNumChannels];
-        int64 numSamples = (dataFile.getSize() / numChannels) / sizeof (int16);
+        int64 numSamples;
+
+        auto reader = std::make_unique<StreamReader>();
+        reader->numChannels = numChannels;
+
+        var compression = record[idCompression];
+
+        if (compression.isObject())
+        {
+            dataFile = streamFolder.getChildFile (compression["data_file"].toString());
+            File indexFile = streamFolder.getChildFile (compression["index_file"].toString());
+
+            reader->compressedReader = std::make_unique<CompressedStreamReader>();
+
+            if (! reader->compressedReader->open (dataFile, indexFile, numChannels))
+                continue;
+
+            numSamples = reader->compressedReader->getNumSamples();
+        }
+        else
+        {
+            if (! dataFile.existsAsFile())
+                continue;
+
+            numSamples = (dataFile.getSize() / numChannels) / sizeof (int16);
+            reader->dataFile = std::make_unique<MemoryMappedFile> (dataFile, MemoryMappedFile::readOnly);
+        }
 
         info.name = streamName;
         info.sampleRate = record[idSampleRate];
@@ -160,12 +188,14 @@ void BinaryFileSource::fillRecordInfo()
             cInfo.type = static_cast<uint8>(int(chan[idType]));
 
             info.channels.add (cInfo);
+            reader->bitVolts.add (cInfo.bitVolts);
         }
 
         infoArray.add (info);
         numRecords++;
 
         m_dataFileArray.add (dataFile);
+        m_streamReaders.add (reader.release());
     }
 
     if (hasEventData)
@@ -226,7 +256,8 @@ void BinaryFileSource::fillRecordInfo()
                     eventInfo.sampleNumbers.push_back (*snData - startSampleNumbers[streamName]);
                     eventInfo.text.push_back ("");
                 }
-                eventInfoMap[streamName] = eventInfo;
+                eventInfo.sortBySampleNumber();
+                eventInfoMap[streamName] = std::move (eventInfo);
             }
             else if (streamName.equalsIgnoreCase ("MessageCenter"))
             {
@@ -264,52 +295,81 @@ void BinaryFileSource::fillRecordInfo()
                     eventInfo.sampleNumbers.push_back (*snData - startSampleNumber);
                     eventInfo.text.push_back (outString);
                 }
-                eventInfoMap[streamName] = eventInfo;
+                eventInfo.sortBySampleNumber();
+                eventInfoMap[streamName] = std::move (eventInfo);
             }
         }
     }
+
+    for (int i = 0; i < m_streamReaders.size(); i++)
+    {
+        auto events = eventInfoMap.find (m_dataFileArray[i].getParentDirectory().getFileName());
+
+        if (events != eventInfoMap.end())
+            m_streamReaders[i]->events = &events->second;
+    }
+
+    auto messageEvents = eventInfoMap.find ("MessageCenter");
+
+    if (messageEvents != eventInfoMap.end())
+        m_messageEvents = &messageEvents->second;
 }
 
 void BinaryFileSource::processEventData (EventInfo& eventInfo, int64 start, int64 stop)
 {
-    int64 local_start = start % getActiveNumSamples();
-    int64 local_stop = stop % getActiveNumSamples();
+    processRecordEventData (getActiveRecord(), eventInfo, start, stop);
+}
 
-    std::vector<String> includeStreams = { currentStream, "MessageCenter" };
+void BinaryFileSource::processRecordEventData (int recordIndex, EventInfo& eventInfo, int64 start, int64 stop)
+{
+    StreamReader* reader = m_streamReaders[recordIndex];
 
-    for (int s = 0; s < includeStreams.size(); s++)
-    {
-        EventInfo info = eventInfoMap[includeStreams[s]];
+    if (reader == nullptr)
+        return;
 
-        int i = 0;
+    int64 local_start = start % getRecordNumSamples (recordIndex);
+    int64 local_stop = stop % getRecordNumSamples (recordIndex);
 
-        while (i < info.sampleNumbers.size())
-        {
-            if (info.sampleNumbers[i] >= local_start && info.sampleNumbers[i] < local_stop)
-            {
-                eventInfo.channels.push_back (info.channels[i] - 1);
-                eventInfo.channelStates.push_back ((info.channelStates[i]));
-                eventInfo.sampleNumbers.push_back (info.sampleNumbers[i]);
-                eventInfo.text.push_back (info.text[i]);
-            }
-            i++;
-        }
+    addEventsInRange (reader->events, reader->eventCursor, eventInfo, local_start, local_stop);
+
+    if (recordIndex == getActiveRecord())
+        addEventsInRange (m_messageEvents, m_messageEventCursor, eventInfo, local_start, local_stop);
+}
+
+void BinaryFileSource::addEventsInRange (const EventInfo* source, size_t& cursor, EventInfo& dest, int64 start, int64 stop)
+{
+    if (source == nullptr)
+        return;
+
+    const std::vector<int64>& sampleNumbers = source->sampleNumbers;
+    const size_t numEvents = sampleNumbers.size();
+
+    // the cursor is still valid if it points to the first event at or after start
+    // (always true during continuous playback); otherwise (after a seek or a loop) search for it
+    const bool cursorIsValid = cursor <= numEvents
+                               && (cursor == 0 || sampleNumbers[cursor - 1] < start)
+                               && (cursor == numEvents || sampleNumbers[cursor] >= start);
+
+    if (! cursorIsValid)
+        cursor = source->findFirstEvent (start);
+
+    while (cursor < numEvents && sampleNumbers[cursor] < stop)
+    {
+        dest.append (*source, cursor, -1);
+        cursor++;
     }
 }
 
 void BinaryFileSource::updateActiveRecord (int index)
 {
-    m_dataFile.reset();
-    m_dataFile = std::make_unique<MemoryMappedFile> (m_dataFileArray[index], MemoryMappedFile::readOnly);
     m_samplePos = 0;
-    numActiveChannels = getActiveNumChannels();
 
-    bitVolts.clear();
+    currentStream = m_dataFileArray[index].getParentDirectory().getFileName();
 
-    for (int i = 0; i < numActiveChannels; i++)
-        bitVolts.add (getChannelInfo (index, i).bitVolts);
+    for (auto reader : m_streamReaders)
+        reader->eventCursor = 0;
 
-    currentStream = m_dataFileArray[index].getParentDirectory().getFileName();
+    m_messageEventCursor = 0;
 }
 
 void BinaryFileSource::seekTo (int64 sample)
@@ -319,26 +379,60 @@ void BinaryFileSource::seekTo (int64 sample)
 
 int BinaryFileSource::readData (float* buffer, int nSamples)
 {
-    int64 samplesToRead;
+    const int activeRecord = getActiveRecord();
+
+    int samplesRead = readStream (m_streamReaders[activeRecord], getRecordNumSamples (activeRecord), m_samplePos, buffer, nSamples);
 
-    if (m_samplePos + nSamples > getActiveNumSamples())
+    m_samplePos += samplesRead;
+    return samplesRead;
+}
+
+int BinaryFileSource::readRecordData (int recordIndex, int64 sampleNumber, float* buffer, int nSamples)
+{
+    return readStream (m_streamReaders[recordIndex], getRecordNumSamples (recordIndex), sampleNumber, buffer, nSamples);
+}
+
+int BinaryFileSource::readStream (StreamReader* reader, int64 numSamples, int64 sampleNumber, float* buffer, int nSamples)
+{
+    if (reader == nullptr)
+        return 0;
+
+    int samplesToRead = int (jlimit (int64 (0), int64 (nSamples), numSamples - sampleNumber));
+
+    if (samplesToRead == 0)
+        return 0;
+
+    const int numChannels = reader->numChannels;
+    const int16* data;
+
+    if (reader->compressedReader != nullptr)
     {
-        samplesToRead = getActiveNumSamples() - m_samplePos;
+        if (samplesToRead > reader->readBufferSize)
+        {
+            reader->readBuffer.malloc (size_t (samplesToRead) * size_t (numChannels));
+            reader->readBufferSize = samplesToRead;
+        }
+
+        samplesToRead = reader->compressedReader->read (sampleNumber, reader->readBuffer, samplesToRead);
+        data = reader->readBuffer;
     }
     else
     {
-        samplesToRead = nSamples;
+        data = static_cast<const int16*> (reader->dataFile->getData()) + (sampleNumber * numChannels);
     }
 
-    int16* data = static_cast<int16*> (m_dataFile->getData()) + (m_samplePos * numActiveChannels);
+    const float* bitVolts = reader->bitVolts.getRawDataPointer();
 
-    for (int i = 0; i < samplesToRead * numActiveChannels; i++)
+    for (int i = 0; i < samplesToRead; i++)
     {
-        *(buffer + i) = *(data + i) * bitVolts[i % numActiveChannels];
+        for (int ch = 0; ch < numChannels; ch++)
+            buffer[ch] = data[ch] * bitVolts[ch];
+
+        buffer += numChannels;
+        data += numChannels;
     }
 
-    m_samplePos += samplesToRead;
-    return int(samplesToRead);
+    return samplesToRead;
 }
 
 /* void BinaryFileSource::processChannelData (int16* inBuffer, float* outBuffer, int channel, int64 numSamples)
@@ -25,6 +25,7 @@
 #define BINARYFILESOURCE_H_INCLUDED
 
 #include "../../../Utils/Utils.h"
+#include "../../RecordNode/CompressedFormat/CompressedStreamReader.h"
 #include "../FileSource.h"
 
 /** 
@@ -35,6 +36,9 @@
 	The files are indexed by a "structure.oebin" file, which 
 	is what is loaded into the File Reader.
 
+	Streams recorded by the Compressed engine (which have a
+	"compression" entry in structure.oebin) are decoded on the fly.
+
 */
 namespace BinarySource
 {
@@ -65,14 +69,47 @@ public:
     /** Add info about events occurring within a sample range */
     void processEventData (EventInfo& info, int64 fromSampleNumber, int64 toSampleNumber) override;
 
+    /** All streams can be read independently */
+    bool canReadAllRecords() const override { return true; }
+
+    /** Reads continuous data from any recorded stream */
+    int readRecordData (int recordIndex, int64 sampleNumber, float* buffer, int nSamples) override;
+
+    /** Add info about events of any recorded stream occurring within a sample range */
+    void processRecordEventData (int recordIndex, EventInfo& info, int64 fromSampleNumber, int64 toSampleNumber) override;
+
 private:
-    int numActiveChannels;
-    Array<float> bitVolts;
+    /** Reads the continuous data and events of one recorded stream */
+    struct StreamReader
+    {
+        std::unique_ptr<MemoryMappedFile> dataFile;
+
+        /** Used instead of dataFile for streams written by the Compressed engine */
+        std::unique_ptr<CompressedStreamReader> compressedReader;
+        HeapBlock<int16> readBuffer;
+        int readBufferSize = 0;
+
+        int numChannels = 0;
+        Array<float> bitVolts;
+
+        /** Events of this stream (null if there are none) */
+        const EventInfo* events = nullptr;
+        size_t eventCursor = 0;
+    };
+
+    /** Reads samples of one stream, converted to floats */
+    int readStream (StreamReader* reader, int64 numSamples, int64 sampleNumber, float* buffer, int nSamples);
+
+    /** Adds the events of one stream within [start, stop), starting the search from a cursor
+        left by the previous call, so contiguous playback only visits events in range */
+    void addEventsInRange (const EventInfo* source, size_t& cursor, EventInfo& dest, int64 start, int64 stop);
 
-    std::unique_ptr<MemoryMappedFile> m_dataFile;
     var m_jsonData;
     Array<File> m_dataFileArray;
 
+    /** One reader per recorded stream */
+    OwnedArray<StreamReader> m_streamReaders;
+
     File m_rootPath;
     int64 m_samplePos;
 
@@ -80,6 +117,10 @@ private:
     const unsigned int BYTES_PER_EVENT = 2;
 
     bool hasEventData;
+
+    /** Events of the MessageCenter, sent along with the events of the active stream */
+    const EventInfo* m_messageEvents;
+    size_t m_messageEventCursor;
 };
 } // namespace BinarySource
 
@@ -41,19 +41,20 @@ FileReader::FileReader() : GenericProcessor ("File Reader"),
                            playbackSamplePos (0),
                            currentSampleRate (0),
                            currentNumChannels (0),
-                           currentSample (0),
                            currentNumTotalSamples (0),
                            startSample (0),
                            stopSample (0),
-                           bufferCacheWindow (0),
-                           m_shouldFillBackBuffer (false),
+                           activePlaybackStream (0),
+                           playAllStreams (false),
+                           readsAllRecords (false),
+                           deviceSamplesPlayed (0),
+                           playbackFinished (false),
                            m_bufferSize (1024),
                            m_sysSampleRate (44100),
                            playbackActive (true),
                            gotNewFile (true),
                            loopPlayback (true),
-                           sampleRateWarningShown (false),
-                           firstProcess (false)
+                           sampleRateWarningShown (false)
 {
     /* Define a default file location based on OS */
 #ifdef __APPLE__
@@ -77,8 +78,7 @@ FileReader::FileReader() : GenericProcessor ("File Reader"),
 
 FileReader::~FileReader()
 {
-    signalThreadShouldExit();
-    notify();
+    stopThread (1000);
 }
 
 void FileReader::registerParameters()
@@ -88,6 +88,7 @@ void FileReader::registerParameters()
     addSelectedStreamParameter (Parameter::PROCESSOR_SCOPE, "active_stream", "Active Stream", "Currently active stream", {"example_data"}, 0);
     addTimeParameter (Parameter::PROCESSOR_SCOPE, "start_time", "Start Time", "Time to start playback", "00:00:00.000");
     addTimeParameter (Parameter::PROCESSOR_SCOPE, "end_time", "Stop Time", "Time to end playback", "00:00:04.999");
+    addBooleanParameter (Parameter::PROCESSOR_SCOPE, "play_all_streams", "Play All Streams", "Play back all recorded streams at once, each at its original sample rate", false, true);
 
     /* Link parameters */
     PathParameter* fileParam = static_cast<PathParameter*>(getParameter("selected_file"));
@@ -110,6 +111,13 @@ void FileReader::parameterValueChanged (Parameter* p)
         bool resetPlayback = false;
         setActiveStream (p->getValue(), resetPlayback);
     }
+    else if (p->getName() == "play_all_streams")
+    {
+        playAllStreams = p->getValue();
+
+        if (input != nullptr)
+            CoreServices::updateSignalChain (this);
+    }
     else if (p->getName() == "start_time")
     {
         if (! input)
@@ -313,8 +321,6 @@ bool FileReader::setFile (String fullpath, bool shouldUpdateSignalChain)
     //Set initial values on time parameters
     endTime->setNextValue (TimeParameter::TimeValue (1000 * stopSample / input->getActiveSampleRate()).toString(), false);
 
-    firstProcess = false;
-
     return true;
 }
 
@@ -343,7 +349,7 @@ void FileReader::setActiveStream (int index, bool reset)
     */
 
     //Check if currentSample is within bounds of new stream
-    if (currentSample > currentNumTotalSamples)
+    if (getCurrentSample() > currentNumTotalSamples)
         reset = true;
 
     stopSample = currentNumTotalSamples;
@@ -351,7 +357,6 @@ void FileReader::setActiveStream (int index, bool reset)
     if (reset)
     {
         startSample = 0;
-        bufferCacheWindow = 0;
 
         /*
         startTime->getTimeValue()->setTimeFromMilliseconds (0);
@@ -362,10 +367,6 @@ void FileReader::setActiveStream (int index, bool reset)
         */
     }
 
-    channelInfo.clear();
-    for (int i = 0; i < currentNumChannels; ++i)
-        channelInfo.add (input->getChannelInfo (index, i));
-
     input->seekTo (startSample);
 
     updateSettings();
@@ -407,7 +408,9 @@ bool FileReader::startAcquisition()
 
     checkAudioDevice();
 
-    /* Start asynchronous file reading thread */
+    playbackFinished = false;
+
+    /* Start reading ahead of playback */
     startThread();
 
     return true;
@@ -430,38 +433,24 @@ bool FileReader::isFileSupported (const String& fileName) const
 
 int64 FileReader::getCurrentSample()
 {
-    return currentSample;
+    if (PlaybackStream* stream = playbackStreams[activePlaybackStream])
+        return stream->readPosition;
+
+    return 0;
 }
 
-void FileReader::setCurrentSample(int64 sampleNumber)
+void FileReader::setCurrentSample (int64 sampleNumber)
 {
     // Stop background thread before modifying shared state
-    stopThread(100);
-
-    const ScopedLock sl(bufferLock);
+    const bool threadWasRunning = isThreadRunning();
+    stopThread (100);
 
-    currentSample = sampleNumber;
-    playbackSamplePos.set(sampleNumber);
+    const ScopedLock sl (bufferLock);
 
-    // Reset file position
-    input->seekTo(sampleNumber);
+    resetPlayback (sampleNumber);
 
-    // Get the current back buffer without switching
-    HeapBlock<float>* backBuffer = getBackBuffer();
-
-    // Fill only the back buffer first
-    readAndFillBufferCache(*backBuffer);
-
-    // Signal that we want to switch buffers on next process() call
-    bufferCacheWindow.set(BUFFER_WINDOW_CACHE_SIZE - 1); // Force buffer switch on next process
-    needsBufferReset.set(true);
-
-    // The process() thread will handle the buffer switch and trigger
-    // the background thread to fill the new back buffer
-    m_shouldFillBackBuffer.set(false);
-
-    // Restart background thread
-    startThread();
+    if (threadWasRunning)
+        startThread();
 }
 
 void FileReader::setPlaybackStart (int64 startSample)
@@ -473,6 +462,9 @@ void FileReader::setPlaybackStart (int64 startSample)
 void FileReader::setPlaybackStop (int64 stopSample)
 {
     this->stopSample = stopSample;
+
+    // the playback range of every stream is updated when playback is reset
+    setCurrentSample (jlimit (startSample, jmax (startSample, stopSample - 1), getPlayheadPosition()));
 }
 
 int64 FileReader::getPlayheadPosition()
@@ -499,19 +491,24 @@ void FileReader::updateSettings()
         return;
     }
 
-    if (true)
-    {
-        LOGD ("File Reader got new file.");
+    /* Playback state is rebuilt below */
+    stopThread (500);
+
+    const ScopedLock sl (bufferLock);
 
-        dataStreams.clear();
-        continuousChannels.clear();
-        eventChannels.clear();
+    createPlaybackStreams();
 
-        String streamName = input->getRecordName (input->getActiveRecord());
+    dataStreams.clear();
+    continuousChannels.clear();
+    eventChannels.clear();
+
+    for (auto stream : playbackStreams)
+    {
+        String streamName = input->getRecordName (stream->recordIndex);
 
         /* Only use the original stream name (FileReader-100.example_data -> example_data) */
         StringArray tokens;
-        tokens.addTokens (input->getRecordName (input->getActiveRecord()), ".");
+        tokens.addTokens (input->getRecordName (stream->recordIndex), ".");
         if (tokens.size())
             streamName = tokens[tokens.size() - 1];
 
@@ -520,23 +517,25 @@ void FileReader::updateSettings()
             streamName,
             "A description of the File Reader Stream",
             "identifier",
-            getDefaultSampleRate()
+            stream->sampleRate
 
         };
 
-        LOGD ("File Reader adding data stream.");
+        LOGD ("File Reader adding data stream ", streamName, " (", stream->sampleRate, " Hz)");
 
         dataStreams.add (new DataStream (streamSettings));
         dataStreams.getLast()->addProcessor (this);
 
-        for (int i = 0; i < currentNumChannels; i++)
+        for (int i = 0; i < stream->numChannels; i++)
         {
+            RecordedChannelInfo info = input->getChannelInfo (stream->recordIndex, i);
+
             ContinuousChannel::Settings channelSettings {
-                static_cast<ContinuousChannel::Type>(channelInfo[i].type),
-                channelInfo[i].name,
+                static_cast<ContinuousChannel::Type> (info.type),
+                info.name,
                 "description",
                 "filereader.stream",
-                channelInfo[i].bitVolts, // BITVOLTS VALUE
+                info.bitVolts, // BITVOLTS VALUE
 
                 dataStreams.getLast()
             };
@@ -561,14 +560,10 @@ void FileReader::updateSettings()
         events->setIdentifier (id);
         events->addProcessor (this);
         eventChannels.add (events);
-
-        gotNewFile = false;
-    }
-    else
-    {
-        LOGD ("File Reader has no new file...not updating.");
     }
 
+    gotNewFile = false;
+
     isEnabled = true;
 
     /* Setup internal buffer based on audio device settings */
@@ -603,23 +598,10 @@ void FileReader::updateSettings()
     if (m_bufferSize == 0)
         m_bufferSize = 1024;
 
-    m_samplesPerBuffer.set (m_bufferSize * (getDefaultSampleRate() / m_sysSampleRate));
-
-    bufferA.malloc (currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
-    bufferB.malloc (currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
+    allocateCaches();
 
-    /* Reset stream to start of playback */
-    input->seekTo (startSample);
-    currentSample = startSample;
-
-    /* Pre-fills the front buffer with a blocking read */
-    readAndFillBufferCache (bufferA);
-
-    readBuffer = &bufferB;
-    bufferCacheWindow = 0;
-    m_shouldFillBackBuffer.set (false);
-    if (firstProcess)
-        switchBuffer();
+    /* Reset streams to start of playback, and pre-fill the caches with a blocking read */
+    resetPlayback (startSample);
 
     LOGD ("File Reader finished updating custom settings.");
 }
@@ -637,21 +619,150 @@ void FileReader::checkAudioDevice()
         m_bufferSize = ads.bufferSize;
         if (m_bufferSize == 0)
             m_bufferSize = 1024;
-        m_samplesPerBuffer.set (m_bufferSize * (getDefaultSampleRate() / m_sysSampleRate));
 
-        bufferA.malloc (currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
-        bufferB.malloc (currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
+        const ScopedLock sl (bufferLock);
+
+        allocateCaches();
 
         /* Reset stream to start of playback */
-        input->seekTo (startSample);
-        currentSample = startSample;
+        resetPlayback (startSample);
+    }
+}
+
+void FileReader::createPlaybackStreams()
+{
+    playbackStreams.clear();
+    activePlaybackStream = 0;
+
+    readsAllRecords = playAllStreams && input->canReadAllRecords();
+
+    for (int i = 0; i < input->getNumRecords(); i++)
+    {
+        if (! readsAllRecords && i != input->getActiveRecord())
+            continue;
+
+        if (i == input->getActiveRecord())
+            activePlaybackStream = playbackStreams.size();
+
+        auto stream = new PlaybackStream();
+        stream->recordIndex = i;
+        stream->numChannels = input->getRecordNumChannels (i);
+        stream->sampleRate = input->getRecordSampleRate (i);
+        stream->numSamples = input->getRecordNumSamples (i);
+
+        playbackStreams.add (stream);
+    }
+
+    if (playAllStreams && ! readsAllRecords)
+        LOGC ("File Reader: this file format can only play back one stream at a time.");
+}
+
+void FileReader::allocateCaches()
+{
+    for (auto stream : playbackStreams)
+    {
+        stream->allocateCache (int (m_bufferSize), m_sysSampleRate);
+
+        if (stream->sampleRate > m_sysSampleRate)
+            LOGC ("File Reader: a stream is sampled at ", stream->sampleRate, " Hz, faster than the audio device (", m_sysSampleRate, " Hz). Samples that don't fit into a block will be skipped.");
+    }
+}
+
+void FileReader::resetPlayback (int64 sampleNumber)
+{
+    if (playbackStreams.size() == 0)
+        return;
+
+    const double activeSampleRate = playbackStreams[activePlaybackStream]->sampleRate;
+
+    deviceSamplesPlayed = 0;
+    playbackFinished = false;
+
+    for (int i = 0; i < playbackStreams.size(); i++)
+    {
+        PlaybackStream* stream = playbackStreams[i];
+
+        if (i == activePlaybackStream)
+        {
+            stream->startSample = startSample;
+            stream->stopSample = stopSample;
+            stream->readPosition = sampleNumber;
+        }
+        else
+        {
+            // other streams play back the same time range
+            const double ratio = stream->sampleRate / activeSampleRate;
+
+            stream->stopSample = jlimit (int64 (1), stream->numSamples, int64 (std::round (stopSample * ratio)));
+            stream->startSample = jlimit (int64 (0), stream->stopSample - 1, int64 (std::round (startSample * ratio)));
+            stream->readPosition = jlimit (stream->startSample, stream->stopSample - 1, int64 (std::round (sampleNumber * ratio)));
+        }
+
+        stream->resetPlayback (stream->readPosition);
+
+        if (! readsAllRecords)
+            input->seekTo (stream->readPosition);
+
+        fillCache (stream);
+    }
+
+    playbackSamplePos.set (sampleNumber);
+}
+
+bool FileReader::fillCache (PlaybackStream* stream)
+{
+    return stream->fillCache ([this, stream] (float* dest, int numSamples)
+                              { return readFromFile (stream, dest, numSamples); });
+}
+
+int FileReader::readFromFile (PlaybackStream* stream, float* dest, int numSamples)
+{
+    int samplesRead = 0;
+
+    while (samplesRead < numSamples)
+    {
+        // loop back to the start of the playback range
+        if (stream->readPosition >= stream->stopSample)
+        {
+            stream->readPosition = stream->startSample;
+
+            if (! readsAllRecords)
+                input->seekTo (stream->startSample);
+        }
+
+        const int samplesToRead = int (jmin (int64 (numSamples - samplesRead), stream->stopSample - stream->readPosition));
+        float* buffer = dest + size_t (samplesRead) * stream->numChannels;
 
-        /* Pre-fills the front buffer with a blocking read */
-        readAndFillBufferCache (bufferA);
+        int n;
 
-        readBuffer = &bufferB;
-        bufferCacheWindow = 0;
-        m_shouldFillBackBuffer.set (false);
+        if (readsAllRecords)
+            n = input->readRecordData (stream->recordIndex, stream->readPosition, buffer, samplesToRead);
+        else
+            n = input->readData (buffer, samplesToRead);
+
+        if (n <= 0)
+        {
+            // the playback range extends past the end of the data
+            if (stream->readPosition == stream->startSample)
+                break;
+
+            stream->readPosition = stream->stopSample;
+            continue;
+        }
+
+        stream->readPosition += n;
+        samplesRead += n;
+    }
+
+    return samplesRead;
+}
+
+void FileReader::waitForCache (PlaybackStream* stream, int numSamples)
+{
+    while (stream->getNumCached() < numSamples && isThreadRunning() && ! Thread::currentThreadShouldExit())
+    {
+        notify();
+        cacheFilled.wait (100);
     }
 }
 
@@ -665,7 +776,7 @@ int64 FileReader::getPlaybackStop()
     return stopSample;
 }
 
-Array<EventInfo> FileReader::getActiveEventInfo()
+const EventInfo& FileReader::getActiveEventInfo() const
 {
     return input->getEventInfo();
 }
@@ -699,66 +810,77 @@ String FileReader::handleConfigMessage (const String& msg)
 
 void FileReader::process (AudioBuffer<float>& buffer)
 {
-    const ScopedLock sl(bufferLock);
+    const ScopedLock sl (bufferLock);
 
-    if (needsBufferReset.compareAndSetBool(false, true))
-    {
-        // Switch to the newly prepared back buffer
-        switchBuffer();
-        bufferCacheWindow.set(0);
-    }
+    deviceSamplesPlayed += buffer.getNumSamples();
 
-    int samplesNeededPerBuffer = int(float(buffer.getNumSamples()) * (getDefaultSampleRate() / m_sysSampleRate));
-    m_samplesPerBuffer.set(samplesNeededPerBuffer);
+    // when rendering offline, the graph waits for the disk instead of skipping samples,
+    // and playback stops at the end of the range so the render can finish
+    const bool renderingOffline = isNonRealtime();
+    const bool shouldLoop = loopPlayback && ! renderingOffline;
 
-    // Handle buffer switching
-    if (firstProcess && bufferCacheWindow.get() == 0)
+    int firstChannel = 0;
+
+    for (int i = 0; i < playbackStreams.size(); i++)
     {
-        switchBuffer();
-    }
+        PlaybackStream* stream = playbackStreams[i];
 
-    // Get current buffer position
-    const float* tempReadBuffer = readBuffer->getData() + 
-        (samplesNeededPerBuffer * currentNumChannels * bufferCacheWindow.get());
+        // each stream plays the samples that are due according to the shared clock;
+        // a stream that was short of cached samples catches up in later blocks
+        int samplesNeeded;
+        int64 samplesToSkip;
+        stream->getSamplesDue (deviceSamplesPlayed, m_sysSampleRate, buffer.getNumSamples(), samplesNeeded, samplesToSkip);
 
-    // Copy data to output buffer
-    for (int ch = 0; ch < currentNumChannels; ++ch)
-    {
-        float* writeBuffer = buffer.getWritePointer(ch);
-        for (int sample = 0; sample < samplesNeededPerBuffer; sample++)
+        if (! shouldLoop)
         {
-            *(writeBuffer + sample) = *(tempReadBuffer + (currentNumChannels * sample) + ch);
+            const int64 samplesLeft = stream->stopSample - stream->playbackPosition;
+
+            samplesNeeded = int (jmin (int64 (samplesNeeded), samplesLeft));
+            samplesToSkip = jmin (samplesToSkip, samplesLeft - samplesNeeded);
         }
-    }
 
-    // Update timestamps and sample positions atomically
-    int64 start = playbackSamplePos.get();
-    playbackSamplePos.set(start + samplesNeededPerBuffer);
-    int64 stop = playbackSamplePos.get();
+        if (renderingOffline)
+            waitForCache (stream, int (jmin (int64 (samplesNeeded) + samplesToSkip, int64 (stream->getCacheSize()))));
 
-    setTimestampAndSamples(start, -1.0, samplesNeededPerBuffer, dataStreams[0]->getStreamId());
+        const PlaybackStream::Block block = stream->play (buffer, firstChannel, samplesNeeded, samplesToSkip, shouldLoop);
 
-    // Handle looping
-    if (playbackSamplePos.get() >= stopSample)
-    {
-        playbackSamplePos.set(startSample + (playbackSamplePos.get() - stopSample));
+        setTimestampAndSamples (block.startSample, -1.0, block.numSamples, dataStreams[i]->getStreamId());
+
+        // Process events for this buffer
+        addEventsInRange (i, block.startSample, block.startSample + block.numSamples + block.numSkipped);
+
+        firstChannel += stream->numChannels;
     }
 
-    // Process events for this buffer
-    addEventsInRange(start, stop);
+    if (playbackStreams.size() > 0)
+        playbackSamplePos.set (playbackStreams[activePlaybackStream]->playbackPosition);
 
-    // Update buffer window counter
-    int newWindow = (bufferCacheWindow.get() + 1) % BUFFER_WINDOW_CACHE_SIZE;
-    bufferCacheWindow.set(newWindow);
+    if (! shouldLoop && ! playbackFinished && playbackStreams.size() > 0
+        && playbackStreams[activePlaybackStream]->playbackPosition >= stopSample)
+    {
+        playbackFinished = true;
+
+        if (renderingOffline)
+        {
+            MessageManager::callAsync ([]
+                                       {
+                CoreServices::sendStatusMessage ("File Reader reached the end of the playback range.");
+                CoreServices::setAcquisitionStatus (false); });
+        }
+    }
 
-    if (!firstProcess)
-        firstProcess = true;
+    // let the background thread refill the caches
+    notify();
 }
 
-void FileReader::addEventsInRange (int64 start, int64 stop)
+void FileReader::addEventsInRange (int streamIndex, int64 start, int64 stop)
 {
     EventInfo events;
-    input->processEventData (events, start, stop);
+
+    if (readsAllRecords)
+        input->processRecordEventData (playbackStreams[streamIndex]->recordIndex, events, start, stop);
+    else
+        input->processEventData (events, start, stop);
 
     for (int i = 0; i < events.channels.size(); i++)
     {
@@ -773,7 +895,7 @@ void FileReader::addEventsInRange (int64 start, int64 stop)
         {
             uint8 ttlBit = events.channels[i];
             bool state = events.channelStates[i] > 0;
-            TTLEventPtr event = TTLEvent::createTTLEvent (eventChannels[0], events.sampleNumbers[i], ttlBit, state);
+            TTLEventPtr event = TTLEvent::createTTLEvent (eventChannels[streamIndex], events.sampleNumbers[i], ttlBit, state);
             addEvent (event, int (absoluteCurrentSampleNumber));
         }
     }
@@ -789,81 +911,21 @@ int64 FileReader::millisecondsToSamples (unsigned int ms) const
     return (int64) (currentSampleRate * float (ms) / 1000.f);
 }
 
-void FileReader::switchBuffer()
-{
-    const ScopedLock sl(bufferLock);
-
-    if (readBuffer == &bufferA)
-        readBuffer = &bufferB;
-    else
-        readBuffer = &bufferA;
-
-    m_shouldFillBackBuffer.set(true);
-    notify();
-}
-
-HeapBlock<float>* FileReader::getFrontBuffer()
-{
-    return readBuffer;
-}
-
-HeapBlock<float>* FileReader::getBackBuffer()
-{
-    if (readBuffer == &bufferA)
-        return &bufferB;
-
-    return &bufferA;
-}
-
 void FileReader::run()
 {
     while (! threadShouldExit())
     {
-        if (m_shouldFillBackBuffer.compareAndSetBool (false, true))
-        {
-            readAndFillBufferCache (*getBackBuffer());
-        }
-
-        wait (30);
-    }
-}
-
-void FileReader::readAndFillBufferCache (HeapBlock<float>& cacheBuffer)
-{
-    const int samplesNeededPerBuffer = m_samplesPerBuffer.get();
-    const int samplesNeeded = samplesNeededPerBuffer * BUFFER_WINDOW_CACHE_SIZE;
-
-    int samplesRead = 0;
-
-    // should only loop if reached end of file and resuming from start
-    while (samplesRead < samplesNeeded)
-    {
-        int samplesToRead = samplesNeeded - samplesRead;
+        bool readData = false;
 
-        // if reached end of file stream
-        if ((currentSample + samplesToRead) > stopSample)
-        {
-            samplesToRead = int (stopSample - currentSample);
-            if (samplesToRead > 0)
-                input->readData (cacheBuffer + samplesRead * currentNumChannels, samplesToRead);
+        for (auto stream : playbackStreams)
+            readData |= fillCache (stream);
 
-            // reset stream to beginning
-            input->seekTo (startSample);
-            currentSample = startSample;
-        }
-        else // else read the block needed
-        {
-            input->readData (cacheBuffer + samplesRead * currentNumChannels, samplesToRead);
+        if (readData)
+            cacheFilled.signal();
 
-            currentSample += samplesToRead;
-        }
-
-        samplesRead += samplesToRead;
-
-        //LOGD("CURRENT SAMPLE: ", currentSample, " samplesRead: ", samplesRead, " samplesNeeded: ", samplesNeeded);
-
-        if (samplesRead < 0)
-            return;
+        // all caches are full; wait until the audio thread has played some samples
+        if (! readData)
+            wait (30);
     }
 }
 
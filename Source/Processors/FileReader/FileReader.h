@@ -28,11 +28,10 @@
 
 #include "../GenericProcessor/GenericProcessor.h"
 #include "FileSource.h"
+#include "PlaybackStream.h"
 
 #include "../../Utils/Utils.h"
 
-#define BUFFER_WINDOW_CACHE_SIZE 10
-
 class ScrubberInterface;
 
 /** Assigns a unique colour to each event channel */
@@ -59,10 +58,18 @@ static const Array<Colour> eventChannelColours = {
 /**
   Reads data from a file.
 
+  By default, only the active stream is played back. If "Play All Streams"
+  is enabled (and the File Source supports it), every recorded stream is
+  played back at once, each at its original sample rate. The streams share
+  one clock, derived from the number of audio device samples processed, and
+  the active stream sets the playback range and playhead.
+
+  A background thread reads ahead of playback into a cache for each stream.
+
   @see GenericProcessor
 */
-class FileReader : public GenericProcessor,
-                   private Thread
+class TESTABLE FileReader : public GenericProcessor,
+                            private Thread
 {
 public:
     /** Constructor */
@@ -131,8 +138,8 @@ public:
     /** Returns the total number of samples per channel */
     int64 getCurrentNumTotalSamples();
 
-    /** Returns a list of EventInfo for the current stream */
-    Array<EventInfo> getActiveEventInfo();
+    /** Returns the events of the current stream, sorted by sample number */
+    const EventInfo& getActiveEventInfo() const;
 
     /** Returns the data sample rate of the current stream */
     float getCurrentSampleRate() const;
@@ -164,7 +171,7 @@ public:
     /** Returns true if playback is currently active */
     bool playbackIsActive();
 
-    /** Flag whether to loop or stop at the end of playback */
+    /** Flag whether to loop or stop at the end of playback (playback never loops while rendering offline) */
     bool loopPlayback;
 
     /** Converts samples to milliseconds using current stream's sample rate */
@@ -173,8 +180,8 @@ public:
     /** Converts milliseconds to samples using current stream's sample rate */
     int64 millisecondsToSamples (unsigned int ms) const;
 
-    /** Swaps the backbuffer to the front and flags the background readerthread to update the new backbuffer */
-    void switchBuffer();
+    /** Returns the number of streams being played back */
+    int getNumPlaybackStreams() const { return playbackStreams.size(); }
 
     /** Returns a pointer to the ScrubberInterface */
     ScrubberInterface* getScrubberInterface();
@@ -189,8 +196,27 @@ private:
     /** Checks for changes in the audio device settings */
     void checkAudioDevice();
 
+    /** Creates the playback streams for the current file and settings */
+    void createPlaybackStreams();
+
+    /** Sizes the stream caches for the current audio device settings */
+    void allocateCaches();
+
+    /** Moves all streams to the time of a sample number of the active stream,
+        and fills their caches (the background thread must be stopped) */
+    void resetPlayback (int64 sampleNumber);
+
+    /** Reads as many samples as fit into a stream's cache. Returns false if it was already full. */
+    bool fillCache (PlaybackStream* stream);
+
+    /** Reads samples of a stream from the file, looping at the end of the playback range */
+    int readFromFile (PlaybackStream* stream, float* dest, int numSamples);
+
+    /** Blocks until a stream's cache holds at least numSamples (used when rendering offline) */
+    void waitForCache (PlaybackStream* stream, int numSamples);
+
     /** Generates any events found within the current continuous buffer interval */
-    void addEventsInRange (int64 start, int64 stop);
+    void addEventsInRange (int streamIndex, int64 start, int64 stop);
 
     /** Flag if a new file has been loaded */
     bool gotNewFile;
@@ -198,41 +224,44 @@ private:
     /** Flag if the invalid sample rate warning is shown */
     bool sampleRateWarningShown;
 
-    /** Total number of samples played back since most recent start of acquisition */
-
     float currentSampleRate;
     int currentNumChannels;
-    int64 currentSample;
     int64 currentNumTotalSamples;
     int64 startSample;
     int64 stopSample;
-    Array<RecordedChannelInfo> channelInfo;
     bool playbackActive;
 
     std::unique_ptr<FileSource> input;
 
-    /* Pointer to current front buffer */
-    HeapBlock<float>* readBuffer;
-    HeapBlock<float> bufferA;
-    HeapBlock<float> bufferB;
+    /** Streams being played back, in output order */
+    OwnedArray<PlaybackStream> playbackStreams;
 
-    HashMap<String, int> supportedExtensions;
+    /** Index of the active stream within playbackStreams */
+    int activePlaybackStream;
+
+    /** True if all recorded streams should be played back */
+    bool playAllStreams;
+
+    /** True if streams are read with FileSource::readRecordData() (false if only the active stream is played back) */
+    bool readsAllRecords;
+
+    /** Audio device samples processed since playback was reset (the shared clock of all streams) */
+    int64 deviceSamplesPlayed;
+
+    /** True once a non-looping playback has reached the end of the playback range */
+    bool playbackFinished;
 
-    Atomic<bool> m_shouldFillBackBuffer;
-    Atomic<int> m_samplesPerBuffer;
+    /** Signalled by the background thread whenever it adds samples to the caches */
+    WaitableEvent cacheFilled;
+
+    HashMap<String, int> supportedExtensions;
 
     unsigned int m_bufferSize;
     float m_sysSampleRate;
 
-    HeapBlock<float>* getFrontBuffer();
-    HeapBlock<float>* getBackBuffer();
-
     /** Executes the background thread task */
     void run() override;
 
-    /** Reads a chunk of the file that fills an entire buffer cache. */
-    void readAndFillBufferCache (HeapBlock<float>& cacheBuffer);
-
     /** Returns the number of included file sources */
     int getNumBuiltInFileSources() const { return 1; }
 
@@ -247,10 +276,6 @@ private:
 
     CriticalSection bufferLock;
     Atomic<int64> playbackSamplePos;
-    Atomic<int> bufferCacheWindow;
-    Atomic<bool> needsBufferReset;
-
-    bool firstProcess;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FileReader);
 };
@@ -43,10 +43,11 @@ FileReaderEditor::FileReaderEditor (GenericProcessor* parentNode)
     scrubDrawerButton->setEnabled (true);
     addAndMakeVisible (scrubDrawerButton.get());
 
-    addPathParameterEditor (Parameter::PROCESSOR_SCOPE, "selected_file", 24, 29);
-    addSelectedStreamParameterEditor (Parameter::PROCESSOR_SCOPE, "active_stream", 24, 54);
-    addTimeParameterEditor (Parameter::PROCESSOR_SCOPE, "start_time", 24, 79);
-    addTimeParameterEditor (Parameter::PROCESSOR_SCOPE, "end_time", 24, 104);
+    addPathParameterEditor (Parameter::PROCESSOR_SCOPE, "selected_file", 24, 27);
+    addSelectedStreamParameterEditor (Parameter::PROCESSOR_SCOPE, "active_stream", 24, 49);
+    addToggleParameterEditor (Parameter::PROCESSOR_SCOPE, "play_all_streams", 24, 71);
+    addTimeParameterEditor (Parameter::PROCESSOR_SCOPE, "start_time", 24, 93);
+    addTimeParameterEditor (Parameter::PROCESSOR_SCOPE, "end_time", 24, 115);
 
     for (auto& p : { "selected_file", "active_stream", "start_time", "end_time" })
     {
@@ -126,7 +127,7 @@ void FileReaderEditor::showScrubInterface (bool show)
     scrubDrawerButton->setBounds (
         scrubDrawerButton->getX() + dX, scrubDrawerButton->getY(), scrubDrawerButton->getWidth(), scrubDrawerButton->getHeight());
 
-    for (auto& p : { "selected_file", "active_stream", "start_time", "end_time" })
+    for (auto& p : { "selected_file", "active_stream", "play_all_streams", "start_time", "end_time" })
     {
         auto* ed = getParameterEditor (p);
         ed->setBounds (ed->getX() + dX, ed->getY(), ed->getWidth(), ed->getHeight());
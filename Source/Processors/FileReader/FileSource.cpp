@@ -76,9 +76,16 @@ int FileSource::getActiveRecord() const
     return activeRecord.get();
 }
 
-const EventInfo& FileSource::getEventInfo()
+const EventInfo& FileSource::getEventInfo() const
 {
-    return eventInfoMap[currentStream];
+    static const EventInfo noEvents;
+
+    auto it = eventInfoMap.find (currentStream);
+
+    if (it == eventInfoMap.end())
+        return noEvents;
+
+    return it->second;
 }
 
 RecordedChannelInfo FileSource::getChannelInfo (int recordIndex, int channel) const
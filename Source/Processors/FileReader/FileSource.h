@@ -28,6 +28,8 @@
 #include "../../Utils/Utils.h"
 #include "../PluginManager/OpenEphysPlugin.h"
 
+#include <algorithm>
+
 struct RecordedChannelInfo
 {
     String name;
@@ -35,12 +37,58 @@ struct RecordedChannelInfo
     uint8 type;
 };
 
+/**
+    Events of one stream, stored as columns of equal length.
+
+    Events loaded by a File Source are sorted by sample number,
+    so the events within a range can be found by binary search.
+*/
 struct EventInfo
 {
     std::vector<int16> channels;
     std::vector<int16> channelStates;
     std::vector<int64> sampleNumbers;
     std::vector<String> text;
+
+    /** Returns the number of events */
+    size_t size() const { return sampleNumbers.size(); }
+
+    /** Returns the index of the first event at or after sampleNumber (size() if there is none) */
+    size_t findFirstEvent (int64 sampleNumber) const
+    {
+        return size_t (std::lower_bound (sampleNumbers.begin(), sampleNumbers.end(), sampleNumber) - sampleNumbers.begin());
+    }
+
+    /** Sorts all columns by sample number, keeping the order of events with equal sample numbers */
+    void sortBySampleNumber()
+    {
+        if (std::is_sorted (sampleNumbers.begin(), sampleNumbers.end()))
+            return;
+
+        std::vector<size_t> order (sampleNumbers.size());
+
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+
+        std::stable_sort (order.begin(), order.end(), [this] (size_t a, size_t b)
+                          { return sampleNumbers[a] < sampleNumbers[b]; });
+
+        EventInfo sorted;
+
+        for (auto i : order)
+            sorted.append (*this, i);
+
+        *this = std::move (sorted);
+    }
+
+    /** Appends one event from another EventInfo */
+    void append (const EventInfo& other, size_t index, int channelOffset = 0)
+    {
+        channels.push_back (int16 (other.channels[index] + channelOffset));
+        channelStates.push_back (other.channelStates[index]);
+        sampleNumbers.push_back (other.sampleNumbers[index]);
+        text.push_back (other.text[index]);
+    }
 };
 
 /** 
@@ -96,6 +144,21 @@ public:
     /** Return false if file is not able to be opened */
     virtual bool isReady();
 
+    /** Returns true if any recorded stream can be read at any position with readRecordData(),
+        independently of the active record. This allows the File Reader to play back all
+        recorded streams at once. */
+    virtual bool canReadAllRecords() const { return false; }
+
+    /** Reads nSamples of a recorded stream, starting at sampleNumber, into a buffer
+        with the same layout as readData(). Does not change the active record or its
+        read position, and may be called from a different thread than processRecordEventData().
+
+        Returns the number of samples actually read. */
+    virtual int readRecordData (int recordIndex, int64 sampleNumber, float* buffer, int nSamples) { return 0; }
+
+    /** Adds info about events of a recorded stream occurring within a sample range */
+    virtual void processRecordEventData (int recordIndex, EventInfo& info, int64 fromSampleNumber, int64 toSampleNumber) {}
+
     // ------------------------------------------------------------
     //                    OTHER METHODS
     //                (used by File Reader)
@@ -143,8 +206,8 @@ public:
     /** Returns the full name of the file */
     String getFileName() const;
 
-    /** Get the event information for the current stream */
-    const EventInfo& getEventInfo();
+    /** Get the event information for the current stream (sorted by sample number) */
+    const EventInfo& getEventInfo() const;
 
 protected:
     /** Holds the name of the current stream */
@@ -161,7 +224,8 @@ protected:
     };
     Array<RecordInfo> infoArray;
 
-    /** Holds information about event channels in a recording */
+    /** Holds information about event channels in a recording, 
+        sorted by sample number (see EventInfo::sortBySampleNumber) */
     std::map<String, EventInfo> eventInfoMap;
 
     bool fileOpened = false;
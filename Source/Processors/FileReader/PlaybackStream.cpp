@@ -0,0 +1,144 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PlaybackStream.h"
+
+void PlaybackStream::allocateCache (int blockSize, double deviceSampleRate)
+{
+    // room for BUFFER_WINDOW_CACHE_SIZE blocks being played and as many being read
+    const int samplesPerBlock = int (std::ceil (blockSize * sampleRate / deviceSampleRate)) + 1;
+    const int cacheSize = samplesPerBlock * BUFFER_WINDOW_CACHE_SIZE * 2;
+
+    fifo.setTotalSize (cacheSize);
+    cache.malloc (size_t (cacheSize) * size_t (numChannels));
+}
+
+void PlaybackStream::resetPlayback (int64 sampleNumber)
+{
+    readPosition = sampleNumber;
+    playbackPosition = sampleNumber;
+    samplesPlayed = 0;
+    fifo.reset();
+}
+
+bool PlaybackStream::fillCache (const ReadFunction& read)
+{
+    const int freeSpace = fifo.getFreeSpace();
+
+    if (freeSpace <= 0)
+        return false;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (freeSpace, start1, size1, start2, size2);
+
+    int samplesRead = read (cache + size_t (start1) * numChannels, size1);
+
+    if (samplesRead == size1 && size2 > 0)
+        samplesRead += read (cache + size_t (start2) * numChannels, size2);
+
+    fifo.finishedWrite (samplesRead);
+
+    return samplesRead > 0;
+}
+
+void PlaybackStream::getSamplesDue (int64 deviceSamplesPlayed,
+                                    double deviceSampleRate,
+                                    double streamSampleRate,
+                                    int64 streamSamplesPlayed,
+                                    int blockSize,
+                                    int& samplesToPlay,
+                                    int64& samplesToSkip)
+{
+    const int64 samplesDue = int64 (double (deviceSamplesPlayed) * streamSampleRate / deviceSampleRate);
+    const int64 backlog = jmax (int64 (0), samplesDue - streamSamplesPlayed);
+
+    samplesToPlay = int (jmin (int64 (blockSize), backlog));
+    samplesToSkip = backlog - samplesToPlay;
+}
+
+void PlaybackStream::getSamplesDue (int64 deviceSamplesPlayed,
+                                    double deviceSampleRate,
+                                    int blockSize,
+                                    int& samplesToPlay,
+                                    int64& samplesToSkip) const
+{
+    getSamplesDue (deviceSamplesPlayed, deviceSampleRate, sampleRate, samplesPlayed, blockSize, samplesToPlay, samplesToSkip);
+}
+
+PlaybackStream::Block PlaybackStream::play (AudioBuffer<float>& buffer, int firstChannel, int samplesToPlay, int64 samplesToSkip, bool shouldLoop)
+{
+    Block block;
+
+    block.startSample = playbackPosition;
+    block.numSamples = readFromCache (buffer, firstChannel, samplesToPlay);
+
+    // a stream sampled faster than the device has more samples due than fit into the
+    // block; those are skipped, so that it doesn't fall further behind in every block
+    block.numSkipped = 0;
+
+    if (block.numSamples == samplesToPlay && samplesToSkip > 0)
+        block.numSkipped = skipCache (int (jmin (samplesToSkip, int64 (std::numeric_limits<int>::max()))));
+
+    samplesPlayed += block.numSamples + block.numSkipped;
+    playbackPosition += block.numSamples + block.numSkipped;
+
+    if (shouldLoop && playbackPosition >= stopSample)
+        playbackPosition = startSample + (playbackPosition - stopSample);
+
+    return block;
+}
+
+int PlaybackStream::readFromCache (AudioBuffer<float>& buffer, int firstChannel, int numSamplesToRead)
+{
+    numSamplesToRead = jmin (numSamplesToRead, fifo.getNumReady());
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (numSamplesToRead, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* writeBuffer = buffer.getWritePointer (firstChannel + ch);
+        const float* channelCache = cache + ch;
+
+        for (int i = 0; i < size1; i++)
+            writeBuffer[i] = channelCache[size_t (start1 + i) * numChannels];
+
+        for (int i = 0; i < size2; i++)
+            writeBuffer[size1 + i] = channelCache[size_t (start2 + i) * numChannels];
+    }
+
+    fifo.finishedRead (size1 + size2);
+
+    return size1 + size2;
+}
+
+int PlaybackStream::skipCache (int numSamplesToSkip)
+{
+    numSamplesToSkip = jmin (numSamplesToSkip, fifo.getNumReady());
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (numSamplesToSkip, start1, size1, start2, size2);
+    fifo.finishedRead (size1 + size2);
+
+    return size1 + size2;
+}
@@ -0,0 +1,126 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PLAYBACKSTREAM_H_INCLUDED
+#define PLAYBACKSTREAM_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../../TestableExport.h"
+
+#define BUFFER_WINDOW_CACHE_SIZE 10
+
+/**
+    Playback state and sample cache of one recorded stream played back by the File Reader.
+
+    A background thread reads samples ahead of playback into the cache, and the
+    audio thread plays the samples that are due according to the audio device
+    samples processed so far, which is the clock shared by all streams.
+*/
+class TESTABLE PlaybackStream
+{
+public:
+    /** Reads up to numSamples interleaved samples of the stream into dest, and returns the number read */
+    using ReadFunction = std::function<int (float* dest, int numSamples)>;
+
+    /** The samples played in one block */
+    struct Block
+    {
+        /** Sample number of the first sample played */
+        int64 startSample;
+
+        /** Samples copied into the output buffer */
+        int numSamples;
+
+        /** Samples that were due after them, but didn't fit into the block */
+        int numSkipped;
+    };
+
+    int recordIndex = 0;
+    int numChannels = 0;
+    float sampleRate = 0.0f;
+    int64 numSamples = 0;
+
+    /** Playback range, in samples of this stream */
+    int64 startSample = 0;
+    int64 stopSample = 0;
+
+    /** Next sample to read from the file (background thread) */
+    int64 readPosition = 0;
+
+    /** Next sample to play, and samples played since playback was reset (audio thread) */
+    int64 playbackPosition = 0;
+    int64 samplesPlayed = 0;
+
+    /** Sizes the cache for blocks of blockSize audio device samples */
+    void allocateCache (int blockSize, double deviceSampleRate);
+
+    /** Returns the number of samples the cache can hold */
+    int getCacheSize() const { return fifo.getTotalSize() - 1; }
+
+    /** Returns the number of samples read ahead of playback */
+    int getNumCached() const { return fifo.getNumReady(); }
+
+    /** Moves playback and reading to a sample number, and empties the cache */
+    void resetPlayback (int64 sampleNumber);
+
+    /** Reads as many samples as fit into the cache. Returns false if it was already full. */
+    bool fillCache (const ReadFunction& read);
+
+    /** Returns the samples of a stream that are due in a block of blockSize device samples,
+        given the device samples played so far (the shared clock of all streams). samplesToPlay
+        fit into the block; samplesToSkip are due as well, but don't fit into the block because
+        the stream is sampled faster than the device, and are skipped to keep the stream in time */
+    static void getSamplesDue (int64 deviceSamplesPlayed,
+                               double deviceSampleRate,
+                               double streamSampleRate,
+                               int64 streamSamplesPlayed,
+                               int blockSize,
+                               int& samplesToPlay,
+                               int64& samplesToSkip);
+
+    /** Returns the samples of this stream that are due in a block (see the static version) */
+    void getSamplesDue (int64 deviceSamplesPlayed,
+                        double deviceSampleRate,
+                        int blockSize,
+                        int& samplesToPlay,
+                        int64& samplesToSkip) const;
+
+    /** Copies up to samplesToPlay cached samples into channels firstChannel onwards of the
+        buffer, then skips up to samplesToSkip cached samples if all of them were copied,
+        and advances the playback position, looping at the end of the playback range if
+        shouldLoop is true. Plays fewer samples if the cache runs short. */
+    Block play (AudioBuffer<float>& buffer, int firstChannel, int samplesToPlay, int64 samplesToSkip, bool shouldLoop);
+
+private:
+    /** Copies cached samples into the output buffer. Returns the number of samples copied. */
+    int readFromCache (AudioBuffer<float>& buffer, int firstChannel, int numSamplesToRead);
+
+    /** Discards up to numSamplesToSkip cached samples. Returns the number of samples discarded. */
+    int skipCache (int numSamplesToSkip);
+
+    /** Interleaved samples read ahead of playback */
+    AbstractFifo fifo { 1 };
+    HeapBlock<float> cache;
+};
+
+#endif // PLAYBACKSTREAM_H_INCLUDED
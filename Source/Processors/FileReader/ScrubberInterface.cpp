@@ -56,27 +56,27 @@ void FullTimeline::paint (Graphics& g)
 
     std::map<int, bool> eventMap; //keeps track of events that would get rendered at the same timeline position
 
-    for (auto info : fileReader->getActiveEventInfo())
+    const EventInfo& info = fileReader->getActiveEventInfo();
+
+    // events are sorted, so only those within the visible range are visited
+    for (size_t i = info.findFirstEvent (startSample); i < info.size() && info.sampleNumbers[i] <= stopSample; i++)
     {
-        for (int i = 0; i < info.sampleNumbers.size(); i++)
-        {
-            int64 sampleNumber = info.sampleNumbers[i]; //TODO: Update EventInfo object name timestamps -> sampleNumbers
-            int16 state = info.channelStates[i];
+        int64 sampleNumber = info.sampleNumbers[i];
+        int16 state = info.channelStates[i];
 
-            if (state && sampleNumber >= startSample && sampleNumber <= stopSample)
-            {
-                float timelinePos = (sampleNumber - startSample) / float (totalSamples) * getWidth();
+        if (state)
+        {
+            float timelinePos = (sampleNumber - startSample) / float (totalSamples) * getWidth();
 
-                //if timelinePos is already in eventMap, skip overlaying a new event to avoid bogging down the GUI while scrubbing
-                if (eventMap.find (timelinePos) != eventMap.end())
-                    continue;
-                eventMap[timelinePos] = true;
-                Colour c = eventChannelColours[info.channels[i] + 1];
-                g.setColour (c);
+            //if timelinePos is already in eventMap, skip overlaying a new event to avoid bogging down the GUI while scrubbing
+            if (eventMap.find (timelinePos) != eventMap.end())
+                continue;
+            eventMap[timelinePos] = true;
+            Colour c = eventChannelColours[info.channels[i] + 1];
+            g.setColour (c);
 
-                g.setOpacity (1.0f);
-                g.fillRoundedRectangle (timelinePos, 0, 1, this->getHeight() - tickHeight, 0.2);
-            }
+            g.setOpacity (1.0f);
+            g.fillRoundedRectangle (timelinePos, 0, 1, this->getHeight() - tickHeight, 0.2);
         }
     }
 
@@ -200,21 +200,20 @@ void ZoomTimeline::paint (Graphics& g)
     int64 startSampleNumber = float (startMs) / 1000.0f * sampleRate + offset;
     int64 stopSampleNumber = startSampleNumber + intervalSamples;
 
-    for (auto info : fileReader->getActiveEventInfo())
+    const EventInfo& info = fileReader->getActiveEventInfo();
+
+    for (size_t i = info.findFirstEvent (startSampleNumber); i < info.size() && info.sampleNumbers[i] <= stopSampleNumber; i++)
     {
-        for (int i = 0; i < info.sampleNumbers.size(); i++)
-        {
-            int64 sampleNumber = info.sampleNumbers[i];
-            int16 state = info.channelStates[i];
+        int64 sampleNumber = info.sampleNumbers[i];
+        int16 state = info.channelStates[i];
 
-            if (state && sampleNumber >= startSampleNumber && sampleNumber <= stopSampleNumber)
-            {
-                float timelinePos = (sampleNumber - startSampleNumber) / float (intervalSamples) * getWidth();
-                Colour c = eventChannelColours[info.channels[i] + 1];
-                g.setColour (c);
-                g.setOpacity (1.0f);
-                g.fillRect (int (timelinePos), tickHeight, 1, this->getHeight() - tickHeight);
-            }
+        if (state)
+        {
+            float timelinePos = (sampleNumber - startSampleNumber) / float (intervalSamples) * getWidth();
+            Colour c = eventChannelColours[info.channels[i] + 1];
+            g.setColour (c);
+            g.setOpacity (1.0f);
+            g.fillRect (int (timelinePos), tickHeight, 1, this->getHeight() - tickHeight);
         }
     }
 
@@ -27,6 +27,7 @@
 #include "../../Processors/ProcessorGraph/ProcessorGraph.h"
 #include "../../Utils/Utils.h"
 #include "../Editors/GenericEditor.h"
+#include "../Events/TTLWordDecoder.h"
 
 #include "../Settings/ConfigurationObject.h"
 #include "../Settings/DataStream.h"
@@ -64,37 +65,40 @@ void LatencyMeter::update (const Array<const DataStream*>& dataStreams)
     }
 }
 
-void LatencyMeter::setLatestLatency (std::map<uint16, juce::int64>& processStartTimes, bool headlessMode)
+void LatencyMeter::setLatestLatency (const StreamBlockTable& blockTable, bool headlessMode)
 {
     if (counter % 10 == 0) // update latency estimate every 10 process blocks
     {
         auto currentTime = juce::Time::getHighResolutionTicks();
 
-        for (auto& entry : processStartTimes)
+        for (int i = 0; i < blockTable.size(); i++)
         {
-            latencies[entry.first].emplace_back (static_cast<int> (currentTime - entry.second));
-            if (latencies[entry.first].size() > 10)
-                latencies[entry.first].erase (latencies[entry.first].begin()); // Keep the size to 10
+            std::vector<int>& streamLatencies = latencies[blockTable.getStreamId (i)];
+
+            streamLatencies.emplace_back (static_cast<int> (currentTime - blockTable.processStartTimes[i]));
+            if (streamLatencies.size() > 10)
+                streamLatencies.erase (streamLatencies.begin()); // Keep the size to 10
         }
 
         if (counter % 50 == 0) // compute mean latency every 50 process blocks
         {
-            for (auto& entry : processStartTimes)
+            for (int i = 0; i < blockTable.size(); i++)
             {
+                const uint16 streamId = blockTable.getStreamId (i);
                 float totalLatency = 0.0f;
 
-                for (auto latency : latencies[entry.first])
+                for (auto latency : latencies[streamId])
                     totalLatency += static_cast<float> (latency);
 
                 totalLatency = (totalLatency / 10.0f) / static_cast<float> (juce::Time::getHighResolutionTicksPerSecond()) * 1000.0f;
 
                 if (! headlessMode)
-                    processor->getEditor()->setMeanLatencyMs (entry.first, totalLatency);
+                    processor->getEditor()->setMeanLatencyMs (streamId, totalLatency);
 
                 // Store the latest total latency in a thread-safe manner
                 {
                     std::lock_guard<std::mutex> lock (latencyMutex);
-                    latestLatencies[entry.first] = totalLatency;
+                    latestLatencies[streamId] = totalLatency;
                 }
             }
         }
@@ -663,11 +667,7 @@ void GenericProcessor::clearSettings()
 
     ttlEventChannel = nullptr;
 
-    startTimestampsForBlock.clear();
-    startSamplesForBlock.clear();
-    syncStreamIds.clear();
-    numSamplesInBlock.clear();
-    processStartTimes.clear();
+    blockTable.clear();
 }
 
 void GenericProcessor::setStreamEnabled (uint16 streamId, bool isEnabled)
@@ -823,6 +823,8 @@ int GenericProcessor::copyDataStreamSettings (const DataStream* stream, int cont
     dataStreams.getLast()->clearChannels();
     dataStreams.getLast()->addProcessor (this);
 
+    continuousChannels.ensureStorageAllocated (continuousChannels.size() + stream->getChannelCount());
+
     for (auto continuousChannel : stream->getContinuousChannels())
     {
         if (false)
@@ -1155,6 +1157,10 @@ void GenericProcessor::update()
 
     updateChannelIndexMaps();
 
+    reserveEventScratch();
+
+    updateOutputLayout();
+
     m_needsToSendTimestampMessages.clear();
     for (auto stream : getDataStreams())
         m_needsToSendTimestampMessages[stream->getStreamId()] = true;
@@ -1172,12 +1178,151 @@ void GenericProcessor::update()
     LOGG ("    TOTAL TIME: ", MS_FROM_START, " milliseconds");
 }
 
+/** Adds a metadata descriptor to an output layout */
+static void writeMetadataDescriptor (MemoryOutputStream& layout, const MetadataDescriptor* descriptor)
+{
+    layout.writeInt ((int) descriptor->getType());
+    layout.writeInt ((int) descriptor->getLength());
+    layout.writeString (descriptor->getName());
+    layout.writeString (descriptor->getDescription());
+    layout.writeString (descriptor->getIdentifier());
+}
+
+/** Adds everything that copies of an InfoObject share to an output layout:
+    its names and indexes, group, position, history, processor chain and metadata */
+static void writeInfoObject (MemoryOutputStream& layout, const InfoObject* info)
+{
+    layout.write (info->getUniqueId().getRawData(), 16);
+    layout.writeInt ((int) info->getType());
+    layout.writeString (info->getName());
+    layout.writeString (info->getDescription());
+    layout.writeString (info->getIdentifier());
+    layout.writeInt (info->getLocalIndex());
+    layout.writeInt (info->getGlobalIndex());
+    layout.writeInt (info->getNodeId());
+    layout.writeString (info->getNodeName());
+    layout.writeInt (info->getSourceNodeId());
+    layout.writeString (info->getSourceNodeName());
+
+    layout.writeString (info->group.name);
+    layout.writeInt (info->group.number);
+
+    layout.writeFloat (info->position.x);
+    layout.writeFloat (info->position.y);
+    layout.writeFloat (info->position.z);
+    layout.writeString (info->position.description);
+
+    // the history and processor chain are written as the hashes their last entries hold,
+    // so that writing them doesn't take longer for channels further down the signal chain
+    layout.writeInt64 (info->getHistoryHash());
+    layout.writeInt (info->processorChain.size());
+    layout.writeInt64 (info->processorChain.getHash());
+
+    for (int i = 0; i < info->getMetadataCount(); i++)
+    {
+        const MetadataValue* value = info->getMetadataValue (i);
+
+        writeMetadataDescriptor (layout, info->getMetadataDescriptor (i));
+        layout.write (value->getRawValuePointer(), value->getDataSize());
+    }
+}
+
+void GenericProcessor::updateOutputLayout()
+{
+    MemoryOutputStream layout (outputLayout.getSize());
+
+    layout.writeString (getName());
+    layout.writeBool (isEnabled);
+
+    for (auto stream : dataStreams)
+    {
+        writeInfoObject (layout, stream);
+
+        layout.writeShort ((short) stream->getStreamId());
+        layout.writeFloat (stream->getSampleRate());
+        layout.writeBool (stream->generatesTimestamps());
+        layout.writeInt64 ((int64) (pointer_sized_int) stream->device);
+    }
+
+    for (auto channel : continuousChannels)
+    {
+        writeInfoObject (layout, channel);
+
+        layout.writeShort ((short) channel->getStreamId());
+        layout.writeFloat (channel->getBitVolts());
+        layout.writeString (channel->getUnits());
+        layout.writeInt (channel->getChannelType());
+        layout.writeBool (channel->isRecorded);
+        layout.writeFloat (channel->inputRange.min);
+        layout.writeFloat (channel->inputRange.max);
+        layout.writeFloat (channel->impedance.magnitude);
+        layout.writeFloat (channel->impedance.phase);
+        layout.writeBool (channel->impedance.measured);
+    }
+
+    for (auto channel : eventChannels)
+    {
+        writeInfoObject (layout, channel);
+
+        layout.writeShort ((short) channel->getStreamId());
+        layout.writeInt (channel->getType());
+        layout.writeInt (channel->getBinaryDataType());
+        layout.writeInt ((int) channel->getLength());
+        layout.writeInt (channel->getMaxTTLBits());
+        layout.writeInt ((int) channel->getDataSize());
+        layout.writeBool (channel->isRecorded);
+
+        for (int line = 0; line < channel->getMaxTTLBits(); line++)
+            layout.writeString (channel->getLineLabel (line));
+
+        for (int i = 0; i < channel->getEventMetadataCount(); i++)
+            writeMetadataDescriptor (layout, channel->getEventMetadataDescriptor (i));
+    }
+
+    for (auto channel : spikeChannels)
+    {
+        writeInfoObject (layout, channel);
+
+        layout.writeShort ((short) channel->getStreamId());
+        layout.writeInt (channel->getChannelType());
+        layout.writeInt ((int) channel->getNumChannels());
+        layout.writeInt ((int) channel->getPrePeakSamples());
+        layout.writeInt ((int) channel->getPostPeakSamples());
+        layout.writeBool (channel->sendFullWaveform);
+        layout.writeBool (channel->isRecorded);
+
+        for (int ch = 0; ch < channel->localChannelIndexes.size(); ch++)
+        {
+            layout.writeInt (channel->localChannelIndexes[ch]);
+            layout.writeBool (channel->detectSpikesOnChannel (ch));
+        }
+
+        if (channel->thresholder != nullptr)
+        {
+            for (float threshold : channel->thresholder->getThresholds())
+                layout.writeFloat (threshold);
+        }
+
+        for (int i = 0; i < channel->getEventMetadataCount(); i++)
+            writeMetadataDescriptor (layout, channel->getEventMetadataDescriptor (i));
+    }
+
+    for (auto configurationObject : configurationObjects)
+        writeInfoObject (layout, configurationObject);
+
+    outputLayoutChanged = ! outputLayout.matches (layout.getData(), layout.getDataSize());
+
+    if (outputLayoutChanged)
+        outputLayout.replaceAll (layout.getData(), layout.getDataSize());
+}
+
 void GenericProcessor::updateChannelIndexMaps()
 {
     continuousChannelMap.clear();
     eventChannelMap.clear();
     spikeChannelMap.clear();
     dataStreamMap.clear();
+    blockTable.clear();
 
     if (dataStreams.size() == 0)
         return;
@@ -1218,6 +1363,8 @@ void GenericProcessor::updateChannelIndexMaps()
         spikeChannelMap[processorId][streamId][localIndex] = chan;
     }
 
+    Array<uint16> streamIds;
+
     for (int i = 0; i < dataStreams.size(); i++)
     {
         DataStream* stream = dataStreams[i];
@@ -1225,8 +1372,11 @@ void GenericProcessor::updateChannelIndexMaps()
         uint16 streamId = stream->getStreamId();
 
         dataStreamMap[streamId] = stream;
+        streamIds.add (streamId);
     }
 
+    blockTable.setStreams (streamIds);
+
     if (latencyMeter != nullptr)
         latencyMeter->update (getDataStreams());
 }
@@ -1241,19 +1391,52 @@ void GenericProcessor::getDefaultEventInfo (Array<DefaultEventInfo>& events, int
     events.clear();
 }
 
+StreamIndex GenericProcessor::getStreamIndex (uint16 streamId) const
+{
+    const int index = blockTable.getIndex (streamId);
+
+    if (index < 0)
+        throw std::out_of_range ("Stream " + std::to_string (streamId) + " does not belong to " + getName().toStdString());
+
+    return StreamIndex (index);
+}
+
 uint32 GenericProcessor::getNumSamplesInBlock (uint16 streamId) const
 {
-    return numSamplesInBlock.at (streamId);
+    return getNumSamplesInBlock (getStreamIndex (streamId));
+}
+
+int GenericProcessor::getStreamBlockSize (StreamIndex stream) const
+{
+    jassert (isPositiveAndBelow (stream.index, dataStreams.size()));
+
+    return getStreamBlockSize (dataStreams[stream.index]->getSampleRate(), AudioProcessor::getSampleRate(), getBlockSize());
+}
+
+int GenericProcessor::getStreamBlockSize (float streamSampleRate, double blockSampleRate, int blockSize)
+{
+    if (blockSize <= 0)
+        return 0;
+
+    if (streamSampleRate <= 0.0f || blockSampleRate <= 0.0)
+        return blockSize;
+
+    const int expectedSamples = int (std::ceil (double (blockSize) * double (streamSampleRate) / blockSampleRate));
+
+    // slow streams may still arrive in packets of several samples
+    const int minimumSize = jmin (blockSize, 64);
+
+    return jlimit (minimumSize, blockSize, 2 * expectedSamples);
 }
 
 int64 GenericProcessor::getFirstSampleNumberForBlock (uint16 streamId) const
 {
-    return startSamplesForBlock.at (streamId);
+    return getFirstSampleNumberForBlock (getStreamIndex (streamId));
 }
 
 double GenericProcessor::getFirstTimestampForBlock (uint16 streamId) const
 {
-    return startTimestampsForBlock.at (streamId);
+    return getFirstTimestampForBlock (getStreamIndex (streamId));
 }
 
 void GenericProcessor::setTimestampAndSamples (int64 sampleNumber,
@@ -1262,7 +1445,7 @@ void GenericProcessor::setTimestampAndSamples (int64 sampleNumber,
                                                uint16 streamId,
                                                uint16 syncStreamId)
 {
-    HeapBlock<char> data;
+    char data[TIMESTAMP_AND_SAMPLES_SIZE];
     size_t dataSize = SystemEvent::fillTimestampAndSamplesData (data,
                                                                 this,
                                                                 streamId,
@@ -1274,11 +1457,11 @@ void GenericProcessor::setTimestampAndSamples (int64 sampleNumber,
 
     m_currentMidiBuffer->addEvent (data, int (dataSize), 0);
 
-    //since the processor generating the timestamp won't get the event, add it to the map
-    startTimestampsForBlock[streamId] = timestamp;
-    startSamplesForBlock[streamId] = sampleNumber;
-    syncStreamIds[streamId] = syncStreamId;
-    processStartTimes[streamId] = m_initialProcessTime;
+    //since the processor generating the timestamp won't get the event, add it to the table
+    const int streamIndex = blockTable.getIndex (streamId);
+
+    if (streamIndex >= 0)
+        blockTable.set (streamIndex, sampleNumber, timestamp, blockTable.numSamplesInBlock[streamIndex], syncStreamId, m_initialProcessTime);
 }
 
 int GenericProcessor::getGlobalChannelIndex (uint16 streamId, int localIndex) const
@@ -1316,11 +1499,11 @@ int GenericProcessor::processEventBuffer()
                 uint32 nSamples = *reinterpret_cast<const uint32*> (dataptr + 24);
                 int64 initialTicks = *reinterpret_cast<const int64*> (dataptr + 28);
 
-                startSamplesForBlock[sourceStreamId] = startSample;
-                startTimestampsForBlock[sourceStreamId] = startTimestamp;
-                syncStreamIds[sourceStreamId] = syncStreamId;
-                numSamplesInBlock[sourceStreamId] = nSamples;
-                processStartTimes[sourceStreamId] = initialTicks;
+                // events from streams that don't pass through this processor are ignored
+                const int streamIndex = blockTable.getIndex (sourceStreamId);
+
+                if (streamIndex >= 0)
+                    blockTable.set (streamIndex, startSample, startTimestamp, nSamples, syncStreamId, initialTicks);
             }
             else if (static_cast<Event::Type> (*dataptr) == Event::Type::PROCESSOR_EVENT
                      && static_cast<EventChannel::Type> (*(dataptr + 1) == EventChannel::Type::TTL))
@@ -1337,9 +1520,17 @@ int GenericProcessor::processEventBuffer()
             else if (static_cast<Event::Type> (*dataptr) == Event::Type::PROCESSOR_EVENT
                      && static_cast<EventChannel::Type> (*(dataptr + 1) == EventChannel::Type::TEXT))
             {
-                TextEventPtr textEvent = TextEvent::deserialize (dataptr, getMessageChannel());
+                // read the packet in place rather than deserializing a TextEvent
+                const EventChannel* messageChannel = getMessageChannel();
+
+                if (*reinterpret_cast<const uint16*> (dataptr + 2) == messageChannel->getSourceNodeId())
+                {
+                    int64 sampleNumber = *reinterpret_cast<const int64*> (dataptr + 8);
+                    String text = String::fromUTF8 (reinterpret_cast<const char*> (dataptr + EVENT_BASE_SIZE),
+                                                    int (messageChannel->getDataSize()));
 
-                handleBroadcastMessage (textEvent->getText(), textEvent->getSampleNumber());
+                    handleBroadcastMessage (text, sampleNumber);
+                }
             }
         }
     }
@@ -1351,11 +1542,13 @@ int GenericProcessor::checkForEvents (bool checkForSpikes)
 {
     if (m_currentMidiBuffer->getNumEvents() > 0)
     {
-        /** Since adding events to the buffer inside this loop could be dangerous, create a temporary event buffer
-		    so any call to addEvent will operate on it; */
-        MidiBuffer temporaryEventBuffer;
+        /** Since adding events to the buffer inside this loop could be dangerous, use a separate event buffer
+		    so any call to addEvent will operate on it (it keeps its storage between blocks) */
+        jassert (m_currentMidiBuffer != &pendingEventBuffer);
+
+        pendingEventBuffer.clear();
         MidiBuffer* originalEventBuffer = m_currentMidiBuffer;
-        m_currentMidiBuffer = &temporaryEventBuffer;
+        m_currentMidiBuffer = &pendingEventBuffer;
 
         for (const auto meta : *originalEventBuffer)
         {
@@ -1381,7 +1574,7 @@ int GenericProcessor::checkForEvents (bool checkForSpikes)
 
                 if (spikeChannel != nullptr)
                 {
-                    handleSpike (Spike::deserialize (meta.data, spikeChannel));
+                    handleSpikeView (Spike::View (meta.data, spikeChannel));
                 }
             }
         }
@@ -1389,9 +1582,9 @@ int GenericProcessor::checkForEvents (bool checkForSpikes)
         // been added here, copy them to the original buffer
         m_currentMidiBuffer = originalEventBuffer;
 
-        if (temporaryEventBuffer.getNumEvents() > 0)
+        if (pendingEventBuffer.getNumEvents() > 0)
         {
-            m_currentMidiBuffer->addEvents (temporaryEventBuffer, 0, -1, 0);
+            m_currentMidiBuffer->addEvents (pendingEventBuffer, 0, -1, 0);
         }
 
         return 0;
@@ -1404,7 +1597,7 @@ void GenericProcessor::addEvent (const Event* event, int sampleNum)
 {
     size_t size = event->getChannelInfo()->getDataSize() + event->getChannelInfo()->getTotalEventMetadataSize() + EVENT_BASE_SIZE;
 
-    HeapBlock<char> buffer (size);
+    char* buffer = getEventScratch (size);
 
     event->serialize (buffer, size);
 
@@ -1424,6 +1617,37 @@ void GenericProcessor::addEvent (const Event* event, int sampleNum)
     }
 }
 
+void GenericProcessor::addTTLWord (EventChannel* channel, int64 sampleNumber, uint64 word, int sampleNum)
+{
+    // packets with metadata are serialized by the TTLEvent objects
+    if (channel->getEventMetadataCount() != 0)
+    {
+        Array<TTLEventPtr> events = TTLEvent::createTTLEvent (channel, sampleNumber, word);
+
+        for (auto& event : events)
+            addEvent (event, sampleNum);
+
+        return;
+    }
+
+    GenericEditor* editor = headlessMode ? nullptr : getEditor();
+    const uint16 streamId = channel->getStreamId();
+
+    TTLWordDecoder::addLineChanges (*m_currentMidiBuffer,
+                                    channel,
+                                    sampleNumber,
+                                    sampleNum >= 0 ? sampleNum : 0,
+                                    channel->getTTLWord(),
+                                    word,
+                                    [channel, editor, streamId] (int line, bool state)
+                                    {
+                                        channel->setLineState (line, state);
+
+                                        if (editor != nullptr)
+                                            editor->setTTLState (streamId, line, state);
+                                    });
+}
+
 void GenericProcessor::addTTLChannel (String name)
 {
     if (dataStreams.size() == 0)
@@ -1463,11 +1687,7 @@ void GenericProcessor::flipTTLState (int sampleIndex, int lineIndex)
     bool currentState = ttlLineStates[lineIndex];
     ttlLineStates.set (lineIndex, ! currentState);
 
-    int64 startSample = startSamplesForBlock[ttlEventChannel->getStreamId()] + sampleIndex;
-
-    TTLEventPtr eventPtr = TTLEvent::createTTLEvent (ttlEventChannel, startSample, lineIndex, ! currentState);
-
-    addEvent (eventPtr, sampleIndex);
+    addTTLLineChange (sampleIndex, lineIndex, ! currentState);
 }
 
 void GenericProcessor::setTTLState (int sampleIndex, int lineIndex, bool state)
@@ -1477,11 +1697,69 @@ void GenericProcessor::setTTLState (int sampleIndex, int lineIndex, bool state)
 
     ttlLineStates.set (lineIndex, state);
 
-    int64 startSample = startSamplesForBlock[ttlEventChannel->getStreamId()] + sampleIndex;
+    addTTLLineChange (sampleIndex, lineIndex, state);
+}
+
+void GenericProcessor::addTTLLineChange (int sampleIndex, int lineIndex, bool state)
+{
+    int64 startSample = getFirstSampleNumberForBlock (ttlEventChannel->getStreamId()) + sampleIndex;
+
+    if (ttlEventChannel->getEventMetadataCount() != 0)
+    {
+        TTLEventPtr eventPtr = TTLEvent::createTTLEvent (ttlEventChannel, startSample, lineIndex, state);
+
+        addEvent (eventPtr, sampleIndex);
 
-    TTLEventPtr eventPtr = TTLEvent::createTTLEvent (ttlEventChannel, startSample, lineIndex, state);
+        return;
+    }
 
-    addEvent (eventPtr, sampleIndex);
+    // serialize the packet directly, without creating a TTLEvent
+    ttlEventChannel->setLineState (lineIndex, state);
+
+    uint8 packet[TTL_PACKET_SIZE];
+
+    TTLWordDecoder::writePacket (packet, ttlEventChannel, startSample, lineIndex, state, ttlEventChannel->getTTLWord());
+
+    m_currentMidiBuffer->addEvent (packet, TTL_PACKET_SIZE, sampleIndex >= 0 ? sampleIndex : 0);
+
+    if (! headlessMode)
+        getEditor()->setTTLState (ttlEventChannel->getStreamId(), lineIndex, state);
+}
+
+void GenericProcessor::reserveEventScratch()
+{
+    size_t maxSize = TIMESTAMP_AND_SAMPLES_SIZE;
+
+    for (auto eventChannel : eventChannels)
+        maxSize = jmax (maxSize, EVENT_BASE_SIZE + eventChannel->getDataSize() + eventChannel->getTotalEventMetadataSize());
+
+    for (auto spikeChannel : spikeChannels)
+        maxSize = jmax (maxSize,
+                        SPIKE_BASE_SIZE
+                            + spikeChannel->getDataSize()
+                            + spikeChannel->getTotalEventMetadataSize()
+                            + spikeChannel->getNumChannels() * sizeof (float));
+
+    if (maxSize > eventScratchSize)
+    {
+        eventScratch.malloc (maxSize);
+        eventScratchSize = maxSize;
+    }
+
+    // room for a few hundred packets (each stored with a 6-byte header)
+    pendingEventBuffer.ensureSize (256 * (maxSize + 6));
+}
+
+char* GenericProcessor::getEventScratch (size_t size)
+{
+    if (size > eventScratchSize)
+    {
+        // only happens for events on channels this processor doesn't own
+        eventScratch.malloc (size);
+        eventScratchSize = size;
+    }
+
+    return eventScratch.getData();
 }
 
 bool GenericProcessor::getTTLState (int lineIndex)
@@ -1509,17 +1787,31 @@ void GenericProcessor::addSpike (const Spike* spike)
                   + spike->spikeChannel->getTotalEventMetadataSize()
                   + spike->spikeChannel->getNumChannels() * sizeof (float);
 
-    HeapBlock<char> buffer (size);
+    char* buffer = getEventScratch (size);
 
     spike->serialize (buffer, size);
 
     m_currentMidiBuffer->addEvent (buffer, int (size), 0);
 }
 
+void GenericProcessor::addSpike (const Spike::Packet& packet)
+{
+    m_currentMidiBuffer->addEvent (packet.getRawData(), int (packet.getSize()), 0);
+}
+
+void GenericProcessor::handleSpikeView (const Spike::View& spike)
+{
+    handleSpike (Spike::deserialize (spike));
+}
+
 void GenericProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& eventBuffer)
 {
+    const int64 blockStartTime = Time::getHighResolutionTicks();
+
+    ProcessorProfiler::AllocationCounter allocations;
+
     if (isSource())
-        m_initialProcessTime = Time::getHighResolutionTicks();
+        m_initialProcessTime = blockStartTime;
 
     m_currentMidiBuffer = &eventBuffer;
 
@@ -1527,7 +1819,15 @@ void GenericProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& eve
 
     process (buffer);
 
-    latencyMeter->setLatestLatency (processStartTimes, headlessMode);
+    latencyMeter->setLatestLatency (blockTable, headlessMode);
+
+    // the whole graph must finish within one audio callback
+    const double callbackRate = AudioProcessor::getSampleRate();
+    const int64 deadline = callbackRate > 0.0
+                               ? int64 (double (Time::getHighResolutionTicksPerSecond()) * getBlockSize() / callbackRate)
+                               : 0;
+
+    profiler.addBlock (Time::getHighResolutionTicks() - blockStartTime, deadline, allocations.getCount());
 }
 
 Array<const EventChannel*> GenericProcessor::getEventChannels()
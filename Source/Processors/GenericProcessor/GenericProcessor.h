@@ -27,6 +27,8 @@
 #include <JuceHeader.h>
 
 #include "GenericProcessorBase.h"
+#include "ProcessorProfiler.h"
+#include "StreamBlockTable.h"
 
 #include "../../CoreServices.h"
 #include "../../Processors/Dsp/LinearSmoothedValueAtomic.h"
@@ -77,7 +79,7 @@ public:
     LatencyMeter (GenericProcessor* processor);
 
     /** Sets the latest latency values for each data stream */
-    void setLatestLatency (std::map<uint16, juce::int64>& processStartTimes, bool headlessMode);
+    void setLatestLatency (const StreamBlockTable& blockTable, bool headlessMode);
 
     /** Returns the latest latency values for each data stream */
     float getLatestLatency (uint16 streamId);
@@ -119,6 +121,7 @@ class PLUGIN_API GenericProcessor : public GenericProcessorBase, public PluginCl
     friend class GenericEditor;
     friend class Splitter;
     friend class Merger;
+    friend class ParallelGraphRenderer;
 
 public:
     /** Constructor (sets the processor's name). */
@@ -481,6 +484,14 @@ public:
     /** Method for updating settings, called by ProcessorGraph.*/
     void update();
 
+    /** Returns true if the last call to update() changed the streams, channels or
+        configuration objects this processor passes downstream (any of the settings
+        their copies share, including positions, groups and metadata values), or
+        whether it is enabled.
+
+        The ProcessorGraph only updates downstream processors if this is true. */
+    bool hasOutputLayoutChanged() const { return outputLayoutChanged; }
+
     // --------------------------------------------
     //     LOADING / SAVING SETTINGS
     // --------------------------------------------
@@ -595,9 +606,25 @@ public:
     /** Returns the most recent latency measurement for a given stream in this processor */
     double getLatency (uint16 streamId) const { return latencyMeter->getLatestLatency (streamId); }
 
+    /** Returns the execution time statistics of this processor's processBlock() calls */
+    ProcessorProfiler& getProfiler() { return profiler; }
+
     /** Returns the plugin specific recording directory derived from the global recording path */
     File getPluginRecordingDirectory();
 
+    /** Returns the largest number of samples the stream at a given index delivers in one block.
+
+        A stream sampled below the rate of the graph's blocks fills only part of each
+        block, so buffers that hold a stream's data only need to be this long,
+        rather than getBlockSize() samples. Returns 0 before the processor has been
+        prepared to play. */
+    int getStreamBlockSize (StreamIndex stream) const;
+
+    /** Returns the block size of a stream sampled at streamSampleRate, for blocks of
+        blockSize samples at blockSampleRate: twice the samples expected per block (as
+        sources deliver data unevenly), at least 64 samples and no more than blockSize */
+    static int getStreamBlockSize (float streamSampleRate, double blockSampleRate, int blockSize);
+
 protected:
     static std::map<int, std::vector<ProcessorAction*>> undoableActions;
 
@@ -614,6 +641,31 @@ protected:
     /** Used to get the current timestamp for a given stream.*/
     double getFirstTimestampForBlock (uint16 streamId) const;
 
+    /** Returns the index of a stream in this processor's list of streams,
+        for use with the StreamIndex accessors below */
+    StreamIndex getStreamIndex (uint16 streamId) const;
+
+    /** Returns the number of samples in the current block for the stream at a given index (O(1)) */
+    uint32 getNumSamplesInBlock (StreamIndex stream) const noexcept
+    {
+        jassert (isPositiveAndBelow (stream.index, blockTable.size()));
+        return blockTable.numSamplesInBlock[stream.index];
+    }
+
+    /** Returns the first sample number of the current block for the stream at a given index (O(1)) */
+    int64 getFirstSampleNumberForBlock (StreamIndex stream) const noexcept
+    {
+        jassert (isPositiveAndBelow (stream.index, blockTable.size()));
+        return blockTable.startSamples[stream.index];
+    }
+
+    /** Returns the first timestamp of the current block for the stream at a given index (O(1)) */
+    double getFirstTimestampForBlock (StreamIndex stream) const noexcept
+    {
+        jassert (isPositiveAndBelow (stream.index, blockTable.size()));
+        return blockTable.startTimestamps[stream.index];
+    }
+
     /** Used to set the timestamp for a given buffer, for a given DataStream. */
     void setTimestampAndSamples (int64 startSampleForBlock,
                                  double startTimestampForBlock,
@@ -643,9 +695,14 @@ protected:
     /** Allows processors to respond to incoming TTL events; called by checkForEvents() */
     virtual void handleTTLEvent (TTLEventPtr event) {}
 
-    /** Allows processors to respond to incoming spikes; called by checkForEvents(true) */
+    /** Allows processors to respond to incoming spikes; called by handleSpikeView() */
     virtual void handleSpike (SpikePtr spike) {}
 
+    /** Allows processors to respond to incoming spikes without creating a Spike object;
+        called by checkForEvents(true). The default implementation deserializes the spike
+        and calls handleSpike(). The view is only valid during the call. */
+    virtual void handleSpikeView (const Spike::View& spike);
+
     /** Returns info about the default events a specific subprocessor generates.
 	Called by createEventChannels(). It is not needed to implement if createEventChannels() is overridden */
     virtual void getDefaultEventInfo (Array<DefaultEventInfo>& events, int subProcessorIdx = 0) const;
@@ -657,6 +714,11 @@ protected:
     /** Add an event (usually a TTLEventPtr) to the processing buffer */
     void addEvent (const Event* event, int sampleNum);
 
+    /** Adds a TTL event for each line that differs between a channel's current TTL word and
+        a new word, and updates the channel's line states. Events are serialized directly into
+        the processing buffer, without creating TTLEvent objects. */
+    void addTTLWord (EventChannel* channel, int64 sampleNumber, uint64 word, int sampleNum);
+
     /** Sends a TEXT event to all other processors, via the MessageCenter, while acquisition is active.
         If recording is active, this message will be recorded */
     void broadcastMessage (String msg);
@@ -668,6 +730,9 @@ protected:
     /** Add a Spike event to the outgoing buffer */
     void addSpike (const Spike* event);
 
+    /** Add a serialized spike to the outgoing buffer, without allocating any memory */
+    void addSpike (const Spike::Packet& packet);
+
     /// OPTIONAL HELPER FUNCTIONS ///
 
     /** Create a simple TTL event channel with 8 lines on the first incoming data stream
@@ -749,20 +814,15 @@ private:
     /** Clears the settings arrays.*/
     void clearSettings();
 
-    /** Map between stream IDs and buffer sample counts. */
-    std::map<uint16, uint32> numSamplesInBlock;
-
-    /** Map between stream IDs and buffer timestamps. */
-    std::map<uint16, double> startTimestampsForBlock;
-
-    /** Map between stream IDs and buffer timestamps. */
-    std::map<uint16, int64> startSamplesForBlock;
+    /** Describes the settings that downstream processors copy, and records whether they changed */
+    void updateOutputLayout();
 
-    /** Map between stream IDs main clock stream IDs. */
-    std::map<uint16, uint16> syncStreamIds;
+    /** The settings recorded at the end of the last update() */
+    MemoryBlock outputLayout;
+    bool outputLayoutChanged = true;
 
-    /** Map between stream IDs and start time of process callbacks. */
-    std::map<uint16, int64> processStartTimes;
+    /** Sample numbers, timestamps and sizes of the current block, by stream index. */
+    StreamBlockTable blockTable;
 
     /** First software timestamp of process() callback. */
     juce::int64 m_initialProcessTime;
@@ -780,6 +840,17 @@ private:
     /** Extracts sample counts and timestamps from the MidiBuffer. */
     int processEventBuffer();
 
+    /** Reserves the scratch space used to serialize events, based on the
+        largest event and spike packets this processor can create. */
+    void reserveEventScratch();
+
+    /** Returns scratch space of at least the given size for serializing one event packet.
+        Only grows (and allocates) if an event is larger than the reserved space. */
+    char* getEventScratch (size_t size);
+
+    /** Adds a packet for a line change of the default TTL channel */
+    void addTTLLineChange (int sampleIndex, int lineIndex, bool state);
+
     /** The type of the processor. */
     Plugin::Processor::Type m_processorType;
 
@@ -796,6 +867,13 @@ private:
     MidiBuffer* m_currentMidiBuffer;
     MidiBuffer messageCenterBuffer;
 
+    /** Receives the events added while checkForEvents() iterates over the block's events */
+    MidiBuffer pendingEventBuffer;
+
+    /** Scratch space for serializing events before they are copied into the event buffer */
+    HeapBlock<char> eventScratch;
+    size_t eventScratchSize = 0;
+
     typedef std::unordered_map<uint16,
                                std::unordered_map<uint16,
                                                   std::unordered_map<uint16,
@@ -831,6 +909,8 @@ private:
 
     std::unique_ptr<LatencyMeter> latencyMeter;
 
+    ProcessorProfiler profiler;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GenericProcessor);
 };
 
@@ -0,0 +1,212 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ProcessorProfiler.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#if OE_TRACK_AUDIO_ALLOCATIONS
+
+namespace
+{
+thread_local int64 allocationCount = 0;
+thread_local bool countingAllocations = false;
+} // namespace
+
+void* operator new (std::size_t size)
+{
+    if (countingAllocations)
+        allocationCount++;
+
+    if (void* ptr = std::malloc (size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void operator delete (void* ptr) noexcept { std::free (ptr); }
+void operator delete[] (void* ptr) noexcept { std::free (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept { std::free (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { std::free (ptr); }
+
+ProcessorProfiler::AllocationCounter::AllocationCounter()
+    : initialCount (allocationCount),
+      wasCounting (countingAllocations)
+{
+    countingAllocations = true;
+}
+
+ProcessorProfiler::AllocationCounter::~AllocationCounter()
+{
+    countingAllocations = wasCounting;
+}
+
+int64 ProcessorProfiler::AllocationCounter::getCount() const
+{
+    return allocationCount - initialCount;
+}
+
+#else
+
+ProcessorProfiler::AllocationCounter::AllocationCounter()
+    : initialCount (0),
+      wasCounting (false)
+{
+}
+
+ProcessorProfiler::AllocationCounter::~AllocationCounter() {}
+
+int64 ProcessorProfiler::AllocationCounter::getCount() const
+{
+    return 0;
+}
+
+#endif
+
+ProcessorProfiler::ProcessorProfiler()
+    : ticksPerMicrosecond (double (Time::getHighResolutionTicksPerSecond()) / 1.0e6)
+{
+    clear();
+}
+
+int ProcessorProfiler::getBin (double microseconds)
+{
+    if (! (microseconds >= 1.0))
+        return 0;
+
+    return jmin (numBins - 1, 1 + int (std::log2 (microseconds) * binsPerOctave));
+}
+
+double ProcessorProfiler::getBinUpperEdge (int bin)
+{
+    return std::exp2 (double (bin) / binsPerOctave);
+}
+
+void ProcessorProfiler::clear()
+{
+    for (auto& bin : bins)
+        bin.store (0, std::memory_order_relaxed);
+
+    numBlocks.store (0, std::memory_order_relaxed);
+    totalTicks.store (0, std::memory_order_relaxed);
+    maxTicks.store (0, std::memory_order_relaxed);
+    numOverruns.store (0, std::memory_order_relaxed);
+    deadlineTicks.store (0, std::memory_order_relaxed);
+    numAllocations.store (0, std::memory_order_relaxed);
+    numAllocatingBlocks.store (0, std::memory_order_relaxed);
+}
+
+void ProcessorProfiler::addBlock (int64 elapsedTicks, int64 deadline, int64 blockAllocations)
+{
+    if (resetRequested.exchange (false, std::memory_order_acquire))
+        clear();
+
+    // single writer, so plain load/store pairs are enough
+    const int bin = getBin (double (elapsedTicks) / ticksPerMicrosecond);
+    bins[bin].store (bins[bin].load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    totalTicks.store (totalTicks.load (std::memory_order_relaxed) + elapsedTicks, std::memory_order_relaxed);
+
+    if (elapsedTicks > maxTicks.load (std::memory_order_relaxed))
+        maxTicks.store (elapsedTicks, std::memory_order_relaxed);
+
+    if (deadline > 0 && elapsedTicks > deadline)
+        numOverruns.store (numOverruns.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    deadlineTicks.store (deadline, std::memory_order_relaxed);
+
+    if (blockAllocations > 0)
+    {
+        numAllocations.store (numAllocations.load (std::memory_order_relaxed) + blockAllocations, std::memory_order_relaxed);
+        numAllocatingBlocks.store (numAllocatingBlocks.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    numBlocks.store (numBlocks.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+double ProcessorProfiler::getPercentile (double fraction) const
+{
+    uint32 counts[numBins];
+    int64 total = 0;
+
+    for (int i = 0; i < numBins; i++)
+    {
+        counts[i] = bins[i].load (std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    if (total == 0)
+        return 0.0;
+
+    const double maxMs = double (maxTicks.load (std::memory_order_relaxed)) / ticksPerMicrosecond / 1000.0;
+    const double target = fraction * double (total);
+    int64 cumulative = 0;
+
+    for (int i = 0; i < numBins; i++)
+    {
+        cumulative += counts[i];
+
+        if (double (cumulative) >= target && counts[i] > 0)
+            return jmin (getBinUpperEdge (i) / 1000.0, maxMs);
+    }
+
+    return maxMs;
+}
+
+ProcessorProfiler::Statistics ProcessorProfiler::getStatistics() const
+{
+    Statistics statistics;
+
+    if (resetRequested.load (std::memory_order_acquire))
+        return statistics;
+
+    statistics.numBlocks = numBlocks.load (std::memory_order_acquire);
+
+    if (statistics.numBlocks == 0)
+        return statistics;
+
+    const double ticksPerMs = ticksPerMicrosecond * 1000.0;
+
+    statistics.meanMs = double (totalTicks.load (std::memory_order_relaxed)) / ticksPerMs / double (statistics.numBlocks);
+    statistics.maxMs = double (maxTicks.load (std::memory_order_relaxed)) / ticksPerMs;
+    statistics.numOverruns = numOverruns.load (std::memory_order_relaxed);
+    statistics.deadlineMs = double (deadlineTicks.load (std::memory_order_relaxed)) / ticksPerMs;
+    statistics.numAllocations = numAllocations.load (std::memory_order_relaxed);
+    statistics.numAllocatingBlocks = numAllocatingBlocks.load (std::memory_order_relaxed);
+    statistics.p50Ms = getPercentile (0.5);
+    statistics.p99Ms = getPercentile (0.99);
+
+    return statistics;
+}
+
+void ProcessorProfiler::reset()
+{
+    resetRequested.store (true, std::memory_order_release);
+}
@@ -0,0 +1,138 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PROCESSORPROFILER_H_INCLUDED
+#define PROCESSORPROFILER_H_INCLUDED
+
+#include <JuceHeader.h>
+
+#include "../PluginManager/PluginAPI.h"
+
+#include <atomic>
+
+/**
+    Collects the execution time of each call to a processor's processBlock()
+    method in a histogram with logarithmically spaced bins.
+
+    The audio thread is the only writer, and never locks or allocates.
+    Statistics can be read from any thread while blocks are being added;
+    they are approximate to within one bin width (about 9%).
+*/
+class PLUGIN_API ProcessorProfiler
+{
+public:
+    /** Summary of the execution times since the last reset */
+    struct Statistics
+    {
+        int64 numBlocks = 0;
+
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+
+        /** Number of blocks that took longer than the deadline */
+        int64 numOverruns = 0;
+
+        /** Deadline of the most recent block (the duration of the audio callback) */
+        double deadlineMs = 0.0;
+
+        /** Number of heap allocations made while processing blocks, and the
+            number of blocks that made any (only counted when the GUI is built
+            with OE_TRACK_AUDIO_ALLOCATIONS) */
+        int64 numAllocations = 0;
+        int64 numAllocatingBlocks = 0;
+    };
+
+    /**
+        Counts the calls to operator new made by the calling thread during its lifetime.
+
+        Counting requires the replacement operator new that is compiled in with
+        OE_TRACK_AUDIO_ALLOCATIONS; otherwise getCount() always returns 0.
+    */
+    class PLUGIN_API AllocationCounter
+    {
+    public:
+        /** Starts counting */
+        AllocationCounter();
+
+        /** Stops counting (unless an enclosing counter is still active) */
+        ~AllocationCounter();
+
+        /** Returns the number of allocations since this counter was created */
+        int64 getCount() const;
+
+    private:
+        int64 initialCount;
+        bool wasCounting;
+    };
+
+    /** Constructor */
+    ProcessorProfiler();
+
+    /** Adds the execution time of one block (called by the audio thread) */
+    void addBlock (int64 elapsedTicks, int64 deadline, int64 numAllocations = 0);
+
+    /** Returns the statistics of all blocks added since the last reset */
+    Statistics getStatistics() const;
+
+    /** Returns the time below which the given fraction of blocks completed, in ms */
+    double getPercentile (double fraction) const;
+
+    /** Clears the statistics; takes effect before the next block is added */
+    void reset();
+
+    /** Bins per doubling of the execution time */
+    static const int binsPerOctave = 8;
+
+    /** Number of bins; the first holds times below 1 us, the last anything above ~1 s */
+    static const int numBins = binsPerOctave * 20 + 2;
+
+    /** Returns the bin that holds an execution time in microseconds */
+    static int getBin (double microseconds);
+
+    /** Returns the upper edge of a bin, in microseconds */
+    static double getBinUpperEdge (int bin);
+
+private:
+    /** Clears all counters (called by the audio thread) */
+    void clear();
+
+    std::atomic<uint32> bins[numBins];
+
+    std::atomic<int64> numBlocks { 0 };
+    std::atomic<int64> totalTicks { 0 };
+    std::atomic<int64> maxTicks { 0 };
+    std::atomic<int64> numOverruns { 0 };
+    std::atomic<int64> deadlineTicks { 0 };
+    std::atomic<int64> numAllocations { 0 };
+    std::atomic<int64> numAllocatingBlocks { 0 };
+
+    std::atomic<bool> resetRequested { false };
+
+    const double ticksPerMicrosecond;
+
+    JUCE_DECLARE_NON_COPYABLE (ProcessorProfiler);
+};
+
+#endif // PROCESSORPROFILER_H_INCLUDED
@@ -0,0 +1,67 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "StreamBlockTable.h"
+
+template <typename Type>
+Type* StreamBlockTable::allocate (std::unique_ptr<void, AlignedDelete>& storage, int count)
+{
+    // round up to whole cache lines, so that no two arrays share one
+    const size_t numBytes = jmax (cacheLineSize, (count * sizeof (Type) + cacheLineSize - 1) / cacheLineSize * cacheLineSize);
+
+    storage.reset (::operator new (numBytes, std::align_val_t (cacheLineSize)));
+    memset (storage.get(), 0, numBytes);
+
+    return static_cast<Type*> (storage.get());
+}
+
+void StreamBlockTable::setStreams (const Array<uint16>& ids)
+{
+    numStreams = ids.size();
+
+    startSamples = allocate<int64> (startSampleStorage, numStreams);
+    startTimestamps = allocate<double> (startTimestampStorage, numStreams);
+    numSamplesInBlock = allocate<uint32> (numSamplesStorage, numStreams);
+    syncStreamIds = allocate<uint16> (syncStreamIdStorage, numStreams);
+    processStartTimes = allocate<int64> (processStartTimeStorage, numStreams);
+    streamIds = allocate<uint16> (streamIdStorage, numStreams);
+
+    indexById.clear();
+
+    for (int i = 0; i < numStreams; i++)
+    {
+        const uint16 streamId = ids[i];
+
+        streamIds[i] = streamId;
+
+        if (streamId >= indexById.size())
+            indexById.resize (streamId + 1, -1);
+
+        indexById[streamId] = i;
+    }
+}
+
+void StreamBlockTable::clear()
+{
+    setStreams ({});
+}
@@ -0,0 +1,132 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef STREAMBLOCKTABLE_H_INCLUDED
+#define STREAMBLOCKTABLE_H_INCLUDED
+
+#include <JuceHeader.h>
+
+#include "../PluginManager/PluginAPI.h"
+
+#include <memory>
+#include <new>
+#include <vector>
+
+/**
+    Position of a data stream within a processor's list of streams
+    (0 ... getNumDataStreams() - 1).
+
+    It is a distinct type so that it cannot be confused with a stream ID:
+    the GenericProcessor methods that take a StreamIndex are O(1) array reads,
+    while those that take a stream ID first look up the index.
+*/
+struct StreamIndex
+{
+    explicit StreamIndex (int index_) : index (index_) {}
+
+    int index;
+};
+
+/**
+    Holds the sample number, timestamp and size of the current block
+    for each of a processor's data streams.
+
+    Each field is stored in its own cache-line aligned array, indexed by
+    stream index, which is assigned when the processor's settings are updated.
+    Stream IDs are mapped to indices through a flat lookup table.
+
+    Written on the audio thread at the start of each block; resized on the
+    message thread while acquisition is stopped.
+*/
+class PLUGIN_API StreamBlockTable
+{
+public:
+    /** Constructor */
+    StreamBlockTable() = default;
+
+    /** Assigns an index to each stream ID (in order) and clears all values */
+    void setStreams (const Array<uint16>& streamIds);
+
+    /** Removes all streams */
+    void clear();
+
+    /** Returns the number of streams */
+    int size() const noexcept { return numStreams; }
+
+    /** Returns the index of a stream ID, or -1 if the stream is not in the table */
+    int getIndex (uint16 streamId) const noexcept
+    {
+        return streamId < indexById.size() ? indexById[streamId] : -1;
+    }
+
+    /** Returns the stream ID at an index */
+    uint16 getStreamId (int index) const noexcept { return streamIds[index]; }
+
+    /** Stores the values for one stream */
+    void set (int index, int64 startSample, double startTimestamp, uint32 numSamples, uint16 syncStreamId, int64 processStartTime) noexcept
+    {
+        jassert (isPositiveAndBelow (index, numStreams));
+
+        startSamples[index] = startSample;
+        startTimestamps[index] = startTimestamp;
+        numSamplesInBlock[index] = numSamples;
+        syncStreamIds[index] = syncStreamId;
+        processStartTimes[index] = processStartTime;
+    }
+
+    /** Per-stream values, indexed by stream index */
+    int64* startSamples = nullptr;
+    double* startTimestamps = nullptr;
+    uint32* numSamplesInBlock = nullptr;
+    uint16* syncStreamIds = nullptr;
+    int64* processStartTimes = nullptr;
+
+private:
+    static constexpr size_t cacheLineSize = 64;
+
+    struct AlignedDelete
+    {
+        void operator() (void* ptr) const { ::operator delete (ptr, std::align_val_t (cacheLineSize)); }
+    };
+
+    /** Allocates a zeroed, cache-line aligned array and returns a typed pointer to it */
+    template <typename Type>
+    Type* allocate (std::unique_ptr<void, AlignedDelete>& storage, int count);
+
+    std::unique_ptr<void, AlignedDelete> startSampleStorage;
+    std::unique_ptr<void, AlignedDelete> startTimestampStorage;
+    std::unique_ptr<void, AlignedDelete> numSamplesStorage;
+    std::unique_ptr<void, AlignedDelete> syncStreamIdStorage;
+    std::unique_ptr<void, AlignedDelete> processStartTimeStorage;
+
+    std::unique_ptr<void, AlignedDelete> streamIdStorage;
+    uint16* streamIds = nullptr;
+
+    std::vector<int> indexById;
+
+    int numStreams = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (StreamBlockTable);
+};
+
+#endif // STREAMBLOCKTABLE_H_INCLUDED
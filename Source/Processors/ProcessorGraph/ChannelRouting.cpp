@@ -0,0 +1,115 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ChannelRouting.h"
+
+#include "../GenericProcessor/GenericProcessor.h"
+
+#include <unordered_map>
+
+void ChannelRouting::add (int sourceChannel, int destChannel, int numChannelsToAdd)
+{
+    if (numChannelsToAdd <= 0)
+        return;
+
+    numChannels += numChannelsToAdd;
+
+    if (! ranges.empty())
+    {
+        Range& last = ranges.back();
+
+        if (last.sourceChannel + last.numChannels == sourceChannel
+            && last.destChannel + last.numChannels == destChannel)
+        {
+            last.numChannels += numChannelsToAdd;
+            return;
+        }
+    }
+
+    ranges.push_back ({ sourceChannel, destChannel, numChannelsToAdd });
+}
+
+void ChannelRouting::clear()
+{
+    ranges.clear();
+    numChannels = 0;
+}
+
+ChannelRouting ChannelRouting::between (const GenericProcessor* source, const GenericProcessor* dest)
+{
+    ChannelRouting routing;
+
+    if (source == nullptr || dest == nullptr)
+        return routing;
+
+    // input index of each destination channel, only built if a stream has been rearranged
+    std::unordered_map<Uuid, int> destIndices;
+
+    for (auto stream : source->getDataStreams())
+    {
+        const Array<ContinuousChannel*> sourceChannels = stream->getContinuousChannels();
+
+        if (sourceChannels.isEmpty())
+            continue;
+
+        // the destination usually holds the stream's channels unchanged and in order
+        if (const DataStream* destStream = dest->getDataStream (stream->getStreamId()))
+        {
+            const Array<ContinuousChannel*> destChannels = destStream->getContinuousChannels();
+
+            const int sourceStart = sourceChannels.getFirst()->getGlobalIndex();
+            const int destStart = destChannels.isEmpty() ? -1 : destChannels.getFirst()->getGlobalIndex();
+
+            bool sameOrder = destChannels.size() == sourceChannels.size();
+
+            for (int i = 0; sameOrder && i < sourceChannels.size(); i++)
+            {
+                sameOrder = *destChannels[i] == *sourceChannels[i]
+                            && sourceChannels[i]->getGlobalIndex() == sourceStart + i
+                            && destChannels[i]->getGlobalIndex() == destStart + i;
+            }
+
+            if (sameOrder)
+            {
+                routing.add (sourceStart, destStart, sourceChannels.size());
+                continue;
+            }
+        }
+
+        if (destIndices.empty())
+        {
+            for (int i = 0; i < dest->getTotalContinuousChannels(); i++)
+                destIndices[dest->getContinuousChannel (i)->getUniqueId()] = i;
+        }
+
+        for (auto channel : sourceChannels)
+        {
+            const auto match = destIndices.find (channel->getUniqueId());
+
+            if (match != destIndices.end())
+                routing.add (channel->getGlobalIndex(), match->second);
+        }
+    }
+
+    return routing;
+}
@@ -0,0 +1,82 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CHANNELROUTING_H_INCLUDED
+#define CHANNELROUTING_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../../TestableExport.h"
+
+#include <vector>
+
+class GenericProcessor;
+
+/**
+    Maps the continuous channels of one processor onto the input
+    channels of another as a list of ranges of consecutive channels.
+
+    Data streams keep their channels together as they pass along the signal
+    chain, so the route between two processors is usually one range per
+    stream (or a single range, if the streams are in the same order).
+*/
+class TESTABLE ChannelRouting
+{
+public:
+    /** A run of consecutive source channels that feeds consecutive destination channels */
+    struct Range
+    {
+        int sourceChannel;
+        int destChannel;
+        int numChannels;
+    };
+
+    /** Creates an empty routing */
+    ChannelRouting() = default;
+
+    /** Routes numChannels channels starting at sourceChannel to the channels starting at
+        destChannel, extending the last range if the channels follow on from it */
+    void add (int sourceChannel, int destChannel, int numChannels = 1);
+
+    /** Returns the ranges, in the order they were added */
+    const std::vector<Range>& getRanges() const { return ranges; }
+
+    /** Returns the total number of routed channels */
+    int getNumChannels() const { return numChannels; }
+
+    /** Removes all ranges */
+    void clear();
+
+    /** Routes each continuous channel of the source to the input of the destination
+        that holds the same channel (the one with a matching UUID).
+
+        Streams are matched by ID and compared channel by channel; a full search
+        is only needed for the channels of streams that the destination has
+        rearranged. */
+    static ChannelRouting between (const GenericProcessor* source, const GenericProcessor* dest);
+
+private:
+    std::vector<Range> ranges;
+    int numChannels = 0;
+};
+
+#endif // CHANNELROUTING_H_INCLUDED
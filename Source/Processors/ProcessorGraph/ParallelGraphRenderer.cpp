@@ -0,0 +1,528 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ParallelGraphRenderer.h"
+
+#include "../GenericProcessor/GenericProcessor.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+int ParallelGraphRenderer::Schedule::getMaxLevelSize() const
+{
+    size_t maxSize = 0;
+
+    for (const auto& level : levels)
+        maxSize = std::max (maxSize, level.size());
+
+    return int (maxSize);
+}
+
+ParallelGraphRenderer::Schedule ParallelGraphRenderer::createSchedule (int numNodes, const std::vector<std::pair<int, int>>& edges)
+{
+    std::vector<std::set<int>> sources (numNodes), destinations (numNodes);
+
+    for (const auto& edge : edges)
+    {
+        if (edge.first == edge.second)
+            continue;
+
+        destinations[edge.first].insert (edge.second);
+        sources[edge.second].insert (edge.first);
+    }
+
+    // topological order (Kahn's algorithm, lowest index first)
+    std::vector<int> order;
+    std::vector<int> remainingSources (numNodes);
+    std::set<int> ready;
+
+    for (int i = 0; i < numNodes; i++)
+    {
+        remainingSources[i] = int (sources[i].size());
+
+        if (remainingSources[i] == 0)
+            ready.insert (i);
+    }
+
+    while (! ready.empty())
+    {
+        const int node = *ready.begin();
+        ready.erase (ready.begin());
+        order.push_back (node);
+
+        for (int dest : destinations[node])
+        {
+            if (--remainingSources[dest] == 0)
+                ready.insert (dest);
+        }
+    }
+
+    Schedule schedule;
+
+    if (int (order.size()) != numNodes)
+    {
+        jassertfalse; // the graph has a cycle
+        return schedule;
+    }
+
+    // a node continues the branch of its source if each is the other's only connection
+    auto continuesBranch = [&] (int node)
+    {
+        return sources[node].size() == 1 && destinations[*sources[node].begin()].size() == 1;
+    };
+
+    std::vector<int> branchOfNode (numNodes, -1);
+    std::vector<int> branchLevels;
+
+    for (int head : order)
+    {
+        if (continuesBranch (head))
+            continue;
+
+        const int branchIndex = int (schedule.branches.size());
+        std::vector<int> branch { head };
+
+        int node = head;
+
+        while (destinations[node].size() == 1 && continuesBranch (*destinations[node].begin()))
+        {
+            node = *destinations[node].begin();
+            branch.push_back (node);
+        }
+
+        int level = 0;
+
+        for (int source : sources[head])
+            level = std::max (level, branchLevels[branchOfNode[source]] + 1);
+
+        for (int member : branch)
+            branchOfNode[member] = branchIndex;
+
+        schedule.branches.push_back (branch);
+        branchLevels.push_back (level);
+
+        if (level >= int (schedule.levels.size()))
+            schedule.levels.resize (level + 1);
+
+        schedule.levels[level].push_back (branchIndex);
+    }
+
+    return schedule;
+}
+
+ParallelGraphRenderer::ParallelGraphRenderer()
+    : workerPool ("Graph branches")
+{
+}
+
+ParallelGraphRenderer::~ParallelGraphRenderer()
+{
+}
+
+void ParallelGraphRenderer::release()
+{
+    const ScopedLock lock (scheduleLock);
+
+    prepared = false;
+
+    ops.clear();
+    outputOp = -1;
+    audioStorage.clear();
+    midiStorage.clear();
+    schedule = Schedule();
+    branchProfilers.clear();
+    currentLevel = nullptr;
+}
+
+void ParallelGraphRenderer::prepare (AudioProcessorGraph& graph, int blockSize)
+{
+    release();
+
+    const ScopedLock lock (scheduleLock);
+
+    if (blockSize <= 0)
+        return;
+
+    const ReferenceCountedArray<AudioProcessorGraph::Node>& nodes = graph.getNodes();
+
+    std::map<AudioProcessorGraph::NodeID, int> nodeIndices;
+
+    for (int i = 0; i < nodes.size(); i++)
+    {
+        auto* ioProcessor = dynamic_cast<AudioProcessorGraph::AudioGraphIOProcessor*> (nodes[i]->getProcessor());
+
+        // audio inputs and MIDI I/O are left to AudioProcessorGraph
+        if (ioProcessor != nullptr && ioProcessor->getType() != AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode)
+            return;
+
+        nodeIndices[nodes[i]->nodeID] = i;
+    }
+
+    std::vector<AudioProcessorGraph::Connection> connections = graph.getConnections();
+
+    // connections are sorted by source node ID, so that channels and events are merged in that order
+    std::stable_sort (connections.begin(), connections.end(), [] (const auto& a, const auto& b)
+                      { return a.source.nodeID < b.source.nodeID; });
+
+    std::vector<std::pair<int, int>> edges;
+
+    for (const auto& connection : connections)
+        edges.push_back ({ nodeIndices.at (connection.source.nodeID), nodeIndices.at (connection.destination.nodeID) });
+
+    schedule = createSchedule (nodes.size(), edges);
+
+    if (schedule.branches.empty() && nodes.size() > 0)
+        return;
+
+    ops.resize (nodes.size());
+
+    for (int i = 0; i < nodes.size(); i++)
+    {
+        NodeOp& op = ops[i];
+        op.node = nodes[i];
+        op.processor = nodes[i]->getProcessor();
+
+        const int numInputs = op.processor->getTotalNumInputChannels();
+        const int numOutputs = op.processor->getTotalNumOutputChannels();
+
+        op.numChannels = (numInputs == 0 && numOutputs == 0) ? 0 : jmax (numInputs, numOutputs);
+
+        auto* ioProcessor = dynamic_cast<AudioProcessorGraph::AudioGraphIOProcessor*> (op.processor);
+        op.isOutput = ioProcessor != nullptr;
+
+        if (op.isOutput)
+            outputOp = i;
+    }
+
+    // assign storage: a node shares the buffers of the previous node in its
+    // branch if it has no other inputs and the channel indices are unchanged
+    std::vector<bool> sharesAudio (nodes.size(), false);
+    std::vector<int> audioStorageChannels;
+
+    for (const auto& branch : schedule.branches)
+    {
+        for (size_t position = 0; position < branch.size(); position++)
+        {
+            const int nodeIndex = branch[position];
+            NodeOp& op = ops[nodeIndex];
+
+            bool canShareAudio = false;
+            bool canShareMidi = false;
+
+            if (position > 0 && ! op.isOutput)
+            {
+                const int previous = branch[position - 1];
+                canShareAudio = true;
+
+                for (const auto& connection : connections)
+                {
+                    if (nodeIndices.at (connection.destination.nodeID) != nodeIndex)
+                        continue;
+
+                    jassert (nodeIndices.at (connection.source.nodeID) == previous);
+
+                    if (connection.source.isMIDI())
+                        canShareMidi = true;
+                    else if (connection.source.channelIndex != connection.destination.channelIndex)
+                        canShareAudio = false;
+                }
+
+                if (canShareAudio)
+                {
+                    op.audioStorage = ops[previous].audioStorage;
+                    audioStorageChannels[op.audioStorage] = jmax (audioStorageChannels[op.audioStorage], op.numChannels);
+                    sharesAudio[nodeIndex] = true;
+                }
+
+                if (canShareMidi)
+                    op.midiStorage = ops[previous].midiStorage;
+            }
+
+            if (! canShareAudio)
+            {
+                op.audioStorage = int (audioStorageChannels.size());
+                audioStorageChannels.push_back (op.numChannels);
+            }
+
+            if (! canShareMidi)
+            {
+                op.midiStorage = midiStorage.size();
+                midiStorage.add (new MidiBuffer())->ensureSize (4096);
+            }
+        }
+    }
+
+    for (int numChannels : audioStorageChannels)
+        audioStorage.add (new AudioBuffer<float> (jmax (1, numChannels), blockSize));
+
+    // resolve the buffers and the inputs of each node
+    for (int i = 0; i < int (ops.size()); i++)
+    {
+        NodeOp& op = ops[i];
+        AudioBuffer<float>* storage = audioStorage[op.audioStorage];
+
+        op.buffer = std::make_unique<AudioBuffer<float>> (storage->getArrayOfWritePointers(), op.numChannels, blockSize);
+        op.midi = midiStorage[op.midiStorage];
+
+        std::vector<bool> channelConnected (op.numChannels, false);
+        bool midiConnected = false;
+
+        for (const auto& connection : connections)
+        {
+            if (nodeIndices.at (connection.destination.nodeID) != i)
+                continue;
+
+            const NodeOp& source = ops[nodeIndices.at (connection.source.nodeID)];
+
+            if (connection.source.isMIDI())
+            {
+                midiConnected = true;
+
+                if (source.midiStorage != op.midiStorage)
+                    op.midiSources.push_back (midiStorage[source.midiStorage]);
+
+                continue;
+            }
+
+            const int destChannel = connection.destination.channelIndex;
+
+            if (! isPositiveAndBelow (destChannel, op.numChannels)
+                || ! isPositiveAndBelow (connection.source.channelIndex, source.numChannels))
+                continue;
+
+            float* destination = storage->getWritePointer (destChannel);
+            const float* sourceChannel = audioStorage[source.audioStorage]->getReadPointer (connection.source.channelIndex);
+
+            if (sharesAudio[i])
+            {
+                channelConnected[destChannel] = true;
+                continue;
+            }
+
+            const bool add = channelConnected[destChannel];
+            channelConnected[destChannel] = true;
+
+            // the stream of a continuous channel sets how much of the block holds data
+            // (the graph's output collects audio, which always fills the block)
+            const GenericProcessor* sourceProcessor = nullptr;
+            int streamIndex = -1;
+
+            if (auto* processor = dynamic_cast<const GenericProcessor*> (source.processor); processor != nullptr && ! op.isOutput)
+            {
+                if (const ContinuousChannel* channel = processor->getContinuousChannel (connection.source.channelIndex))
+                {
+                    streamIndex = processor->blockTable.getIndex (channel->getStreamId());
+
+                    if (streamIndex >= 0)
+                        sourceProcessor = processor;
+                }
+            }
+
+            // extend the previous copy if this channel follows on from it in both buffers
+            if (! op.channelCopies.empty())
+            {
+                ChannelCopy& last = op.channelCopies.back();
+                const int offset = last.numChannels * blockSize;
+
+                if (last.add == add && last.source + offset == sourceChannel && last.destination + offset == destination
+                    && last.sourceProcessor == sourceProcessor && last.streamIndex == streamIndex)
+                {
+                    last.numChannels++;
+                    continue;
+                }
+            }
+
+            op.channelCopies.push_back ({ sourceChannel, destination, 1, add, sourceProcessor, streamIndex });
+        }
+
+        for (int channel = 0; channel < op.numChannels; channel++)
+        {
+            if (channelConnected[channel])
+                continue;
+
+            float* destination = storage->getWritePointer (channel);
+
+            if (! op.channelsToClear.empty()
+                && op.channelsToClear.back().destination + op.channelsToClear.back().numChannels * blockSize == destination)
+            {
+                op.channelsToClear.back().numChannels++;
+            }
+            else
+            {
+                op.channelsToClear.push_back ({ destination, 1 });
+            }
+        }
+
+        op.clearMidi = ! midiConnected || ! op.midiSources.empty();
+    }
+
+    for (size_t i = 0; i < schedule.branches.size(); i++)
+        branchProfilers.add (new ProcessorProfiler());
+
+    const double sampleRate = graph.getSampleRate();
+    deadlineTicks = sampleRate > 0.0 ? int64 (double (Time::getHighResolutionTicksPerSecond()) * blockSize / sampleRate) : 0;
+
+    workerPool.setNumThreads (jlimit (1, SystemStats::getNumCpus(), schedule.getMaxLevelSize()));
+
+    preparedBlockSize = blockSize;
+    prepared = true;
+}
+
+bool ParallelGraphRenderer::render (AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
+{
+    if (! prepared || buffer.getNumSamples() != preparedBlockSize)
+        return false;
+
+    for (const auto& level : schedule.levels)
+    {
+        if (level.size() == 1)
+        {
+            renderBranch (level[0]);
+        }
+        else
+        {
+            currentLevel = &level;
+            workerPool.run (int (level.size()), &renderBranchTask, this);
+        }
+    }
+
+    buffer.clear();
+    midiMessages.clear();
+
+    if (outputOp >= 0)
+    {
+        const NodeOp& output = ops[outputOp];
+
+        for (int channel = 0; channel < jmin (output.numChannels, buffer.getNumChannels()); channel++)
+            buffer.copyFrom (channel, 0, *output.buffer, channel, 0, buffer.getNumSamples());
+    }
+
+    return true;
+}
+
+void ParallelGraphRenderer::renderBranchTask (void* context, int taskIndex)
+{
+    auto* renderer = static_cast<ParallelGraphRenderer*> (context);
+
+    renderer->renderBranch ((*renderer->currentLevel)[taskIndex]);
+}
+
+void ParallelGraphRenderer::renderBranch (int branchIndex)
+{
+    const int64 startTime = Time::getHighResolutionTicks();
+
+    for (int nodeIndex : schedule.branches[branchIndex])
+        renderNode (ops[nodeIndex]);
+
+    branchProfilers[branchIndex]->addBlock (Time::getHighResolutionTicks() - startTime, deadlineTicks);
+}
+
+void ParallelGraphRenderer::renderNode (NodeOp& op)
+{
+    const int numSamples = preparedBlockSize;
+
+    for (const ChannelClear& channels : op.channelsToClear)
+        FloatVectorOperations::clear (channels.destination, channels.numChannels * numSamples);
+
+    for (const ChannelCopy& copy : op.channelCopies)
+    {
+        const int streamSamples = copy.sourceProcessor == nullptr
+                                      ? numSamples
+                                      : jmin (numSamples, int (copy.sourceProcessor->getNumSamplesInBlock (StreamIndex (copy.streamIndex))));
+
+        if (streamSamples == numSamples)
+        {
+            if (copy.add)
+                FloatVectorOperations::add (copy.destination, copy.source, copy.numChannels * numSamples);
+            else
+                FloatVectorOperations::copy (copy.destination, copy.source, copy.numChannels * numSamples);
+
+            continue;
+        }
+
+        // only the start of each channel holds this block's samples
+        for (int channel = 0; channel < copy.numChannels; channel++)
+        {
+            const size_t offset = size_t (channel) * size_t (numSamples);
+
+            if (copy.add)
+                FloatVectorOperations::add (copy.destination + offset, copy.source + offset, streamSamples);
+            else
+            {
+                FloatVectorOperations::copy (copy.destination + offset, copy.source + offset, streamSamples);
+
+                // don't leave the previous block's samples in the rest of the channel
+                FloatVectorOperations::clear (copy.destination + offset + streamSamples, numSamples - streamSamples);
+            }
+        }
+    }
+
+    if (op.clearMidi)
+        op.midi->clear();
+
+    for (const MidiBuffer* source : op.midiSources)
+        op.midi->addEvents (*source, 0, -1, 0);
+
+    // the output node only collects the graph's output channels
+    if (op.isOutput)
+        return;
+
+    if (op.processor->isSuspended())
+    {
+        op.buffer->clear();
+        return;
+    }
+
+    const ScopedLock lock (op.processor->getCallbackLock());
+
+    if (op.node->isBypassed())
+        op.processor->processBlockBypassed (*op.buffer, *op.midi);
+    else
+        op.processor->processBlock (*op.buffer, *op.midi);
+}
+
+Array<ParallelGraphRenderer::BranchInfo> ParallelGraphRenderer::getBranchInfo() const
+{
+    const ScopedLock lock (scheduleLock);
+
+    Array<BranchInfo> info;
+
+    for (int level = 0; level < int (schedule.levels.size()); level++)
+    {
+        for (int branchIndex : schedule.levels[level])
+        {
+            BranchInfo branch;
+            branch.level = level;
+
+            for (int nodeIndex : schedule.branches[branchIndex])
+                branch.nodeIds.add (int (ops[nodeIndex].node->nodeID.uid));
+
+            branch.statistics = branchProfilers[branchIndex]->getStatistics();
+
+            info.add (branch);
+        }
+    }
+
+    return info;
+}
@@ -0,0 +1,200 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PARALLELGRAPHRENDERER_H_INCLUDED
+#define PARALLELGRAPHRENDERER_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../../TestableExport.h"
+#include "../../Utils/WorkerPool.h"
+#include "../GenericProcessor/ProcessorProfiler.h"
+
+#include <utility>
+#include <vector>
+
+class GenericProcessor;
+
+/**
+    Renders the nodes of an AudioProcessorGraph, running independent
+    branches of the signal chain concurrently.
+
+    The graph is divided into branches: chains of nodes in which each node
+    feeds only the next one, and each node after the first is fed only by
+    the one before it. A branch can start once the branches that feed it have
+    finished, so branches are grouped into levels (by their distance from the
+    nodes without inputs), and the branches of a level run in parallel on a
+    WorkerPool. Two probes that each feed their own filter, spike detector
+    and Record Node form two branches of the same level; a Merger or an
+    Audio Node that joins them starts a branch at the next level.
+
+    Nodes receive their channels and events in the same way as in
+    AudioProcessorGraph: channels fed by several sources are summed,
+    unconnected channels are cleared, and event buffers are merged in order
+    of source node ID. A node whose only source is the previous node of its
+    branch (and which is that node's only destination) works in place on its
+    buffers when the channel indices match; all other inputs are copied, a
+    range of consecutive channels at a time. Only the samples that a stream
+    delivered in the current block are copied, so a 2.5 kHz stream costs a
+    fraction of a 30 kHz stream with the same number of channels.
+
+    prepare() must be called on the message thread once the graph's nodes have
+    been prepared. render() returns false until then, or if the graph contains
+    nodes that can't be rendered here (audio inputs or MIDI I/O), so that the
+    caller can fall back to AudioProcessorGraph's serial rendering.
+*/
+class TESTABLE ParallelGraphRenderer
+{
+public:
+    /** Division of a graph into branches and levels */
+    struct Schedule
+    {
+        /** Node indices of each branch, in processing order */
+        std::vector<std::vector<int>> branches;
+
+        /** Branch indices of each level; every branch only depends on branches of lower levels */
+        std::vector<std::vector<int>> levels;
+
+        /** Returns the largest number of branches in one level */
+        int getMaxLevelSize() const;
+    };
+
+    /** Divides a directed acyclic graph into branches and levels.
+        Edges are (source, destination) pairs of node indices in [0, numNodes).
+        Returns an empty schedule if the graph has a cycle. */
+    static Schedule createSchedule (int numNodes, const std::vector<std::pair<int, int>>& edges);
+
+    /** Timing of one branch */
+    struct BranchInfo
+    {
+        /** Node IDs of the branch, in processing order */
+        Array<int> nodeIds;
+
+        /** Level of the branch */
+        int level = 0;
+
+        /** Execution time of the whole branch in each block */
+        ProcessorProfiler::Statistics statistics;
+    };
+
+    /** Constructor */
+    ParallelGraphRenderer();
+
+    /** Destructor */
+    ~ParallelGraphRenderer();
+
+    /** Builds the schedule and buffers for the graph's current nodes and connections */
+    void prepare (AudioProcessorGraph& graph, int blockSize);
+
+    /** Frees the schedule and buffers; render() returns false until the next prepare() */
+    void release();
+
+    /** Returns true if prepared with at least two branches that can run at the same time */
+    bool canRunInParallel() const { return prepared && schedule.getMaxLevelSize() > 1; }
+
+    /** Renders one block into the graph's output buffer.
+        Returns false (without rendering anything) if the renderer isn't prepared
+        for a block of this size. */
+    bool render (AudioBuffer<float>& buffer, MidiBuffer& midiMessages);
+
+    /** Returns the branches of the current schedule with their execution times */
+    Array<BranchInfo> getBranchInfo() const;
+
+    /** Returns the number of threads used to run branches, including the audio thread */
+    int getNumThreads() const { return workerPool.getNumThreads(); }
+
+private:
+    /** Consecutive channels copied from a source node's buffer at the start of a node.
+        The channels of a storage buffer are adjacent in memory, so a range of
+        channels is copied in one call when the whole block is in use. */
+    struct ChannelCopy
+    {
+        const float* source;
+        float* destination;
+        int numChannels;
+        bool add;
+
+        /** The source processor and the index of the stream the channels belong to,
+            which limit the copy to the samples in the stream's current block
+            (nullptr for channels that aren't part of a stream) */
+        const GenericProcessor* sourceProcessor;
+        int streamIndex;
+    };
+
+    /** Consecutive channels cleared at the start of a node */
+    struct ChannelClear
+    {
+        float* destination;
+        int numChannels;
+    };
+
+    /** Everything needed to render one node */
+    struct NodeOp
+    {
+        AudioProcessorGraph::Node::Ptr node;
+        AudioProcessor* processor = nullptr;
+
+        int numChannels = 0;
+        int audioStorage = -1;
+        int midiStorage = -1;
+
+        std::unique_ptr<AudioBuffer<float>> buffer;
+        MidiBuffer* midi = nullptr;
+
+        std::vector<ChannelCopy> channelCopies;
+        std::vector<ChannelClear> channelsToClear;
+        std::vector<const MidiBuffer*> midiSources;
+        bool clearMidi = false;
+
+        bool isOutput = false;
+    };
+
+    /** Gathers a node's inputs and processes it */
+    void renderNode (NodeOp& op);
+
+    /** Renders the nodes of one branch in order */
+    void renderBranch (int branchIndex);
+
+    static void renderBranchTask (void* context, int taskIndex);
+
+    Schedule schedule;
+    std::vector<NodeOp> ops;
+    int outputOp = -1;
+
+    OwnedArray<AudioBuffer<float>> audioStorage;
+    OwnedArray<MidiBuffer> midiStorage;
+
+    OwnedArray<ProcessorProfiler> branchProfilers;
+
+    WorkerPool workerPool;
+    const std::vector<int>* currentLevel = nullptr;
+
+    int preparedBlockSize = 0;
+    int64 deadlineTicks = 0;
+    bool prepared = false;
+
+    CriticalSection scheduleLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelGraphRenderer);
+};
+
+#endif // PARALLELGRAPHRENDERER_H_INCLUDED
@@ -28,6 +28,7 @@
 
 #include "../GenericProcessor/GenericProcessor.h"
 #include "ProcessorGraph.h"
+#include "ChannelRouting.h"
 
 #include "../../UI/EditorViewport.h"
 #include "../../UI/GraphViewer.h"
@@ -689,8 +690,6 @@ void ProcessorGraph::updateSettings (GenericProcessor* processor, bool signalCha
         return;
     }
 
-    getMessageCenter()->addSpecialProcessorChannels();
-
     GenericProcessor* processorToUpdate = processor;
 
     if (processorToUpdate != nullptr
@@ -699,47 +698,141 @@ void ProcessorGraph::updateSettings (GenericProcessor* processor, bool signalCha
         && ! processorToUpdate->getSourceNode()->isEmpty())
     {
         processorToUpdate = processorToUpdate->getSourceNode();
-        processor = processorToUpdate;
     }
 
-    Array<Splitter*> splitters;
+    if (batchUpdateDepth > 0 && ! signalChainIsLoading)
+    {
+        if (processorToUpdate != nullptr)
+            pendingUpdates.addIfNotAlreadyThere (processorToUpdate);
+
+        return;
+    }
+
+    getMessageCenter()->addSpecialProcessorChannels();
+
+    if (processorToUpdate != nullptr)
+        propagateSettings ({ processorToUpdate }, signalChainIsLoading);
+
+    updateViews (processorToUpdate, true);
 
-    while ((processor != nullptr) || (splitters.size() > 0))
+    if (! signalChainIsLoading && ! isConsoleApp)
     {
-        if (processor != nullptr)
+        CoreServices::saveRecoveryConfig();
+    }
+}
+
+void ProcessorGraph::beginBatchUpdate()
+{
+    batchUpdateDepth++;
+}
+
+void ProcessorGraph::endBatchUpdate()
+{
+    jassert (batchUpdateDepth > 0);
+
+    if (batchUpdateDepth == 0 || --batchUpdateDepth > 0 || pendingUpdates.isEmpty())
+        return;
+
+    Array<GenericProcessor*> processorsToUpdate;
+    processorsToUpdate.swapWith (pendingUpdates);
+
+    LOGD ("Updating settings for ", processorsToUpdate.size(), " changed processors");
+
+    getMessageCenter()->addSpecialProcessorChannels();
+
+    propagateSettings (processorsToUpdate, false);
+
+    updateViews (processorsToUpdate.getFirst(), true);
+
+    if (! isConsoleApp)
+    {
+        CoreServices::saveRecoveryConfig();
+    }
+}
+
+void ProcessorGraph::propagateSettings (const Array<GenericProcessor*>& changedProcessors, bool signalChainIsLoading)
+{
+    // Orders the processors downstream of the changed ones so that each comes after
+    // all of its sources (depth-first, in reverse post-order)
+    Array<GenericProcessor*> order;
+    Array<GenericProcessor*> visited;
+
+    for (auto changedProcessor : changedProcessors)
+    {
+        std::vector<std::pair<GenericProcessor*, int>> stack;
+
+        if (! visited.contains (changedProcessor))
         {
-            processor->update();
+            visited.add (changedProcessor);
+            stack.push_back ({ changedProcessor, 0 });
+        }
 
-            if (signalChainIsLoading && processor->getSourceNode() != nullptr)
+        while (! stack.empty())
+        {
+            GenericProcessor* processor = stack.back().first;
+            const int path = stack.back().second++;
+
+            if (path < (processor->isSplitter() ? 2 : 1))
+            {
+                GenericProcessor* dest = processor->isSplitter() ? ((Splitter*) processor)->getDestNode (path)
+                                                                 : processor->getDestNode();
+
+                if (dest != nullptr && ! visited.contains (dest))
+                {
+                    visited.add (dest);
+                    stack.push_back ({ dest, 0 });
+                }
+            }
+            else
             {
-                processor->loadFromXml();
-                processor->update();
+                order.add (processor);
+                stack.pop_back();
             }
+        }
+    }
+
+    // Updates a processor if it changed, or if one of its sources changed its output
+    Array<GenericProcessor*> changedOutputs;
+    int numUpdated = 0;
+
+    for (int i = order.size(); --i >= 0;)
+    {
+        GenericProcessor* processor = order.getUnchecked (i);
+
+        bool needsUpdate = signalChainIsLoading || changedProcessors.contains (processor);
 
-            if (processor->isSplitter())
+        if (! needsUpdate)
+        {
+            if (processor->isMerger())
             {
-                splitters.add ((Splitter*) processor);
-                processor = splitters.getLast()->getDestNode (0); // travel down chain 0 first
+                Merger* merger = (Merger*) processor;
+                needsUpdate = changedOutputs.contains (merger->getSourceNode (0))
+                              || changedOutputs.contains (merger->getSourceNode (1));
             }
             else
             {
-                processor = processor->getDestNode();
+                needsUpdate = changedOutputs.contains (processor->getSourceNode());
             }
         }
-        else
+
+        if (! needsUpdate)
+            continue;
+
+        processor->update();
+
+        if (signalChainIsLoading && processor->getSourceNode() != nullptr)
         {
-            Splitter* splitter = splitters.getFirst();
-            processor = splitter->getDestNode (1); // then come back to chain 1
-            splitters.remove (0);
+            processor->loadFromXml();
+            processor->update();
         }
-    }
 
-    updateViews (processorToUpdate, true);
+        numUpdated++;
 
-    if (! signalChainIsLoading && ! isConsoleApp)
-    {
-        CoreServices::saveRecoveryConfig();
+        if (signalChainIsLoading || processor->hasOutputLayoutChanged())
+            changedOutputs.add (processor);
     }
+
+    LOGD ("Updated ", numUpdated, " of ", order.size(), " downstream processors");
 }
 
 void ProcessorGraph::updateViews (GenericProcessor* processor, bool updateGraphViewer)
@@ -991,6 +1084,7 @@ void ProcessorGraph::clearSignalChain()
 
     rootNodes.clear();
     emptyProcessors.clear();
+    pendingUpdates.clear();
     currentNodeId = 100;
 
     if (! isConsoleApp)
@@ -1058,12 +1152,12 @@ void ProcessorGraph::restoreParameters()
         p->loadFromXml();
     }
 
-    // update everyone's settings
-    for (auto p : rootNodes)
-    {
-        LOGG ("Updating settings for ", p->getName(), " : ", p->getNodeId());
-        updateSettings (p, true);
-    }
+    // update everyone's settings, each processor after all of its sources
+    LOGG ("Updating settings for ", rootNodes.size(), " root processors");
+    propagateSettings (getRootNodes(), true);
+
+    if (rootNodes.size() > 0)
+        updateViews (rootNodes.getLast(), true);
 
     isLoadingSignalChain = false;
 
@@ -1196,8 +1290,38 @@ GenericProcessor* ProcessorGraph::getProcessorWithNodeId (int nodeId)
     return nullptr;
 }
 
+void ProcessorGraph::prepareToPlay (double sampleRate, int estimatedSamplesPerBlock)
+{
+    AudioProcessorGraph::prepareToPlay (sampleRate, estimatedSamplesPerBlock);
+
+    parallelRenderer.prepare (*this, estimatedSamplesPerBlock);
+
+    LOGD ("Parallel renderer: ", parallelRenderer.getBranchInfo().size(), " branches on ", parallelRenderer.getNumThreads(), " threads");
+}
+
+void ProcessorGraph::releaseResources()
+{
+    parallelRenderer.release();
+
+    AudioProcessorGraph::releaseResources();
+}
+
+void ProcessorGraph::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
+{
+    if (parallelProcessing && parallelRenderer.canRunInParallel() && parallelRenderer.render (buffer, midiMessages))
+        return;
+
+    AudioProcessorGraph::processBlock (buffer, midiMessages);
+}
+
 void ProcessorGraph::clearConnections()
 {
+    // the parallel schedule is rebuilt when the graph is next prepared
+    {
+        const ScopedLock lock (getCallbackLock());
+        parallelRenderer.release();
+    }
+
     for (int i = 0; i < getNumNodes(); i++)
     {
         Node* node = getNode (i);
@@ -1207,7 +1331,7 @@ void ProcessorGraph::clearConnections()
         {
             if (nodeId != AUDIO_NODE_ID)
             {
-                disconnectNode (node->nodeID);
+                disconnectNode (node->nodeID, UpdateKind::none);
             }
 
             GenericProcessor* p = (GenericProcessor*) node->getProcessor();
@@ -1226,12 +1350,15 @@ void ProcessorGraph::clearConnections()
         dest.nodeID = NodeID (OUTPUT_NODE_ID);
         dest.channelIndex = n;
 
-        addConnection (Connection (src, dest));
+        addConnection (Connection (src, dest), UpdateKind::none);
     }
 }
 
 void ProcessorGraph::updateConnections()
 {
+    const int64 startTime = Time::getHighResolutionTicks();
+
+    // connections are made without updating the graph, which is rebuilt once at the end
     clearConnections(); // clear processor graph
 
     // stores the pointer to a source leading into a particular dest node
@@ -1370,25 +1497,37 @@ void ProcessorGraph::updateConnections()
         {
             sourceMap[node].add (conn);
         }
+    }
 
-        // Finally, actually connect sources to each dest processor,
-        // in correct order by merger topography
-        for (const auto& destSources : sourceMap)
-        {
-            GenericProcessor* dest = destSources.first;
+    // Finally, actually connect sources to each dest processor,
+    // in correct order by merger topography
+    int numChannels = 0;
 
-            for (const ConnectionInfo& conn : destSources.second)
-            {
-                connectProcessors (conn.source, dest, conn.connectContinuous, conn.connectEvents);
-            }
+    for (const auto& destSources : sourceMap)
+    {
+        GenericProcessor* dest = destSources.first;
+
+        for (const ConnectionInfo& conn : destSources.second)
+        {
+            numChannels += connectProcessors (conn.source, dest, conn.connectContinuous, conn.connectEvents);
         }
     }
+
+    const int64 connectedTime = Time::getHighResolutionTicks();
+
+    rebuild();
+
+    const int64 endTime = Time::getHighResolutionTicks();
+
+    LOGD ("Connected ", numChannels, " channels in ",
+          Time::highResolutionTicksToSeconds (connectedTime - startTime) * 1000.0, " ms, rebuilt graph in ",
+          Time::highResolutionTicksToSeconds (endTime - connectedTime) * 1000.0, " ms");
 }
 
-void ProcessorGraph::connectProcessors (GenericProcessor* source, GenericProcessor* dest, bool connectContinuous, bool connectEvents)
+int ProcessorGraph::connectProcessors (GenericProcessor* source, GenericProcessor* dest, bool connectContinuous, bool connectEvents)
 {
     if (source == nullptr || dest == nullptr)
-        return;
+        return 0;
 
     LOGG ("Connecting ", source->getName(), " ", source->getNodeId(), " to ", dest->getName(), " ", dest->getNodeId());
 
@@ -1396,19 +1535,25 @@ void ProcessorGraph::connectProcessors (GenericProcessor* source, GenericProcess
     cs.nodeID = NodeID (source->getNodeId()); //source
     cd.nodeID = NodeID (dest->getNodeId()); //dest
 
-    // 1. connect continuous channels
+    int numChannels = 0;
+
+    // 1. connect continuous channels, one stream at a time
     if (connectContinuous)
     {
-        for (int chan = 0; chan < source->getNumOutputs(); chan++)
-        {
-            cs.channelIndex = chan;
-            cd.channelIndex = dest->getIndexOfMatchingChannel (source->getContinuousChannel (chan));
+        const ChannelRouting routing = ChannelRouting::between (source, dest);
 
-            if (cd.channelIndex > -1)
+        for (const ChannelRouting::Range& range : routing.getRanges())
+        {
+            for (int chan = 0; chan < range.numChannels; chan++)
             {
-                addConnection (Connection (cs, cd));
+                cs.channelIndex = range.sourceChannel + chan;
+                cd.channelIndex = range.destChannel + chan;
+
+                addConnection (Connection (cs, cd), UpdateKind::none);
             }
         }
+
+        numChannels = routing.getNumChannels();
     }
 
     // 2. connect event channel
@@ -1416,7 +1561,7 @@ void ProcessorGraph::connectProcessors (GenericProcessor* source, GenericProcess
     {
         cs.channelIndex = midiChannelIndex;
         cd.channelIndex = midiChannelIndex;
-        addConnection (Connection (cs, cd));
+        addConnection (Connection (cs, cd), UpdateKind::none);
     }
 
     //3. Ensure the RecordNode block size matches the buffer size of Audio Settings
@@ -1428,6 +1573,8 @@ void ProcessorGraph::connectProcessors (GenericProcessor* source, GenericProcess
         int blockSize = ads.bufferSize;
         ((RecordNode*) dest)->updateBlockSize (blockSize);
     }
+
+    return numChannels;
 }
 
 void ProcessorGraph::connectAudioMonitorToAudioNode (GenericProcessor* source)
@@ -1447,7 +1594,7 @@ void ProcessorGraph::connectAudioMonitorToAudioNode (GenericProcessor* source)
 
         LOGG ("  Source channel: ", cs.channelIndex, ", Dest Channel: ", cd.channelIndex);
 
-        addConnection (Connection (cs, cd));
+        addConnection (Connection (cs, cd), UpdateKind::none);
     }
 
     getAudioNode()->registerProcessor (source);
@@ -1464,7 +1611,7 @@ void ProcessorGraph::connectProcessorToMessageCenter (GenericProcessor* source)
     cd.nodeID = NodeID (source->getNodeId()); // dest
     cd.channelIndex = midiChannelIndex;
 
-    addConnection (Connection (cs, cd));
+    addConnection (Connection (cs, cd), UpdateKind::none);
 
     LOGD ("Connecting ", source->getName(), " (", source->getNodeId(), ") to Message Center");
 }
@@ -1604,6 +1751,8 @@ void ProcessorGraph::removeProcessor (GenericProcessor* processor)
         AccessClass::getEditorViewport()->removeEditor (processor->editor.get());
     }
 
+    pendingUpdates.removeFirstMatchingValue (processor);
+
     Node::Ptr node = removeNode (nodeId);
     node.reset();
 }
@@ -1765,6 +1914,7 @@ void ProcessorGraph::startAcquisition()
         if (node->nodeID != NodeID (OUTPUT_NODE_ID))
         {
             GenericProcessor* p = (GenericProcessor*) node->getProcessor();
+            p->getProfiler().reset();
             p->startAcquisition();
 
             if (p->getEditor() != nullptr)
@@ -27,6 +27,9 @@
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "../../TestableExport.h"
 #include "../PluginManager/OpenEphysPlugin.h"
+#include "ParallelGraphRenderer.h"
+
+#include <atomic>
 class GenericProcessor;
 class GenericEditor;
 class RecordNode;
@@ -115,9 +118,16 @@ public:
     /* Returns a list of processor editors that are currently visible*/
     Array<GenericEditor*> getVisibleEditors (GenericProcessor* processor);
 
-    /* Updates the settings of all processors downstream of the specified processor*/
+    /* Updates the settings of the specified processor, and of the processors downstream
+       of it for as long as their inputs change. Deferred until the end of a batch update. */
     void updateSettings (GenericProcessor* processor, bool signalChainIsLoading = false);
 
+    /* Starts collecting updateSettings() calls instead of running them (calls can be nested) */
+    void beginBatchUpdate();
+
+    /* Ends a batch, and updates the processors that changed during it in one pass */
+    void endBatchUpdate();
+
     /* Updates the views (EditorViewport and GraphView) of all processors downstream of the specified processor*/
     void updateViews (GenericProcessor* processor, bool updateGraphViewer = false);
 
@@ -233,12 +243,33 @@ public:
 
     UndoManager* getUndoManager() noexcept { return undoManager.get(); }
 
+    /** Prepares the graph, and the parallel renderer for the current signal chain */
+    void prepareToPlay (double sampleRate, int estimatedSamplesPerBlock) override;
+
+    /** Releases the graph's resources */
+    void releaseResources() override;
+
+    /** Renders one block, running independent branches of the signal chain
+        concurrently when parallel processing is enabled */
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override;
+
+    using AudioProcessorGraph::processBlock;
+
+    /** Enables or disables parallel processing of independent branches (disabled by default; takes effect at the next block) */
+    void setParallelProcessing (bool enabled) { parallelProcessing = enabled; }
+
+    /** Returns true if parallel processing is enabled */
+    bool isParallelProcessingEnabled() const { return parallelProcessing; }
+
+    /** Returns the renderer used for parallel processing */
+    const ParallelGraphRenderer& getParallelRenderer() const { return parallelRenderer; }
+
 private:
     /* Disconnect all processors*/
     void clearConnections();
 
-    /* Connect a source processor and a destination processor*/
-    void connectProcessors (GenericProcessor* source,
+    /* Connect a source processor and a destination processor; returns the number of continuous channels connected */
+    int connectProcessors (GenericProcessor* source,
                             GenericProcessor* dest,
                             bool connectContinuous,
                             bool connectEvents);
@@ -249,6 +280,9 @@ private:
     /* Connect a processor to the MessageCenter*/
     void connectProcessorToMessageCenter (GenericProcessor* source);
 
+    /* Updates the changed processors, then each downstream processor whose sources changed their output */
+    void propagateSettings (const Array<GenericProcessor*>& changedProcessors, bool signalChainIsLoading);
+
     Array<GenericProcessor*> rootNodes;
 
     Array<GenericProcessor*> processorArray;
@@ -263,9 +297,15 @@ private:
 
     bool isLoadingSignalChain;
 
+    int batchUpdateDepth = 0;
+    Array<GenericProcessor*> pendingUpdates;
+
     bool isConsoleApp;
 
     int insertionPoint;
+
+    ParallelGraphRenderer parallelRenderer;
+    std::atomic<bool> parallelProcessing { false };
 };
 
 #endif // __PROCESSORGRAPH_H_124F8B50__
@@ -0,0 +1,497 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "AsyncFileWriter.h"
+
+#include "../../../Utils/Utils.h"
+
+#if JUCE_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//==============================================================================
+/** Thread that performs the disk writes of one or more AsyncFileWriters */
+class AsyncFileWriter::IOThread : public Thread
+{
+public:
+    IOThread (const String& name) : Thread (name)
+    {
+        startThread();
+    }
+
+    ~IOThread()
+    {
+        signalThreadShouldExit();
+        requestAdded.signal();
+        stopThread (-1);
+    }
+
+    void submit (Request&& request)
+    {
+        {
+            const ScopedLock lock (queueLock);
+            queue.push_back (std::move (request));
+        }
+
+        requestAdded.signal();
+    }
+
+    void run() override
+    {
+        while (true)
+        {
+            Request request;
+
+            {
+                const ScopedLock lock (queueLock);
+
+                if (queue.empty())
+                {
+                    if (threadShouldExit())
+                        return;
+                }
+                else
+                {
+                    request = std::move (queue.front());
+                    queue.pop_front();
+                }
+            }
+
+            if (request.writer == nullptr)
+                requestAdded.wait (100);
+            else
+                request.writer->performRequest (request);
+        }
+    }
+
+private:
+    std::deque<Request> queue;
+    CriticalSection queueLock;
+    WaitableEvent requestAdded;
+};
+
+//==============================================================================
+#if JUCE_LINUX
+
+/** Direct POSIX access to the file. Appended data goes through dataFd, which is
+    opened with O_DIRECT if possible; headers and the unaligned tail go through bufferedFd. */
+struct AsyncFileWriter::FileHandle
+{
+    int dataFd = -1;
+    int bufferedFd = -1;
+    bool direct = false;
+
+    bool preallocated = false;
+    int64 endPosition = 0;
+
+    int64 lastRangeStart = 0;
+    int64 lastRangeSize = 0;
+
+    ~FileHandle()
+    {
+        if (bufferedFd >= 0)
+        {
+            finishWriteback();
+
+            // give back the space reserved beyond the end of the data
+            if (preallocated && ftruncate (bufferedFd, endPosition) != 0)
+                LOGD ("AsyncFileWriter: unable to release the preallocated space: ", strerror (errno));
+        }
+
+        if (dataFd >= 0 && dataFd != bufferedFd)
+            ::close (dataFd);
+
+        if (bufferedFd >= 0)
+            ::close (bufferedFd);
+    }
+
+    bool open (const File& file, const Options& options)
+    {
+        const String path = file.getFullPathName();
+
+        bufferedFd = ::open (path.toRawUTF8(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+        if (bufferedFd < 0)
+        {
+            LOGE ("AsyncFileWriter: unable to open ", path, ": ", strerror (errno));
+            return false;
+        }
+
+        if (options.directIO)
+        {
+            dataFd = ::open (path.toRawUTF8(), O_WRONLY | O_CLOEXEC | O_DIRECT);
+
+            if (dataFd < 0)
+                LOGD ("AsyncFileWriter: direct I/O not available for ", path, ", using buffered writes");
+        }
+
+        direct = dataFd >= 0;
+
+        if (! direct)
+            dataFd = bufferedFd;
+
+        if (options.preallocateBytes > 0)
+        {
+            preallocated = fallocate (bufferedFd, FALLOC_FL_KEEP_SIZE, 0, options.preallocateBytes) == 0;
+
+            if (! preallocated)
+                LOGD ("AsyncFileWriter: unable to preallocate ", options.preallocateBytes, " bytes for ", path);
+        }
+
+        return true;
+    }
+
+    static bool writeAll (int fd, int64 position, const char* data, size_t numBytes)
+    {
+        while (numBytes > 0)
+        {
+            const ssize_t written = pwrite (fd, data, numBytes, position);
+
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                return false;
+            }
+
+            data += written;
+            position += written;
+            numBytes -= size_t (written);
+        }
+
+        return true;
+    }
+
+    bool writeData (int64 position, const char* data, size_t numBytes)
+    {
+        endPosition = jmax (endPosition, position + int64 (numBytes));
+
+        const bool isAligned = (position % alignment) == 0 && (numBytes % alignment) == 0;
+
+        if (direct && isAligned)
+        {
+            if (writeAll (dataFd, position, data, numBytes))
+                return true;
+
+            if (errno != EINVAL)
+                return false;
+
+            // the filesystem accepted O_DIRECT but refuses the write: carry on with buffered I/O
+            LOGD ("AsyncFileWriter: direct write refused, switching to buffered writes");
+            ::close (dataFd);
+            dataFd = bufferedFd;
+            direct = false;
+        }
+
+        if (! writeAll (bufferedFd, position, data, numBytes))
+            return false;
+
+        // this includes the unaligned tail of a direct file, which would otherwise stay in the page cache
+        dropWrittenPages (position, numBytes);
+
+        return true;
+    }
+
+    /** Starts writeback of the range just written, then waits for the previous
+        range and drops it from the page cache, so dirty pages never pile up */
+    void dropWrittenPages (int64 position, size_t numBytes)
+    {
+        sync_file_range (bufferedFd, position, numBytes, SYNC_FILE_RANGE_WRITE);
+
+        if (lastRangeSize > 0)
+        {
+            sync_file_range (bufferedFd, lastRangeStart, lastRangeSize, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            posix_fadvise (bufferedFd, lastRangeStart, lastRangeSize, POSIX_FADV_DONTNEED);
+        }
+
+        lastRangeStart = position;
+        lastRangeSize = int64 (numBytes);
+    }
+
+    /** Waits for the last range passed to dropWrittenPages, and drops it from the page cache */
+    void finishWriteback()
+    {
+        if (lastRangeSize > 0)
+        {
+            sync_file_range (bufferedFd, lastRangeStart, lastRangeSize, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            posix_fadvise (bufferedFd, lastRangeStart, lastRangeSize, POSIX_FADV_DONTNEED);
+            lastRangeSize = 0;
+        }
+    }
+
+    bool writeHeader (int64 position, const char* data, size_t numBytes)
+    {
+        endPosition = jmax (endPosition, position + int64 (numBytes));
+
+        return writeAll (bufferedFd, position, data, numBytes);
+    }
+};
+
+#else
+
+/** Writes through a FileOutputStream, used only from the I/O thread */
+struct AsyncFileWriter::FileHandle
+{
+    std::unique_ptr<FileOutputStream> stream;
+    bool direct = false;
+
+    bool open (const File& file, const Options&)
+    {
+        stream = file.createOutputStream (0);
+
+        if (stream == nullptr || ! stream->openedOk())
+        {
+            LOGE ("AsyncFileWriter: unable to open ", file.getFullPathName());
+            return false;
+        }
+
+        stream->setPosition (0);
+        stream->truncate();
+
+        return true;
+    }
+
+    bool writeData (int64 position, const char* data, size_t numBytes)
+    {
+        return stream->setPosition (position) && stream->write (data, numBytes);
+    }
+
+    bool writeHeader (int64 position, const char* data, size_t numBytes)
+    {
+        const int64 endPosition = stream->getPosition();
+
+        const bool ok = stream->setPosition (position) && stream->write (data, numBytes);
+        stream->setPosition (jmax (endPosition, position + int64 (numBytes)));
+
+        return ok;
+    }
+};
+
+#endif
+
+//==============================================================================
+AsyncFileWriter::AsyncFileWriter (const File& file, const Options& options)
+    : m_file (file),
+      m_options (options),
+      m_bufferSize ((jmax (options.bufferSize, size_t (1)) + alignment - 1) & ~(alignment - 1)),
+      m_handle (std::make_unique<FileHandle>()),
+      m_thread (options.ioThread != nullptr ? options.ioThread : createIOThread ("Record I/O")),
+      m_header (size_t (options.headerSize), true),
+      m_bufferPosition (options.headerSize & ~int64 (alignment - 1)),
+      m_position (options.headerSize)
+{
+    m_openedOk = m_handle->open (file, options);
+    m_usingDirectIO = m_openedOk && m_handle->direct;
+}
+
+std::shared_ptr<AsyncFileWriter::IOThread> AsyncFileWriter::createIOThread (const String& name)
+{
+    return std::make_shared<IOThread> (name);
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+    if (! m_openedOk)
+        return;
+
+    if (m_currentBuffer >= 0 && m_bufferFill > 0)
+        submitBuffer();
+
+    Request request;
+    request.writer = this;
+    request.type = Request::CLOSE;
+
+    m_thread->submit (std::move (request));
+    m_closed.wait();
+}
+
+bool AsyncFileWriter::write (const void* data, size_t numBytes)
+{
+    if (! m_openedOk || m_failed)
+        return false;
+
+    const char* source = static_cast<const char*> (data);
+
+    while (numBytes > 0)
+    {
+        if (m_currentBuffer < 0 && ! acquireBuffer())
+            return false;
+
+        const size_t bytesToCopy = jmin (numBytes, m_bufferSize - m_bufferFill);
+
+        memcpy (m_buffers[m_currentBuffer]->data + m_bufferFill, source, bytesToCopy);
+
+        m_bufferFill += bytesToCopy;
+        m_position += int64 (bytesToCopy);
+        source += bytesToCopy;
+        numBytes -= bytesToCopy;
+
+        if (m_bufferFill == m_bufferSize)
+            submitBuffer();
+    }
+
+    return ! m_failed;
+}
+
+bool AsyncFileWriter::writeHeader (int64 position, const void* data, size_t numBytes)
+{
+    if (! m_openedOk || m_failed)
+        return false;
+
+    // the header must not overlap the appended data
+    jassert (position + int64 (numBytes) <= m_options.headerSize);
+
+    memcpy (m_header + position, data, numBytes);
+
+    Request request;
+    request.writer = this;
+    request.type = Request::HEADER;
+    request.position = position;
+    request.numBytes = numBytes;
+    request.headerData.append (data, numBytes);
+
+    m_thread->submit (std::move (request));
+
+    return true;
+}
+
+bool AsyncFileWriter::acquireBuffer()
+{
+    bool waited = false;
+
+    while (true)
+    {
+        {
+            const ScopedLock lock (m_bufferLock);
+
+            if (! m_freeBuffers.isEmpty())
+            {
+                m_currentBuffer = m_freeBuffers.removeAndReturn (m_freeBuffers.size() - 1);
+                break;
+            }
+
+            if (m_buffers.size() < jmax (1, m_options.numBuffers))
+            {
+                Buffer* buffer = new Buffer();
+                buffer->memory.malloc (m_bufferSize + alignment);
+                buffer->data = reinterpret_cast<char*> ((reinterpret_cast<pointer_sized_uint> (buffer->memory.getData()) + alignment - 1)
+                                                        & ~pointer_sized_uint (alignment - 1));
+
+                m_currentBuffer = m_buffers.size();
+                m_buffers.add (buffer);
+                break;
+            }
+        }
+
+        if (m_failed)
+            return false;
+
+        if (! waited)
+        {
+            LOGD ("AsyncFileWriter: waiting for the disk to catch up on ", m_file.getFileName());
+            waited = true;
+        }
+
+        m_bufferReleased.wait (100);
+    }
+
+    // leave room for the end of the header, copied in when the buffer is submitted
+    m_bufferFill = getHeaderBytesInBuffer (m_bufferPosition);
+    return true;
+}
+
+size_t AsyncFileWriter::getHeaderBytesInBuffer (int64 position) const
+{
+    return size_t (jmax (int64 (0), m_options.headerSize - position));
+}
+
+void AsyncFileWriter::submitBuffer()
+{
+    // use the latest header contents, so this write never undoes a header update queued before it
+    const size_t headerBytes = getHeaderBytesInBuffer (m_bufferPosition);
+
+    if (headerBytes > 0)
+        memcpy (m_buffers[m_currentBuffer]->data, m_header + m_bufferPosition, headerBytes);
+
+    Request request;
+    request.writer = this;
+    request.type = Request::DATA;
+    request.bufferIndex = m_currentBuffer;
+    request.position = m_bufferPosition;
+    request.numBytes = m_bufferFill;
+
+    m_bufferPosition += int64 (m_bufferFill);
+    m_currentBuffer = -1;
+    m_bufferFill = 0;
+
+    m_thread->submit (std::move (request));
+}
+
+void AsyncFileWriter::performRequest (const Request& request)
+{
+    switch (request.type)
+    {
+        case Request::DATA:
+        {
+            Buffer* buffer;
+
+            {
+                const ScopedLock lock (m_bufferLock);
+                buffer = m_buffers[request.bufferIndex];
+            }
+
+            if (! m_failed && ! m_handle->writeData (request.position, buffer->data, request.numBytes))
+            {
+                LOGE ("AsyncFileWriter: error writing to ", m_file.getFullPathName());
+                m_failed = true;
+            }
+
+            m_usingDirectIO = m_handle->direct;
+
+            {
+                const ScopedLock lock (m_bufferLock);
+                m_freeBuffers.add (request.bufferIndex);
+            }
+
+            m_bufferReleased.signal();
+            break;
+        }
+
+        case Request::HEADER:
+            if (! m_failed && ! m_handle->writeHeader (request.position, static_cast<const char*> (request.headerData.getData()), request.numBytes))
+            {
+                LOGE ("AsyncFileWriter: error writing header of ", m_file.getFullPathName());
+                m_failed = true;
+            }
+            break;
+
+        case Request::CLOSE:
+            m_handle.reset();
+            m_closed.signal();
+            break;
+    }
+}
@@ -0,0 +1,180 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef ASYNCFILEWRITER_H
+#define ASYNCFILEWRITER_H
+
+#include "../../../../JuceLibraryCode/JuceHeader.h"
+
+#include "../../PluginManager/PluginClass.h"
+
+#include <atomic>
+#include <deque>
+
+/**
+
+    Writes a file sequentially from a background thread.
+
+    Appended data is copied into a small pool of aligned buffers; full
+    buffers are handed to an I/O thread, so the caller only blocks if every
+    buffer of the file is still waiting to reach the disk. Files can share
+    an I/O thread (a record engine uses one for all of its files), so a
+    slow disk only holds up the files written to it.
+
+    On Linux the file can be opened with O_DIRECT, bypassing the page cache
+    (if the filesystem refuses, writes fall back to buffered I/O with
+    early writeback and cache dropping), and disk space can be reserved
+    up front with fallocate (the space beyond the data is given back when
+    the file is closed). Other platforms write through a FileOutputStream
+    on the I/O thread.
+
+    An optional header region at the start of the file can be (re)written
+    at any time with writeHeader(); appended data starts right after it.
+    To keep direct writes aligned, the first buffer starts on the aligned
+    offset below the end of the header, and carries the last header bytes.
+
+*/
+class PLUGIN_API AsyncFileWriter
+{
+public:
+    class IOThread;
+
+    /** Settings used when opening a file */
+    struct Options
+    {
+        /** Bypass the page cache (Linux only) */
+        bool directIO = false;
+
+        /** Number of bytes of disk space to reserve when the file is opened (0 = none) */
+        int64 preallocateBytes = 0;
+
+        /** Size of each buffer (rounded up to a multiple of alignment) */
+        size_t bufferSize = 64 * 1024;
+
+        /** Maximum number of buffers that can be queued for this file */
+        int numBuffers = 2;
+
+        /** Size of the header region that precedes the appended data */
+        int64 headerSize = 0;
+
+        /** Thread that performs the writes (if null, the file gets a thread of its own) */
+        std::shared_ptr<IOThread> ioThread;
+    };
+
+    /** Creates an I/O thread that can be shared by several files */
+    static std::shared_ptr<IOThread> createIOThread (const String& name);
+
+    /** Alignment of buffers, file offsets and sizes required for direct I/O */
+    static constexpr size_t alignment = 4096;
+
+    /** Creates (or truncates) a file and opens it for writing */
+    AsyncFileWriter (const File& file, const Options& options);
+
+    /** Writes any buffered data, and waits until everything has been written to the file */
+    ~AsyncFileWriter();
+
+    /** Returns true if the file was opened successfully */
+    bool openedOk() const { return m_openedOk; }
+
+    /** Returns true if the file is currently being written with direct I/O */
+    bool isUsingDirectIO() const { return m_usingDirectIO.load(); }
+
+    /** Appends data to the end of the file. Returns false if a previous write has failed. */
+    bool write (const void* data, size_t numBytes);
+
+    /** Writes data into the header region */
+    bool writeHeader (int64 position, const void* data, size_t numBytes);
+
+    /** Returns the total number of bytes in the file (header + appended data) */
+    int64 getPosition() const { return m_position; }
+
+    /** Returns the File being written */
+    const File& getFile() const { return m_file; }
+
+private:
+    struct FileHandle;
+
+    struct Buffer
+    {
+        HeapBlock<char> memory;
+        char* data;
+    };
+
+    struct Request
+    {
+        enum Type
+        {
+            DATA,
+            HEADER,
+            CLOSE
+        };
+
+        AsyncFileWriter* writer = nullptr;
+        Type type = DATA;
+        int bufferIndex = -1;
+        int64 position = 0;
+        size_t numBytes = 0;
+        MemoryBlock headerData;
+    };
+
+    /** Makes a free buffer the current one, waiting for one if necessary */
+    bool acquireBuffer();
+
+    /** Queues the current buffer for writing */
+    void submitBuffer();
+
+    /** Returns the number of header bytes at the start of the buffer written at position */
+    size_t getHeaderBytesInBuffer (int64 position) const;
+
+    /** Called on the I/O thread */
+    void performRequest (const Request& request);
+
+    const File m_file;
+    const Options m_options;
+    const size_t m_bufferSize;
+
+    std::unique_ptr<FileHandle> m_handle;
+    std::shared_ptr<IOThread> m_thread;
+
+    OwnedArray<Buffer> m_buffers;
+    Array<int> m_freeBuffers;
+    CriticalSection m_bufferLock;
+    WaitableEvent m_bufferReleased;
+    WaitableEvent m_closed;
+
+    HeapBlock<char> m_header;
+
+    int m_currentBuffer { -1 };
+    size_t m_bufferFill { 0 };
+    int64 m_bufferPosition;
+    int64 m_position;
+
+    bool m_openedOk { false };
+    std::atomic<bool> m_usingDirectIO { false };
+    std::atomic<bool> m_failed { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AsyncFileWriter);
+};
+
+#endif // ASYNCFILEWRITER_H
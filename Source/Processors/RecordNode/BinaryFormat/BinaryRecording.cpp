@@ -37,7 +37,6 @@ BinaryRecording::BinaryRecording()
     m_bufferSize = MAX_BUFFER_SIZE;
     m_scaledBuffer.malloc (MAX_BUFFER_SIZE);
     m_intBuffer.malloc (MAX_BUFFER_SIZE);
-    m_sampleNumberBuffer.malloc (MAX_BUFFER_SIZE);
 }
 
 BinaryRecording::~BinaryRecording() {}
@@ -68,9 +67,15 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
 
     String contPath = basepath + "continuous" + File::getSeparatorString();
 
+    if (m_ioThread == nullptr)
+        m_ioThread = AsyncFileWriter::createIOThread ("Record I/O");
+
+    const AsyncFileWriter::Options eventFileOptions = getWriterOptions (0.0, 16 * 1024, 2);
+
     m_channelIndexes.insertMultiple (0, 0, getNumRecordedContinuousChannels());
     m_fileIndexes.insertMultiple (0, 0, getNumRecordedContinuousChannels());
     m_samplesWritten.insertMultiple (0, 0, getNumRecordedContinuousChannels());
+    m_channelScales.insertMultiple (0, 0.0f, getNumRecordedContinuousChannels());
 
     Array<var> continuousChannelJSON;
     Array<var> singleStreamJSON;
@@ -94,8 +99,8 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
 
         if (streamId != lastStreamId)
         {
-            wroteFirstSampleNumber[streamId] = false;
-            
+            firstSampleNumber[streamId] = -1;
+
             firstChannels.add (channelInfo);
             streamIndex++;
 
@@ -111,6 +116,7 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
 
         m_fileIndexes.set (ch, streamIndex);
         m_channelIndexes.set (ch, indexWithinStream++);
+        m_channelScales.set (ch, 1.0f / channelInfo->getBitVolts());
 
         DynamicObject::Ptr singleChannelJSON = new DynamicObject();
 
@@ -138,15 +144,18 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
         streamIndex++;
 
         String datPath = getProcessorString (ch);
-        String filename = contPath + datPath + "continuous.dat";
 
         LOGD ("Creating file: ", contPath, datPath, "sample_numbers.npy");
-        ScopedPointer<NpyFile> tFile = new NpyFile (contPath + datPath + "sample_numbers.npy", NpyType (BaseType::INT64, 1));
+        const AsyncFileWriter::Options timestampFileOptions = getWriterOptions (ch->getSampleRate() * sizeof (int64), 256 * 1024, 4);
+
+        ScopedPointer<NpyFile> tFile = new NpyFile (contPath + datPath + "sample_numbers.npy", NpyType (BaseType::INT64, 1), 1, timestampFileOptions);
         m_dataTimestampFiles.add (tFile.release());
 
-        ScopedPointer<NpyFile> syncTimestampFile = new NpyFile (contPath + datPath + "timestamps.npy", NpyType (BaseType::DOUBLE, 1));
+        ScopedPointer<NpyFile> syncTimestampFile = new NpyFile (contPath + datPath + "timestamps.npy", NpyType (BaseType::DOUBLE, 1), 1, timestampFileOptions);
         m_dataSyncTimestampFiles.add (syncTimestampFile.release());
 
+        m_sampleNumberBuffers.emplace_back (MAX_BUFFER_SIZE);
+
         DynamicObject::Ptr fileJSON = new DynamicObject();
         fileJSON->setProperty ("folder_name", datPath.replace (File::getSeparatorString(), "/")); //to make it more system agnostic, replace separator with only one slash
         fileJSON->setProperty ("sample_rate", ch->getSampleRate());
@@ -157,12 +166,7 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
         fileJSON->setProperty ("recorded_processor_id", ch->getNodeId());
         fileJSON->setProperty ("num_channels", channelCounts[streamIndex]);
 
-        ScopedPointer<SequentialBlockFile> bFile = new SequentialBlockFile (channelCounts[streamIndex], samplesPerBlock);
-
-        if (bFile->openFile (filename))
-            m_continuousFiles.add (bFile.release());
-        else
-            m_continuousFiles.add (nullptr);
+        openContinuousFile (contPath + datPath, channelCounts[streamIndex], ch->getSampleRate(), fileJSON.get());
 
         fileJSON->setProperty ("channels", multiStreamJSON.getReference (streamIndex));
 
@@ -209,12 +213,12 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
 
         ScopedPointer<EventRecording> rec = new EventRecording();
 
-        rec->data = std::make_unique<NpyFile> (eventPath + eventName + dataFileName + ".npy", type);
-        rec->samples = std::make_unique<NpyFile> (eventPath + eventName + "sample_numbers.npy", NpyType (BaseType::INT64, 1));
-        rec->timestamps = std::make_unique<NpyFile> (eventPath + eventName + "timestamps.npy", NpyType (BaseType::DOUBLE, 1));
+        rec->data = std::make_unique<NpyFile> (eventPath + eventName + dataFileName + ".npy", type, 1, eventFileOptions);
+        rec->samples = std::make_unique<NpyFile> (eventPath + eventName + "sample_numbers.npy", NpyType (BaseType::INT64, 1), 1, eventFileOptions);
+        rec->timestamps = std::make_unique<NpyFile> (eventPath + eventName + "timestamps.npy", NpyType (BaseType::DOUBLE, 1), 1, eventFileOptions);
         if (chan->getType() == EventChannel::TTL && m_saveTTLWords)
         {
-            rec->extraFile = std::make_unique<NpyFile> (eventPath + eventName + "full_words.npy", NpyType (BaseType::UINT64, 1));
+            rec->extraFile = std::make_unique<NpyFile> (eventPath + eventName + "full_words.npy", NpyType (BaseType::UINT64, 1), 1, eventFileOptions);
         }
 
         DynamicObject::Ptr jsonChannel = new DynamicObject();
@@ -296,11 +300,11 @@ void BinaryRecording::openFiles (File rootFolder, int experimentNumber, int reco
 
         String directoryName = getProcessorString (ch) + ch->getName() + File::getSeparatorString();
 
-        rec->data = std::make_unique<NpyFile> (spikePath + directoryName + "waveforms.npy", NpyType (BaseType::INT16, ch->getTotalSamples()), ch->getNumChannels());
-        rec->samples = std::make_unique<NpyFile> (spikePath + directoryName + "sample_numbers.npy", NpyType (BaseType::INT64, 1));
-        rec->timestamps = std::make_unique<NpyFile> (spikePath + directoryName + "timestamps.npy", NpyType (BaseType::DOUBLE, 1));
-        rec->channels = std::make_unique<NpyFile> (spikePath + directoryName + "electrode_indices.npy", NpyType (BaseType::UINT16, 1));
-        rec->extraFile = std::make_unique<NpyFile> (spikePath + directoryName + "clusters.npy", NpyType (BaseType::UINT16, 1));
+        rec->data = std::make_unique<NpyFile> (spikePath + directoryName + "waveforms.npy", NpyType (BaseType::INT16, ch->getTotalSamples()), ch->getNumChannels(), eventFileOptions);
+        rec->samples = std::make_unique<NpyFile> (spikePath + directoryName + "sample_numbers.npy", NpyType (BaseType::INT64, 1), 1, eventFileOptions);
+        rec->timestamps = std::make_unique<NpyFile> (spikePath + directoryName + "timestamps.npy", NpyType (BaseType::DOUBLE, 1), 1, eventFileOptions);
+        rec->channels = std::make_unique<NpyFile> (spikePath + directoryName + "electrode_indices.npy", NpyType (BaseType::UINT16, 1), 1, eventFileOptions);
+        rec->extraFile = std::make_unique<NpyFile> (spikePath + directoryName + "clusters.npy", NpyType (BaseType::UINT16, 1), 1, eventFileOptions);
 
         electrodeJSON->setProperty ("folder", directoryName.replace (File::getSeparatorString(), "/"));
         electrodeJSON->setProperty ("source_channels", channelJSON);
@@ -357,7 +361,7 @@ std::unique_ptr<NpyFile> BinaryRecording::createEventMetadataFile (const Metadat
     }
     if (jsonFile)
         jsonFile->setProperty ("event_metadata", jsonMetadata);
-    return std::make_unique<NpyFile> (filename, types);
+    return std::make_unique<NpyFile> (filename, types, getWriterOptions (0.0, 16 * 1024, 2));
 }
 
 template <typename TO, typename FROM>
@@ -475,9 +479,32 @@ void BinaryRecording::createChannelMetadata (const MetadataObject* channel, Dyna
     jsonFile->setProperty ("channel_metadata", jsonMetadata);
 }
 
-void BinaryRecording::closeFiles()
+void BinaryRecording::openContinuousFile (const String& streamPath, int numChannels, double sampleRate, DynamicObject* streamJSON)
+{
+    ScopedPointer<SequentialBlockFile> bFile = new SequentialBlockFile (numChannels, samplesPerBlock);
+
+    const double bytesPerSecond = sampleRate * numChannels * sizeof (int16);
+
+    if (bFile->openFile (streamPath + "continuous.dat", getWriterOptions (bytesPerSecond, 4 * 1024 * 1024, 4, true)))
+        m_continuousFiles.add (bFile.release());
+    else
+        m_continuousFiles.add (nullptr);
+}
+
+void BinaryRecording::writeContinuousFile (int fileIndex, int64 firstSample, const float* const* dataBuffers, const float* scales, int size)
+{
+    if (SequentialBlockFile* file = m_continuousFiles[fileIndex])
+        file->writeChannels (firstSample, dataBuffers, scales, size);
+}
+
+void BinaryRecording::closeContinuousFiles()
 {
     m_continuousFiles.clear();
+}
+
+void BinaryRecording::closeFiles()
+{
+    closeContinuousFiles();
     m_eventFiles.clear();
     m_spikeFiles.clear();
 
@@ -485,17 +512,18 @@ void BinaryRecording::closeFiles()
 
     m_channelIndexes.clear();
     m_fileIndexes.clear();
+    m_channelScales.clear();
     m_samplesWritten.clear();
 
     m_dataTimestampFiles.clear();
     m_dataSyncTimestampFiles.clear();
+    m_sampleNumberBuffers.clear();
 
     m_spikeChannelIndexes.clear();
     m_spikeFileIndexes.clear();
 
     m_scaledBuffer.malloc (MAX_BUFFER_SIZE);
     m_intBuffer.malloc (MAX_BUFFER_SIZE);
-    m_sampleNumberBuffer.malloc (MAX_BUFFER_SIZE);
     m_bufferSize = MAX_BUFFER_SIZE;
 }
 
@@ -537,7 +565,6 @@ void BinaryRecording::writeContinuousData (int writeChannel,
         LOGE ("BinaryRecording::writeContinuousData: Write buffer overrun, resizing from: ", m_bufferSize, " to: ", size);
         m_scaledBuffer.malloc (size);
         m_intBuffer.malloc (size);
-        m_sampleNumberBuffer.malloc (size);
         m_bufferSize = size;
     }
 
@@ -560,28 +587,67 @@ void BinaryRecording::writeContinuousData (int writeChannel,
 
     /* If is first channel in subprocessor */
     if (m_channelIndexes[writeChannel] == 0)
-    {
-        int64 baseSampleNumber = getLatestSampleNumber (writeChannel);
+        writeSampleNumbersAndTimestamps (fileIndex, writeChannel, realChannel, timestampBuffer, size);
+}
 
-        uint32 streamId = getContinuousChannel (realChannel)->getStreamId();
+void BinaryRecording::writeContinuousStream (int streamIndex,
+                                             int firstWriteChannel,
+                                             int numChannels,
+                                             const float* const* dataBuffers,
+                                             const double* timestampBuffer,
+                                             int size)
+{
+    if (! size || ! numChannels)
+        return;
 
-        if (! wroteFirstSampleNumber[streamId] )
-        {
-            firstSampleNumber[streamId] = baseSampleNumber;
-            wroteFirstSampleNumber[streamId] = true;
-        }
+    int fileIndex = m_fileIndexes[firstWriteChannel];
 
-        for (int i = 0; i < size; i++)
-            /* Generate int sample number */
-            m_sampleNumberBuffer[i] = baseSampleNumber + i;
+    /* Convert every channel from float to int w/ bitVolts scaling and write them to the stream's file in one pass */
+    writeContinuousFile (fileIndex,
+                         m_samplesWritten[firstWriteChannel],
+                         dataBuffers,
+                         m_channelScales.getRawDataPointer() + firstWriteChannel,
+                         size);
+
+    for (int chan = 0; chan < numChannels; chan++)
+        m_samplesWritten.set (firstWriteChannel + chan, m_samplesWritten[firstWriteChannel + chan] + size);
+
+    writeSampleNumbersAndTimestamps (fileIndex, firstWriteChannel, getGlobalIndex (firstWriteChannel), timestampBuffer, size);
+}
+
+void BinaryRecording::writeSampleNumbersAndTimestamps (int fileIndex,
+                                                       int writeChannel,
+                                                       int realChannel,
+                                                       const double* timestampBuffer,
+                                                       int size)
+{
+    int64 baseSampleNumber = getLatestSampleNumber (writeChannel);
+
+    uint32 streamId = getContinuousChannel (realChannel)->getStreamId();
+
+    auto first = firstSampleNumber.find (streamId);
+
+    if (first != firstSampleNumber.end() && first->second.load() < 0)
+        first->second = baseSampleNumber;
 
-        /* Write int timestamps to disc */
-        m_dataTimestampFiles[fileIndex]->writeData (m_sampleNumberBuffer, size * sizeof (int64));
-        m_dataTimestampFiles[fileIndex]->increaseRecordCount (size);
+    /* Each stream has its own buffer, as streams can be written from different threads */
+    int64* sampleNumberBuffer = m_sampleNumberBuffers[fileIndex].data();
 
-        m_dataSyncTimestampFiles[fileIndex]->writeData (timestampBuffer, size * sizeof (double));
-        m_dataSyncTimestampFiles[fileIndex]->increaseRecordCount (size);
+    for (int start = 0; start < size; start += MAX_BUFFER_SIZE)
+    {
+        const int blockSize = jmin (size - start, MAX_BUFFER_SIZE);
+
+        for (int i = 0; i < blockSize; i++)
+            /* Generate int sample number */
+            sampleNumberBuffer[i] = baseSampleNumber + start + i;
+
+        m_dataTimestampFiles[fileIndex]->writeData (sampleNumberBuffer, blockSize * sizeof (int64));
     }
+
+    m_dataTimestampFiles[fileIndex]->increaseRecordCount (size);
+
+    m_dataSyncTimestampFiles[fileIndex]->writeData (timestampBuffer, size * sizeof (double));
+    m_dataSyncTimestampFiles[fileIndex]->increaseRecordCount (size);
 }
 
 void BinaryRecording::writeEvent (int eventIndex, const EventPacket& event)
@@ -680,10 +746,10 @@ void BinaryRecording::writeTimestampSyncText (uint64 streamId, int64 sampleNumbe
     String syncString = text + ": " + String (sampleNumber);
     LOGD (syncString);
 
-    int64 fsn = firstSampleNumber[streamId];
+    auto first = firstSampleNumber.find (streamId);
 
-    if(streamId > 0)
-        jassert (fsn == sampleNumber);
+    if (streamId > 0 && first != firstSampleNumber.end() && first->second.load() >= 0)
+        jassert (first->second.load() == sampleNumber);
 
     m_syncTextFile->writeText (syncString + "\r\n", false, false, nullptr);
     
@@ -696,10 +762,27 @@ RecordEngineManager* BinaryRecording::getEngineManager()
     EngineParameter* param;
     param = new EngineParameter (EngineParameter::BOOL, 0, "Record TTL full words", true);
     man->addParameter (param);
+    param = new EngineParameter (EngineParameter::BOOL, 1, "Direct I/O (Linux)", false);
+    man->addParameter (param);
+    param = new EngineParameter (EngineParameter::INT, 2, "Preallocate (minutes)", 0, 0, 1440);
+    man->addParameter (param);
     return man;
 }
 
 void BinaryRecording::setParameter (EngineParameter& parameter)
 {
     boolParameter (0, m_saveTTLWords);
+    boolParameter (1, m_useDirectIO);
+    intParameter (2, m_preallocateMinutes);
+}
+
+AsyncFileWriter::Options BinaryRecording::getWriterOptions (double bytesPerSecond, size_t bufferSize, int numBuffers, bool isContinuousData) const
+{
+    AsyncFileWriter::Options options;
+    options.directIO = m_useDirectIO && isContinuousData;
+    options.ioThread = m_ioThread;
+    options.bufferSize = bufferSize;
+    options.numBuffers = numBuffers;
+    options.preallocateBytes = int64 (bytesPerSecond * 60.0 * m_preallocateMinutes);
+    return options;
 }
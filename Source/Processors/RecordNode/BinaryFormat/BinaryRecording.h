@@ -24,9 +24,11 @@
 #ifndef BINARYRECORDING_H
 #define BINARYRECORDING_H
 
+#include <atomic>
 #include <chrono>
 #include <iomanip>
 #include <memory>
+#include <vector>
 
 #include "../../../Utils/Utils.h"
 #include "../RecordEngine.h"
@@ -62,6 +64,17 @@ public:
                               const double* timestampBuffer,
                               int size);
 
+    /** Writes a block of continuous data for all recorded channels of a stream */
+    void writeContinuousStream (int streamIndex,
+                                int firstWriteChannel,
+                                int numChannels,
+                                const float* const* dataBuffers,
+                                const double* timestampBuffer,
+                                int size) override;
+
+    /** Streams are written to separate files, so they can be written in parallel */
+    bool canWriteStreamsInParallel() const override { return true; }
+
     /** Writes an event to disk */
     void writeEvent (int eventIndex, const EventPacket& packet);
 
@@ -74,6 +87,21 @@ public:
     /** Sets an engine parameter (in this case TTL word writing bool) */
     void setParameter (EngineParameter& parameter);
 
+protected:
+    /** Creates the continuous data file(s) of a stream in streamPath. Called by openFiles()
+        once per stream, in file index order; streamJSON is the stream's entry in structure.oebin. */
+    virtual void openContinuousFile (const String& streamPath, int numChannels, double sampleRate, DynamicObject* streamJSON);
+
+    /** Writes size samples of every channel of a stream, starting at sample firstSample of the file */
+    virtual void writeContinuousFile (int fileIndex, int64 firstSample, const float* const* dataBuffers, const float* scales, int size);
+
+    /** Closes the continuous data files */
+    virtual void closeContinuousFiles();
+
+    /** Returns the settings for a file written at bytesPerSecond (used to size the preallocation).
+        Direct I/O, if enabled, is only used for continuous data files. */
+    AsyncFileWriter::Options getWriterOptions (double bytesPerSecond, size_t bufferSize, int numBuffers, bool isContinuousData = false) const;
+
 private:
     class EventRecording
     {
@@ -89,17 +117,24 @@ private:
     void createChannelMetadata (const MetadataObject* channel, DynamicObject* jsonObject);
     void writeEventMetadata (const MetadataEvent* event, NpyFile* file);
     void increaseEventCounts (EventRecording* rec);
+    void writeSampleNumbersAndTimestamps (int fileIndex, int writeChannel, int realChannel, const double* timestampBuffer, int size);
 
     bool m_saveTTLWords { true };
+    bool m_useDirectIO { false };
+    int m_preallocateMinutes { 0 };
+
+    /** Performs the disk writes of all of this engine's files */
+    std::shared_ptr<AsyncFileWriter::IOThread> m_ioThread;
 
     HeapBlock<float> m_scaledBuffer;
     HeapBlock<int16> m_intBuffer;
-    HeapBlock<int64> m_sampleNumberBuffer;
+    std::vector<std::vector<int64>> m_sampleNumberBuffers;
     int m_bufferSize;
     int m_syncTimestampBufferSize;
 
     Array<unsigned int> m_channelIndexes;
     Array<unsigned int> m_fileIndexes;
+    Array<float> m_channelScales;
 
     OwnedArray<SequentialBlockFile> m_continuousFiles;
     OwnedArray<EventRecording> m_eventFiles;
@@ -119,8 +154,9 @@ private:
     int m_experimentNum;
     Array<int64> m_samplesWritten;
 
-    std::map<uint64, int64> firstSampleNumber;
-    std::map<uint64, bool> wroteFirstSampleNumber;
+    /** First sample number written for each stream (-1 until written). The keys are
+        inserted by openFiles(), so writer threads only ever update existing values. */
+    std::map<uint64, std::atomic<int64>> firstSampleNumber;
 
     const int samplesPerBlock { 4096 };
 };
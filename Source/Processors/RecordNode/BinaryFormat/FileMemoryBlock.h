@@ -23,11 +23,13 @@
 
 #include "../../../../JuceLibraryCode/JuceHeader.h"
 
+#include "AsyncFileWriter.h"
+
 template <class StorageType = int16>
 class FileMemoryBlock
 {
 public:
-    FileMemoryBlock (std::shared_ptr<FileOutputStream> file, int blockSize, uint64 offset) : m_data (blockSize, true),
+    FileMemoryBlock (std::shared_ptr<AsyncFileWriter> file, int blockSize, uint64 offset) : m_data (blockSize, true),
                                                                                              m_file (file),
                                                                                              m_blockSize (blockSize),
                                                                                              m_offset (offset),
@@ -50,7 +52,7 @@ public:
 
 private:
     HeapBlock<StorageType> m_data;
-    std::shared_ptr<FileOutputStream> m_file;
+    std::shared_ptr<AsyncFileWriter> m_file;
     const int m_blockSize;
     const uint64 m_offset;
     size_t m_finalFlushSamples;
@@ -31,7 +31,7 @@
 
 #include "NpyFile.h"
 
-NpyFile::NpyFile (String path, const Array<NpyType>& typeList)
+NpyFile::NpyFile (String path, const Array<NpyType>& typeList, const AsyncFileWriter::Options& options)
 {
     m_dim1 = 1;
     m_dim2 = 1;
@@ -49,10 +49,10 @@ NpyFile::NpyFile (String path, const Array<NpyType>& typeList)
     if (! openFile (path))
         return;
 
-    writeHeader (typeList);
+    writeHeader (typeList, options);
 }
 
-NpyFile::NpyFile (String path, NpyType type, unsigned int dim)
+NpyFile::NpyFile (String path, NpyType type, unsigned int dim, const AsyncFileWriter::Options& options)
 {
     if (! openFile (path))
         return;
@@ -61,7 +61,7 @@ NpyFile::NpyFile (String path, NpyType type, unsigned int dim)
     typeList.add (type);
     m_dim1 = dim;
     m_dim2 = type.getTypeLength();
-    writeHeader (typeList);
+    writeHeader (typeList, options);
 }
 
 bool NpyFile::openFile (String path)
@@ -76,14 +76,9 @@ bool NpyFile::openFile (String path)
         LOGD ("Re-creating file: ", path);
     }
 
-    m_file = file.createOutputStream();
+    m_path = file;
 
-    if (! m_file)
-        return false;
-
-    m_okOpen = true;
-
-    return true;
+    return file.existsAsFile();
 }
 
 String NpyFile::getShapeString()
@@ -102,7 +97,7 @@ String NpyFile::getShapeString()
     return shape;
 }
 
-void NpyFile::writeHeader (const Array<NpyType>& typeList)
+void NpyFile::writeHeader (const Array<NpyType>& typeList, const AsyncFileWriter::Options& options)
 {
     uint8 magicNum = 0x93;
     String magicStr = "NUMPY";
@@ -146,39 +141,46 @@ void NpyFile::writeHeader (const Array<NpyType>& typeList)
     strHeader += '\n';
     uint16 strHeaderLen = strHeader.length();
 
-    m_file->write (&magicNum, sizeof (uint8));
-    m_file->write (magicStr.toUTF8(), magicStr.getNumBytesAsUTF8());
-    m_file->write (&ver, sizeof (uint16));
-    m_file->write (&strHeaderLen, sizeof (uint16));
-    m_file->write (strHeader.toUTF8(), strHeaderLen);
-    m_headerLen = m_file->getPosition(); // total header length
-    m_file->flush();
+    MemoryOutputStream header;
+    header.write (&magicNum, sizeof (uint8));
+    header.write (magicStr.toUTF8(), magicStr.getNumBytesAsUTF8());
+    header.write (&ver, sizeof (uint16));
+    header.write (&strHeaderLen, sizeof (uint16));
+    header.write (strHeader.toUTF8(), strHeaderLen);
+    m_headerLen = header.getDataSize(); // total header length
+
+    AsyncFileWriter::Options fileOptions = options;
+    fileOptions.headerSize = m_headerLen;
+
+    m_file = std::make_unique<AsyncFileWriter> (m_path, fileOptions);
+
+    if (! m_file->openedOk())
+    {
+        m_file.reset();
+        return;
+    }
+
+    m_okOpen = true;
+    m_file->writeHeader (0, header.getData(), header.getDataSize());
 }
 
 void NpyFile::updateHeader()
 {
-    if (true)
+    if (! m_okOpen)
+        return;
+
+    // overwrite the shape part of the header (written in place by the I/O thread)
+    String newShape = getShapeString();
+    if (int64 (m_shapePos + newShape.getNumBytesAsUTF8()) + 1 > m_headerLen) // +1 for newline
     {
-        // overwrite the shape part of the header - even without explicitly calling
-        // m_file->flush(), overwriting seems to trigger a flush to disk,
-        // while appending to end of file does not
-        int64 currentPos = m_file->getPosition(); // returns int64, necessary for big files
-        if (m_file->setPosition (m_shapePos))
-        {
-            String newShape = getShapeString();
-            if (m_shapePos + newShape.getNumBytesAsUTF8() + 1 > m_headerLen) // +1 for newline
-            {
-                std::cerr << "Error. Header has grown too big to update in-place " << std::endl;
-            }
-            m_file->write (newShape.toUTF8(), newShape.getNumBytesAsUTF8());
-            m_file->flush(); // not necessary, already flushed due to overwrite? do it anyway
-            m_file->setPosition (currentPos); // restore position to end of file
-        }
-        else
-        {
-            std::cerr << "Error. Unable to seek to update file header"
-                      << m_file->getFile().getFullPathName() << std::endl;
-        }
+        std::cerr << "Error. Header has grown too big to update in-place " << std::endl;
+        return;
+    }
+
+    if (! m_file->writeHeader (m_shapePos, newShape.toUTF8(), newShape.getNumBytesAsUTF8()))
+    {
+        std::cerr << "Error. Unable to update file header "
+                  << m_file->getFile().getFullPathName() << std::endl;
     }
 }
 
@@ -189,7 +191,8 @@ NpyFile::~NpyFile()
 
 void NpyFile::writeData (const void* data, size_t size)
 {
-    m_file->write (data, size);
+    if (m_okOpen)
+        m_file->write (data, size);
 }
 
 void NpyFile::increaseRecordCount (int count)
@@ -34,6 +34,7 @@
 
 #include "../../../Utils/Utils.h"
 #include "../RecordEngine.h"
+#include "AsyncFileWriter.h"
 
 #include "../../PluginManager/PluginClass.h"
 #include "../../Settings/Metadata.h"
@@ -85,10 +86,10 @@ class PLUGIN_API NpyFile
 {
 public:
     /** Constructor for an array of types */
-    NpyFile (String path, const Array<NpyType>& typeList);
+    NpyFile (String path, const Array<NpyType>& typeList, const AsyncFileWriter::Options& options = AsyncFileWriter::Options());
 
     /** Constructor for a 1-dimensional file with a single type */
-    NpyFile (String path, NpyType type, unsigned int dim = 1);
+    NpyFile (String path, NpyType type, unsigned int dim = 1, const AsyncFileWriter::Options& options = AsyncFileWriter::Options());
 
     /** Destructor */
     ~NpyFile();
@@ -106,13 +107,14 @@ private:
     /** Returns a string describing the underlying array shape */
     String getShapeString();
 
-    /** Writes the initial file header */
-    void writeHeader (const Array<NpyType>& typeList);
+    /** Writes the initial file header and creates the writer for the data that follows it */
+    void writeHeader (const Array<NpyType>& typeList, const AsyncFileWriter::Options& options);
 
     /** Updates the header with the total number of samples */
     void updateHeader();
 
-    std::unique_ptr<FileOutputStream> m_file;
+    File m_path;
+    std::unique_ptr<AsyncFileWriter> m_file;
     int64 m_headerLen;
     bool m_okOpen { false };
     int64 m_recordCount { 0 };
@@ -47,7 +47,7 @@ SequentialBlockFile::~SequentialBlockFile()
     m_memBlocks[0]->partialFlush (m_lastBlockFill * m_nChannels);
 }
 
-bool SequentialBlockFile::openFile (String filename)
+bool SequentialBlockFile::openFile (String filename, const AsyncFileWriter::Options& options)
 {
     File file (filename);
     Result res = file.create();
@@ -59,10 +59,11 @@ bool SequentialBlockFile::openFile (String filename)
         LOGD ("Re-creating file: ", filename);
     }
 
-    m_file = file.createOutputStream (streamBufferSize);
-    if (! m_file)
+    m_file = std::make_shared<AsyncFileWriter> (file, options);
+    if (! m_file->openedOk())
     {
         LOGD ("Unable to create output stream!");
+        m_file.reset();
         return false;
     }
 
@@ -79,15 +80,8 @@ bool SequentialBlockFile::writeChannel (uint64 startPos, int channel, int16* dat
         return false;
     }
 
-    int bIndex = m_memBlocks.size() - 1;
-    if ((bIndex < 0) || (m_memBlocks[bIndex]->getOffset() + m_samplesPerBlock) < (startPos + nSamples))
-        allocateBlocks (startPos, nSamples);
+    int bIndex = getBlockIndexForWrite (startPos, nSamples);
 
-    for (bIndex = m_memBlocks.size() - 1; bIndex >= 0; bIndex--)
-    {
-        if (m_memBlocks[bIndex]->getOffset() <= startPos)
-            break;
-    }
     if (bIndex < 0)
     {
         //LOGE("Memory block unloaded ahead of time for chan", channel, " start ", startPos, " ns ", nSamples);
@@ -128,6 +122,65 @@ bool SequentialBlockFile::writeChannel (uint64 startPos, int channel, int16* dat
     return true;
 }
 
+bool SequentialBlockFile::writeChannels (uint64 startPos, const float* const* data, const float* scales, int nSamples)
+{
+    if (! m_file)
+    {
+        printf ("[RN]SequentialBlockFile::writeChannels returned false: (!m_file)\n");
+        return false;
+    }
+
+    int bIndex = getBlockIndexForWrite (startPos, nSamples);
+
+    if (bIndex < 0)
+        return false;
+
+    int writtenSamples = 0;
+    uint64 startIdx = startPos - m_memBlocks[bIndex]->getOffset();
+    int lastBlockIdx = m_memBlocks.size() - 1;
+
+    while (writtenSamples < nSamples)
+    {
+        int16* blockPtr = m_memBlocks[bIndex]->getData() + startIdx * m_nChannels;
+        int samplesToWrite = jmin ((nSamples - writtenSamples), (m_samplesPerBlock - int (startIdx)));
+
+        // scale, convert and interleave straight into the block
+        SampleConverter::convertToInt16Interleaved (data, writtenSamples, scales, m_nChannels, samplesToWrite, blockPtr);
+
+        writtenSamples += samplesToWrite;
+
+        //Update the last block fill index
+        size_t samplePos = startIdx + samplesToWrite;
+        if (bIndex == lastBlockIdx && samplePos > m_lastBlockFill)
+        {
+            m_lastBlockFill = samplePos;
+        }
+
+        startIdx = 0;
+        bIndex++;
+    }
+
+    for (int chan = 0; chan < m_nChannels; chan++)
+        m_currentBlock.set (chan, bIndex - 1);
+
+    return true;
+}
+
+int SequentialBlockFile::getBlockIndexForWrite (uint64 startPos, int nSamples)
+{
+    int bIndex = m_memBlocks.size() - 1;
+    if ((bIndex < 0) || (m_memBlocks[bIndex]->getOffset() + m_samplesPerBlock) < (startPos + nSamples))
+        allocateBlocks (startPos, nSamples);
+
+    for (bIndex = m_memBlocks.size() - 1; bIndex >= 0; bIndex--)
+    {
+        if (m_memBlocks[bIndex]->getOffset() <= startPos)
+            break;
+    }
+
+    return bIndex;
+}
+
 void SequentialBlockFile::allocateBlocks (uint64 startIndex, int numSamples)
 {
     //First deallocate full blocks
@@ -25,6 +25,7 @@
 #define SEQUENTIALBLOCKFILE_H
 
 #include "../../../Utils/Utils.h"
+#include "../SampleConverter.h"
 #include "FileMemoryBlock.h"
 
 #include "../../PluginManager/PluginClass.h"
@@ -61,13 +62,17 @@ public:
     ~SequentialBlockFile();
 
     /** Opens the file at the requested path */
-    bool openFile (String filename);
+    bool openFile (String filename, const AsyncFileWriter::Options& options = AsyncFileWriter::Options());
 
     /** Writes nSamples of data for a particular channel */
     bool writeChannel (uint64 startPos, int channel, int16* data, int nSamples);
 
+    /** Writes nSamples of float data for all channels at once, converting each
+        channel to int16 with its scale factor (see SampleConverter) */
+    bool writeChannels (uint64 startPos, const float* const* data, const float* scales, int nSamples);
+
 private:
-    std::shared_ptr<FileOutputStream> m_file;
+    std::shared_ptr<AsyncFileWriter> m_file;
     const int m_nChannels;
     const int m_samplesPerBlock;
     const int m_blockSize;
@@ -78,8 +83,11 @@ private:
     /** Allocates data for a startIndex / numSamples combination */
     void allocateBlocks (uint64 startIndex, int numSamples);
 
+    /** Makes sure blocks exist for the requested range and returns the index of the block
+        containing startPos, or -1 if that block has already been flushed */
+    int getBlockIndexForWrite (uint64 startPos, int nSamples);
+
     /** Compile-time params */
-    const int streamBufferSize { 0 };
     const int blockArrayInitSize { 128 };
 };
 #endif // !SEQUENTIALBLOCKFILE_H
@@ -0,0 +1,120 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "CompressedRecording.h"
+
+CompressedRecording::CompressedRecording()
+{
+}
+
+CompressedRecording::~CompressedRecording()
+{
+    closeContinuousFiles();
+}
+
+String CompressedRecording::getEngineId() const
+{
+    return "COMPRESSED";
+}
+
+RecordEngineManager* CompressedRecording::getEngineManager()
+{
+    RecordEngineManager* man = new RecordEngineManager ("COMPRESSED", "Compressed", &(engineFactory<CompressedRecording>) );
+    EngineParameter* param;
+    param = new EngineParameter (EngineParameter::BOOL, 0, "Record TTL full words", true);
+    man->addParameter (param);
+    param = new EngineParameter (EngineParameter::BOOL, 1, "Direct I/O (Linux)", false);
+    man->addParameter (param);
+    // index 2 is the binary engine's preallocation, which isn't offered here
+    // because the size of a compressed file isn't known in advance
+    param = new EngineParameter (EngineParameter::INT, 3, "Compression threads", 2, 1, 16);
+    man->addParameter (param);
+    return man;
+}
+
+void CompressedRecording::setParameter (EngineParameter& parameter)
+{
+    BinaryRecording::setParameter (parameter);
+
+    intParameter (3, m_compressionThreads);
+}
+
+void CompressedRecording::openFiles (File rootFolder, int experimentNumber, int recordingNumber)
+{
+    m_statistics.bytesReceived = 0;
+    m_statistics.bytesStored = 0;
+
+    m_encoderPool = std::make_unique<ThreadPool> (ThreadPoolOptions {}
+                                                      .withThreadName ("Record Compression")
+                                                      .withNumberOfThreads (jmax (1, m_compressionThreads)));
+
+    BinaryRecording::openFiles (rootFolder, experimentNumber, recordingNumber);
+}
+
+void CompressedRecording::closeFiles()
+{
+    BinaryRecording::closeFiles();
+
+    m_encoderPool.reset();
+
+    if (m_statistics.bytesStored > 0)
+        LOGC ("Compressed continuous data by a factor of ", double (m_statistics.bytesReceived) / double (m_statistics.bytesStored));
+}
+
+void CompressedRecording::openContinuousFile (const String& streamPath, int numChannels, double sampleRate, DynamicObject* streamJSON)
+{
+    ScopedPointer<CompressedStreamFile> file = new CompressedStreamFile (numChannels, samplesPerChunk, m_encoderPool.get(), &m_statistics);
+
+    if (file->openFile (streamPath + "continuous.oecz", streamPath + "chunk_offsets.npy", getWriterOptions (0.0, 1024 * 1024, 4, true)))
+        m_streamFiles.add (file.release());
+    else
+        m_streamFiles.add (nullptr);
+
+    DynamicObject::Ptr compressionJSON = new DynamicObject();
+    compressionJSON->setProperty ("codec", "oecz");
+    compressionJSON->setProperty ("chunk_samples", samplesPerChunk);
+    compressionJSON->setProperty ("data_file", "continuous.oecz");
+    compressionJSON->setProperty ("index_file", "chunk_offsets.npy");
+
+    streamJSON->setProperty ("compression", var (compressionJSON.get()));
+}
+
+void CompressedRecording::writeContinuousFile (int fileIndex, int64 firstSample, const float* const* dataBuffers, const float* scales, int size)
+{
+    if (CompressedStreamFile* file = m_streamFiles[fileIndex])
+        file->writeChannels (dataBuffers, scales, size);
+}
+
+void CompressedRecording::closeContinuousFiles()
+{
+    m_streamFiles.clear();
+}
+
+bool CompressedRecording::getCompressionStatistics (uint64& bytesReceived, uint64& bytesStored) const
+{
+    bytesReceived = m_statistics.bytesReceived.load();
+    bytesStored = m_statistics.bytesStored.load();
+
+    return true;
+}
@@ -0,0 +1,95 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef COMPRESSEDRECORDING_H
+#define COMPRESSEDRECORDING_H
+
+#include "../BinaryFormat/BinaryRecording.h"
+#include "CompressedStreamFile.h"
+
+/**
+
+    Records data in the Binary Format, except that the continuous data
+    of each stream is compressed losslessly (see ContinuousCodec).
+
+    Each stream folder holds a "continuous.oecz" file made of compressed
+    chunks and a "chunk_offsets.npy" index, instead of "continuous.dat".
+    The stream's entry in structure.oebin has a "compression" object that
+    names these files. Events, spikes, sample numbers and timestamps are
+    written exactly as by the Binary Format.
+
+    Chunks are encoded on a pool of worker threads, so the threads that
+    write the streams spend their time on I/O.
+
+*/
+class CompressedRecording : public BinaryRecording
+{
+public:
+    /** Constructor */
+    CompressedRecording();
+
+    /** Destructor */
+    ~CompressedRecording();
+
+    /** Returns the unique identifier of this RecordEngine */
+    String getEngineId() const override;
+
+    /** Launches the manager for this Record Engine, and instantiates any parameters */
+    static RecordEngineManager* getEngineManager();
+
+    /** Opens files at the start of recording */
+    void openFiles (File rootFolder, int experimentNumber, int recordingNumber) override;
+
+    /** Closes files at the end of recording */
+    void closeFiles() override;
+
+    /** Sets an engine parameter */
+    void setParameter (EngineParameter& parameter) override;
+
+    /** Reports the amount of continuous data received and stored */
+    bool getCompressionStatistics (uint64& bytesReceived, uint64& bytesStored) const override;
+
+protected:
+    /** Creates the compressed data and chunk index files of a stream */
+    void openContinuousFile (const String& streamPath, int numChannels, double sampleRate, DynamicObject* streamJSON) override;
+
+    /** Compresses and writes a block of samples for every channel of a stream */
+    void writeContinuousFile (int fileIndex, int64 firstSample, const float* const* dataBuffers, const float* scales, int size) override;
+
+    /** Flushes and closes the compressed files */
+    void closeContinuousFiles() override;
+
+private:
+    int m_compressionThreads { 2 };
+
+    std::unique_ptr<ThreadPool> m_encoderPool;
+    OwnedArray<CompressedStreamFile> m_streamFiles;
+
+    CompressedStreamFile::Statistics m_statistics;
+
+    /** Number of samples per compressed chunk */
+    const int samplesPerChunk { 2048 };
+};
+
+#endif
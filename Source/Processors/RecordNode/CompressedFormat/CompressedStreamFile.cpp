@@ -0,0 +1,180 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "CompressedStreamFile.h"
+
+#include "../SampleConverter.h"
+#include "ContinuousCodec.h"
+
+CompressedStreamFile::CompressedStreamFile (int numChannels, int samplesPerChunk, ThreadPool* encoderPool, Statistics* statistics)
+    : m_numChannels (numChannels),
+      m_samplesPerChunk (samplesPerChunk),
+      m_encoderPool (encoderPool),
+      m_statistics (statistics)
+{
+}
+
+CompressedStreamFile::~CompressedStreamFile()
+{
+    close();
+}
+
+bool CompressedStreamFile::openFile (const String& dataPath, const String& indexPath, const AsyncFileWriter::Options& options)
+{
+    File file (dataPath);
+    Result res = file.create();
+
+    if (res.failed())
+    {
+        LOGE ("Error creating file ", dataPath, ": ", res.getErrorMessage());
+        return false;
+    }
+
+    m_file = std::make_unique<AsyncFileWriter> (file, options);
+
+    if (! m_file->openedOk())
+    {
+        LOGE ("Unable to create output stream for ", dataPath);
+        m_file.reset();
+        return false;
+    }
+
+    AsyncFileWriter::Options indexOptions;
+    indexOptions.ioThread = options.ioThread;
+
+    m_indexFile = std::make_unique<NpyFile> (indexPath, NpyType (BaseType::INT64, 1), 1, indexOptions);
+
+    const size_t maxEncodedSize = ContinuousCodec::getMaxEncodedSize (m_numChannels, m_samplesPerChunk);
+
+    for (int i = 0; i < numChunks; i++)
+    {
+        Chunk* chunk = m_chunks.add (new Chunk());
+        chunk->samples.malloc (size_t (m_numChannels) * size_t (m_samplesPerChunk));
+        chunk->encoded.malloc (maxEncodedSize);
+    }
+
+    return true;
+}
+
+void CompressedStreamFile::writeChannels (const float* const* data, const float* scales, int numSamples)
+{
+    if (m_file == nullptr)
+        return;
+
+    int offset = 0;
+
+    while (offset < numSamples)
+    {
+        Chunk* chunk = m_chunks[m_currentChunk];
+
+        const int samplesToCopy = jmin (numSamples - offset, m_samplesPerChunk - chunk->numSamples);
+
+        SampleConverter::convertToInt16Interleaved (data,
+                                                    offset,
+                                                    scales,
+                                                    m_numChannels,
+                                                    samplesToCopy,
+                                                    chunk->samples + size_t (chunk->numSamples) * size_t (m_numChannels));
+
+        chunk->numSamples += samplesToCopy;
+        offset += samplesToCopy;
+
+        if (chunk->numSamples == m_samplesPerChunk)
+            submitCurrentChunk();
+    }
+
+    // write whatever the encoder has finished, without waiting
+    while (m_numSubmitted > 0 && writeOldestChunk (false))
+    {
+    }
+}
+
+void CompressedStreamFile::submitCurrentChunk()
+{
+    Chunk* chunk = m_chunks[m_currentChunk];
+
+    const int numChannels = m_numChannels;
+
+    auto encode = [chunk, numChannels]
+    {
+        chunk->encodedSize = ContinuousCodec::encodeChunk (chunk->samples, numChannels, chunk->numSamples, chunk->encoded);
+        chunk->encodingFinished.signal();
+    };
+
+    if (m_encoderPool != nullptr)
+    {
+        m_encoderPool->addJob (std::function<void()> (encode));
+    }
+    else
+    {
+        encode();
+    }
+
+    m_numSubmitted++;
+    m_currentChunk = (m_currentChunk + 1) % numChunks;
+
+    // the next chunk to fill is still waiting to be written
+    if (m_numSubmitted == numChunks)
+        writeOldestChunk (true);
+}
+
+bool CompressedStreamFile::writeOldestChunk (bool waitIfEncoding)
+{
+    Chunk* chunk = m_chunks[m_oldestChunk];
+
+    if (! chunk->encodingFinished.wait (waitIfEncoding ? -1.0 : 0.0))
+        return false;
+
+    const int64 offset = m_file->getPosition();
+
+    m_file->write (chunk->encoded, chunk->encodedSize);
+
+    m_indexFile->writeData (&offset, sizeof (int64));
+    m_indexFile->increaseRecordCount();
+
+    m_statistics->bytesReceived += uint64 (chunk->numSamples) * uint64 (m_numChannels) * sizeof (int16);
+    m_statistics->bytesStored += uint64 (chunk->encodedSize);
+
+    chunk->numSamples = 0;
+
+    m_oldestChunk = (m_oldestChunk + 1) % numChunks;
+    m_numSubmitted--;
+
+    return true;
+}
+
+void CompressedStreamFile::close()
+{
+    if (m_file == nullptr)
+        return;
+
+    if (m_chunks[m_currentChunk]->numSamples > 0)
+        submitCurrentChunk();
+
+    while (m_numSubmitted > 0)
+        writeOldestChunk (true);
+
+    m_indexFile.reset();
+    m_file.reset();
+}
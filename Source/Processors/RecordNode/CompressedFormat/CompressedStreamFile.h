@@ -0,0 +1,117 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef COMPRESSEDSTREAMFILE_H_INCLUDED
+#define COMPRESSEDSTREAMFILE_H_INCLUDED
+
+#include "../../../Utils/Utils.h"
+#include "../BinaryFormat/AsyncFileWriter.h"
+#include "../BinaryFormat/NpyFile.h"
+
+#include "../../PluginManager/PluginClass.h"
+
+#include <atomic>
+
+/**
+
+    Writes the continuous data of one stream as a sequence of
+    compressed chunks (see ContinuousCodec).
+
+    Incoming samples are scaled to int16 and interleaved into a chunk
+    buffer. Full chunks are encoded on a ThreadPool shared by all streams,
+    and written to the file in order by the thread that writes the stream,
+    which only waits for the encoder when all chunk buffers are in use.
+
+    The byte offset of every chunk is appended to an index file
+    (a .npy array of int64), so any sample can be found without
+    scanning the data file.
+
+*/
+class PLUGIN_API CompressedStreamFile
+{
+public:
+    /** Byte counters, shared by all streams of a recording */
+    struct Statistics
+    {
+        /** Continuous data received, as int16 samples */
+        std::atomic<uint64> bytesReceived { 0 };
+
+        /** Compressed data written to disk */
+        std::atomic<uint64> bytesStored { 0 };
+    };
+
+    /** Constructor. Chunks are encoded on the calling thread if encoderPool is null. */
+    CompressedStreamFile (int numChannels, int samplesPerChunk, ThreadPool* encoderPool, Statistics* statistics);
+
+    /** Destructor (closes the file) */
+    ~CompressedStreamFile();
+
+    /** Creates the data and index files */
+    bool openFile (const String& dataPath, const String& indexPath, const AsyncFileWriter::Options& options);
+
+    /** Appends numSamples of float data for all channels, converting each
+        channel to int16 with its scale factor (see SampleConverter) */
+    void writeChannels (const float* const* data, const float* scales, int numSamples);
+
+    /** Encodes and writes any remaining data, then closes the files */
+    void close();
+
+private:
+    struct Chunk
+    {
+        HeapBlock<int16> samples;
+        HeapBlock<uint8> encoded;
+        int numSamples = 0;
+        size_t encodedSize = 0;
+        WaitableEvent encodingFinished;
+    };
+
+    /** Sends the chunk being filled to the encoder, and moves on to the next one */
+    void submitCurrentChunk();
+
+    /** Writes the oldest submitted chunk, if it has been encoded (or after waiting for it).
+        Returns false if it isn't ready yet. */
+    bool writeOldestChunk (bool waitIfEncoding);
+
+    const int m_numChannels;
+    const int m_samplesPerChunk;
+
+    ThreadPool* m_encoderPool;
+    Statistics* m_statistics;
+
+    std::unique_ptr<AsyncFileWriter> m_file;
+    std::unique_ptr<NpyFile> m_indexFile;
+
+    OwnedArray<Chunk> m_chunks;
+    int m_currentChunk { 0 };
+    int m_oldestChunk { 0 };
+    int m_numSubmitted { 0 };
+
+    /** Number of chunks that can be waiting to be encoded or written */
+    const int numChunks { 4 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressedStreamFile);
+};
+
+#endif // COMPRESSEDSTREAMFILE_H_INCLUDED
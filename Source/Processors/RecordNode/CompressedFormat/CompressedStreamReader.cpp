@@ -0,0 +1,190 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "CompressedStreamReader.h"
+
+#include "ContinuousCodec.h"
+
+CompressedStreamReader::CompressedStreamReader()
+{
+}
+
+CompressedStreamReader::~CompressedStreamReader()
+{
+}
+
+bool CompressedStreamReader::open (const File& dataFile, const File& indexFile, int numChannels)
+{
+    m_dataFile = dataFile;
+    m_file = std::make_unique<MemoryMappedFile> (dataFile, MemoryMappedFile::readOnly);
+    m_numChannels = numChannels;
+    m_loadedChunk = -1;
+
+    m_chunkOffsets.clearQuick();
+    m_chunkStartSamples.clearQuick();
+
+    if (m_file->getData() == nullptr || numChannels <= 0)
+    {
+        m_file.reset();
+        return false;
+    }
+
+    if (! (indexFile.existsAsFile() && loadIndex (indexFile)))
+        scanChunks();
+
+    return m_chunkOffsets.size() > 0;
+}
+
+bool CompressedStreamReader::loadIndex (const File& indexFile)
+{
+    FileInputStream stream (indexFile);
+
+    if (stream.failedToOpen())
+        return false;
+
+    // .npy version 1.0: 6-byte magic string, 2-byte version, 2-byte header length, header
+    char magic[6];
+
+    if (stream.read (magic, 6) != 6 || memcmp (magic, "\x93NUMPY", 6) != 0)
+        return false;
+
+    stream.skipNextBytes (2);
+    const int headerLength = stream.readShort();
+    stream.skipNextBytes (headerLength);
+
+    const uint8* data = static_cast<const uint8*> (m_file->getData());
+    const int64 fileSize = int64 (m_file->getSize());
+
+    int64 startSample = 0;
+
+    while (! stream.isExhausted())
+    {
+        const int64 offset = stream.readInt64();
+
+        ContinuousCodec::ChunkHeader header;
+
+        if (offset < 0 || offset >= fileSize
+            || ! ContinuousCodec::readChunkHeader (data + offset, size_t (fileSize - offset), header)
+            || header.numChannels != uint32 (m_numChannels))
+        {
+            m_chunkOffsets.clearQuick();
+            m_chunkStartSamples.clearQuick();
+            return false;
+        }
+
+        m_chunkOffsets.add (offset);
+        m_chunkStartSamples.add (startSample);
+        startSample += header.numSamples;
+    }
+
+    m_chunkStartSamples.add (startSample);
+
+    return m_chunkOffsets.size() > 0;
+}
+
+void CompressedStreamReader::scanChunks()
+{
+    const uint8* data = static_cast<const uint8*> (m_file->getData());
+    const int64 fileSize = int64 (m_file->getSize());
+
+    int64 offset = 0;
+    int64 startSample = 0;
+
+    ContinuousCodec::ChunkHeader header;
+
+    while (offset < fileSize
+           && ContinuousCodec::readChunkHeader (data + offset, size_t (fileSize - offset), header)
+           && header.numChannels == uint32 (m_numChannels))
+    {
+        m_chunkOffsets.add (offset);
+        m_chunkStartSamples.add (startSample);
+
+        offset += int64 (sizeof (header)) + header.payloadSize;
+        startSample += header.numSamples;
+    }
+
+    m_chunkStartSamples.add (startSample);
+}
+
+int64 CompressedStreamReader::getNumSamples() const
+{
+    return m_chunkStartSamples.isEmpty() ? 0 : m_chunkStartSamples.getLast();
+}
+
+bool CompressedStreamReader::loadChunk (int index)
+{
+    if (index == m_loadedChunk)
+        return true;
+
+    const int numSamples = int (m_chunkStartSamples[index + 1] - m_chunkStartSamples[index]);
+
+    if (numSamples > m_chunkCapacity)
+    {
+        m_chunkData.malloc (size_t (numSamples) * size_t (m_numChannels));
+        m_chunkCapacity = numSamples;
+    }
+
+    const int64 offset = m_chunkOffsets[index];
+    const uint8* data = static_cast<const uint8*> (m_file->getData()) + offset;
+
+    m_loadedChunk = -1;
+
+    if (ContinuousCodec::decodeChunk (data, size_t (int64 (m_file->getSize()) - offset), m_chunkData, m_numChannels, numSamples) != numSamples)
+    {
+        LOGE ("Corrupt compressed chunk ", index, " in ", m_dataFile.getFullPathName());
+        return false;
+    }
+
+    m_loadedChunk = index;
+
+    return true;
+}
+
+int CompressedStreamReader::read (int64 position, int16* dest, int numSamples)
+{
+    int samplesRead = 0;
+
+    while (samplesRead < numSamples && position < getNumSamples())
+    {
+        // last chunk starting at or before position
+        const int chunk = int (std::upper_bound (m_chunkStartSamples.begin(), m_chunkStartSamples.end(), position)
+                               - m_chunkStartSamples.begin())
+                          - 1;
+
+        if (chunk < 0 || ! loadChunk (chunk))
+            break;
+
+        const int offsetInChunk = int (position - m_chunkStartSamples[chunk]);
+        const int samplesToCopy = int (jmin (int64 (numSamples - samplesRead), m_chunkStartSamples[chunk + 1] - position));
+
+        memcpy (dest + size_t (samplesRead) * size_t (m_numChannels),
+                m_chunkData + size_t (offsetInChunk) * size_t (m_numChannels),
+                size_t (samplesToCopy) * size_t (m_numChannels) * sizeof (int16));
+
+        samplesRead += samplesToCopy;
+        position += samplesToCopy;
+    }
+
+    return samplesRead;
+}
@@ -0,0 +1,88 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef COMPRESSEDSTREAMREADER_H_INCLUDED
+#define COMPRESSEDSTREAMREADER_H_INCLUDED
+
+#include "../../../Utils/Utils.h"
+
+#include "../../PluginManager/PluginClass.h"
+
+/**
+
+    Reads continuous data written by CompressedStreamFile.
+
+    The chunk offsets are loaded from the index file if it is present and
+    consistent with the data; otherwise they are recovered by walking the
+    chunk headers (e.g. if the recording was interrupted). Only the chunk
+    being read is kept decoded in memory.
+
+*/
+class PLUGIN_API CompressedStreamReader
+{
+public:
+    /** Constructor */
+    CompressedStreamReader();
+
+    /** Destructor */
+    ~CompressedStreamReader();
+
+    /** Opens a data file with numChannels channels. Returns false if it holds no valid chunks. */
+    bool open (const File& dataFile, const File& indexFile, int numChannels);
+
+    /** Returns the number of samples per channel in the file */
+    int64 getNumSamples() const;
+
+    /** Returns the number of chunks in the file */
+    int getNumChunks() const { return m_chunkOffsets.size(); }
+
+    /** Copies up to numSamples interleaved frames, starting at sample position, into dest.
+        Returns the number of frames copied. */
+    int read (int64 position, int16* dest, int numSamples);
+
+private:
+    /** Reads the chunk offsets from an index file; returns false if they don't match the data */
+    bool loadIndex (const File& indexFile);
+
+    /** Finds the chunks by following their headers from the start of the file */
+    void scanChunks();
+
+    /** Decodes a chunk into m_chunkData */
+    bool loadChunk (int index);
+
+    File m_dataFile;
+    std::unique_ptr<MemoryMappedFile> m_file;
+    int m_numChannels { 0 };
+
+    Array<int64> m_chunkOffsets;
+    Array<int64> m_chunkStartSamples;
+
+    HeapBlock<int16> m_chunkData;
+    int m_chunkCapacity { 0 };
+    int m_loadedChunk { -1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressedStreamReader);
+};
+
+#endif // COMPRESSEDSTREAMREADER_H_INCLUDED
@@ -0,0 +1,414 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "ContinuousCodec.h"
+
+#if JUCE_MSVC
+#include <intrin.h>
+#endif
+
+namespace
+{
+const int chunkHeaderSize = int (sizeof (ContinuousCodec::ChunkHeader));
+
+// residuals of a second-order predictor need 19 bits after zigzag mapping
+const int rawResidualBits = 20;
+
+// quotients of this size or larger are stored as raw residuals
+const int escapeQuotient = 24;
+
+const int maxRiceParameter = 18;
+
+// channels that don't compress are stored as raw samples, with this predictor order
+const int verbatimOrder = 3;
+
+inline uint32 zigzag (int32 value)
+{
+    return (uint32 (value) << 1) ^ uint32 (value >> 31);
+}
+
+inline int32 unzigzag (uint32 value)
+{
+    return int32 (value >> 1) ^ -int32 (value & 1);
+}
+
+inline int countTrailingZeros (uint64 value)
+{
+#if JUCE_MSVC
+    unsigned long index;
+    _BitScanForward64 (&index, value);
+    return int (index);
+#else
+    return __builtin_ctzll (value);
+#endif
+}
+
+inline void writeUint32 (uint8* dest, uint32 value)
+{
+    dest[0] = uint8 (value);
+    dest[1] = uint8 (value >> 8);
+    dest[2] = uint8 (value >> 16);
+    dest[3] = uint8 (value >> 24);
+}
+
+inline uint32 readUint32 (const uint8* src)
+{
+    return uint32 (src[0]) | (uint32 (src[1]) << 8) | (uint32 (src[2]) << 16) | (uint32 (src[3]) << 24);
+}
+
+/** Appends bits to a buffer, least significant bit first */
+class BitWriter
+{
+public:
+    explicit BitWriter (uint8* destination) : start (destination), out (destination) {}
+
+    /** Writes the numBits (<= 32) low bits of value, which must be zero above numBits */
+    inline void write (uint32 value, int numBits)
+    {
+        accumulator |= uint64 (value) << bitCount;
+        bitCount += numBits;
+
+        if (bitCount >= 32)
+        {
+            writeUint32 (out, uint32 (accumulator));
+            out += 4;
+            accumulator >>= 32;
+            bitCount -= 32;
+        }
+    }
+
+    /** Writes a residual with Rice parameter k */
+    inline void writeRice (uint32 value, int k)
+    {
+        const uint32 quotient = value >> k;
+
+        if (quotient < uint32 (escapeQuotient))
+        {
+            // quotient ones followed by a zero
+            write ((1u << quotient) - 1, int (quotient) + 1);
+            write (value & ((1u << k) - 1), k);
+        }
+        else
+        {
+            write ((1u << escapeQuotient) - 1, escapeQuotient);
+            write (value, rawResidualBits);
+        }
+    }
+
+    /** Writes any pending bits, padded to a whole byte, and returns the total number of bytes */
+    size_t finish()
+    {
+        while (bitCount > 0)
+        {
+            *out++ = uint8 (accumulator);
+            accumulator >>= 8;
+            bitCount -= 8;
+        }
+
+        bitCount = 0;
+        accumulator = 0;
+
+        return size_t (out - start);
+    }
+
+private:
+    uint8* start;
+    uint8* out;
+    uint64 accumulator = 0;
+    int bitCount = 0;
+};
+
+/** Reads bits written by BitWriter; reading past the end returns zeros and flags the stream as corrupt */
+class BitReader
+{
+public:
+    BitReader (const uint8* source, size_t numBytes) : in (source), end (source + numBytes), bitsAvailable (uint64 (numBytes) * 8) {}
+
+    inline uint32 read (int numBits)
+    {
+        if (bitCount < numBits)
+            refill();
+
+        const uint32 value = uint32 (accumulator & ((uint64 (1) << numBits) - 1));
+        consume (numBits);
+        return value;
+    }
+
+    inline uint32 readRice (int k)
+    {
+        if (bitCount <= escapeQuotient)
+            refill();
+
+        const int ones = countTrailingZeros (~accumulator);
+
+        if (ones >= escapeQuotient)
+        {
+            consume (escapeQuotient);
+            return read (rawResidualBits);
+        }
+
+        consume (ones + 1);
+        return (uint32 (ones) << k) | read (k);
+    }
+
+    bool isOverrun() const { return bitsConsumed > bitsAvailable; }
+
+private:
+    inline void refill()
+    {
+        while (bitCount <= 56)
+        {
+            const uint64 byte = (in < end) ? *in++ : 0;
+            accumulator |= byte << bitCount;
+            bitCount += 8;
+        }
+    }
+
+    inline void consume (int numBits)
+    {
+        accumulator >>= numBits;
+        bitCount -= numBits;
+        bitsConsumed += uint64 (numBits);
+    }
+
+    const uint8* in;
+    const uint8* end;
+    uint64 accumulator = 0;
+    int bitCount = 0;
+    uint64 bitsAvailable;
+    uint64 bitsConsumed = 0;
+};
+
+inline int32 predict (const int32 previous1, const int32 previous2, int order)
+{
+    switch (order)
+    {
+        case 1:
+            return previous1;
+        case 2:
+            return 2 * previous1 - previous2;
+        default:
+            return 0;
+    }
+}
+
+} // namespace
+
+size_t ContinuousCodec::getMaxEncodedSize (int numChannels, int numSamples)
+{
+    // per channel: predictor order and Rice parameter, followed by at most 16 bits per sample
+    const size_t bitsPerChannel = 7 + size_t (numSamples) * 16;
+
+    return size_t (chunkHeaderSize) + (size_t (numChannels) * bitsPerChannel + 7) / 8 + 8;
+}
+
+size_t ContinuousCodec::encodeChunk (const int16* interleaved, int numChannels, int numSamples, uint8* dest)
+{
+    BitWriter writer (dest + chunkHeaderSize);
+
+    for (int chan = 0; chan < numChannels; chan++)
+    {
+        const int16* x = interleaved + chan;
+
+        // pick the predictor with the smallest residuals
+        int order = 0;
+        uint64 residualSum = 0;
+
+        if (numSamples > 2)
+        {
+            uint64 sums[3] = { 0, 0, 0 };
+
+            int32 previous1 = x[numChannels];
+            int32 previous2 = x[0];
+
+            for (int i = 2; i < numSamples; i++)
+            {
+                const int32 value = x[i * numChannels];
+
+                sums[0] += uint64 (std::abs (value));
+                sums[1] += uint64 (std::abs (value - previous1));
+                sums[2] += uint64 (std::abs (value - 2 * previous1 + previous2));
+
+                previous2 = previous1;
+                previous1 = value;
+            }
+
+            for (int candidate = 1; candidate < 3; candidate++)
+            {
+                if (sums[candidate] < sums[order])
+                    order = candidate;
+            }
+
+            residualSum = sums[order];
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; i++)
+                residualSum += uint64 (std::abs (int32 (x[i * numChannels])));
+        }
+
+        order = jmin (order, numSamples);
+
+        // Rice parameter close to log2 of the mean zigzag-mapped residual
+        const uint64 numResiduals = uint64 (jmax (1, numSamples - order));
+        const uint64 zigzagSum = residualSum * 2;
+
+        int k = 0;
+
+        while (k < maxRiceParameter && (numResiduals << (k + 1)) < zigzagSum)
+            k++;
+
+        // exact size of the Rice-coded channel, to fall back to raw samples if they are smaller
+        uint64 codedBits = uint64 (16 * order);
+
+        int32 previous1 = order > 0 ? x[(order - 1) * numChannels] : 0;
+        int32 previous2 = order > 1 ? x[(order - 2) * numChannels] : 0;
+
+        for (int i = order; i < numSamples; i++)
+        {
+            const int32 value = x[i * numChannels];
+            const uint32 quotient = zigzag (value - predict (previous1, previous2, order)) >> k;
+
+            codedBits += (quotient < uint32 (escapeQuotient)) ? quotient + 1 + uint32 (k)
+                                                              : uint32 (escapeQuotient + rawResidualBits);
+
+            previous2 = previous1;
+            previous1 = value;
+        }
+
+        if (codedBits >= uint64 (16 * numSamples))
+        {
+            writer.write (uint32 (verbatimOrder), 2);
+            writer.write (0, 5);
+
+            for (int i = 0; i < numSamples; i++)
+                writer.write (uint32 (uint16 (x[i * numChannels])), 16);
+
+            continue;
+        }
+
+        writer.write (uint32 (order), 2);
+        writer.write (uint32 (k), 5);
+
+        for (int i = 0; i < order; i++)
+            writer.write (uint32 (uint16 (x[i * numChannels])), 16);
+
+        previous1 = order > 0 ? x[(order - 1) * numChannels] : 0;
+        previous2 = order > 1 ? x[(order - 2) * numChannels] : 0;
+
+        for (int i = order; i < numSamples; i++)
+        {
+            const int32 value = x[i * numChannels];
+
+            writer.writeRice (zigzag (value - predict (previous1, previous2, order)), k);
+
+            previous2 = previous1;
+            previous1 = value;
+        }
+    }
+
+    const size_t payloadSize = writer.finish();
+
+    writeUint32 (dest, chunkMagic);
+    writeUint32 (dest + 4, uint32 (numSamples));
+    writeUint32 (dest + 8, uint32 (numChannels));
+    writeUint32 (dest + 12, uint32 (payloadSize));
+
+    return size_t (chunkHeaderSize) + payloadSize;
+}
+
+bool ContinuousCodec::readChunkHeader (const uint8* data, size_t availableBytes, ChunkHeader& header)
+{
+    if (availableBytes < size_t (chunkHeaderSize))
+        return false;
+
+    header.magic = readUint32 (data);
+    header.numSamples = readUint32 (data + 4);
+    header.numChannels = readUint32 (data + 8);
+    header.payloadSize = readUint32 (data + 12);
+
+    return header.magic == chunkMagic
+           && header.numChannels > 0
+           && header.payloadSize <= availableBytes - size_t (chunkHeaderSize);
+}
+
+int ContinuousCodec::decodeChunk (const uint8* data, size_t availableBytes, int16* interleaved, int numChannels, int maxSamples)
+{
+    ChunkHeader header;
+
+    if (! readChunkHeader (data, availableBytes, header)
+        || header.numChannels != uint32 (numChannels)
+        || header.numSamples > uint32 (maxSamples))
+        return -1;
+
+    const int numSamples = int (header.numSamples);
+
+    BitReader reader (data + chunkHeaderSize, header.payloadSize);
+
+    for (int chan = 0; chan < numChannels; chan++)
+    {
+        int16* x = interleaved + chan;
+
+        const int order = int (reader.read (2));
+        const int k = int (reader.read (5));
+
+        if (order == verbatimOrder)
+        {
+            for (int i = 0; i < numSamples; i++)
+                x[i * numChannels] = int16 (uint16 (reader.read (16)));
+
+            if (reader.isOverrun())
+                return -1;
+
+            continue;
+        }
+
+        if (order > numSamples || k > maxRiceParameter)
+            return -1;
+
+        for (int i = 0; i < order; i++)
+            x[i * numChannels] = int16 (uint16 (reader.read (16)));
+
+        int32 previous1 = order > 0 ? x[(order - 1) * numChannels] : 0;
+        int32 previous2 = order > 1 ? x[(order - 2) * numChannels] : 0;
+
+        for (int i = order; i < numSamples; i++)
+        {
+            const int32 value = predict (previous1, previous2, order) + unzigzag (reader.readRice (k));
+
+            if (value < -32768 || value > 32767)
+                return -1;
+
+            x[i * numChannels] = int16 (value);
+
+            previous2 = previous1;
+            previous1 = value;
+        }
+
+        if (reader.isOverrun())
+            return -1;
+    }
+
+    return numSamples;
+}
@@ -0,0 +1,81 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef CONTINUOUSCODEC_H_INCLUDED
+#define CONTINUOUSCODEC_H_INCLUDED
+
+#include <JuceHeader.h>
+
+#include "../../PluginManager/PluginClass.h"
+
+/**
+
+    Lossless codec for chunks of interleaved int16 continuous data.
+
+    Each channel of a chunk is predicted with a fixed polynomial
+    predictor (order 0, 1 or 2, chosen per channel and chunk), and
+    the prediction residuals are stored with an adaptive Rice code.
+    Neural data is dominated by slow, smooth signals, so most residuals
+    are much smaller than the raw samples. Channels that would not get
+    any smaller are stored as raw samples, so a chunk never takes more
+    than a few bytes above its uncompressed size.
+
+    A chunk starts with a ChunkHeader, so a file made of consecutive
+    chunks can be decoded from any chunk boundary.
+
+*/
+class PLUGIN_API ContinuousCodec
+{
+public:
+    /** Header stored in front of every encoded chunk */
+    struct ChunkHeader
+    {
+        uint32 magic;
+        uint32 numSamples;
+        uint32 numChannels;
+        uint32 payloadSize;
+    };
+
+    /** Value of ChunkHeader::magic ("OECZ") */
+    static constexpr uint32 chunkMagic = 0x5A43454F;
+
+    /** Returns the largest possible size of an encoded chunk, including its header */
+    static size_t getMaxEncodedSize (int numChannels, int numSamples);
+
+    /** Encodes numSamples frames of numChannels interleaved samples into dest,
+        which must hold at least getMaxEncodedSize() bytes.
+        Returns the number of bytes written (header included). */
+    static size_t encodeChunk (const int16* interleaved, int numChannels, int numSamples, uint8* dest);
+
+    /** Reads and validates the header of the chunk starting at data.
+        Returns false if there is no valid chunk header. */
+    static bool readChunkHeader (const uint8* data, size_t availableBytes, ChunkHeader& header);
+
+    /** Decodes the chunk starting at data into interleaved frames.
+        Returns the number of frames decoded, or -1 if the chunk is corrupt,
+        has a different channel count, or holds more than maxSamples frames. */
+    static int decodeChunk (const uint8* data, size_t availableBytes, int16* interleaved, int numChannels, int maxSamples);
+};
+
+#endif // CONTINUOUSCODEC_H_INCLUDED
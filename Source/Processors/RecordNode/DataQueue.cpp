@@ -23,12 +23,10 @@
 
 #include "DataQueue.h"
 
-DataQueue::DataQueue (int blockSize, int nBlocks) : m_buffer (0, blockSize * nBlocks),
-                                                    m_numChans (0),
+DataQueue::DataQueue (int blockSize, int nBlocks) : m_numChans (0),
                                                     m_blockSize (blockSize),
                                                     m_readInProgress (false),
-                                                    m_numBlocks (nBlocks),
-                                                    m_maxSize (blockSize * nBlocks)
+                                                    m_numBlocks (nBlocks)
 {
 }
 
@@ -41,47 +39,50 @@ int DataQueue::getBlockSize()
     return m_blockSize;
 }
 
-void DataQueue::setTimestampStreamCount (int nStreams)
+float DataQueue::getUsage() const
 {
-    if (m_readInProgress)
-        return;
+    float usage = 0.0f;
 
-    m_FTSFifos.clear();
-    m_readFTSSamples.clear();
-    m_numFTSChans = nStreams;
+    for (auto fifo : m_fifos)
+        usage = jmax (usage, 1.0f - (float) fifo->getFreeSpace() / (float) fifo->getTotalSize());
 
-    for (int i = 0; i < nStreams; ++i)
-    {
-        m_FTSFifos.add (new AbstractFifo (m_maxSize));
-        m_readFTSSamples.push_back (0);
-    }
-    m_FTSBuffer.setSize (nStreams, m_maxSize);
+    return usage;
 }
 
-void DataQueue::setChannelCount (int nChans)
+void DataQueue::setStreamChannelCounts (const Array<int>& channelCounts, const Array<int>& blockSizes)
 {
     if (m_readInProgress)
         return;
 
     m_fifos.clear();
-    m_readSamples.clear();
-    m_numChans = nChans;
+    m_buffers.clear();
+    m_FTSBuffers.clear();
     m_sampleNumbers.clear();
+    m_readSamples.clear();
     m_lastReadSampleNumbers.clear();
+    m_firstChannels.clear();
+    m_blockSizes.clear();
+
+    m_channelCounts = channelCounts;
+    m_numChans = 0;
 
-    for (int i = 0; i < nChans; ++i)
+    for (int stream = 0; stream < channelCounts.size(); stream++)
     {
-        m_fifos.add (new AbstractFifo (m_maxSize));
-        m_readSamples.push_back (0);
-        m_sampleNumbers.add (new std::vector<int64>());
+        const int count = channelCounts[stream];
+        const int blockSize = blockSizes[stream] > 0 ? blockSizes[stream] : m_blockSize;
+        const int size = blockSize * m_numBlocks;
+
+        m_firstChannels.add (m_numChans);
+        m_numChans += count;
+        m_blockSizes.add (blockSize);
 
-        for (int j = 0; j < m_numBlocks; j++)
-        {
-            m_sampleNumbers.getLast()->push_back (0);
-        }
+        m_fifos.add (new AbstractFifo (size));
+        m_buffers.add (new AudioSampleBuffer (count, size));
+        m_FTSBuffers.add (new SynchronizedTimestampBuffer (1, size));
+        m_sampleNumbers.add (new std::vector<int64> (size));
+        m_readSamples.push_back (0);
         m_lastReadSampleNumbers.push_back (0);
     }
-    m_buffer.setSize (nChans, m_maxSize);
 }
 
 void DataQueue::resize (int nBlocks)
@@ -89,129 +90,84 @@ void DataQueue::resize (int nBlocks)
     if (m_readInProgress)
         return;
 
-    int size = m_blockSize * nBlocks;
-    m_maxSize = size;
     m_numBlocks = nBlocks;
 
-    for (int i = 0; i < m_numChans; ++i)
+    for (int i = 0; i < m_fifos.size(); ++i)
     {
+        const int size = m_blockSizes[i] * nBlocks;
+
         m_fifos[i]->setTotalSize (size);
         m_fifos[i]->reset();
+        m_buffers[i]->setSize (m_channelCounts[i], size);
+        m_FTSBuffers[i]->setSize (1, size);
+        m_sampleNumbers[i]->resize (size);
         m_readSamples[i] = 0;
-        m_sampleNumbers[i]->resize (nBlocks);
         m_lastReadSampleNumbers[i] = 0;
     }
-
-    m_readFTSSamples.clear();
-
-    for (int i = 0; i < m_numFTSChans; ++i)
-    {
-        m_readFTSSamples.push_back (0);
-        m_FTSFifos[i]->setTotalSize (size);
-        m_FTSFifos[i]->reset();
-    }
-    m_buffer.setSize (m_numChans, size);
-    m_FTSBuffer.setSize (m_numFTSChans, size);
 }
 
-void DataQueue::fillSampleNumbers (int channel, int index, int size, int64 sampleNumber)
+int DataQueue::getNumStreams() const
 {
-    //Search for the next block start.
-    int blockMod = index % m_blockSize;
-    int blockIdx = index / m_blockSize;
-    int64 startSampleNumber;
-    int blockStartPos;
-
-    if (blockMod == 0) //block starts here
-    {
-        startSampleNumber = sampleNumber;
-        blockStartPos = index;
-    }
-    else //we're in the middle of a block, correct to jump to the start of the next-
-    {
-        startSampleNumber = sampleNumber + (m_blockSize - blockMod);
-        blockStartPos = index + (m_blockSize - blockMod);
-        blockIdx++;
-    }
+    return m_fifos.size();
+}
 
-    //check that the block is in range
-    int64 latestSampleNumber;
+int DataQueue::getFirstChannelForStream (int streamIndex) const
+{
+    return m_firstChannels[streamIndex];
+}
 
-    for (int i = 0; i < size; i += m_blockSize)
-    {
-        if ((blockStartPos + i) < (index + size))
-        {
-            latestSampleNumber = startSampleNumber + (i * m_blockSize);
-            m_sampleNumbers[channel]->at (blockIdx) = latestSampleNumber;
-        }
-    }
+int DataQueue::getNumChannelsForStream (int streamIndex) const
+{
+    return m_channelCounts[streamIndex];
 }
 
-float DataQueue::writeSynchronizedTimestamps (double start, double step, int destChannel, int nSamples)
+float DataQueue::writeStream (const AudioBuffer<float>& buffer,
+                              int streamIndex,
+                              const int* sourceChannels,
+                              int nSamples,
+                              int64 sampleNumber,
+                              double firstTimestamp,
+                              double timestampStep)
 {
-    int index1, size1, index2, size2;
+    AbstractFifo* fifo = m_fifos[streamIndex];
 
-    m_FTSFifos[destChannel]->prepareToWrite (nSamples, index1, size1, index2, size2);
+    int index1, size1, index2, size2;
+    fifo->prepareToWrite (nSamples, index1, size1, index2, size2);
 
     if ((size1 + size2) < nSamples)
     {
         LOGE (__FUNCTION__, " Recording Data Queue Overflow: sz1: ", size1, " sz2: ", size2, " nSamples: ", nSamples);
     }
 
-    for (int i = 0; i < size1; i++)
-    {
-        m_FTSBuffer.setSample (destChannel, index1 + i, start + (double) i * step);
-    }
+    AudioSampleBuffer& streamBuffer = *m_buffers.getUnchecked (streamIndex);
+    const int numChannels = m_channelCounts[streamIndex];
 
-    if (size2 > 0)
+    for (int chan = 0; chan < numChannels; ++chan)
     {
-        for (int i = 0; i < size2; i++)
-        {
-            m_FTSBuffer.setSample (destChannel, index2 + i, start + (double) (size1 * step) + double (i * step));
-        }
-    }
+        streamBuffer.copyFrom (chan, index1, buffer, sourceChannels[chan], 0, size1);
 
-    m_FTSFifos[destChannel]->finishedWrite (size1 + size2);
-
-    return 1.0f - (float) m_FTSFifos[destChannel]->getFreeSpace() / (float) m_FTSFifos[destChannel]->getTotalSize();
-}
+        if (size2 > 0)
+            streamBuffer.copyFrom (chan, index2, buffer, sourceChannels[chan], size1, size2);
+    }
 
-float DataQueue::writeChannel (const AudioBuffer<float>& buffer,
-                               int srcChannel,
-                               int destChannel,
-                               int nSamples,
-                               int64 sampleNumber)
-{
-    int index1, size1, index2, size2;
-    m_fifos[destChannel]->prepareToWrite (nSamples, index1, size1, index2, size2);
+    int64* sampleNumbers = m_sampleNumbers[streamIndex]->data();
+    double* timestamps = m_FTSBuffers.getUnchecked (streamIndex)->getWritePointer (0);
 
-    if ((size1 + size2) < nSamples)
+    for (int i = 0; i < size1; i++)
     {
-        LOGE (__FUNCTION__, " Recording Data Queue Overflow: sz1: ", size1, " sz2: ", size2, " nSamples: ", nSamples);
+        sampleNumbers[index1 + i] = sampleNumber + i;
+        timestamps[index1 + i] = firstTimestamp + (double) i * timestampStep;
     }
-    m_buffer.copyFrom (destChannel,
-                       index1,
-                       buffer,
-                       srcChannel,
-                       0,
-                       size1);
-
-    fillSampleNumbers (destChannel, index1, size1, sampleNumber);
 
-    if (size2 > 0)
+    for (int i = 0; i < size2; i++)
     {
-        m_buffer.copyFrom (destChannel,
-                           index2,
-                           buffer,
-                           srcChannel,
-                           size1,
-                           size2);
-
-        fillSampleNumbers (destChannel, index2, size2, sampleNumber + size1);
+        sampleNumbers[index2 + i] = sampleNumber + size1 + i;
+        timestamps[index2 + i] = firstTimestamp + (double) (size1 + i) * timestampStep;
     }
-    m_fifos[destChannel]->finishedWrite (size1 + size2);
 
-    return 1.0f - (float) m_fifos[destChannel]->getFreeSpace() / (float) m_fifos[destChannel]->getTotalSize();
+    fifo->finishedWrite (size1 + size2);
+
+    return 1.0f - (float) fifo->getFreeSpace() / (float) fifo->getTotalSize();
 }
 
 /*
@@ -221,18 +177,17 @@ allowing the record subsystem to access the internal buffer is way faster, altho
 done with special care and manually finish the read process.
 */
 
-const AudioBuffer<float>& DataQueue::getContinuousDataBufferReference() const
+const AudioBuffer<float>& DataQueue::getStreamBufferReference (int streamIndex) const
 {
-    return m_buffer;
+    return *m_buffers.getUnchecked (streamIndex);
 }
 
-const SynchronizedTimestampBuffer& DataQueue::getTimestampBufferReference() const
+const SynchronizedTimestampBuffer& DataQueue::getTimestampBufferReference (int streamIndex) const
 {
-    return m_FTSBuffer;
+    return *m_FTSBuffers.getUnchecked (streamIndex);
 }
 
-bool DataQueue::startRead (std::vector<CircularBufferIndexes>& dataBufferIdxs,
-                           std::vector<CircularBufferIndexes>& timestampBufferIdxs,
+bool DataQueue::startRead (std::vector<CircularBufferIndexes>& streamBufferIdxs,
                            Array<int64>& sampleNumbers,
                            int nMax)
 {
@@ -242,46 +197,11 @@ bool DataQueue::startRead (std::vector<CircularBufferIndexes>& dataBufferIdxs,
 
     m_readInProgress = true;
 
-    for (int chan = 0; chan < m_numChans; ++chan)
+    for (int stream = 0; stream < m_fifos.size(); ++stream)
     {
-        int readyToRead = m_fifos.getUnchecked (chan)->getNumReady();
-
-        int samplesToRead = ((readyToRead > nMax) && (nMax > 0)) ? nMax : readyToRead;
-
-        CircularBufferIndexes& idx = dataBufferIdxs[chan];
-
-        m_fifos.getUnchecked (chan)->prepareToRead (samplesToRead, idx.index1, idx.size1, idx.index2, idx.size2);
-        m_readSamples[chan] = idx.size1 + idx.size2;
-
-        int blockMod = idx.index1 % m_blockSize;
-        int blockDiff = (blockMod == 0) ? 0 : (m_blockSize - blockMod);
-
-        //If the next sample number block is within the data we're reading, include the translated sample number in the output
         int64 sampleNum;
-
-        if (blockDiff < (idx.size1 + idx.size2))
-        {
-            int blockIdx = ((idx.index1 + blockDiff) / m_blockSize) % m_numBlocks;
-            sampleNum = m_sampleNumbers[chan]->at (blockIdx) - blockDiff;
-        }
-        //If not, copy the last sent again
-        else
-        {
-            sampleNum = m_lastReadSampleNumbers[chan];
-        }
-
-        sampleNumbers.set (chan, sampleNum); // expensive operation?
-        m_lastReadSampleNumbers[chan] = sampleNum + idx.size1 + idx.size2;
-    }
-
-    for (int chan = 0; chan < m_numFTSChans; ++chan)
-    {
-        CircularBufferIndexes& idx = timestampBufferIdxs[chan];
-        int readyToRead = m_FTSFifos.getUnchecked (chan)->getNumReady();
-        int samplesToRead = ((readyToRead > nMax) && (nMax > 0)) ? nMax : readyToRead;
-
-        m_FTSFifos.getUnchecked (chan)->prepareToRead (samplesToRead, idx.index1, idx.size1, idx.index2, idx.size2);
-        m_readFTSSamples[chan] = idx.size1 + idx.size2;
+        startReadStream (stream, streamBufferIdxs[stream], sampleNum, nMax);
+        sampleNumbers.set (stream, sampleNum);
     }
 
     return true;
@@ -292,26 +212,36 @@ void DataQueue::stopRead()
     if (! m_readInProgress)
         return;
 
-    for (int i = 0; i < m_numChans; ++i)
-    {
-        m_fifos[i]->finishedRead (m_readSamples[i]);
-        m_readSamples[i] = 0;
-    }
-
-    for (int i = 0; i < m_numFTSChans; ++i)
-    {
-        m_FTSFifos[i]->finishedRead (m_readFTSSamples[i]);
-        m_readFTSSamples[i] = 0;
-    }
+    for (int i = 0; i < m_fifos.size(); ++i)
+        stopReadStream (i);
 
     m_readInProgress = false;
 }
 
-void DataQueue::getSampleNumbersForBlock (int idx, Array<int64>& sampleNumbers) const
+bool DataQueue::startReadStream (int streamIndex,
+                                 CircularBufferIndexes& idx,
+                                 int64& sampleNumber,
+                                 int nMax)
 {
-    sampleNumbers.clear();
-    for (int chan = 0; chan < m_numChans; ++chan)
-    {
-        sampleNumbers.add ((*m_sampleNumbers[chan])[idx]);
-    }
+    AbstractFifo* fifo = m_fifos.getUnchecked (streamIndex);
+
+    int readyToRead = fifo->getNumReady();
+    int samplesToRead = ((readyToRead > nMax) && (nMax > 0)) ? nMax : readyToRead;
+
+    fifo->prepareToRead (samplesToRead, idx.index1, idx.size1, idx.index2, idx.size2);
+    m_readSamples[streamIndex] = idx.size1 + idx.size2;
+
+    //If nothing is available, repeat the sample number following the last read
+    sampleNumber = (m_readSamples[streamIndex] > 0) ? m_sampleNumbers[streamIndex]->at (idx.index1)
+                                                    : m_lastReadSampleNumbers[streamIndex];
+
+    m_lastReadSampleNumbers[streamIndex] = sampleNumber + m_readSamples[streamIndex];
+
+    return m_readSamples[streamIndex] > 0;
+}
+
+void DataQueue::stopReadStream (int streamIndex)
+{
+    m_fifos[streamIndex]->finishedRead (m_readSamples[streamIndex]);
+    m_readSamples[streamIndex] = 0;
 }
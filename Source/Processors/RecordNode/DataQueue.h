@@ -24,6 +24,7 @@
 #ifndef DATAQUEUE_H_INCLUDED
 #define DATAQUEUE_H_INCLUDED
 
+#include "../../TestableExport.h"
 #include "../../Utils/Utils.h"
 #include <JuceHeader.h>
 
@@ -41,78 +42,109 @@ struct CircularBufferIndexes
  *
  * Buffers data from the Record Node prior to disk writing
  *
+ * Data is queued per stream: all recorded channels of a stream share
+ * a single FIFO, so each block is written and read once per stream
+ * rather than once per channel. Each stream has its own buffer, sized
+ * by the stream's block size, so a low-rate stream takes up only as much
+ * memory as the data it delivers.
+ *
  * */
-class DataQueue
+class TESTABLE DataQueue
 {
 public:
-    /** Constructor */
+    /** Constructor. blockSize is the default number of samples per block of each stream */
     DataQueue (int blockSize, int nBlocks);
 
     /** Destructor */
     ~DataQueue();
 
     /// -----------  NOT THREAD SAFE  -------------- //
-    /** Sets the number of continuous channel buffers needed */
-    void setChannelCount (int nChans);
-
-    /** Sets the number of timestamp buffers needed */
-    void setTimestampStreamCount (int nStreams);
+    /** Sets the number of recorded channels for each stream (may be 0), and the
+        largest number of samples each stream writes in one block (0 for the default
+        block size). Each stream's FIFO holds nBlocks of its blocks. */
+    void setStreamChannelCounts (const Array<int>& channelCounts, const Array<int>& blockSizes = {});
 
     /** Changes the number of blocks in the queue */
     void resize (int nBlocks);
 
-    /** Returns an array of sample numbers for a given block*/
-    void getSampleNumbersForBlock (int idx, Array<int64>& sampleNumbers) const;
+    /** Returns the number of streams in the queue */
+    int getNumStreams() const;
 
-    /// -----------  THREAD SAFE  -------------- //
+    /** Returns the index of a stream's first channel among the recorded channels of all streams */
+    int getFirstChannelForStream (int streamIndex) const;
 
-    /** Writes an array of data for one channel */
-    float writeChannel (const AudioBuffer<float>& buffer, int srcChannel, int destChannel, int nSamples, int64 sampleNumber);
+    /** Returns the number of recorded channels that belong to a stream */
+    int getNumChannelsForStream (int streamIndex) const;
 
-    /** Writes an array of timestamps for one stream */
-    float writeSynchronizedTimestamps (double start, double step, int destChannel, int nSamples);
+    /// -----------  THREAD SAFE  -------------- //
 
-    /** Start reading data for one channel */
-    bool startRead (std::vector<CircularBufferIndexes>& dataBufferIdxs,
-                    std::vector<CircularBufferIndexes>& timestampBufferIdxs,
+    /** Writes one block of data, timestamps and sample numbers for all recorded channels of a stream
+
+        @param buffer The source buffer
+        @param streamIndex Index of the destination stream
+        @param sourceChannels Buffer channel index for each recorded channel of the stream
+        @param nSamples Number of samples to write
+        @param sampleNumber Sample number of the first sample
+        @param firstTimestamp Synchronized timestamp of the first sample
+        @param timestampStep Timestamp increment between samples
+
+        @return The fraction of the stream's FIFO in use
+    */
+    float writeStream (const AudioBuffer<float>& buffer,
+                       int streamIndex,
+                       const int* sourceChannels,
+                       int nSamples,
+                       int64 sampleNumber,
+                       double firstTimestamp,
+                       double timestampStep);
+
+    /** Start reading data for all streams */
+    bool startRead (std::vector<CircularBufferIndexes>& streamBufferIdxs,
                     Array<int64>& sampleNumbers,
                     int nMax);
 
     /** Called when data read is finished */
     void stopRead();
 
-    /** Returns a reference to the continuous data buffer */
-    const AudioBuffer<float>& getContinuousDataBufferReference() const;
+    /** Start reading data for a single stream. Different streams can be read from different threads. */
+    bool startReadStream (int streamIndex,
+                          CircularBufferIndexes& bufferIdxs,
+                          int64& sampleNumber,
+                          int nMax);
+
+    /** Called when a single stream's read is finished */
+    void stopReadStream (int streamIndex);
+
+    /** Returns a reference to a stream's continuous data buffer (one channel per recorded channel) */
+    const AudioBuffer<float>& getStreamBufferReference (int streamIndex) const;
 
-    /** Returns a reference to the timestamp buffer */
-    const SynchronizedTimestampBuffer& getTimestampBufferReference() const;
+    /** Returns a reference to a stream's timestamp buffer (a single channel) */
+    const SynchronizedTimestampBuffer& getTimestampBufferReference (int streamIndex) const;
 
     /** Returns the current block size*/
     int getBlockSize();
 
-private:
-    /** Fills the sample number buffer for a given channel */
-    void fillSampleNumbers (int channel, int index, int size, int64 sampleNumber);
-
-    int lastIdx;
+    /** Returns the fraction of the fullest stream FIFO in use (0 - 1) */
+    float getUsage() const;
 
+private:
     OwnedArray<AbstractFifo> m_fifos;
-    OwnedArray<AbstractFifo> m_FTSFifos;
 
-    AudioSampleBuffer m_buffer;
-    SynchronizedTimestampBuffer m_FTSBuffer;
+    OwnedArray<AudioSampleBuffer> m_buffers;
+    OwnedArray<SynchronizedTimestampBuffer> m_FTSBuffers;
+    OwnedArray<std::vector<int64>> m_sampleNumbers;
+
+    Array<int> m_channelCounts;
+    Array<int> m_firstChannels;
+    Array<int> m_blockSizes;
 
     std::vector<int> m_readSamples;
-    std::vector<int> m_readFTSSamples;
-    OwnedArray<std::vector<int64>> m_sampleNumbers;
     std::vector<int64> m_lastReadSampleNumbers;
 
     int m_numChans;
-    int m_numFTSChans;
     int m_blockSize;
     bool m_readInProgress;
     int m_numBlocks;
-    int m_maxSize;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DataQueue);
 };
@@ -0,0 +1,146 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "EventQueue.h"
+
+EventQueue::EventQueue (size_t capacityInBytes) : m_capacity (0)
+{
+    resize (capacityInBytes);
+}
+
+EventQueue::~EventQueue()
+{
+}
+
+void EventQueue::reset()
+{
+    m_writePos = 0;
+    m_readPos = 0;
+    m_numWritten = 0;
+    m_numRead = 0;
+    m_numDropped = 0;
+    m_bytesDropped = 0;
+
+    m_pendingPos = 0;
+    m_pendingSize = 0;
+    m_writePending = false;
+}
+
+void EventQueue::resize (size_t capacityInBytes)
+{
+    // keep the capacity a multiple of the record alignment, so a wrapped
+    // record always leaves room for at least one padding header
+    m_capacity = jmax (recordAlignment, capacityInBytes & ~(recordAlignment - 1));
+    m_data.malloc (m_capacity);
+
+    reset();
+}
+
+uint8* EventQueue::prepareToWrite (size_t numBytes)
+{
+    jassert (! m_writePending);
+
+    const size_t recordSize = getRecordSize (numBytes);
+
+    const uint64 writePos = m_writePos.load (std::memory_order_relaxed);
+    const uint64 readPos = m_readPos.load (std::memory_order_acquire);
+
+    const size_t freeSpace = m_capacity - size_t (writePos - readPos);
+    const size_t offset = size_t (writePos % m_capacity);
+    const size_t spaceToEnd = m_capacity - offset;
+
+    // records are never split, so skip to the start of the buffer if this one doesn't fit before the end
+    const size_t padding = (recordSize > spaceToEnd) ? spaceToEnd : 0;
+
+    if (numBytes >= paddingMarker || recordSize + padding > freeSpace)
+    {
+        m_numDropped.fetch_add (1, std::memory_order_relaxed);
+        m_bytesDropped.fetch_add (numBytes, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if (padding > 0)
+        reinterpret_cast<RecordHeader*> (m_data.getData() + offset)->size = paddingMarker;
+
+    m_pendingPos = writePos + padding;
+    m_pendingSize = numBytes;
+    m_writePending = true;
+
+    return m_data.getData() + size_t (m_pendingPos % m_capacity) + sizeof (RecordHeader);
+}
+
+void EventQueue::finishedWrite (int64 sampleNumber, int extra)
+{
+    if (! m_writePending)
+        return;
+
+    RecordHeader* header = reinterpret_cast<RecordHeader*> (m_data.getData() + size_t (m_pendingPos % m_capacity));
+    header->size = uint32 (m_pendingSize);
+    header->extra = int32 (extra);
+    header->sampleNumber = sampleNumber;
+
+    m_writePending = false;
+
+    m_numWritten.fetch_add (1, std::memory_order_relaxed);
+    m_writePos.store (m_pendingPos + getRecordSize (m_pendingSize), std::memory_order_release);
+}
+
+bool EventQueue::addEvent (const EventPacket& packet, int64 sampleNumber, int extra)
+{
+    return addEvent (packet.getRawData(), size_t (packet.getRawDataSize()), sampleNumber, extra);
+}
+
+bool EventQueue::addEvent (const uint8* data, size_t numBytes, int64 sampleNumber, int extra)
+{
+    uint8* dest = prepareToWrite (numBytes);
+
+    if (dest == nullptr)
+        return false;
+
+    memcpy (dest, data, numBytes);
+    finishedWrite (sampleNumber, extra);
+
+    return true;
+}
+
+int EventQueue::getRemainingEvents() const
+{
+    return int (m_numWritten.load (std::memory_order_relaxed) - m_numRead.load (std::memory_order_relaxed));
+}
+
+uint64 EventQueue::getNumDroppedEvents() const
+{
+    return m_numDropped.load (std::memory_order_relaxed);
+}
+
+uint64 EventQueue::getNumDroppedBytes() const
+{
+    return m_bytesDropped.load (std::memory_order_relaxed);
+}
+
+float EventQueue::getUsage() const
+{
+    const uint64 used = m_writePos.load (std::memory_order_relaxed) - m_readPos.load (std::memory_order_relaxed);
+
+    return float (used) / float (m_capacity);
+}
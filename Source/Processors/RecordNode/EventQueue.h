@@ -26,115 +26,147 @@
 
 #include <JuceHeader.h>
 
-#include <vector>
-
-#include "../Events/Spike.h"
-
-template <class MsgContainer>
-class AsyncEventMessage : public ReferenceCountedObject
+#include <atomic>
+
+#include "../../TestableExport.h"
+#include "../Events/Event.h"
+
+/**
+ *
+ * Single-producer / single-consumer queue that buffers serialized
+ * events and spikes between the Record Node and the RecordThread.
+ *
+ * All memory is allocated up front. Each entry is stored inline as a
+ * variable-length record (a 16-byte header followed by the serialized
+ * packet, padded to 16 bytes), so adding an event never touches the heap.
+ *
+ * Events that do not fit are dropped and counted; the counters can
+ * be queried from any thread.
+ *
+ * */
+class TESTABLE EventQueue
 {
 public:
-    AsyncEventMessage (const MsgContainer& m, int64 t, int extra) : ReferenceCountedObject(),
-                                                                    m_data (m),
-                                                                    m_timestamp (t),
-                                                                    m_extra (extra)
-    {
-    }
+    /** Constructor */
+    EventQueue (size_t capacityInBytes);
 
-    ~AsyncEventMessage() {};
+    /** Destructor */
+    ~EventQueue();
 
-    const MsgContainer& getData() const { return m_data; }
-    const int64& getTimestamp() const { return m_timestamp; }
-    const int& getExtra() const { return m_extra; }
+    /// -----------  NOT THREAD SAFE  -------------- //
 
-private:
-    const MsgContainer m_data;
-    const int64 m_timestamp;
-    const int m_extra;
-};
+    /** Discards all buffered events and clears the overflow counters */
+    void reset();
 
-template <class EventClass>
-class EventQueue
-{
-public:
-    typedef AsyncEventMessage<EventClass> EventContainer;
-    typedef ReferenceCountedObjectPtr<EventContainer> EventClassPtr;
+    /** Changes the capacity of the queue (discards all buffered events) */
+    void resize (size_t capacityInBytes);
 
-    EventQueue (int size) : m_fifo (size)
-    {
-        m_data.resize (size);
-    }
+    /// -----------  PRODUCER (audio thread)  -------------- //
 
-    ~EventQueue()
-    {
-    }
+    /** Reserves space for a packet of numBytes and returns a pointer to write it into.
+        Returns nullptr (and counts an overflow) if there is not enough space. */
+    uint8* prepareToWrite (size_t numBytes);
 
-    int getRemainingEvents() const
-    {
-        return m_fifo.getNumReady();
-    }
+    /** Publishes the packet reserved by the last call to prepareToWrite() */
+    void finishedWrite (int64 sampleNumber, int extra = 0);
 
-    void reset()
-    {
-        m_data.clear();
-        m_data.resize (m_fifo.getTotalSize());
-    }
+    /** Copies an already serialized packet into the queue. Returns false if it was dropped. */
+    bool addEvent (const EventPacket& packet, int64 sampleNumber, int extra = 0);
 
-    void resize (int size)
-    {
-        m_data.clear();
-        m_fifo.setTotalSize (size);
-        m_data.resize (size);
-    }
+    /** Copies a raw serialized packet into the queue. Returns false if it was dropped. */
+    bool addEvent (const uint8* data, size_t numBytes, int64 sampleNumber, int extra = 0);
 
-    void addEvent (const EventClass& ev, int64 t, int extra = 0)
-    {
-        int pos1, size1, pos2, size2;
-        size1 = 0;
-        m_fifo.prepareToWrite (1, pos1, size1, pos2, size2);
+    /// -----------  CONSUMER (record thread)  -------------- //
 
-        /* This means there is a buffer overrun. Instead of overwriting the existing data and risking a collision of both threads
-			we just skip the incoming samples. TODO: use this to notify of the overrun and act consequently   */
-        if (size1 > 0)
-        {
-            m_data[pos1] = new EventContainer (ev, t, extra);
-            m_fifo.finishedWrite (1);
-        }
-    }
+    /** Calls callback (const uint8* data, size_t numBytes, int64 sampleNumber, int extra)
+        for up to maxEvents buffered packets (all of them if maxEvents <= 0), then releases
+        their space in a single step. The data pointer is only valid inside the callback.
 
-    int getEvents (std::vector<EventClassPtr>& vec, int max)
+        Returns the number of packets read. */
+    template <typename Callback>
+    int readEvents (int maxEvents, Callback&& callback)
     {
-        int pos1, size1, pos2, size2;
-        int numAvailable = m_fifo.getNumReady();
-        int numToRead = ((max < numAvailable) && (max > 0)) ? max : numAvailable;
-        m_fifo.prepareToRead (numToRead, pos1, size1, pos2, size2);
-        vec.resize (numToRead);
-        for (int i = 0; i < size1; ++i)
-        {
-            vec[i] = m_data[pos1 + i];
-        }
-        if (size2 > 0)
+        const uint64 writePos = m_writePos.load (std::memory_order_acquire);
+        uint64 readPos = m_readPos.load (std::memory_order_relaxed);
+
+        int numRead = 0;
+
+        while (readPos < writePos && (maxEvents <= 0 || numRead < maxEvents))
         {
-            for (int i = 0; i < size2; ++i)
+            const size_t offset = size_t (readPos % m_capacity);
+            const RecordHeader* header = reinterpret_cast<const RecordHeader*> (m_data.getData() + offset);
+
+            if (header->size == paddingMarker)
             {
-                vec[size1 + i] = m_data[pos2 + i];
+                readPos += m_capacity - offset;
+                continue;
             }
+
+            callback (m_data.getData() + offset + sizeof (RecordHeader),
+                      size_t (header->size),
+                      header->sampleNumber,
+                      int (header->extra));
+
+            readPos += getRecordSize (header->size);
+            numRead++;
         }
-        m_fifo.finishedRead (numToRead);
-        return numToRead;
+
+        m_readPos.store (readPos, std::memory_order_release);
+        m_numRead.fetch_add (uint64 (numRead), std::memory_order_relaxed);
+
+        return numRead;
     }
 
+    /// -----------  THREAD SAFE  -------------- //
+
+    /** Returns the number of events waiting to be read */
+    int getRemainingEvents() const;
+
+    /** Returns the number of events dropped because the queue was full */
+    uint64 getNumDroppedEvents() const;
+
+    /** Returns the number of bytes dropped because the queue was full */
+    uint64 getNumDroppedBytes() const;
+
+    /** Returns the fraction of the queue currently in use (0 - 1) */
+    float getUsage() const;
+
+    /** Returns the total capacity of the queue in bytes */
+    size_t getCapacity() const { return m_capacity; }
+
 private:
-    std::vector<EventClassPtr> m_data;
-    AbstractFifo m_fifo;
+    struct RecordHeader
+    {
+        uint32 size;
+        int32 extra;
+        int64 sampleNumber;
+    };
+
+    static constexpr uint32 paddingMarker = 0xFFFFFFFF;
+    static constexpr size_t recordAlignment = sizeof (RecordHeader);
+
+    static size_t getRecordSize (size_t numBytes)
+    {
+        return sizeof (RecordHeader) + ((numBytes + recordAlignment - 1) & ~(recordAlignment - 1));
+    }
+
+    HeapBlock<uint8> m_data;
+    size_t m_capacity;
+
+    std::atomic<uint64> m_writePos { 0 };
+    std::atomic<uint64> m_readPos { 0 };
+
+    std::atomic<uint64> m_numWritten { 0 };
+    std::atomic<uint64> m_numRead { 0 };
+    std::atomic<uint64> m_numDropped { 0 };
+    std::atomic<uint64> m_bytesDropped { 0 };
+
+    // producer-only state for the packet being written
+    uint64 m_pendingPos = 0;
+    size_t m_pendingSize = 0;
+    bool m_writePending = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EventQueue);
 };
-//NOTE: Events are sent as midimessages while spikes as spike objects due to the difference on how they are passed to the record node.
-//Once the probe system is implemented, this will be normalized
-typedef EventQueue<EventPacket> EventMsgQueue;
-typedef EventQueue<Spike> SpikeMsgQueue;
-typedef ReferenceCountedObjectPtr<AsyncEventMessage<EventPacket>> EventMessagePtr;
-typedef ReferenceCountedObjectPtr<AsyncEventMessage<Spike>> SpikeMessagePtr;
 
 #endif // EVENTQUEUE_H_INCLUDED
@@ -25,6 +25,7 @@
 #include "RecordNode.h"
 
 #include "BinaryFormat/BinaryRecording.h"
+#include "CompressedFormat/CompressedRecording.h"
 
 RecordEngine::RecordEngine()
     : manager (nullptr), recordNode (nullptr)
@@ -83,6 +84,29 @@ void RecordEngine::updateLatestSampleNumbers (const Array<int64>& num, int chann
         sampleNumbers.set (channel, num[channel]);
 }
 
+void RecordEngine::updateLatestSampleNumbers (int64 sampleNumber, int firstChannel, int numChannels)
+{
+    for (int i = 0; i < numChannels; i++)
+        sampleNumbers.set (firstChannel + i, sampleNumber);
+}
+
+void RecordEngine::writeContinuousStream (int streamIndex,
+                                          int firstWriteChannel,
+                                          int numChannels,
+                                          const float* const* dataBuffers,
+                                          const double* timestampBuffer,
+                                          int size)
+{
+    for (int i = 0; i < numChannels; i++)
+    {
+        writeContinuousData (firstWriteChannel + i,
+                             getGlobalIndex (firstWriteChannel + i),
+                             dataBuffers[i],
+                             timestampBuffer,
+                             size);
+    }
+}
+
 void RecordEngine::setChannelMap (const Array<int>& globalChans,
                                   const Array<int>& localChans)
 {
@@ -94,6 +118,9 @@ void RecordEngine::setChannelMap (const Array<int>& globalChans,
 
     for (auto chan : localChans)
         localChannelMap.add (chan);
+
+    sampleNumbers.clearQuick();
+    sampleNumbers.insertMultiple (0, 0, globalChans.size());
 }
 
 int64 RecordEngine::getLatestSampleNumber (int channel) const
@@ -220,7 +247,7 @@ void RecordEngineManager::addParameter (EngineParameter* param)
 
 int RecordEngineManager::getNumOfBuiltInEngines()
 {
-    return 1;
+    return 2;
 }
 
 RecordEngineManager* RecordEngineManager::createBuiltInEngineManager (int index)
@@ -230,6 +257,9 @@ RecordEngineManager* RecordEngineManager::createBuiltInEngineManager (int index)
         case 0:
             return BinaryRecording::getEngineManager();
 
+        case 1:
+            return CompressedRecording::getEngineManager();
+
         default:
             return nullptr;
     }
@@ -247,6 +277,11 @@ RecordEngine* RecordEngineManager::instantiateEngine()
         return new BinaryRecording();
     }
 
+    if (id == "COMPRESSED")
+    {
+        return new CompressedRecording();
+    }
+
     return nullptr;
 }
 
@@ -115,6 +115,28 @@ public:
     /** Called by configureEngine() */
     virtual void setParameter (EngineParameter& parameter) {}
 
+    /** Write a block of continuous data for all recorded channels of a stream,
+        with one array of synchronized float timestamps shared by every channel.
+
+        The channels of a stream have consecutive write indices starting at firstWriteChannel.
+        The default implementation calls writeContinuousData() once per channel.
+    */
+    virtual void writeContinuousStream (int streamIndex,
+                                        int firstWriteChannel,
+                                        int numChannels,
+                                        const float* const* dataBuffers,
+                                        const double* timestampBuffer,
+                                        int size);
+
+    /** Returns true if writeContinuousStream() can be called for different streams
+        from different threads at the same time. Events, spikes and sync texts are
+        always written from a single thread. */
+    virtual bool canWriteStreamsInParallel() const { return false; }
+
+    /** Reports the amount of continuous data received (as int16 samples) and actually stored
+        on disk since the files were opened. Returns false if the engine doesn't compress data. */
+    virtual bool getCompressionStatistics (uint64& bytesReceived, uint64& bytesStored) const { return false; }
+
     // ------------------------------------------------------------
     //                    OTHER METHODS
     // ------------------------------------------------------------
@@ -134,6 +156,9 @@ public:
     /** Called at the start of every write block */
     void updateLatestSampleNumbers (const Array<int64>& sampleNumbers, int channel = -1);
 
+    /** Called at the start of every stream write block, for a consecutive range of channels */
+    void updateLatestSampleNumbers (int64 sampleNumber, int firstChannel, int numChannels);
+
 protected:
     // ------------------------------------------------------------
     //    HELPFUL METHODS FOR GETTING INFO ABOUT INCOMING DATA
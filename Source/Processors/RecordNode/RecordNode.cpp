@@ -45,7 +45,9 @@ EventMonitor::EventMonitor()
     : receivedEvents (0),
       receivedSpikes (0),
       bufferedEvents (0),
-      bufferedSpikes (0)
+      bufferedSpikes (0),
+      droppedEvents (0),
+      droppedSpikes (0)
 {
 }
 
@@ -57,6 +59,8 @@ void EventMonitor::reset()
     receivedSpikes = 0;
     bufferedEvents = 0;
     bufferedSpikes = 0;
+    droppedEvents = 0;
+    droppedSpikes = 0;
 }
 
 void EventMonitor::displayStatus()
@@ -64,6 +68,9 @@ void EventMonitor::displayStatus()
     LOGD ("Record Node received ", receivedEvents, " total EVENTS and sent ", bufferedEvents, " to the RecordThread");
 
     LOGD ("Record Node received ", receivedSpikes, " total SPIKES and sent ", bufferedSpikes, " to the RecordThread");
+
+    if (droppedEvents > 0 || droppedSpikes > 0)
+        LOGE ("Record Node dropped ", droppedEvents, " EVENTS and ", droppedSpikes, " SPIKES because the recording buffer was full");
 }
 
 RecordNode::RecordNode()
@@ -84,8 +91,8 @@ RecordNode::RecordNode()
     int bufferSize = ads.bufferSize;
 
     dataQueue = std::make_unique<DataQueue> (bufferSize, DATA_BUFFER_NBLOCKS);
-    eventQueue = std::make_unique<EventMsgQueue> (EVENT_BUFFER_NEVENTS);
-    spikeQueue = std::make_unique<SpikeMsgQueue> (SPIKE_BUFFER_NSPIKES);
+    eventQueue = std::make_unique<EventQueue> (EVENT_BUFFER_BYTES_PER_STREAM);
+    spikeQueue = std::make_unique<EventQueue> (SPIKE_BUFFER_BYTES_PER_STREAM);
 
     isSyncReady = true;
 
@@ -118,6 +125,7 @@ void RecordNode::registerParameters()
 
     addBooleanParameter (Parameter::PROCESSOR_SCOPE, "events", "Record Events", "Toggle saving events coming into this node", true, true);
     addBooleanParameter (Parameter::PROCESSOR_SCOPE, "spikes", "Record Spikes", "Toggle saving spikes coming into this node", true, true);
+    addIntParameter (Parameter::PROCESSOR_SCOPE, "writer_threads", "Writer Threads", "Number of threads writing continuous data (streams are split between them)", 1, 1, 8, true);
 
     addMaskChannelsParameter (Parameter::STREAM_SCOPE, "channels", "Channels", "Channels to record from", true);
     addTtlLineParameter (Parameter::STREAM_SCOPE, "sync_line", "Sync Line", "Event line to use for sync signal", 8, true, false, true);
@@ -157,6 +165,10 @@ void RecordNode::parameterValueChanged (Parameter* p)
     {
         setRecordSpikes (((BooleanParameter*) p)->getBoolValue());
     }
+    else if (p->getName() == "writer_threads")
+    {
+        LOGD ("Parameter changed: writer_threads");
+    }
     else if (p->getName() == "channels")
     {
         LOGD ("Parameter changed: channels");
@@ -457,18 +469,26 @@ void RecordNode::handleBroadcastMessage (const String& msg, const int64 messageS
 
         size_t size = event->getChannelInfo()->getDataSize() + event->getChannelInfo()->getTotalEventMetadataSize() + EVENT_BASE_SIZE;
 
-        HeapBlock<char> buffer (size);
+        uint8* buffer = eventQueue->prepareToWrite (size);
 
-        event->serialize (buffer, size);
+        if (buffer == nullptr)
+        {
+            eventMonitor->droppedEvents++;
+            return;
+        }
 
-        eventQueue->addEvent (EventPacket (buffer, int (size)), messageSampleNumber, -1);
+        event->serialize (buffer, size);
+        eventQueue->finishedWrite (messageSampleNumber, -1);
     }
 }
 
 void RecordNode::updateBlockSize (int newBlockSize)
 {
     if (dataQueue->getBlockSize() != newBlockSize)
+    {
+        const ScopedLock sl (queueLock);
         dataQueue = std::make_unique<DataQueue> (newBlockSize, DATA_BUFFER_NBLOCKS);
+    }
 }
 
 String RecordNode::getEngineId()
@@ -648,6 +668,7 @@ AudioProcessorEditor* RecordNode::createEditor()
 void RecordNode::updateSettings()
 {
     activeStreamIds.clear();
+    syncStreamHandles.clear();
     synchronizer.prepareForUpdate();
 
     for (auto stream : dataStreams)
@@ -658,7 +679,7 @@ void RecordNode::updateSettings()
 
         LOGD ("Record Node found stream: (", streamId, ") ", stream->getName(), " with sample rate ", stream->getSampleRate());
         int syncLine = syncLineParam->getSelectedLine();
-        synchronizer.addDataStream (stream->getKey(), stream->getSampleRate(), syncLine, stream->generatesTimestamps());
+        syncStreamHandles[streamId] = synchronizer.addDataStream (stream->getKey(), stream->getSampleRate(), syncLine, stream->generatesTimestamps());
 
         fifoUsage[streamId] = 0.0f;
 
@@ -780,8 +801,11 @@ bool RecordNode::stopAcquisition()
     synchronizer.reset();
     eventMonitor->reset();
 
-    eventQueue->reset();
-    spikeQueue->reset();
+    {
+        const ScopedLock sl (queueLock);
+        eventQueue->reset();
+        spikeQueue->reset();
+    }
 
     if (! headlessMode)
         stopTimer();
@@ -812,7 +836,10 @@ void RecordNode::startRecording()
     channelMap.clear();
     localChannelMap.clear();
 
-    timestampChannelMap.clear();
+    recordedChannelsPerStream.clear();
+
+    // the samples each stream can write per block, so slower streams get smaller queues
+    Array<int> streamBlockSizes;
 
     int streamIndex = 0;
 
@@ -827,24 +854,27 @@ void RecordNode::startRecording()
             lastSourceNodeId = stream->getSourceNodeId();
         }
 
+        int recordedChannelCount = 0;
+
         for (auto channelRecordState : ((MaskChannelsParameter*) stream->getParameter ("channels"))->getChannelStates())
         {
             if (channelRecordState)
             {
                 channelMap.add (channelIndexInRecordNode);
                 localChannelMap.add (channelIndexInStream++);
-                timestampChannelMap.add (streamIndex);
+                recordedChannelCount++;
             }
 
             channelIndexInRecordNode++;
         }
 
+        recordedChannelsPerStream.add (recordedChannelCount);
+        streamBlockSizes.add (getStreamBlockSize (StreamIndex (streamIndex)));
+
         procInfo.add (pi);
         streamIndex++;
     }
 
-    int numRecordedChannels = channelMap.size();
-
     validBlocks.clear();
     validBlocks.insertMultiple (0, false, getNumInputs());
 
@@ -852,14 +882,30 @@ void RecordNode::startRecording()
     recordEngine->setChannelMap (channelMap, localChannelMap);
 
     recordThread->setChannelMap (channelMap);
-    recordThread->setTimestampChannelMap (timestampChannelMap);
 
-    dataQueue->setChannelCount (numRecordedChannels);
-    dataQueue->setTimestampStreamCount (dataStreams.size());
+    {
+        const ScopedLock sl (queueLock);
+
+        dataQueue->setStreamChannelCounts (recordedChannelsPerStream, streamBlockSizes);
+
+        // the event and spike queues grow with the number of recorded streams
+        const size_t numQueueStreams = size_t (jmax (1, dataStreams.size()));
+
+        if (eventQueue->getCapacity() != numQueueStreams * EVENT_BUFFER_BYTES_PER_STREAM)
+            eventQueue->resize (numQueueStreams * EVENT_BUFFER_BYTES_PER_STREAM);
+
+        if (spikeQueue->getCapacity() != numQueueStreams * SPIKE_BUFFER_BYTES_PER_STREAM)
+            spikeQueue->resize (numQueueStreams * SPIKE_BUFFER_BYTES_PER_STREAM);
+    }
+
+    assignStreamsToWriters();
 
     recordThread->setQueuePointers (dataQueue.get(), eventQueue.get(), spikeQueue.get());
     recordThread->setFirstBlockFlag (false);
 
+    recordedClockVersions.clearQuick();
+    recordedClockVersions.insertMultiple (0, -1, dataStreams.size());
+
     /* Set write properties */
     setFirstBlock = false;
 
@@ -909,6 +955,16 @@ void RecordNode::setRecordEvents (bool recordEvents)
     this->recordEvents = recordEvents;
 }
 
+int RecordNode::getSyncStreamHandle (uint16 streamId) const
+{
+    auto it = syncStreamHandles.find (streamId);
+
+    if (it == syncStreamHandles.end())
+        return -1;
+
+    return it->second;
+}
+
 void RecordNode::setRecordSpikes (bool recordSpikes)
 {
     this->recordSpikes = recordSpikes;
@@ -920,30 +976,38 @@ void RecordNode::handleTTLEvent (TTLEventPtr event)
 
     int64 sampleNumber = event->getSampleNumber();
 
-    String streamKey = getDataStream (event->getStreamId())->getKey();
+    uint16 streamId = event->getStreamId();
+    const int syncStream = getSyncStreamHandle (streamId);
 
-    synchronizer.addEvent (streamKey, event->getLine(), sampleNumber, event->getState());
+    synchronizer.addEvent (syncStream, event->getLine(), sampleNumber, event->getState());
 
     if (recordEvents && isRecording)
     {
         size_t size = event->getChannelInfo()->getDataSize() + event->getChannelInfo()->getTotalEventMetadataSize() + EVENT_BASE_SIZE;
-        uint16 streamId = event->getStreamId();
 
         double ts = -1.0;
-        if (synchronizer.streamGeneratesTimestamps (streamKey))
+        if (synchronizer.streamGeneratesTimestamps (syncStream))
         {
             ts = getFirstTimestampForBlock (streamId) + (sampleNumber - getFirstSampleNumberForBlock (streamId)) / getDataStream (streamId)->getSampleRate();
         }
         else
         {
-            ts = synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber);
+            ts = synchronizer.convertSampleNumberToTimestamp (syncStream, sampleNumber);
         }
 
-        HeapBlock<char> buffer (size);
         event->setTimestampInSeconds (ts);
-        event->serialize (buffer, size);
 
-        eventQueue->addEvent (EventPacket (buffer, int (size)), sampleNumber);
+        // serialize straight into the queue's preallocated storage
+        uint8* buffer = eventQueue->prepareToWrite (size);
+
+        if (buffer == nullptr)
+        {
+            eventMonitor->droppedEvents++;
+            return;
+        }
+
+        event->serialize (buffer, size);
+        eventQueue->finishedWrite (sampleNumber);
 
         eventMonitor->bufferedEvents++;
     }
@@ -957,48 +1021,66 @@ void RecordNode::handleEvent (const EventChannel* eventInfo, const EventPacket&
 
         int eventIndex = getIndexOfMatchingChannel (eventInfo);
 
-        String streamKey = getDataStream (eventInfo->getStreamId())->getKey();
+        const int syncStream = getSyncStreamHandle (eventInfo->getStreamId());
 
-        Event::setTimestampInSeconds (packet, synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber));
+        Event::setTimestampInSeconds (packet, synchronizer.convertSampleNumberToTimestamp (syncStream, sampleNumber));
 
-        eventQueue->addEvent (packet, sampleNumber, eventIndex);
+        if (! eventQueue->addEvent (packet, sampleNumber, eventIndex))
+            eventMonitor->droppedEvents++;
     }
 }
 
 // only called if recordSpikes is true
-void RecordNode::handleSpike (SpikePtr spike)
+void RecordNode::handleSpikeView (const Spike::View& spike)
 {
     eventMonitor->receivedSpikes++;
 
     if (recordSpikes && isRecording)
     {
-        String streamKey = getDataStream (spike->getStreamId())->getKey();
-        uint16 streamId = spike->getStreamId();
-        int64 sampleNumber = spike->getSampleNumber();
+        uint16 streamId = spike.getChannelInfo()->getStreamId();
+        const int syncStream = getSyncStreamHandle (streamId);
+        int64 sampleNumber = spike.getSampleNumber();
 
         double ts = -1.0;
-        if (synchronizer.streamGeneratesTimestamps (streamKey))
+        if (synchronizer.streamGeneratesTimestamps (syncStream))
         {
             ts = getFirstTimestampForBlock (streamId) + (sampleNumber - getFirstSampleNumberForBlock (streamId)) / getDataStream (streamId)->getSampleRate();
         }
         else
         {
-            ts = synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber);
+            ts = synchronizer.convertSampleNumberToTimestamp (syncStream, sampleNumber);
         }
 
-        spike->setTimestampInSeconds (ts);
-        writeSpike (spike, spike->getChannelInfo());
+        writeSpike (spike, ts);
         eventMonitor->bufferedSpikes++;
     }
 }
 
+void RecordNode::writeClockModel (const DataStream* stream, int64 sampleNumber, const SyncClock& clock)
+{
+    // clock models are written even if events aren't recorded, as the
+    // timestamps of the continuous data can't be reconstructed without them
+    uint8* buffer = eventQueue->prepareToWrite (sizeof (ClockModelRecord));
+
+    if (buffer == nullptr)
+    {
+        eventMonitor->droppedEvents++;
+        return;
+    }
+
+    const ClockModelRecord record { stream->getStreamId(), sampleNumber, clock };
+
+    memcpy (buffer, &record, sizeof (ClockModelRecord));
+
+    eventQueue->finishedWrite (sampleNumber, CLOCK_MODEL_EVENT);
+}
+
 void RecordNode::handleTimestampSyncTexts (const EventPacket& packet)
 {
     int64 sampleNumber = Event::getSampleNumber (packet);
 
-    String syncText = SystemEvent::getSyncText (packet);
-
-    eventQueue->addEvent (packet, sampleNumber, -1);
+    if (! eventQueue->addEvent (packet, sampleNumber, -1))
+        eventMonitor->droppedEvents++;
 }
 
 void RecordNode::process (AudioBuffer<float>& buffer)
@@ -1046,63 +1128,65 @@ void RecordNode::process (AudioBuffer<float>& buffer)
         bool fifoAlmostFull = false;
 
         int streamIndex = -1;
-        int channelIndex = -1;
+        int firstChannelIndex = 0;
 
         for (auto stream : dataStreams)
         {
             streamIndex++;
 
-            int recordChanCount = (*stream)["channels"].getArray()->size();
+            const int recordChanCount = recordedChannelsPerStream[streamIndex];
+            const int* sourceChannels = channelMap.getRawDataPointer() + firstChannelIndex;
+
+            firstChannelIndex += recordChanCount;
 
             if (recordChanCount == 0)
                 continue;
 
             const uint16 streamId = stream->getStreamId();
-            const String streamKey = stream->getKey();
+
+            const int syncStream = getSyncStreamHandle (streamId);
 
             uint32 numSamples = getNumSamplesInBlock (streamId);
 
             int64 sampleNumber = getFirstSampleNumberForBlock (streamId);
 
-            float totalFifoUsage = 0.0f;
-
             double first, second;
 
             if (numSamples > 0)
             {
-                if (! synchronizer.streamGeneratesTimestamps (streamKey))
+                if (! synchronizer.streamGeneratesTimestamps (syncStream))
                 {
-                    first = synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber);
-                    second = synchronizer.convertSampleNumberToTimestamp (streamKey, sampleNumber + 1);
+                    const SyncClock clock = synchronizer.getClock (syncStream);
+
+                    // record each clock model once, from the first block that uses it
+                    if (clock.isSynchronized && int64 (clock.version) != recordedClockVersions[streamIndex])
+                    {
+                        writeClockModel (stream, sampleNumber, clock);
+                        recordedClockVersions.set (streamIndex, int64 (clock.version));
+                    }
+
+                    first = synchronizer.convertSampleNumberToTimestamp (syncStream, sampleNumber);
+                    second = synchronizer.convertSampleNumberToTimestamp (syncStream, sampleNumber + 1);
                 }
                 else
                 {
                     first = getFirstTimestampForBlock (streamId);
                     second = first + 1 / stream->getSampleRate();
                 }
-                dataQueue->writeSynchronizedTimestamps (
-                    first,
-                    second - first,
-                    streamIndex,
-                    numSamples);
-            }
 
-            for (int i = 0; i < recordChanCount; i++)
+                fifoUsage[streamId] = dataQueue->writeStream (buffer,
+                                                              streamIndex,
+                                                              sourceChannels,
+                                                              numSamples,
+                                                              sampleNumber,
+                                                              first,
+                                                              second - first);
+            }
+            else
             {
-                channelIndex++;
-
-                if (numSamples > 0)
-                {
-                    totalFifoUsage += dataQueue->writeChannel (buffer,
-                                                               channelMap[channelIndex],
-                                                               channelIndex,
-                                                               numSamples,
-                                                               sampleNumber);
-                }
+                fifoUsage[streamId] = 0.0f;
             }
 
-            fifoUsage[streamId] = totalFifoUsage / recordChanCount;
-
             if (fifoUsage[streamId] > 0.9)
                 fifoAlmostFull = true;
 
@@ -1116,8 +1200,8 @@ void RecordNode::process (AudioBuffer<float>& buffer)
             if (headlessMode)
             {
                 LOGC ("Record Buffer Warning: The recording buffer has reached capacity. Stopping recording to prevent data corruption.\n\n \
-                        To address the issue, you can try reducing the number of simultaneously recorded channels or \
-                        using multiple Record Nodes to distribute data writing across more than one drive.");
+                        To address the issue, you can try increasing the number of writer threads, reducing the number of \
+                        simultaneously recorded channels, or using multiple Record Nodes to distribute data writing across more than one drive.");
             }
             else
             {
@@ -1125,8 +1209,8 @@ void RecordNode::process (AudioBuffer<float>& buffer)
                                            { AlertWindow::showMessageBoxAsync (AlertWindow::AlertIconType::WarningIcon,
                                                                                "Record Buffer Warning",
                                                                                "The recording buffer has reached capacity. Stopping recording to prevent data corruption. \n\n"
-                                                                               "To address the issue, you can try reducing the number of simultaneously recorded channels or "
-                                                                               "using multiple Record Nodes to distribute data writing across more than one drive.",
+                                                                               "To address the issue, you can try increasing the number of writer threads, reducing the number of "
+                                                                               "simultaneously recorded channels, or using multiple Record Nodes to distribute data writing across more than one drive.",
                                                                                "OK"); });
             }
         }
@@ -1139,18 +1223,170 @@ void RecordNode::process (AudioBuffer<float>& buffer)
     }
 }
 
-// called in RecordNode::handleSpike
-void RecordNode::writeSpike (const Spike* spike, const SpikeChannel* spikeElectrode)
+// called in RecordNode::handleSpikeView
+void RecordNode::writeSpike (const Spike::View& spike, double timestamp)
 {
-    int electrodeIndex = getIndexOfMatchingChannel (spikeElectrode);
+    int electrodeIndex = getIndexOfMatchingChannel (spike.getChannelInfo());
+
+    if (electrodeIndex < 0)
+        return;
+
+    size_t size = spike.getSize();
 
-    if (electrodeIndex >= 0)
-        spikeQueue->addEvent (*spike, spike->getSampleNumber(), electrodeIndex);
+    // copy the packet straight into the queue's preallocated storage
+    uint8* buffer = spikeQueue->prepareToWrite (size);
+
+    if (buffer == nullptr)
+    {
+        eventMonitor->droppedSpikes++;
+        return;
+    }
+
+    memcpy (buffer, spike.getRawData(), size);
+    memcpy (buffer + SPIKE_TIMESTAMP_OFFSET, &timestamp, sizeof (double));
+
+    spikeQueue->finishedWrite (spike.getSampleNumber(), electrodeIndex);
 }
 
 void RecordNode::timerCallback()
 {
     updateSyncMonitors();
+    updateWriterStatistics();
+}
+
+void RecordNode::assignStreamsToWriters()
+{
+    Array<int> recordedStreams;
+
+    for (int i = 0; i < recordedChannelsPerStream.size(); i++)
+    {
+        if (recordedChannelsPerStream[i] > 0)
+            recordedStreams.add (i);
+    }
+
+    int numWriters = ((IntParameter*) getParameter ("writer_threads"))->getIntValue();
+
+    if (! recordEngine->canWriteStreamsInParallel())
+        numWriters = 1;
+
+    numWriters = jlimit (1, jmax (1, recordedStreams.size()), numWriters);
+
+    // the heaviest streams are assigned first, each one to the least loaded writer
+    std::sort (recordedStreams.begin(), recordedStreams.end(), [this] (int a, int b)
+               { return recordedChannelsPerStream[a] * dataStreams[a]->getSampleRate()
+                        > recordedChannelsPerStream[b] * dataStreams[b]->getSampleRate(); });
+
+    Array<Array<int>> streamsPerWriter;
+    Array<double> writerLoad;
+
+    streamsPerWriter.resize (numWriters);
+    writerLoad.insertMultiple (0, 0.0, numWriters);
+
+    for (auto stream : recordedStreams)
+    {
+        int writer = 0;
+
+        for (int i = 1; i < numWriters; i++)
+        {
+            if (writerLoad[i] < writerLoad[writer])
+                writer = i;
+        }
+
+        streamsPerWriter.getReference (writer).add (stream);
+        writerLoad.set (writer, writerLoad[writer] + recordedChannelsPerStream[stream] * dataStreams[stream]->getSampleRate());
+    }
+
+    recordThread->setWriterStreams (streamsPerWriter);
+
+    writerIndexForStream.clear();
+
+    for (int i = 0; i < dataStreams.size(); i++)
+        writerIndexForStream[dataStreams[i]->getStreamId()] = recordThread->getWriterForStream (i);
+
+    writerStatistics.clearQuick();
+    writerStatistics.resize (numWriters);
+    lastWriterStatisticsTicks = Time::getHighResolutionTicks();
+
+    LOGD ("Record Node writing ", recordedStreams.size(), " streams with ", numWriters, " writer thread(s)");
+}
+
+void RecordNode::updateWriterStatistics()
+{
+    if (! recordThread->isThreadRunning() || writerStatistics.size() != recordThread->getNumWriters())
+        return;
+
+    const int64 now = Time::getHighResolutionTicks();
+    const double elapsedSeconds = Time::highResolutionTicksToSeconds (now - lastWriterStatisticsTicks);
+    lastWriterStatisticsTicks = now;
+
+    if (elapsedSeconds <= 0.0)
+        return;
+
+    for (int i = 0; i < writerStatistics.size(); i++)
+    {
+        StreamWriter* writer = recordThread->getWriter (i);
+        WriterStatistics& stats = writerStatistics.getReference (i);
+
+        const uint64 bytes = writer->getBytesWritten();
+        const uint64 busy = writer->getBusyMicroseconds();
+
+        // counters restart with every recording
+        if (bytes < stats.lastBytesWritten || busy < stats.lastBusyMicroseconds)
+            stats.lastBytesWritten = stats.lastBusyMicroseconds = 0;
+
+        stats.megabytesPerSecond = float ((bytes - stats.lastBytesWritten) / elapsedSeconds / (1024.0 * 1024.0));
+        stats.busyPercent = float ((busy - stats.lastBusyMicroseconds) / (elapsedSeconds * 1.0e4));
+        stats.maxWriteMilliseconds = float (writer->getAndResetMaxWriteMicroseconds()) / 1000.0f;
+
+        stats.lastBytesWritten = bytes;
+        stats.lastBusyMicroseconds = busy;
+    }
+
+    uint64 bytesReceived, bytesStored;
+
+    if (recordEngine->getCompressionStatistics (bytesReceived, bytesStored) && bytesStored > 0)
+    {
+        if (bytesReceived < lastBytesCompressed || bytesStored < lastBytesStored)
+            lastBytesCompressed = lastBytesStored = 0;
+
+        const double megabytes = 1024.0 * 1024.0 * elapsedSeconds;
+
+        compressionStatus = "Compression: " + String (double (bytesReceived) / double (bytesStored), 2) + "x ("
+                            + String ((bytesReceived - lastBytesCompressed) / megabytes, 1) + " MB/s in, "
+                            + String ((bytesStored - lastBytesStored) / megabytes, 1) + " MB/s out)";
+
+        lastBytesCompressed = bytesReceived;
+        lastBytesStored = bytesStored;
+    }
+    else
+    {
+        compressionStatus = String();
+    }
+}
+
+String RecordNode::getWriterStatusForStream (uint16 streamId) const
+{
+    auto it = writerIndexForStream.find (streamId);
+
+    if (it == writerIndexForStream.end() || it->second < 0 || it->second >= writerStatistics.size())
+        return String();
+
+    const WriterStatistics& stats = writerStatistics.getReference (it->second);
+
+    return "Writer thread " + String (it->second + 1) + " of " + String (writerStatistics.size()) + ": "
+           + String (stats.megabytesPerSecond, 1) + " MB/s, "
+           + String (stats.busyPercent, 0) + "% busy, "
+           + "max write " + String (stats.maxWriteMilliseconds, 1) + " ms";
+}
+
+float RecordNode::getQueueUsage() const
+{
+    const ScopedLock sl (queueLock);
+
+    if (dataQueue == nullptr || ! isRecording)
+        return 0.0f;
+
+    return jmax (dataQueue->getUsage(), eventQueue->getUsage(), spikeQueue->getUsage());
 }
 
 void RecordNode::updateSyncMonitors()
@@ -1164,7 +1400,7 @@ void RecordNode::updateSyncMonitors()
 
         editor->setStreamStartTime (streamId, synchronizer.isStreamSynced (streamKey), synchronizer.getStartTime (streamKey));
         editor->setLastSyncEvent (streamId, synchronizer.isStreamSynced (streamKey), synchronizer.getLastSyncEvent (streamKey));
-        editor->setSyncAccuracy (streamId, synchronizer.isStreamSynced (streamKey), synchronizer.getAccuracy (streamKey));
+        editor->setSyncAccuracy (streamId, synchronizer.isStreamSynced (streamKey), synchronizer.getAccuracyStatistics (streamKey));
     }
 }
 
@@ -43,14 +43,28 @@
 
 #define WRITE_BLOCK_LENGTH 1024
 #define DATA_BUFFER_NBLOCKS 300
-#define EVENT_BUFFER_NEVENTS 200000
-#define SPIKE_BUFFER_NSPIKES 200000
+#define EVENT_BUFFER_BYTES_PER_STREAM (1024 * 1024)
+#define SPIKE_BUFFER_BYTES_PER_STREAM (4 * 1024 * 1024)
 
 #define NIDAQ_BIT_VOLTS 0.001221f
 #define NPX_BIT_VOLTS 0.195f
 #define MAX_BUFFER_SIZE 40960
 #define CHANNELS_PER_THREAD 384
 
+/** The extra value of clock models in the event queue (other events use -1 or their channel index) */
+#define CLOCK_MODEL_EVENT -2
+
+/**
+	A clock model waiting to be written by the RecordThread; queued as
+	it is, so that the message text is built outside of the audio thread
+*/
+struct ClockModelRecord
+{
+    uint16 streamId;
+    int64 sampleNumber;
+    SyncClock clock;
+};
+
 /**
 	Class used internally by the RecordNode to count the number of incoming events
 	Primarily useful for debugging purposes
@@ -81,6 +95,12 @@ public:
 
     /* Counts the total of number of events sent to the recording buffer */
     int bufferedSpikes;
+
+    /* Counts the total number of events dropped because the recording buffer was full */
+    int droppedEvents;
+
+    /* Counts the total number of spikes dropped because the recording buffer was full */
+    int droppedSpikes;
 };
 
 /**
@@ -191,8 +211,13 @@ public:
     /** Returns true if this Record Node is writing data*/
     bool getRecordingStatus() const;
 
-    /** Called by handleEvent() */
-    void writeSpike (const Spike* spike, const SpikeChannel* spikeElectrode);
+    /** Copies a serialized spike into the spike queue, with its timestamp in seconds;
+        called by handleSpikeView() */
+    void writeSpike (const Spike::View& spike, double timestamp);
+
+    /** Queues the clock model used for a stream's timestamps, which the RecordThread
+        writes as a message so that they can be reconstructed offline; called by process() */
+    void writeClockModel (const DataStream* stream, int64 sampleNumber, const SyncClock& clock);
 
     /** Called by the ControlPanel to determine the amount of space
       left in the current dataDirectory.
@@ -228,13 +253,22 @@ public:
 
     std::map<uint16, float> fifoUsage;
 
+    /** Synchronizer handle of each stream, resolved in updateSettings() */
+    std::map<uint16, int> syncStreamHandles;
+
+    /** Version of the latest clock model written for each stream (-1 if none) */
+    Array<int64> recordedClockVersions;
+
+    /** Returns the synchronizer handle of a stream, or -1 */
+    int getSyncStreamHandle (uint16 streamId) const;
+
     ScopedPointer<EventMonitor> eventMonitor;
 
     std::unique_ptr<DiskSpaceChecker> diskSpaceChecker;
 
     Array<int> channelMap; //Map from record channel index to source channel index
     Array<int> localChannelMap; // Map from record channel index to recorded index within stream
-    Array<int> timestampChannelMap; // Map from recorded channel index to recorded source processor idx
+    Array<int> recordedChannelsPerStream; // Number of recorded channels in each stream
 
     bool isSyncReady;
 
@@ -257,6 +291,16 @@ public:
     /** Actual sync monitor update -- can be called independently of timer*/
     void updateSyncMonitors();
 
+    /** Returns a description of the load on the thread that writes a stream (empty if not recording) */
+    String getWriterStatusForStream (uint16 streamId) const;
+
+    /** Returns the fraction of the fullest recording queue (continuous data, events or spikes)
+        in use (0 - 1); can be called from any thread */
+    float getQueueUsage() const;
+
+    /** Returns the compression ratio and throughput of the Record Engine (empty if it does not compress) */
+    String getCompressionStatus() const { return compressionStatus; }
+
     /** Static flag to ensure override timestamps warning 
      * for hardware-synced streams is shown only once per run */
     static bool overrideTimestampWarningShown;
@@ -269,11 +313,35 @@ private:
     void handleTTLEvent (TTLEventPtr event) override;
 
     /** Writes incoming spikes to disk */
-    void handleSpike (SpikePtr spike) override;
+    void handleSpikeView (const Spike::View& spike) override;
 
     /** Handles incoming timestamp sync messages */
     virtual void handleTimestampSyncTexts (const EventPacket& packet);
 
+    /** Splits the recorded streams between the RecordThread's writers, balancing their data rates */
+    void assignStreamsToWriters();
+
+    /** Updates the throughput and load of each writer (called once per second) */
+    void updateWriterStatistics();
+
+    struct WriterStatistics
+    {
+        float megabytesPerSecond = 0.0f;
+        float busyPercent = 0.0f;
+        float maxWriteMilliseconds = 0.0f;
+
+        uint64 lastBytesWritten = 0;
+        uint64 lastBusyMicroseconds = 0;
+    };
+
+    Array<WriterStatistics> writerStatistics;
+    std::map<uint16, int> writerIndexForStream;
+    int64 lastWriterStatisticsTicks = 0;
+
+    uint64 lastBytesCompressed = 0;
+    uint64 lastBytesStored = 0;
+    String compressionStatus;
+
     /**RecordEngines loaded**/
     OwnedArray<RecordEngine> engineArray;
 
@@ -293,8 +361,11 @@ private:
     int recordingNumber;
 
     std::unique_ptr<DataQueue> dataQueue;
-    std::unique_ptr<EventMsgQueue> eventQueue;
-    std::unique_ptr<SpikeMsgQueue> spikeQueue;
+    std::unique_ptr<EventQueue> eventQueue;
+    std::unique_ptr<EventQueue> spikeQueue;
+
+    /** Held while the queues are replaced, resized or reset, so getQueueUsage() can read them */
+    CriticalSection queueLock;
 
     int spikeElectrodeIndex;
 
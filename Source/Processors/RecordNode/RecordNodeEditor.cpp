@@ -113,6 +113,16 @@ void SyncAccuracyMonitor::paint (Graphics& g)
     }
 }
 
+String SyncAccuracyMonitor::getStatisticsText() const
+{
+    if (! isSynchronized || statistics.numPulses == 0)
+        return String();
+
+    return "Clock model " + String (statistics.modelVersion) + " fitted to "
+           + String (statistics.numPulses) + " sync pulses (RMS error "
+           + String (statistics.rmsErrorMs, 3) + " ms)";
+}
+
 StreamMonitor::StreamMonitor (RecordNode* rn, uint64 id)
     : LevelMonitor (rn),
       streamId (id)
@@ -127,10 +137,18 @@ StreamMonitor::~StreamMonitor() {}
 
 void StreamMonitor::timerCallback()
 {
-    if (((RecordNode*) processor)->recordThread->isThreadRunning())
-        setFillPercentage (((RecordNode*) processor)->fifoUsage[streamId]);
+    RecordNode* recordNode = (RecordNode*) processor;
+
+    if (recordNode->recordThread->isThreadRunning())
+    {
+        setFillPercentage (recordNode->fifoUsage[streamId]);
+        setTooltip (recordNode->getWriterStatusForStream (uint16 (streamId)));
+    }
     else
+    {
         setFillPercentage (0.0);
+        setTooltip (String());
+    }
 }
 
 void StreamMonitor::paintButton (Graphics& g, bool isMouseOver, bool isButtonDown)
@@ -187,6 +205,12 @@ void DiskMonitor::update (float dataRate, int64 bytesFree, float timeLeft)
         String msg = String (bytesFree / pow (2, 30)) + " GB available\n";
         msg += String (int (timeLeft / 60.0f)) + " minutes remaining\n";
         msg += "Data rate: " + String (dataRate * 1000 / pow (2, 20), 2) + " MB/s";
+
+        String compression = ((RecordNode*) processor)->getCompressionStatus();
+
+        if (compression.isNotEmpty())
+            msg += "\n" + compression;
+
         setTooltip (msg);
     }
     else
@@ -567,6 +591,7 @@ RecordNodeEditor::RecordNodeEditor (RecordNode* parentNode)
 
     addCustomParameterEditor (new RecordPathParameterEditor (parentNode->getParameter ("directory")), 42, 32);
     addComboBoxParameterEditor (Parameter::PROCESSOR_SCOPE, "engine", 42, 57);
+    addBoundedValueParameterEditor (Parameter::PROCESSOR_SCOPE, "writer_threads", 124, 57);
 
     for (auto& p : { "directory", "engine" })
     {
@@ -575,6 +600,14 @@ RecordNodeEditor::RecordNodeEditor (RecordNode* parentNode)
         ed->setBounds (ed->getX(), ed->getY(), 110, ed->getHeight());
     }
 
+    // the engine selector shares its row with the writer thread count
+    auto* engineEditor = getParameterEditor ("engine");
+    engineEditor->setBounds (engineEditor->getX(), engineEditor->getY(), 78, engineEditor->getHeight());
+
+    auto* threadsEditor = getParameterEditor ("writer_threads");
+    threadsEditor->setLayout (ParameterEditor::Layout::nameHidden);
+    threadsEditor->setBounds (threadsEditor->getX(), threadsEditor->getY(), 28, engineEditor->getHeight());
+
     addCustomParameterEditor (new RecordToggleParameterEditor (parentNode->getParameter ("events")), 40, 85);
     addCustomParameterEditor (new RecordToggleParameterEditor (parentNode->getParameter ("spikes")), 40, 107);
 
@@ -698,12 +731,15 @@ void RecordNodeEditor::setLastSyncEvent (uint16 streamId, bool isSynchronized, f
     }
 }
 
-void RecordNodeEditor::setSyncAccuracy (uint16 streamId, bool isSynchronized, float syncAccuracy)
+void RecordNodeEditor::setSyncAccuracy (uint16 streamId, bool isSynchronized, const SyncAccuracy& accuracy)
 {
     if (syncAccuracyMonitors.find (streamId) != syncAccuracyMonitors.end())
     {
         if (syncAccuracyMonitors[streamId] != nullptr)
-            syncAccuracyMonitors[streamId]->setSyncMetric (isSynchronized, syncAccuracy);
+        {
+            syncAccuracyMonitors[streamId]->setSyncMetric (isSynchronized, float (accuracy.latestErrorMs));
+            syncAccuracyMonitors[streamId]->setStatistics (accuracy);
+        }
     }
 }
 
@@ -27,6 +27,7 @@
 #include "../../Utils/Utils.h"
 #include "../Editors/GenericEditor.h"
 #include "../Editors/PopupChannelSelector.h"
+#include "../Synchronizer/Synchronizer.h"
 
 #include "DiskMonitor/DiskSpaceListener.h"
 
@@ -79,6 +80,15 @@ public:
 
     /** Paints the metric */
     void paint (Graphics& g);
+
+    /** Sets the statistics of the stream's clock fit */
+    void setStatistics (const SyncAccuracy& accuracy) { statistics = accuracy; }
+
+    /** Describes the clock fit, for the cell's tooltip (empty if the stream isn't synchronized) */
+    String getStatisticsText() const;
+
+private:
+    SyncAccuracy statistics;
 };
 
 /** 
@@ -360,7 +370,7 @@ public:
     void setLastSyncEvent (uint16 streamId, bool isSynchronized, float syncTimeSeconds);
 
     /** Set the synchronization accuracy metric for a particular stream */
-    void setSyncAccuracy (uint16 streamId, bool isSynchronized, float expectedMinusActual);
+    void setSyncAccuracy (uint16 streamId, bool isSynchronized, const SyncAccuracy& accuracy);
 
     std::unique_ptr<FifoDrawerButton> fifoDrawerButton;
 
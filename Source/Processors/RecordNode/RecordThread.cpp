@@ -27,17 +27,132 @@
 //#define EVERY_ENGINE for(int eng = 0; eng < m_engineArray.size(); eng++) m_engineArray[eng]
 #define EVERY_ENGINE m_engine;
 
+StreamWriter::StreamWriter()
+{
+}
+
+void StreamWriter::setStreams (const Array<int>& streamIndices)
+{
+    m_streams = streamIndices;
+}
+
+void StreamWriter::prepare (DataQueue* dataQueue, RecordEngine* engine)
+{
+    m_dataQueue = dataQueue;
+    m_engine = engine;
+
+    int maxChannels = 0;
+
+    for (auto stream : m_streams)
+        maxChannels = jmax (maxChannels, m_dataQueue->getNumChannelsForStream (stream));
+
+    m_channelPointers.resize (maxChannels);
+
+    m_bytesWritten = 0;
+    m_busyMicroseconds = 0;
+    m_maxWriteMicroseconds = 0;
+}
+
+int StreamWriter::write (int maxSamples)
+{
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    int samplesWritten = 0;
+    uint64 bytesWritten = 0;
+
+    for (auto stream : m_streams)
+    {
+        CircularBufferIndexes idx;
+        int64 sampleNumber;
+
+        if (! m_dataQueue->startReadStream (stream, idx, sampleNumber, maxSamples))
+            continue;
+
+        const int firstChannel = m_dataQueue->getFirstChannelForStream (stream);
+        const int numChannels = m_dataQueue->getNumChannelsForStream (stream);
+
+        if (numChannels > 0)
+        {
+            writeBlock (stream, firstChannel, numChannels, idx.index1, idx.size1, sampleNumber);
+
+            if (idx.size2 > 0)
+                writeBlock (stream, firstChannel, numChannels, idx.index2, idx.size2, sampleNumber + idx.size1);
+
+            samplesWritten += idx.size1 + idx.size2;
+            bytesWritten += uint64 (idx.size1 + idx.size2) * uint64 (numChannels) * sizeof (int16);
+        }
+
+        m_dataQueue->stopReadStream (stream);
+    }
+
+    if (samplesWritten > 0)
+    {
+        const uint64 elapsed = uint64 (Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks) * 1.0e6);
+
+        m_bytesWritten += bytesWritten;
+        m_busyMicroseconds += elapsed;
+
+        uint64 previousMax = m_maxWriteMicroseconds.load();
+
+        while (elapsed > previousMax && ! m_maxWriteMicroseconds.compare_exchange_weak (previousMax, elapsed))
+        {
+        }
+    }
+
+    return samplesWritten;
+}
+
+void StreamWriter::writeBlock (int stream, int firstChannel, int numChannels, int bufferIndex, int size, int64 sampleNumber)
+{
+    const AudioBuffer<float>& dataBuffer = m_dataQueue->getStreamBufferReference (stream);
+    const SynchronizedTimestampBuffer& timestampBuffer = m_dataQueue->getTimestampBufferReference (stream);
+
+    m_engine->updateLatestSampleNumbers (sampleNumber, firstChannel, numChannels);
+
+    for (int chan = 0; chan < numChannels; ++chan)
+        m_channelPointers[chan] = dataBuffer.getReadPointer (chan, bufferIndex);
+
+    m_engine->writeContinuousStream (stream,
+                                     firstChannel,
+                                     numChannels,
+                                     m_channelPointers.data(),
+                                     timestampBuffer.getReadPointer (0, bufferIndex),
+                                     size);
+}
+
+WriterThread::WriterThread (StreamWriter* writer, int index) : Thread ("Record Writer " + String (index)),
+                                                               m_writer (writer)
+{
+}
+
+void WriterThread::run()
+{
+    while (! threadShouldExit())
+    {
+        if (m_writer->write (BLOCK_MAX_WRITE_SAMPLES) == 0)
+            wait (1);
+    }
+
+    // flush the buffers
+    m_writer->write (BLOCK_MAX_WRITE_SAMPLES);
+}
+
 RecordThread::RecordThread (RecordNode* parentNode, RecordEngine* engine) : Thread ("Record Thread"),
-                                                                            m_engine (engine),
                                                                             recordNode (parentNode),
+                                                                            m_engine (engine),
+                                                                            m_lastDroppedEvents (0),
+                                                                            m_lastDroppedSpikes (0),
                                                                             m_receivedFirstBlock (false),
                                                                             m_cleanExit (true)
 //samplesWritten(0)
 {
+    m_writers.add (new StreamWriter());
 }
 
 RecordThread::~RecordThread()
 {
+    for (auto thread : m_writerThreads)
+        thread->stopThread (5000);
 }
 
 void RecordThread::setEngine (RecordEngine* engine)
@@ -59,13 +174,6 @@ void RecordThread::setFileComponents (File rootFolder, int experimentNumber, int
     m_recordingNumber = recordingNumber;
 }
 
-void RecordThread::setTimestampChannelMap (const Array<int>& channels)
-{
-    if (isThreadRunning())
-        return;
-    m_timestampBufferChannelArray = channels;
-}
-
 void RecordThread::setChannelMap (const Array<int>& channels)
 {
     if (isThreadRunning())
@@ -74,13 +182,48 @@ void RecordThread::setChannelMap (const Array<int>& channels)
     m_numChannels = channels.size();
 }
 
-void RecordThread::setQueuePointers (DataQueue* data, EventMsgQueue* events, SpikeMsgQueue* spikes)
+void RecordThread::setQueuePointers (DataQueue* data, EventQueue* events, EventQueue* spikes)
 {
     m_dataQueue = data;
     m_eventQueue = events;
     m_spikeQueue = spikes;
 }
 
+void RecordThread::setWriterStreams (const Array<Array<int>>& streamsPerWriter)
+{
+    if (isThreadRunning())
+    {
+        LOGD (__FUNCTION__, " Tried to change writer streams while thread was running!");
+        return;
+    }
+
+    m_writerThreads.clear();
+    m_writers.clear();
+
+    for (const auto& streams : streamsPerWriter)
+    {
+        StreamWriter* writer = m_writers.add (new StreamWriter());
+        writer->setStreams (streams);
+    }
+
+    if (m_writers.isEmpty())
+        m_writers.add (new StreamWriter());
+
+    for (int i = 1; i < m_writers.size(); i++)
+        m_writerThreads.add (new WriterThread (m_writers[i], i));
+}
+
+int RecordThread::getWriterForStream (int streamIndex) const
+{
+    for (int i = 0; i < m_writers.size(); i++)
+    {
+        if (m_writers[i]->getStreams().contains (streamIndex))
+            return i;
+    }
+
+    return -1;
+}
+
 void RecordThread::setFirstBlockFlag (bool state)
 {
     m_receivedFirstBlock = state;
@@ -89,33 +232,20 @@ void RecordThread::setFirstBlockFlag (bool state)
 
 void RecordThread::run()
 {
-    const AudioBuffer<float>& dataBuffer = m_dataQueue->getContinuousDataBufferReference();
-    const SynchronizedTimestampBuffer& ftsBuffer = m_dataQueue->getTimestampBufferReference();
-
     spikesReceived = 0;
     spikesWritten = 0;
 
-    sampleNumbers.clear();
-    dataBufferIdxs.clear();
-    timestampBufferIdxs.clear();
-
-    for (int chan = 0; chan < m_numChannels; ++chan)
-    {
-        sampleNumbers.add (0);
-        dataBufferIdxs.push_back (CircularBufferIndexes());
-    }
+    m_lastDroppedEvents = m_eventQueue->getNumDroppedEvents();
+    m_lastDroppedSpikes = m_spikeQueue->getNumDroppedEvents();
 
-    for (int stream = 0; stream < recordNode->getNumDataStreams(); ++stream)
-    {
-        timestampBufferIdxs.push_back (CircularBufferIndexes());
-    }
+    for (auto writer : m_writers)
+        writer->prepare (m_dataQueue, m_engine);
 
     bool closeEarly = true;
 
     //1-Open Files
     m_cleanExit = false;
     closeEarly = false;
-    Array<int64> sampleNumbers;
 
     m_engine->openFiles (m_rootFolder, m_experimentNumber, m_recordingNumber);
 
@@ -130,22 +260,29 @@ void RecordThread::run()
         wait (1);
     }
 
-    m_dataQueue->getSampleNumbersForBlock (0, sampleNumbers);
-    m_engine->updateLatestSampleNumbers (sampleNumbers);
+    //3-Normal loop, with the other writers running on their own threads
+    for (auto thread : m_writerThreads)
+        thread->startThread (Thread::Priority::high);
 
-    //3-Normal loop
     while (! threadShouldExit())
-        writeData (dataBuffer, ftsBuffer, BLOCK_MAX_WRITE_SAMPLES, BLOCK_MAX_WRITE_EVENTS, BLOCK_MAX_WRITE_SPIKES);
+        writeData (BLOCK_MAX_WRITE_SAMPLES, BLOCK_MAX_WRITE_EVENTS, BLOCK_MAX_WRITE_SPIKES);
 
     //LOGD(__FUNCTION__, " Exiting record thread");
     //4-Before closing the thread, try to write the remaining samples
 
+    // each writer thread flushes its own streams before exiting
+    for (auto thread : m_writerThreads)
+        thread->signalThreadShouldExit();
+
+    for (auto thread : m_writerThreads)
+        thread->stopThread (5000);
+
     LOGD ("Closing all files");
 
     if (! closeEarly)
     {
         // flush the buffers
-        writeData (dataBuffer, ftsBuffer, BLOCK_MAX_WRITE_SAMPLES, BLOCK_MAX_WRITE_EVENTS, BLOCK_MAX_WRITE_SPIKES, true);
+        writeData (BLOCK_MAX_WRITE_SAMPLES, BLOCK_MAX_WRITE_EVENTS, BLOCK_MAX_WRITE_SPIKES, true);
 
         //5-Close files
         m_engine->closeFiles();
@@ -156,121 +293,99 @@ void RecordThread::run()
     //LOGC("RecordThread received ", spikesReceived, " spikes and wrote ", spikesWritten, ".");
 }
 
-void RecordThread::writeData (const AudioBuffer<float>& dataBuffer,
-                              const SynchronizedTimestampBuffer& timestampBuffer,
-                              int maxSamples,
-                              int maxEvents,
-                              int maxSpikes,
-                              bool lastBlock)
+void RecordThread::writeEvent (const EventPacket& event)
 {
-    if (m_dataQueue->startRead (dataBufferIdxs, timestampBufferIdxs, sampleNumbers, maxSamples))
+    if (SystemEvent::getBaseType (event) == EventBase::Type::SYSTEM_EVENT)
     {
-        m_engine->updateLatestSampleNumbers (sampleNumbers);
+        m_engine->writeTimestampSyncText (SystemEvent::getStreamId (event), SystemEvent::getSampleNumber (event), 0.0f, SystemEvent::getSyncText (event));
+    }
+    else
+    {
+        int processorId = EventBase::getProcessorId (event);
+        int streamId = EventBase::getStreamId (event);
+        int channelIdx = EventBase::getChannelIndex (event);
 
-        /* Copy data to record engine */
-        for (int chan = 0; chan < m_numChannels; ++chan)
-        {
-            if (dataBufferIdxs[chan].size1 > 0)
-            {
-                const double* r = timestampBuffer.getReadPointer (m_timestampBufferChannelArray[chan],
-                                                                  dataBufferIdxs[chan].index1);
-
-                //if (chan == 0)
-                //  std::cout << "Writing " << dataBufferIdxs[chan].size1 << " samples for channel 0"
-                //            << std::endl;
-
-                m_engine->writeContinuousData (
-                    chan, // write channel (index among all recorded channels)
-                    m_channelArray[chan], // real channel (index within processor)
-                    dataBuffer.getReadPointer (chan, dataBufferIdxs[chan].index1), // pointer to float
-                    r, // pointer to float
-                    dataBufferIdxs[chan].size1); // integer
-
-                /*if (chan == 0)
-			{
-
-				std::cout << chan << " " << m_channelArray[chan] <<
-					" " << dataBufferIdxs[chan].index1 <<
-					" " << dataBufferIdxs[chan].size1 <<
-					" " << dataBufferIdxs[chan].index2 <<
-					" " << dataBufferIdxs[chan].size2
-					<< " "
-					<< *r << std::endl;
-
-				std::cout << chan << " " << m_timestampBufferChannelArray[chan] <<
-					" " << timestampBufferIdxs[m_timestampBufferChannelArray[chan]].index1 <<
-					" " << timestampBufferIdxs[m_timestampBufferChannelArray[chan]].size1 <<
-					" " << timestampBufferIdxs[m_timestampBufferChannelArray[chan]].index2 <<
-					" " << timestampBufferIdxs[m_timestampBufferChannelArray[chan]].size2
-					<< " "
-					<< *r << std::endl;
-			}*/
-
-                //samplesWritten += dataBufferIdxs[chan].size1;
-
-                if (dataBufferIdxs[chan].size2 > 0)
-                {
-                    sampleNumbers.set (chan, sampleNumbers[chan] + dataBufferIdxs[chan].size1);
-
-                    m_engine->updateLatestSampleNumbers (sampleNumbers, chan);
-
-                    m_engine->writeContinuousData (
-                        chan, // write channel (index among all recorded channels)
-                        m_channelArray[chan], // real channel (index within processor)
-                        dataBuffer.getReadPointer (chan, dataBufferIdxs[chan].index2), // pointer to float
-                        timestampBuffer.getReadPointer (m_timestampBufferChannelArray[chan],
-                                                        dataBufferIdxs[chan].index2), // pointer to float
-                        dataBufferIdxs[chan].size2); // integer
-
-                    //samplesWritten += dataBufferIdxs[chan].size2;
-                }
-            }
-        }
+        const EventChannel* chan = recordNode->getEventChannel (processorId, streamId, channelIdx);
+        int eventIndex = recordNode->getIndexOfMatchingChannel (chan);
 
-        m_dataQueue->stopRead();
+        m_engine->writeEvent (eventIndex, event);
     }
+}
 
-    std::vector<EventMessagePtr> events;
-    int nEvents = m_eventQueue->getEvents (events, maxEvents);
+void RecordThread::writeClockModel (const uint8* data)
+{
+    ClockModelRecord record;
+    memcpy (&record, data, sizeof (ClockModelRecord));
 
-    for (int ev = 0; ev < nEvents; ++ev)
-    {
-        const MidiMessage& event = events[ev]->getData();
+    const DataStream* stream = recordNode->getDataStream (record.streamId);
 
-        if (SystemEvent::getBaseType (event) == EventBase::Type::SYSTEM_EVENT)
-        {
-            String syncText = SystemEvent::getSyncText (event);
-            m_engine->writeTimestampSyncText (SystemEvent::getStreamId (event), SystemEvent::getSampleNumber (event), 0.0f, SystemEvent::getSyncText (event));
-        }
-        else
-        {
-            int processorId = EventBase::getProcessorId (event);
-            int streamId = EventBase::getStreamId (event);
-            int channelIdx = EventBase::getChannelIndex (event);
+    if (stream == nullptr)
+        return;
 
-            const EventChannel* chan = recordNode->getEventChannel (processorId, streamId, channelIdx);
-            int eventIndex = recordNode->getIndexOfMatchingChannel (chan);
+    const SyncClock& clock = record.clock;
 
-            m_engine->writeEvent (eventIndex, event);
-        }
-    }
+    String text = "Clock model " + String (clock.version) + " for " + stream->getKey()
+                  + " from sample " + String (record.sampleNumber)
+                  + ": timestamp = " + String (clock.baselineTimestamp, 9)
+                  + " + (sample_number - " + String (clock.baselineSampleNumber)
+                  + ") / " + String (clock.sampleRate, 6);
 
-    std::vector<SpikeMessagePtr> spikes;
-    int nSpikes = m_spikeQueue->getEvents (spikes, BLOCK_MAX_WRITE_SPIKES);
+    // the message stream has no block info of its own, so the message is
+    // placed at the sample where the clock model takes effect
+    TextEventPtr event = TextEvent::createTextEvent (recordNode->getMessageChannel(), record.sampleNumber, text);
 
-    for (int sp = 0; sp < nSpikes; ++sp)
-    {
+    event->setTimestampInSeconds (clock.baselineTimestamp + double (record.sampleNumber - clock.baselineSampleNumber) / clock.sampleRate);
+
+    size_t size = event->getChannelInfo()->getDataSize() + event->getChannelInfo()->getTotalEventMetadataSize() + EVENT_BASE_SIZE;
+
+    HeapBlock<uint8> buffer (size);
+
+    event->serialize (buffer, size);
+
+    writeEvent (EventPacket (buffer, int (size)));
+}
+
+void RecordThread::writeData (int maxSamples,
+                              int maxEvents,
+                              int maxSpikes,
+                              bool lastBlock)
+{
+    m_writers.getFirst()->write (maxSamples);
+
+    m_eventQueue->readEvents (maxEvents, [this] (const uint8* data, size_t size, int64, int extra)
+                              {
+        if (extra == CLOCK_MODEL_EVENT)
+            writeClockModel (data);
+        else
+            writeEvent (EventPacket (data, int (size))); });
+
+    m_spikeQueue->readEvents (maxSpikes, [this] (const uint8* data, size_t, int64, int spikeIndex)
+                              {
         spikesReceived++;
 
-        if (spikes[sp] != nullptr)
+        const SpikeChannel* chan = recordNode->getSpikeChannel (spikeIndex);
+
+        if (chan == nullptr)
+            return;
+
+        SpikePtr spike = Spike::deserialize (data, chan);
+
+        if (spike != nullptr)
         {
-            const Spike& spike = spikes[sp]->getData();
-            const SpikeChannel* chan = spike.getChannelInfo();
-            int spikeIndex = recordNode->getIndexOfMatchingChannel (chan);
             spikesWritten++;
+            m_engine->writeSpike (spikeIndex, spike);
+        } });
 
-            m_engine->writeSpike (spikeIndex, &spikes[sp]->getData());
-        }
+    uint64 droppedEvents = m_eventQueue->getNumDroppedEvents();
+    uint64 droppedSpikes = m_spikeQueue->getNumDroppedEvents();
+
+    if (droppedEvents != m_lastDroppedEvents || droppedSpikes != m_lastDroppedSpikes)
+    {
+        LOGE ("Record buffer overflow: ", droppedEvents - m_lastDroppedEvents, " events and ",
+              droppedSpikes - m_lastDroppedSpikes, " spikes were dropped");
+
+        m_lastDroppedEvents = droppedEvents;
+        m_lastDroppedSpikes = droppedSpikes;
     }
 }
 
@@ -36,11 +36,90 @@
 
 class RecordNode;
 
+/**
+*
+*	Writes the continuous data of a subset of the recorded streams
+*   from the DataQueue to the RecordEngine.
+*
+*   Each StreamWriter is used by a single thread (the RecordThread,
+*   or one of its WriterThreads); the statistics can be read from any thread.
+*
+*/
+class StreamWriter
+{
+public:
+    /** Constructor */
+    StreamWriter();
+
+    /** Sets the DataQueue streams written by this writer */
+    void setStreams (const Array<int>& streamIndices);
+
+    /** Returns the DataQueue streams written by this writer */
+    const Array<int>& getStreams() const { return m_streams; }
+
+    /** Prepares the writer for a new recording */
+    void prepare (DataQueue* dataQueue, RecordEngine* engine);
+
+    /** Writes up to maxSamples of every stream. Returns the number of samples written. */
+    int write (int maxSamples);
+
+    /** Returns the number of bytes of continuous data written since prepare() */
+    uint64 getBytesWritten() const { return m_bytesWritten.load(); }
+
+    /** Returns the total time spent writing since prepare(), in microseconds */
+    uint64 getBusyMicroseconds() const { return m_busyMicroseconds.load(); }
+
+    /** Returns the duration of the longest write() call since the last call to this method, in microseconds */
+    uint64 getAndResetMaxWriteMicroseconds() { return m_maxWriteMicroseconds.exchange (0); }
+
+private:
+    /** Writes one contiguous block of a stream */
+    void writeBlock (int stream, int firstChannel, int numChannels, int bufferIndex, int size, int64 sampleNumber);
+
+    Array<int> m_streams;
+
+    DataQueue* m_dataQueue { nullptr };
+    RecordEngine* m_engine { nullptr };
+
+    std::vector<const float*> m_channelPointers;
+
+    std::atomic<uint64> m_bytesWritten { 0 };
+    std::atomic<uint64> m_busyMicroseconds { 0 };
+    std::atomic<uint64> m_maxWriteMicroseconds { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamWriter);
+};
+
+/**
+*
+*	Additional thread used by the RecordThread to write
+*   the continuous data of some streams in parallel.
+*
+*/
+class WriterThread : public Thread
+{
+public:
+    /** Constructor */
+    WriterThread (StreamWriter* writer, int index);
+
+    /** Writes data until the thread is asked to exit, then flushes the last block */
+    void run() override;
+
+private:
+    StreamWriter* m_writer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WriterThread);
+};
+
 /**
 *
 *	A thread inside the RecordNode that allows continuous data, spikes,
 *   and events to be written outside of the process() method.
 *
+*   Continuous streams can be split between several StreamWriters, each
+*   running on its own thread; events and spikes are always written by
+*   this thread, so their order is preserved.
+*
 */
 class RecordThread : public Thread
 {
@@ -57,11 +136,21 @@ public:
     /** Sets the indices of recorded channels */
     void setChannelMap (const Array<int>& channels);
 
-    /** Sets the float timestamp channel map */
-    void setTimestampChannelMap (const Array<int>& channels);
-
     /** Sets the pointers to the 3 data queues*/
-    void setQueuePointers (DataQueue* data, EventMsgQueue* events, SpikeMsgQueue* spikes);
+    void setQueuePointers (DataQueue* data, EventQueue* events, EventQueue* spikes);
+
+    /** Sets the DataQueue streams handled by each writer. The first writer runs
+        on this thread; every other one gets its own WriterThread. */
+    void setWriterStreams (const Array<Array<int>>& streamsPerWriter);
+
+    /** Returns the number of writers (including the one on this thread) */
+    int getNumWriters() const { return m_writers.size(); }
+
+    /** Returns a writer, for reading its statistics */
+    StreamWriter* getWriter (int index) const { return m_writers[index]; }
+
+    /** Returns the index of the writer handling a DataQueue stream (or -1) */
+    int getWriterForStream (int streamIndex) const;
 
     /** Runs the thread */
     void run() override;
@@ -79,29 +168,34 @@ public:
     RecordNode* recordNode;
 
 private:
-    /** Writes continuous data with an array of synchronized timestamps */
-    void writeData (const AudioBuffer<float>& dataBuffer,
-                    const SynchronizedTimestampBuffer& timestampBuffer,
-                    int maxSamples,
+    /** Writes this thread's continuous streams, then pending events and spikes */
+    void writeData (int maxSamples,
                     int maxEvents,
                     int maxSpikes,
                     bool lastBlock = false);
 
+    /** Writes an event or message read from the event queue */
+    void writeEvent (const EventPacket& event);
+
+    /** Writes a clock model queued by RecordNode::writeClockModel() as a message */
+    void writeClockModel (const uint8* data);
+
     RecordEngine* m_engine;
     Array<int> m_channelArray;
-    Array<int> m_timestampBufferChannelArray;
 
     DataQueue* m_dataQueue;
-    EventMsgQueue* m_eventQueue;
-    SpikeMsgQueue* m_spikeQueue;
+    EventQueue* m_eventQueue;
+    EventQueue* m_spikeQueue;
+
+    OwnedArray<StreamWriter> m_writers;
+    OwnedArray<WriterThread> m_writerThreads;
+
+    uint64 m_lastDroppedEvents;
+    uint64 m_lastDroppedSpikes;
 
     std::atomic<bool> m_receivedFirstBlock;
     std::atomic<bool> m_cleanExit;
 
-    Array<int64> sampleNumbers;
-    std::vector<CircularBufferIndexes> dataBufferIdxs;
-    std::vector<CircularBufferIndexes> timestampBufferIdxs;
-
     int spikesReceived;
     int spikesWritten;
 
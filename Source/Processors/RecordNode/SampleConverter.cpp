@@ -0,0 +1,389 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "SampleConverter.h"
+
+namespace
+{
+typedef void (*ConversionKernel) (const float* const*, int, const float*, int, int, int16*);
+
+const float maxSampleValue = 32767.0f;
+
+/** Channels are converted in groups of this size by all vectorized kernels */
+const int channelsPerTile = 8;
+
+/** Converts a rectangle of channels x samples, writing into frames of frameSize values */
+void convertRegion (const float* const* source,
+                    int sourceOffset,
+                    const float* scales,
+                    int firstChannel,
+                    int lastChannel,
+                    int firstSample,
+                    int lastSample,
+                    int frameSize,
+                    int16* dest)
+{
+    for (int chan = firstChannel; chan < lastChannel; chan++)
+    {
+        const float* src = source[chan] + sourceOffset;
+        const float scale = scales[chan];
+        int16* out = dest + chan;
+
+        for (int i = firstSample; i < lastSample; i++)
+        {
+            const float value = jlimit (-maxSampleValue, maxSampleValue, src[i] * scale);
+            out[i * frameSize] = int16 (roundToInt (value));
+        }
+    }
+}
+
+/** Converts the samples and channels not covered by whole tiles */
+void convertRemainder (const float* const* source,
+                       int sourceOffset,
+                       const float* scales,
+                       int numChannels,
+                       int numSamples,
+                       int tiledChannels,
+                       int tiledSamples,
+                       int16* dest)
+{
+    convertRegion (source, sourceOffset, scales, 0, tiledChannels, tiledSamples, numSamples, numChannels, dest);
+    convertRegion (source, sourceOffset, scales, tiledChannels, numChannels, 0, numSamples, numChannels, dest);
+}
+
+#if DSP_KERNELS_SSE2
+
+/** Transposes an 8 x 8 tile of int16 values (rows become columns) */
+inline void transpose8x8 (__m128i* r)
+{
+    const __m128i t0 = _mm_unpacklo_epi16 (r[0], r[1]);
+    const __m128i t1 = _mm_unpackhi_epi16 (r[0], r[1]);
+    const __m128i t2 = _mm_unpacklo_epi16 (r[2], r[3]);
+    const __m128i t3 = _mm_unpackhi_epi16 (r[2], r[3]);
+    const __m128i t4 = _mm_unpacklo_epi16 (r[4], r[5]);
+    const __m128i t5 = _mm_unpackhi_epi16 (r[4], r[5]);
+    const __m128i t6 = _mm_unpacklo_epi16 (r[6], r[7]);
+    const __m128i t7 = _mm_unpackhi_epi16 (r[6], r[7]);
+
+    const __m128i u0 = _mm_unpacklo_epi32 (t0, t2);
+    const __m128i u1 = _mm_unpackhi_epi32 (t0, t2);
+    const __m128i u2 = _mm_unpacklo_epi32 (t1, t3);
+    const __m128i u3 = _mm_unpackhi_epi32 (t1, t3);
+    const __m128i u4 = _mm_unpacklo_epi32 (t4, t6);
+    const __m128i u5 = _mm_unpackhi_epi32 (t4, t6);
+    const __m128i u6 = _mm_unpacklo_epi32 (t5, t7);
+    const __m128i u7 = _mm_unpackhi_epi32 (t5, t7);
+
+    r[0] = _mm_unpacklo_epi64 (u0, u4);
+    r[1] = _mm_unpackhi_epi64 (u0, u4);
+    r[2] = _mm_unpacklo_epi64 (u1, u5);
+    r[3] = _mm_unpackhi_epi64 (u1, u5);
+    r[4] = _mm_unpacklo_epi64 (u2, u6);
+    r[5] = _mm_unpackhi_epi64 (u2, u6);
+    r[6] = _mm_unpacklo_epi64 (u3, u7);
+    r[7] = _mm_unpackhi_epi64 (u3, u7);
+}
+
+/** Converts 8 samples of 8 channels and stores them as 8 partial frames */
+inline void convertTileSSE2 (const float* const* source,
+                             int offset,
+                             const float* scales,
+                             int firstChannel,
+                             int frameSize,
+                             int16* dest)
+{
+    const __m128 maxValue = _mm_set1_ps (maxSampleValue);
+    const __m128 minValue = _mm_set1_ps (-maxSampleValue);
+
+    __m128i rows[channelsPerTile];
+
+    for (int i = 0; i < channelsPerTile; i++)
+    {
+        const float* src = source[firstChannel + i] + offset;
+        const __m128 scale = _mm_set1_ps (scales[firstChannel + i]);
+
+        __m128 a = _mm_mul_ps (_mm_loadu_ps (src), scale);
+        __m128 b = _mm_mul_ps (_mm_loadu_ps (src + 4), scale);
+
+        a = _mm_min_ps (_mm_max_ps (a, minValue), maxValue);
+        b = _mm_min_ps (_mm_max_ps (b, minValue), maxValue);
+
+        rows[i] = _mm_packs_epi32 (_mm_cvtps_epi32 (a), _mm_cvtps_epi32 (b));
+    }
+
+    transpose8x8 (rows);
+
+    for (int i = 0; i < 8; i++)
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (dest + i * frameSize + firstChannel), rows[i]);
+}
+
+void convertSSE2 (const float* const* source,
+                  int sourceOffset,
+                  const float* scales,
+                  int numChannels,
+                  int numSamples,
+                  int16* dest)
+{
+    const int tiledChannels = numChannels & ~(channelsPerTile - 1);
+    const int tiledSamples = numSamples & ~7;
+
+    for (int s = 0; s < tiledSamples; s += 8)
+    {
+        for (int c = 0; c < tiledChannels; c += channelsPerTile)
+            convertTileSSE2 (source, sourceOffset + s, scales, c, numChannels, dest + s * numChannels);
+    }
+
+    convertRemainder (source, sourceOffset, scales, numChannels, numSamples, tiledChannels, tiledSamples, dest);
+}
+
+/** Same as transpose8x8, applied to both 128-bit lanes at once */
+DSP_KERNELS_AVX2_TARGET inline void transpose8x8x2 (__m256i* r)
+{
+    const __m256i t0 = _mm256_unpacklo_epi16 (r[0], r[1]);
+    const __m256i t1 = _mm256_unpackhi_epi16 (r[0], r[1]);
+    const __m256i t2 = _mm256_unpacklo_epi16 (r[2], r[3]);
+    const __m256i t3 = _mm256_unpackhi_epi16 (r[2], r[3]);
+    const __m256i t4 = _mm256_unpacklo_epi16 (r[4], r[5]);
+    const __m256i t5 = _mm256_unpackhi_epi16 (r[4], r[5]);
+    const __m256i t6 = _mm256_unpacklo_epi16 (r[6], r[7]);
+    const __m256i t7 = _mm256_unpackhi_epi16 (r[6], r[7]);
+
+    const __m256i u0 = _mm256_unpacklo_epi32 (t0, t2);
+    const __m256i u1 = _mm256_unpackhi_epi32 (t0, t2);
+    const __m256i u2 = _mm256_unpacklo_epi32 (t1, t3);
+    const __m256i u3 = _mm256_unpackhi_epi32 (t1, t3);
+    const __m256i u4 = _mm256_unpacklo_epi32 (t4, t6);
+    const __m256i u5 = _mm256_unpackhi_epi32 (t4, t6);
+    const __m256i u6 = _mm256_unpacklo_epi32 (t5, t7);
+    const __m256i u7 = _mm256_unpackhi_epi32 (t5, t7);
+
+    r[0] = _mm256_unpacklo_epi64 (u0, u4);
+    r[1] = _mm256_unpackhi_epi64 (u0, u4);
+    r[2] = _mm256_unpacklo_epi64 (u1, u5);
+    r[3] = _mm256_unpackhi_epi64 (u1, u5);
+    r[4] = _mm256_unpacklo_epi64 (u2, u6);
+    r[5] = _mm256_unpackhi_epi64 (u2, u6);
+    r[6] = _mm256_unpacklo_epi64 (u3, u7);
+    r[7] = _mm256_unpackhi_epi64 (u3, u7);
+}
+
+/** Converts 16 samples of 8 channels and stores them as 16 partial frames */
+DSP_KERNELS_AVX2_TARGET inline void convertTileAVX2 (const float* const* source,
+                                                     int offset,
+                                                     const float* scales,
+                                                     int firstChannel,
+                                                     int frameSize,
+                                                     int16* dest)
+{
+    const __m256 maxValue = _mm256_set1_ps (maxSampleValue);
+    const __m256 minValue = _mm256_set1_ps (-maxSampleValue);
+
+    __m256i rows[channelsPerTile];
+
+    for (int i = 0; i < channelsPerTile; i++)
+    {
+        const float* src = source[firstChannel + i] + offset;
+        const __m256 scale = _mm256_set1_ps (scales[firstChannel + i]);
+
+        __m256 a = _mm256_mul_ps (_mm256_loadu_ps (src), scale);
+        __m256 b = _mm256_mul_ps (_mm256_loadu_ps (src + 8), scale);
+
+        a = _mm256_min_ps (_mm256_max_ps (a, minValue), maxValue);
+        b = _mm256_min_ps (_mm256_max_ps (b, minValue), maxValue);
+
+        // packs works within 128-bit lanes; reorder so that the low lane holds
+        // samples 0-7 and the high lane samples 8-15
+        const __m256i packed = _mm256_packs_epi32 (_mm256_cvtps_epi32 (a), _mm256_cvtps_epi32 (b));
+        rows[i] = _mm256_permute4x64_epi64 (packed, 0xD8);
+    }
+
+    transpose8x8x2 (rows);
+
+    for (int i = 0; i < 8; i++)
+    {
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (dest + i * frameSize + firstChannel),
+                          _mm256_castsi256_si128 (rows[i]));
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (dest + (i + 8) * frameSize + firstChannel),
+                          _mm256_extracti128_si256 (rows[i], 1));
+    }
+}
+
+DSP_KERNELS_AVX2_TARGET void convertAVX2 (const float* const* source,
+                                          int sourceOffset,
+                                          const float* scales,
+                                          int numChannels,
+                                          int numSamples,
+                                          int16* dest)
+{
+    const int tiledChannels = numChannels & ~(channelsPerTile - 1);
+    const int wideSamples = numSamples & ~15;
+    const int tiledSamples = numSamples & ~7;
+
+    for (int s = 0; s < wideSamples; s += 16)
+    {
+        for (int c = 0; c < tiledChannels; c += channelsPerTile)
+            convertTileAVX2 (source, sourceOffset + s, scales, c, numChannels, dest + s * numChannels);
+    }
+
+    if (tiledSamples > wideSamples)
+    {
+        for (int c = 0; c < tiledChannels; c += channelsPerTile)
+            convertTileSSE2 (source, sourceOffset + wideSamples, scales, c, numChannels, dest + wideSamples * numChannels);
+    }
+
+    convertRemainder (source, sourceOffset, scales, numChannels, numSamples, tiledChannels, tiledSamples, dest);
+}
+
+#endif // DSP_KERNELS_SSE2
+
+#if DSP_KERNELS_NEON
+
+/** Converts 8 samples of 8 channels and stores them as 8 partial frames */
+inline void convertTileNEON (const float* const* source,
+                             int offset,
+                             const float* scales,
+                             int firstChannel,
+                             int frameSize,
+                             int16* dest)
+{
+    const float32x4_t maxValue = vdupq_n_f32 (maxSampleValue);
+    const float32x4_t minValue = vdupq_n_f32 (-maxSampleValue);
+
+    int16x8_t rows[channelsPerTile];
+
+    for (int i = 0; i < channelsPerTile; i++)
+    {
+        const float* src = source[firstChannel + i] + offset;
+        const float32x4_t scale = vdupq_n_f32 (scales[firstChannel + i]);
+
+        float32x4_t a = vmulq_f32 (vld1q_f32 (src), scale);
+        float32x4_t b = vmulq_f32 (vld1q_f32 (src + 4), scale);
+
+        a = vminq_f32 (vmaxq_f32 (a, minValue), maxValue);
+        b = vminq_f32 (vmaxq_f32 (b, minValue), maxValue);
+
+        rows[i] = vcombine_s16 (vqmovn_s32 (vcvtnq_s32_f32 (a)), vqmovn_s32 (vcvtnq_s32_f32 (b)));
+    }
+
+    // transpose the 8 x 8 tile: 16-bit, then 32-bit, then 64-bit swaps
+    const int16x8x2_t p01 = vtrnq_s16 (rows[0], rows[1]);
+    const int16x8x2_t p23 = vtrnq_s16 (rows[2], rows[3]);
+    const int16x8x2_t p45 = vtrnq_s16 (rows[4], rows[5]);
+    const int16x8x2_t p67 = vtrnq_s16 (rows[6], rows[7]);
+
+    const int32x4x2_t q0 = vtrnq_s32 (vreinterpretq_s32_s16 (p01.val[0]), vreinterpretq_s32_s16 (p23.val[0]));
+    const int32x4x2_t q1 = vtrnq_s32 (vreinterpretq_s32_s16 (p01.val[1]), vreinterpretq_s32_s16 (p23.val[1]));
+    const int32x4x2_t q2 = vtrnq_s32 (vreinterpretq_s32_s16 (p45.val[0]), vreinterpretq_s32_s16 (p67.val[0]));
+    const int32x4x2_t q3 = vtrnq_s32 (vreinterpretq_s32_s16 (p45.val[1]), vreinterpretq_s32_s16 (p67.val[1]));
+
+    const int32x4_t lows[4] = { q0.val[0], q1.val[0], q0.val[1], q1.val[1] };
+    const int32x4_t highs[4] = { q2.val[0], q3.val[0], q2.val[1], q3.val[1] };
+
+    for (int i = 0; i < 4; i++)
+    {
+        const int16x8_t first = vreinterpretq_s16_s32 (vcombine_s32 (vget_low_s32 (lows[i]), vget_low_s32 (highs[i])));
+        const int16x8_t second = vreinterpretq_s16_s32 (vcombine_s32 (vget_high_s32 (lows[i]), vget_high_s32 (highs[i])));
+
+        vst1q_s16 (dest + i * frameSize + firstChannel, first);
+        vst1q_s16 (dest + (i + 4) * frameSize + firstChannel, second);
+    }
+}
+
+void convertNEON (const float* const* source,
+                  int sourceOffset,
+                  const float* scales,
+                  int numChannels,
+                  int numSamples,
+                  int16* dest)
+{
+    const int tiledChannels = numChannels & ~(channelsPerTile - 1);
+    const int tiledSamples = numSamples & ~7;
+
+    for (int s = 0; s < tiledSamples; s += 8)
+    {
+        for (int c = 0; c < tiledChannels; c += channelsPerTile)
+            convertTileNEON (source, sourceOffset + s, scales, c, numChannels, dest + s * numChannels);
+    }
+
+    convertRemainder (source, sourceOffset, scales, numChannels, numSamples, tiledChannels, tiledSamples, dest);
+}
+
+#endif // DSP_KERNELS_NEON
+
+const Dsp::KernelSet<ConversionKernel>& getKernels()
+{
+    static const Dsp::KernelSet<ConversionKernel> kernels { { SampleConverter::Kernel::Scalar, SampleConverter::convertToInt16InterleavedScalar },
+#if DSP_KERNELS_SSE2
+                                                            { SampleConverter::Kernel::SSE2, convertSSE2 },
+                                                            { SampleConverter::Kernel::AVX2, convertAVX2 },
+#endif
+#if DSP_KERNELS_NEON
+                                                            { SampleConverter::Kernel::NEON, convertNEON },
+#endif
+    };
+
+    return kernels;
+}
+} // namespace
+
+void SampleConverter::convertToInt16Interleaved (const float* const* source,
+                                                 int sourceOffset,
+                                                 const float* scales,
+                                                 int numChannels,
+                                                 int numSamples,
+                                                 int16* dest)
+{
+    getKernels().getSelected() (source, sourceOffset, scales, numChannels, numSamples, dest);
+}
+
+void SampleConverter::convertToInt16InterleavedScalar (const float* const* source,
+                                                       int sourceOffset,
+                                                       const float* scales,
+                                                       int numChannels,
+                                                       int numSamples,
+                                                       int16* dest)
+{
+    convertRegion (source, sourceOffset, scales, 0, numChannels, 0, numSamples, numChannels, dest);
+}
+
+bool SampleConverter::isKernelSupported (Kernel kernel)
+{
+    return getKernels().isSupported (kernel);
+}
+
+void SampleConverter::convertToInt16Interleaved (Kernel kernel,
+                                                 const float* const* source,
+                                                 int sourceOffset,
+                                                 const float* scales,
+                                                 int numChannels,
+                                                 int numSamples,
+                                                 int16* dest)
+{
+    getKernels().getOrScalar (kernel) (source, sourceOffset, scales, numChannels, numSamples, dest);
+}
+
+String SampleConverter::getKernelName()
+{
+    return getKernels().getSelectedName();
+}
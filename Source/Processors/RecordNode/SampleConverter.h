@@ -0,0 +1,85 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef SAMPLECONVERTER_H_INCLUDED
+#define SAMPLECONVERTER_H_INCLUDED
+
+#include <JuceHeader.h>
+
+#include "../Dsp/KernelDispatch.h"
+#include "../PluginManager/PluginClass.h"
+
+/**
+
+    Converts blocks of float samples to interleaved int16 frames,
+    as written by the Binary format.
+
+    Each output sample is round (clamp (input * scale, -32767, 32767)),
+    where scale is normally 1 / bitVolts for the channel. Scaling,
+    conversion and interleaving are done in a single pass over the data,
+    using SSE2, AVX2 or NEON when available. The fastest kernel supported
+    by the host CPU is selected the first time a conversion is requested.
+
+*/
+class PLUGIN_API SampleConverter
+{
+public:
+    /** The available conversion kernels */
+    using Kernel = Dsp::KernelType;
+
+    /** Converts numSamples samples of numChannels channels, starting at
+        source[chan][sourceOffset], into numSamples frames of numChannels
+        int16 values in dest. */
+    static void convertToInt16Interleaved (const float* const* source,
+                                           int sourceOffset,
+                                           const float* scales,
+                                           int numChannels,
+                                           int numSamples,
+                                           int16* dest);
+
+    /** Plain C++ implementation of convertToInt16Interleaved (used as a reference) */
+    static void convertToInt16InterleavedScalar (const float* const* source,
+                                                 int sourceOffset,
+                                                 const float* scales,
+                                                 int numChannels,
+                                                 int numSamples,
+                                                 int16* dest);
+
+    /** Returns true if a kernel was built in and can run on the host CPU */
+    static bool isKernelSupported (Kernel kernel);
+
+    /** Converts with a specific kernel, which must be supported (used to test each kernel against the scalar one) */
+    static void convertToInt16Interleaved (Kernel kernel,
+                                           const float* const* source,
+                                           int sourceOffset,
+                                           const float* scales,
+                                           int numChannels,
+                                           int numSamples,
+                                           int16* dest);
+
+    /** Returns the name of the kernel used by convertToInt16Interleaved ("AVX2", "SSE2", "NEON" or "Scalar") */
+    static String getKernelName();
+};
+
+#endif // SAMPLECONVERTER_H_INCLUDED
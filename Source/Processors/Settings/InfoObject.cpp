@@ -26,21 +26,143 @@
 #include "../GenericProcessor/GenericProcessor.h"
 #include "DataStream.h"
 
+namespace
+{
+/** Combines the hash of a list with the next value in it (64-bit FNV-1a, one value at a time) */
+int64 combineHash (int64 hash, int64 value)
+{
+    const uint64 fnvOffsetBasis = 14695981039346656037ull;
+    const uint64 fnvPrime = 1099511628211ull;
+
+    return (int64) (((hash == 0 ? fnvOffsetBasis : (uint64) hash) ^ (uint64) value) * fnvPrime);
+}
+} // namespace
+
 HistoryObject::HistoryObject() {}
 
 HistoryObject::~HistoryObject() {}
 
+HistoryObject::Entry::Entry (const String& name_, Entry* previous_)
+    : name (name_),
+      previous (previous_),
+      hash (combineHash (previous_ == nullptr ? 0 : previous_->hash, name_.hashCode64()))
+{
+}
+
 String HistoryObject::getHistoryString() const
 {
-    return m_historyString;
+    Array<const Entry*> entries;
+
+    for (const Entry* entry = m_lastEntry.get(); entry != nullptr; entry = entry->previous.get())
+        entries.add (entry);
+
+    String history;
+
+    for (int i = entries.size(); --i >= 0;)
+    {
+        history += entries[i]->name;
+
+        if (i > 0)
+            history += " -> ";
+    }
+
+    return history;
 }
 
 void HistoryObject::addToHistoryString (String entry)
 {
-    if (m_historyString.isEmpty())
-        m_historyString = entry;
-    else
-        m_historyString += (" -> " + entry);
+    m_lastEntry = new Entry (entry, m_lastEntry.get());
+}
+
+int64 HistoryObject::getHistoryHash() const
+{
+    return m_lastEntry == nullptr ? 0 : m_lastEntry->hash;
+}
+
+ProcessorChain::Link::Link (GenericProcessor* processor_, Link* previous_)
+    : processor (processor_),
+      previous (previous_),
+      size (previous_ == nullptr ? 1 : previous_->size + 1),
+      hash (combineHash (previous_ == nullptr ? 0 : previous_->hash, processor_->getNodeId()))
+{
+}
+
+int ProcessorChain::size() const
+{
+    return m_last == nullptr ? 0 : m_last->size;
+}
+
+bool ProcessorChain::isEmpty() const
+{
+    return m_last == nullptr;
+}
+
+GenericProcessor* ProcessorChain::operator[] (int index) const
+{
+    if (index < 0 || index >= size())
+        return nullptr;
+
+    const Link* link = m_last.get();
+
+    while (link->size > index + 1)
+        link = link->previous.get();
+
+    return link->processor;
+}
+
+GenericProcessor* ProcessorChain::getFirst() const
+{
+    return (*this)[0];
+}
+
+GenericProcessor* ProcessorChain::getLast() const
+{
+    return m_last == nullptr ? nullptr : m_last->processor;
+}
+
+int ProcessorChain::indexOf (const GenericProcessor* processor) const
+{
+    int index = -1;
+
+    for (const Link* link = m_last.get(); link != nullptr; link = link->previous.get())
+    {
+        if (link->processor == processor)
+            index = link->size - 1;
+    }
+
+    return index;
+}
+
+bool ProcessorChain::contains (const GenericProcessor* processor) const
+{
+    for (const Link* link = m_last.get(); link != nullptr; link = link->previous.get())
+    {
+        if (link->processor == processor)
+            return true;
+    }
+
+    return false;
+}
+
+Array<GenericProcessor*> ProcessorChain::toArray() const
+{
+    Array<GenericProcessor*> processors;
+    processors.insertMultiple (0, nullptr, size());
+
+    for (const Link* link = m_last.get(); link != nullptr; link = link->previous.get())
+        processors.set (link->size - 1, link->processor);
+
+    return processors;
+}
+
+int64 ProcessorChain::getHash() const
+{
+    return m_last == nullptr ? 0 : m_last->hash;
+}
+
+void ProcessorChain::add (GenericProcessor* processor)
+{
+    m_last = new Link (processor, m_last.get());
 }
 
 NamedObject::NamedObject()
@@ -110,20 +232,20 @@ InfoObject::~InfoObject()
 }
 
 InfoObject::InfoObject (const InfoObject& other) : NamedObject (other),
-                                                   HistoryObject (other),
                                                    MetadataObject (other),
+                                                   HistoryObject (other),
+                                                   processorChain (other.processorChain),
+                                                   group (other.group),
+                                                   position (other.position),
                                                    m_type (other.m_type),
                                                    m_local_index (other.m_local_index),
                                                    m_global_index (other.m_global_index),
-                                                   m_sourceNodeId (other.m_sourceNodeId),
-                                                   m_sourceNodeName (other.m_sourceNodeName),
                                                    m_nodeId (other.m_nodeId),
                                                    m_nodeName (other.m_nodeName),
-                                                   m_isLocal (false),
+                                                   m_sourceNodeId (other.m_sourceNodeId),
+                                                   m_sourceNodeName (other.m_sourceNodeName),
                                                    m_isEnabled (other.m_isEnabled),
-                                                   group (other.group),
-                                                   position (other.position),
-                                                   processorChain (other.processorChain)
+                                                   m_isLocal (false)
 {
 }
 
@@ -192,7 +314,7 @@ String InfoObject::getNodeName() const
 
 void InfoObject::addProcessor (GenericProcessor* processor)
 {
-    if (processorChain.size() == 0)
+    if (processorChain.isEmpty())
         m_sourceNodeName = processor->getName();
 
     processorChain.add (processor);
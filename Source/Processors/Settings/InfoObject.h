@@ -36,7 +36,12 @@ class GenericProcessor;
 class ParameterCollection;
 class DataStream;
 
-/** This class creates a string that indicates all of the processors a channel has passed through */
+/** This class creates a string that indicates all of the processors a channel has passed through
+*
+* The entries are held in a list that copies share, so copying an object
+* doesn't copy its history.
+*
+*/
 class PLUGIN_API HistoryObject
 {
 protected:
@@ -53,8 +58,127 @@ public:
     /** Adds a new entry in the history string*/
     void addToHistoryString (String entry);
 
+    /** Returns a hash of the entries in the history, in order (0 if there are none) */
+    int64 getHistoryHash() const;
+
 private:
-    String m_historyString;
+    /** An entry in the history, linked to the ones before it */
+    struct Entry : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<Entry>;
+
+        Entry (const String& name, Entry* previous);
+
+        const String name;
+        const Ptr previous;
+
+        /** Hash of this entry and the ones before it */
+        const int64 hash;
+    };
+
+    Entry::Ptr m_lastEntry;
+};
+
+/** Holds pointers to all processors that may have modified an InfoObject, in the order it passed through them
+*
+* Like the history, the list is shared between copies of an object. It can be used
+* in place of the Array<GenericProcessor*> it replaces: it can be indexed, searched,
+* and iterated from the first processor to the last.
+*
+*/
+class PLUGIN_API ProcessorChain
+{
+public:
+    /** Iterates over the processors in the chain, starting with the first one
+    *
+    * The links point from each processor to the one before it, so an iterator
+    * collects the processors when it's created, and then steps through them.
+    */
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = GenericProcessor*;
+        using difference_type = int;
+        using pointer = GenericProcessor* const*;
+        using reference = GenericProcessor*;
+
+        Iterator (const ProcessorChain& chain_, int index_) : chain (&chain_), index (index_)
+        {
+            if (index < chain->size())
+                processors = chain->toArray();
+        }
+
+        GenericProcessor* operator*() const { return processors[index]; }
+
+        Iterator& operator++()
+        {
+            ++index;
+            return *this;
+        }
+
+        bool operator== (const Iterator& other) const { return chain == other.chain && index == other.index; }
+        bool operator!= (const Iterator& other) const { return ! (*this == other); }
+
+    private:
+        const ProcessorChain* chain;
+        int index;
+        Array<GenericProcessor*> processors;
+    };
+
+    /** Returns the number of processors in the chain */
+    int size() const;
+
+    /** Returns true if the chain has no processors */
+    bool isEmpty() const;
+
+    /** Returns a processor by index, starting with the first one (or nullptr if the index is out of range) */
+    GenericProcessor* operator[] (int index) const;
+
+    /** Returns the processor the object started from (or nullptr if the chain is empty) */
+    GenericProcessor* getFirst() const;
+
+    /** Returns the processor the object passed through most recently (or nullptr if the chain is empty) */
+    GenericProcessor* getLast() const;
+
+    /** Returns the index of the first occurrence of a processor (or -1 if it isn't in the chain) */
+    int indexOf (const GenericProcessor* processor) const;
+
+    /** Returns true if the processor is in the chain */
+    bool contains (const GenericProcessor* processor) const;
+
+    /** Returns the processors in the chain, starting with the first one */
+    Array<GenericProcessor*> toArray() const;
+
+    /** Returns a hash of the node IDs the processors had when they were added, in order (0 if the chain is empty) */
+    int64 getHash() const;
+
+    /** Returns an iterator pointing to the first processor */
+    Iterator begin() const { return Iterator (*this, 0); }
+
+    /** Returns an iterator pointing past the last processor */
+    Iterator end() const { return Iterator (*this, size()); }
+
+    /** Adds a processor to the end of the chain */
+    void add (GenericProcessor* processor);
+
+private:
+    /** A processor in the chain, linked to the ones before it */
+    struct Link : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<Link>;
+
+        Link (GenericProcessor* processor, Link* previous);
+
+        GenericProcessor* const processor;
+        const Ptr previous;
+        const int size;
+
+        /** Hash of this processor's node ID and the ones before it */
+        const int64 hash;
+    };
+
+    Link::Ptr m_last;
 };
 
 /** Base class for the GUI's info objects
@@ -219,7 +343,7 @@ public:
     bool isLocal() const;
 
     /** Holds pointers to all processors that may have modified this object */
-    Array<GenericProcessor*> processorChain;
+    ProcessorChain processorChain;
 
     /** Holds information about the "group" this object belongs to */
     Group group;
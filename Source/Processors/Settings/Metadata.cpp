@@ -334,6 +334,24 @@ MetadataObject::MetadataObject() {}
 
 MetadataObject::~MetadataObject() {}
 
+MetadataObject::MetadataSet& MetadataObject::getWritableMetadata()
+{
+    if (m_metadata == nullptr)
+    {
+        m_metadata = new MetadataSet();
+    }
+    else if (m_metadata->getReferenceCount() > 1)
+    {
+        // the fields themselves are never modified, so the copy can share them
+        MetadataSet* copy = new MetadataSet();
+        copy->descriptors.addArray (m_metadata->descriptors);
+        copy->values.addArray (m_metadata->values);
+        m_metadata = copy;
+    }
+
+    return *m_metadata;
+}
+
 void MetadataObject::addMetadata (MetadataDescriptor* desc, MetadataValue* val)
 {
     if (desc->getType() != val->getDataType() || desc->getLength() != val->getDataLength())
@@ -346,8 +364,9 @@ void MetadataObject::addMetadata (MetadataDescriptor* desc, MetadataValue* val)
         delete val;
         return;
     }
-    m_metadataDescriptorArray.add (desc);
-    m_metadataValueArray.add (val);
+    MetadataSet& metadata = getWritableMetadata();
+    metadata.descriptors.add (desc);
+    metadata.values.add (val);
 }
 
 void MetadataObject::addMetadata (const MetadataDescriptor& desc, const MetadataValue& val)
@@ -357,31 +376,38 @@ void MetadataObject::addMetadata (const MetadataDescriptor& desc, const Metadata
         jassertfalse;
         return;
     }
-    m_metadataDescriptorArray.add (new MetadataDescriptor (desc));
-    m_metadataValueArray.add (new MetadataValue (val));
+    MetadataSet& metadata = getWritableMetadata();
+    metadata.descriptors.add (new MetadataDescriptor (desc));
+    metadata.values.add (new MetadataValue (val));
 }
 
 const MetadataDescriptor* MetadataObject::getMetadataDescriptor (int index) const
 {
-    return m_metadataDescriptorArray[index];
+    if (m_metadata == nullptr)
+        return nullptr;
+    return m_metadata->descriptors[index];
 }
 
 const MetadataValue* MetadataObject::getMetadataValue (int index) const
 {
-    return m_metadataValueArray[index];
+    if (m_metadata == nullptr)
+        return nullptr;
+    return m_metadata->values[index];
 }
 
 const int MetadataObject::getMetadataCount() const
 {
-    return m_metadataDescriptorArray.size();
+    if (m_metadata == nullptr)
+        return 0;
+    return m_metadata->descriptors.size();
 }
 
 int MetadataObject::findMetadata (MetadataDescriptor::MetadataType type, unsigned int length, String identifier) const
 {
-    int nMetadata = m_metadataDescriptorArray.size();
+    int nMetadata = getMetadataCount();
     for (int i = 0; i < nMetadata; i++)
     {
-        MetadataDescriptorPtr md = m_metadataDescriptorArray[i];
+        MetadataDescriptorPtr md = m_metadata->descriptors[i];
         if (md->getType() == type && md->getLength() == length && compareIdentifierStrings (identifier, md->getIdentifier()))
             return i;
     }
@@ -400,13 +426,15 @@ bool MetadataObject::hasSimilarMetadata (const MetadataObject& other) const
 
 bool MetadataObject::checkMetadataCoincidence (const MetadataObject& other, bool similar) const
 {
-    int nMetadata = m_metadataDescriptorArray.size();
-    if (nMetadata != other.m_metadataDescriptorArray.size())
+    int nMetadata = getMetadataCount();
+    if (nMetadata != other.getMetadataCount())
         return false;
+    if (m_metadata == other.m_metadata)
+        return true;
     for (int i = 0; i < nMetadata; i++)
     {
-        MetadataDescriptorPtr md = m_metadataDescriptorArray[i];
-        MetadataDescriptorPtr mdo = other.m_metadataDescriptorArray[i];
+        MetadataDescriptorPtr md = m_metadata->descriptors[i];
+        MetadataDescriptorPtr mdo = other.m_metadata->descriptors[i];
         if (similar)
         {
             if (! md->isSimilar (*mdo))
@@ -245,6 +245,9 @@ typedef ReferenceCountedObjectPtr<MetadataValue> MetadataValuePtr;
 
 /**
     Base class for all InfoObjects that can include metadata
+
+    Copies of an object share its metadata fields until one of them adds
+    a new field, so channels copied down the signal chain don't duplicate them.
  */
 class PLUGIN_API MetadataObject
 {
@@ -280,13 +283,21 @@ public:
     /** Returns true if another object has the same metadata types and lengths */
     bool hasSimilarMetadata (const MetadataObject& other) const;
 
-protected:
-    MetadataDescriptorArray m_metadataDescriptorArray;
-    MetadataValueArray m_metadataValueArray;
-
 private:
+    /** The metadata fields, shared between copies of an object */
+    struct MetadataSet : public ReferenceCountedObject
+    {
+        MetadataDescriptorArray descriptors;
+        MetadataValueArray values;
+    };
+
+    /** Returns a set of fields that only this object holds, copying the shared one if needed */
+    MetadataSet& getWritableMetadata();
+
     /** Checks whether metadata is similar to the same*/
     bool checkMetadataCoincidence (const MetadataObject& other, bool similar) const;
+
+    ReferenceCountedObjectPtr<MetadataSet> m_metadata;
 };
 
 class PLUGIN_API MetadataEventLock
@@ -45,6 +45,20 @@ public:
     virtual Array<float>& getThresholds() = 0;
 
     virtual bool checkSample (int channel, float sample) = 0;
+
+    /** Returns the number of upcoming samples of a channel for which checkSample() is
+        guaranteed to compare against the current value of getThresholds()[channel].
+        Detectors may scan these samples directly, as long as they call advance() for
+        every sample that checkSample() would have seen. */
+    virtual int getNumSamplesWithFixedThreshold (int channel) { return 0; }
+
+    /** Updates the state of a channel as if checkSample() had been called for each of
+        numSamples samples (which must not exceed getNumSamplesWithFixedThreshold()) */
+    virtual void advance (int channel, const float* samples, int numSamples)
+    {
+        for (int i = 0; i < numSamples; i++)
+            checkSample (channel, samples[i]);
+    }
 };
 
 class PLUGIN_API SpikeChannel : public ChannelInfoObject,
@@ -30,6 +30,7 @@
 #include "../../Utils/Utils.h"
 
 #include "../Events/Event.h"
+#include "../Events/TTLWordDecoder.h"
 #include "../Settings/DataStream.h"
 
 SourceNode::SourceNode (const String& name_, DataThreadCreator dataThreadCreator)
@@ -90,10 +91,30 @@ void SourceNode::resizeBuffers()
         for (int i = 0; i < dataStreams.size(); i++)
         {
             inputBuffers.add (dataThread->getBufferAddress (i));
-            eventCodeBuffers.add (new MemoryBlock (10000 * sizeof (uint64)));
+            eventCodeBuffers.add (new MemoryBlock());
             eventStates.add (0);
         }
     }
+
+    resizeEventCodeBuffers();
+}
+
+void SourceNode::resizeEventCodeBuffers()
+{
+    // a slow stream may deliver a whole block of samples at once, after several empty blocks
+    int blockSize = getBlockSize();
+
+    // until the processor has been prepared, its block size is unknown
+    if (blockSize <= 0)
+        blockSize = 10000;
+
+    for (auto eventCodeBuffer : eventCodeBuffers)
+        eventCodeBuffer->setSize (size_t (blockSize) * sizeof (uint64));
+}
+
+void SourceNode::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    resizeEventCodeBuffers();
 }
 
 void SourceNode::initialize (bool signalChainIsLoading)
@@ -320,27 +341,20 @@ void SourceNode::process (AudioBuffer<float>& buffer)
 
         if (eventChannels[streamIdx])
         {
-            int maxTTLBits = eventChannels[streamIdx]->getMaxTTLBits();
+            const uint64* eventCodes = static_cast<const uint64*> (eventCodeBuffers[streamIdx]->getData());
 
             uint64 lastCode = eventStates[streamIdx];
 
-            for (int sample = 0; sample < nSamples; ++sample)
+            // skip directly to the samples where the TTL word changes
+            for (int sample = TTLWordDecoder::findNextChange (eventCodes, 0, nSamples, lastCode);
+                 sample < nSamples;
+                 sample = TTLWordDecoder::findNextChange (eventCodes, sample + 1, nSamples, lastCode))
             {
-                uint64 currentCode = *(static_cast<uint64*> (eventCodeBuffers[streamIdx]->getData()) + sample);
+                lastCode = eventCodes[sample];
 
-                //If there has been no change to the TTL word, avoid doing anything at all here
-                if (lastCode != currentCode)
-                {
-                    Array<TTLEventPtr> events = TTLEvent::createTTLEvent (eventChannels[streamIdx],
-                                                                          sampleNumber + sample,
-                                                                          currentCode);
-
-                    for (auto& event : events)
-                        addEvent (event, sample);
-
-                    lastCode = currentCode;
-                }
+                addTTLWord (eventChannels[streamIdx], sampleNumber + sample, lastCode, sample);
             }
+
             eventStates.set (streamIdx, lastCode);
         }
     }
@@ -55,6 +55,9 @@ public:
     /** Returns true if the processor is ready for acquisition */
     bool isReady() override;
 
+    /* Sizes the per-stream buffers for the block size of each stream */
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+
     /* Copies samples from the DataThread's DataBuffer into the GUI's processing buffers. */
     void process (AudioBuffer<float>& buffer) override;
 
@@ -117,6 +120,9 @@ private:
     /* Updates the size of the DataBuffers*/
     void resizeBuffers();
 
+    /* Sizes each stream's TTL word buffer to hold one block*/
+    void resizeEventCodeBuffers();
+
     /* Interval (in ms) for checking for the data source*/
     int sourceCheckInterval = 2000;
 
@@ -23,6 +23,156 @@
 
 #include "Synchronizer.h"
 
+SyncPulseBuffer::SyncPulseBuffer (int capacity)
+    : pulses (size_t (capacity))
+{
+}
+
+void SyncPulseBuffer::add (const SyncPulse& pulse)
+{
+    latestIndex = (latestIndex + 1) % int (pulses.size());
+    pulses[size_t (latestIndex)] = pulse;
+
+    numPulses = jmin (numPulses + 1, int (pulses.size()));
+    totalPulses++;
+}
+
+void SyncPulseBuffer::clear()
+{
+    latestIndex = -1;
+    numPulses = 0;
+    totalPulses = 0;
+}
+
+SyncPulse& SyncPulseBuffer::operator[] (int index)
+{
+    jassert (index >= 0 && index < numPulses);
+
+    const int capacity = int (pulses.size());
+    return pulses[size_t ((latestIndex - index + capacity) % capacity)];
+}
+
+const SyncPulse& SyncPulseBuffer::operator[] (int index) const
+{
+    jassert (index >= 0 && index < numPulses);
+
+    const int capacity = int (pulses.size());
+    return pulses[size_t ((latestIndex - index + capacity) % capacity)];
+}
+
+// =======================================================
+
+ClockFit::ClockFit (int windowSize)
+    : pairs (size_t (windowSize))
+{
+}
+
+void ClockFit::clear()
+{
+    oldestIndex = 0;
+    numPairs = 0;
+
+    meanX = 0.0;
+    meanY = 0.0;
+    cxx = 0.0;
+    cxy = 0.0;
+    cyy = 0.0;
+}
+
+void ClockFit::add (int64 sampleNumber, double timestamp)
+{
+    if (numPairs == 0)
+        referenceSampleNumber = sampleNumber;
+
+    const int windowSize = int (pairs.size());
+
+    if (numPairs == windowSize)
+    {
+        const auto& oldest = pairs[size_t (oldestIndex)];
+        remove (oldest.first, oldest.second);
+        oldestIndex = (oldestIndex + 1) % windowSize;
+    }
+
+    const double x = double (sampleNumber - referenceSampleNumber);
+    const double y = timestamp;
+
+    pairs[size_t ((oldestIndex + numPairs) % windowSize)] = { x, y };
+    numPairs++;
+
+    // Welford's update of the means and co-moments
+    const double dx = x - meanX;
+    const double dy = y - meanY;
+
+    meanX += dx / numPairs;
+    meanY += dy / numPairs;
+
+    cxx += dx * (x - meanX);
+    cxy += dx * (y - meanY);
+    cyy += dy * (y - meanY);
+}
+
+void ClockFit::remove (double x, double y)
+{
+    if (numPairs == 1)
+    {
+        clear();
+        return;
+    }
+
+    // inverse of the update in add()
+    const double oldMeanX = (numPairs * meanX - x) / (numPairs - 1);
+    const double oldMeanY = (numPairs * meanY - y) / (numPairs - 1);
+
+    cxx -= (x - oldMeanX) * (x - meanX);
+    cxy -= (x - oldMeanX) * (y - meanY);
+    cyy -= (y - oldMeanY) * (y - meanY);
+
+    meanX = oldMeanX;
+    meanY = oldMeanY;
+    numPairs--;
+}
+
+double ClockFit::getTimeSpan() const
+{
+    if (numPairs < 2)
+        return 0.0;
+
+    const int windowSize = int (pairs.size());
+    const int latestIndex = (oldestIndex + numPairs - 1) % windowSize;
+
+    return pairs[size_t (latestIndex)].second - pairs[size_t (oldestIndex)].second;
+}
+
+double ClockFit::getSlope() const
+{
+    if (numPairs < 2 || cxx <= 0.0)
+        return 0.0;
+
+    return cxy / cxx;
+}
+
+double ClockFit::getTimestamp (int64 sampleNumber) const
+{
+    return meanY + getSlope() * (double (sampleNumber - referenceSampleNumber) - meanX);
+}
+
+int64 ClockFit::getCenterSampleNumber() const
+{
+    return referenceSampleNumber + int64 (std::round (meanX));
+}
+
+double ClockFit::getResidualRms() const
+{
+    if (numPairs < 2)
+        return 0.0;
+
+    const double residualSumOfSquares = cyy - getSlope() * cxy;
+
+    return std::sqrt (jmax (0.0, residualSumOfSquares) / numPairs);
+}
+
+// =======================================================
+
 SyncStream::SyncStream (String streamKey_, float expectedSampleRate_, Synchronizer* synchronizer_, bool generatesTimestamps_)
     : streamKey (streamKey_), synchronizer(synchronizer_),
       expectedSampleRate (expectedSampleRate_),
@@ -40,12 +190,17 @@ void SyncStream::reset (String mainStreamKey)
     isMainStream = (streamKey == mainStreamKey);
 
     pulses.clear();
-    baselineMatchingPulse = SyncPulse();
-    nextMatchingPulse = SyncPulse();
+    clockFit.clear();
+    consecutiveOutliers = 0;
+
+    modelSampleNumber = 0;
+    modelTimestamp = 0.0;
+    modelVersion++;
 
     latestSyncSampleNumber = 0;
     latestGlobalSyncTime = 0.0;
     latestSyncMillis = -1;
+    latestMatchedPulse = -1;
 
     if (isMainStream)
     {
@@ -61,9 +216,25 @@ void SyncStream::reset (String mainStreamKey)
         overrideHardwareTimestamps = syncLine > -1; // override hardware timestamps for other streams if sync line is set
         isSynchronized = generatesTimestamps && !overrideHardwareTimestamps; // if the stream generates its own timestamps, it is synchronized unless it overrides hardware timestamps
     }
+
+    publishClock();
+}
+
+void SyncStream::publishClock()
+{
+    SyncClock newClock;
+
+    newClock.isSynchronized = isSynchronized;
+    newClock.generatesTimestamps = generatesTimestamps && ! overrideHardwareTimestamps;
+    newClock.version = modelVersion;
+    newClock.baselineSampleNumber = modelSampleNumber;
+    newClock.baselineTimestamp = modelTimestamp;
+    newClock.sampleRate = actualSampleRate;
+
+    clock.store (newClock);
 }
 
-void SyncStream::addEvent (int64 sampleNumber, bool state)
+void SyncStream::addEvent (int64 sampleNumber, bool state, int64 computerTimeMillis)
 {
     //LOGD ("[+] Adding event for stream ", streamKey, " (", sampleNumber, ")");
 
@@ -72,9 +243,9 @@ void SyncStream::addEvent (int64 sampleNumber, bool state)
         SyncPulse latestPulse;
         latestPulse.localSampleNumber = sampleNumber;
         latestPulse.localTimestamp = double(sampleNumber) / expectedSampleRate;
-        latestPulse.computerTimeMillis = Time::currentTimeMillis();
+        latestPulse.computerTimeMillis = computerTimeMillis;
 
-        pulses.insert (pulses.begin(), latestPulse);
+        pulses.add (latestPulse);
     }
     else // off event received, pulse terminated
     {
@@ -91,11 +262,6 @@ void SyncStream::addEvent (int64 sampleNumber, bool state)
                 latestPulse.interval = latestPulse.localTimestamp - pulses[1].localTimestamp;
             }
         }
-
-        if (pulses.size() > MAX_PULSES_IN_BUFFER)
-        {
-            pulses.pop_back();
-        }
     }
 }
 
@@ -109,7 +275,7 @@ double SyncStream::getLatestSyncTime()
     if (latestSyncMillis != -1)
     {
        // LOGD ("Returning: ", double (Time::currentTimeMillis() - latestSyncMillis) / 1000.0f);
-        return double (Time::currentTimeMillis() - latestSyncMillis) / 1000.0f;
+        return double (synchronizer->getCurrentTimeMillis() - latestSyncMillis) / 1000.0f;
 	}
     else
     {
@@ -118,6 +284,18 @@ double SyncStream::getLatestSyncTime()
 	}
 }
 
+SyncAccuracy SyncStream::getAccuracyStatistics()
+{
+    SyncAccuracy accuracy;
+
+    accuracy.latestErrorMs = getSyncAccuracy();
+    accuracy.rmsErrorMs = clockFit.getResidualRms() * 1000;
+    accuracy.numPulses = clockFit.size();
+    accuracy.modelVersion = modelVersion;
+
+    return accuracy;
+}
+
 double SyncStream::getSyncAccuracy()
 {
     if (pulses.size() > 0)
@@ -133,9 +311,9 @@ double SyncStream::getSyncAccuracy()
         //double estimatedGlobalTime = latestSyncSampleNumber / actualSampleRate + globalStartTime;
 
         // NEW CALCULATION:
-        double estimatedGlobalTime = double(latestSyncSampleNumber - baselineMatchingPulse.localSampleNumber)
+        double estimatedGlobalTime = double(latestSyncSampleNumber - modelSampleNumber)
                                          / actualSampleRate
-                                     + (baselineMatchingPulse.globalTimestamp);
+                                     + modelTimestamp;
         //LOGD ("estimatedGlobalTime: ", estimatedGlobalTime);
         //LOGD ("difference: ", latestGlobalSyncTime - estimatedGlobalTime);
 
@@ -158,169 +336,109 @@ void SyncStream::syncWith (const SyncStream* mainStream)
         return;
     }
 
-    int localIndex = 0;
-    bool foundMatchingPulse = false;
+    // pulses up to the latest matching pulse have already been compared,
+    // so only the pulses received since then are checked
+    const int numNewPulses = int (jmin (int64 (pulses.size()), pulses.getTotalPulses() - 1 - latestMatchedPulse));
 
-    for (auto& pulse : pulses) // loop through pulses in this stream
+    for (int localIndex = 0; localIndex < numNewPulses; localIndex++) // loop through new pulses in this stream
     {
-        if (pulse.complete)
+        SyncPulse& pulse = pulses[localIndex];
+
+        if (! pulse.complete)
+            continue;
+
+        for (int index = 0; index < mainStream->pulses.size(); index++) // loop through pulses in main stream
         {
-            int index = 0;
+            const SyncPulse& mainPulse = mainStream->pulses[index];
+
+            // main pulses are in reverse order of arrival, so none of the remaining ones can match
+            if (mainPulse.computerTimeMillis <= pulse.computerTimeMillis - MAX_TIME_DIFFERENCE_MS)
+                break;
 
-            for (auto& mainPulse : mainStream->pulses) // loop through pulses in main stream
+            if (mainPulse.complete && comparePulses (pulse, mainPulse)) // putative match
             {
-                if (mainPulse.complete)
+                if (pulses.size() > localIndex + 3 && mainStream->pulses.size() > index + 3)
                 {
-                    if (comparePulses (pulse, mainPulse)) // putative match
+                    // previous three pulses also match
+                    if (comparePulses (pulses[localIndex + 1], mainStream->pulses[index + 1])
+                        && comparePulses (pulses[localIndex + 2], mainStream->pulses[index + 2])
+                        && comparePulses (pulses[localIndex + 3], mainStream->pulses[index + 3]))
                     {
-                        if (pulses.size() > localIndex + 3 && mainStream->pulses.size() > index + 3)
-                        {
-                            // previous three pulses also match
-                            if (comparePulses (pulses[localIndex + 1], mainStream->pulses[index + 1])
-                                && comparePulses (pulses[localIndex + 2], mainStream->pulses[index + 2])
-                                && comparePulses (pulses[localIndex + 3], mainStream->pulses[index + 3]))
-                            {
-                                pulse.matchingPulseIndex = index;
-                                pulse.globalTimestamp = mainPulse.localTimestamp;
-                                latestSyncSampleNumber = pulse.localSampleNumber;
-                                latestGlobalSyncTime = pulse.globalTimestamp;
-                                latestSyncMillis = pulse.computerTimeMillis;
-                                //LOGD ("Pulse at ", pulse.localTimestamp, " matches with 4 main pulses at ", index);
-                                //LOGD ("latestSyncSampleNumber: ", latestSyncSampleNumber, ", latestGlobalSyncTime: ", latestGlobalSyncTime);
-
-
-                                if (baselineMatchingPulse.complete == false)
-                                {
-                                    baselineMatchingPulse.localTimestamp = pulse.localTimestamp;
-                                    baselineMatchingPulse.globalTimestamp = mainPulse.localTimestamp;
-                                    baselineMatchingPulse.localSampleNumber = pulse.localSampleNumber;
-                                    baselineMatchingPulse.complete = true;
-                                    //LOGC ("Time of first matching pulse: ", baselineMatchingPulse.localTimestamp, " (local), ", baselineMatchingPulse.globalTimestamp, " (global)");
-                                }
-                                else
-                                {
-                                    if (pulse.localTimestamp - baselineMatchingPulse.localTimestamp > INITIAL_SAMPLE_RATE_UPDATE_INTERVAL_S)
-                                    {
-
-                                        if (nextMatchingPulse.complete == false)
-                                        {
-											nextMatchingPulse.localTimestamp = pulse.localTimestamp;
-											nextMatchingPulse.globalTimestamp = mainPulse.localTimestamp;
-											nextMatchingPulse.localSampleNumber = pulse.localSampleNumber;
-											nextMatchingPulse.complete = true;
-										}
-                                        else
-                                        {
-                                            if (pulse.localTimestamp - nextMatchingPulse.localTimestamp > SAMPLE_RATE_UPDATE_INTERVAL_S)
-                                            {
-
-                                                double estimatedActualSampleRate = double (nextMatchingPulse.localSampleNumber - baselineMatchingPulse.localSampleNumber)
-                                                                                   / double (nextMatchingPulse.globalTimestamp - baselineMatchingPulse.globalTimestamp);
-
-                                                if (std::abs (estimatedActualSampleRate - expectedSampleRate) / expectedSampleRate < 0.01)
-                                                {
-                                                    actualSampleRate = estimatedActualSampleRate;
-                                                }
-
-                                                //baselineMatchingPulse = nextMatchingPulse;
-
-                                                //LOGD ("Time of new matching pulse: ",
-                                                 //     nextMatchingPulse.localTimestamp,
-                                                  //    " (local), ",
-                                                  //    nextMatchingPulse.globalTimestamp,
-                                                  //    " (global)");
-
-                                                double estimatedPulseTime = synchronizer->convertSampleNumberToTimestamp (streamKey, nextMatchingPulse.localSampleNumber);
-                                                //LOGD ("pulses[localIndex].estimatedPulseTime: ", estimatedPulseTime);
-
-                                                nextMatchingPulse.localTimestamp = pulse.localTimestamp;
-                                                nextMatchingPulse.globalTimestamp = mainPulse.localTimestamp;
-                                                nextMatchingPulse.localSampleNumber = pulse.localSampleNumber;
-                                            }
-											
-										}
-                                        
-
-                                    }
-                                }
-                                
-                            }
-                        }
-
-                        break;
+                        pulse.matchingPulseIndex = index;
+                        pulse.globalTimestamp = mainPulse.localTimestamp;
+                        latestMatchedPulse = pulses.getTotalPulses() - 1 - localIndex;
+                        latestSyncSampleNumber = pulse.localSampleNumber;
+                        latestGlobalSyncTime = pulse.globalTimestamp;
+                        latestSyncMillis = pulse.computerTimeMillis;
+                        //LOGD ("Pulse at ", pulse.localTimestamp, " matches with 4 main pulses at ", index);
+
+                        addMatchingPulse (pulse);
+
+                        return;
                     }
                 }
 
-                index++;
+                break;
             }
         }
-
-        if (pulse.matchingPulseIndex != -1)
-        {
-            foundMatchingPulse = true;
-            break;
-        }
-
-        localIndex++;
     }
+}
 
-    if (foundMatchingPulse)
+void SyncStream::addMatchingPulse (const SyncPulse& pulse)
+{
+    if (clockFit.size() >= MIN_PULSES_FOR_OUTLIER_REJECTION)
     {
-        if (baselineMatchingPulse.complete && (pulses[localIndex].localTimestamp - baselineMatchingPulse.localTimestamp) > 1.0)
-        {
-            //LOGD ("pulses[localIndex].localSampleNumber: ", pulses[localIndex].localSampleNumber, ", baselineMatchingPulse.localSampleNumber: ", baselineMatchingPulse.localSampleNumber);
-            //LOGD ("pulses[localIndex].localTimestamp: ", pulses[localIndex].localTimestamp, ", baselineMatchingPulse.localTimestamp: ", baselineMatchingPulse.localTimestamp);
-            //LOGD ("pulses[localIndex].globalTimestamp: ", pulses[localIndex].globalTimestamp, ", baselineMatchingPulse.globalTimestamp: ", baselineMatchingPulse.globalTimestamp);
+        const double residual = pulse.globalTimestamp - clockFit.getTimestamp (pulse.localSampleNumber);
 
-            double estimatedActualSampleRate = double(pulses[localIndex].localSampleNumber - baselineMatchingPulse.localSampleNumber) 
-                / double(pulses[localIndex].globalTimestamp - baselineMatchingPulse.globalTimestamp);
+        if (std::abs (residual) * 1000 > MAX_RESIDUAL_MS)
+        {
+            //LOGD ("Pulse at ", pulse.localTimestamp, " is ", residual * 1000, " ms from the fitted clock.");
 
-            //LOGC (streamKey, " actualSampleRate: ", actualSampleRate, ", estimatedActualSampleRate: ", estimatedActualSampleRate);
+            // several outliers in a row mean that the clock itself has changed
+            if (++consecutiveOutliers < MAX_CONSECUTIVE_OUTLIERS)
+                return;
 
-            double estimatedGlobalStartTime = pulses[localIndex].globalTimestamp 
-                - double (pulses[localIndex].localSampleNumber) / estimatedActualSampleRate;
+            clockFit.clear();
+        }
+    }
 
-            double estimatedPulseTime = synchronizer->convertSampleNumberToTimestamp(streamKey, pulses[localIndex].localSampleNumber);
-            //LOGC (streamKey, " estimatedPulseTime: ", estimatedPulseTime);
-            //LOGC (streamKey, " diff from global time: ", estimatedPulseTime - pulses[localIndex].globalTimestamp);
+    consecutiveOutliers = 0;
+    clockFit.add (pulse.localSampleNumber, pulse.globalTimestamp);
 
-            if (std::abs (estimatedActualSampleRate - expectedSampleRate) / expectedSampleRate < 0.05)
-            {
-                if (actualSampleRate == -1.0)
-                {
-                    actualSampleRate = estimatedActualSampleRate;
+    if (clockFit.size() < 2 || clockFit.getTimeSpan() <= 1.0)
+    {
+        //LOGD ("At least 1 second must elapse before synchronization can be attempted.");
+        return;
+    }
 
-                    if (std::abs (estimatedGlobalStartTime) < 1.0)
-                    {
-                        if (! isSynchronized)
+    const double estimatedActualSampleRate = 1.0 / clockFit.getSlope();
 
-                        {
-                            globalStartTime = estimatedGlobalStartTime;
-                            isSynchronized = true;
-                        }
-                    }
-                    else
-                    {
-                        //LOGD ("Estimated global start time of ", estimatedGlobalStartTime, " is out of bounds. Ignoring.");
-                    }
-                }
+    if (std::abs (estimatedActualSampleRate - expectedSampleRate) / expectedSampleRate >= 0.05)
+    {
+        //LOGD ("Estimated sample rate of ", estimatedActualSampleRate, " is out of bounds. Expected sample rate = ", expectedSampleRate);
+        return;
+    }
 
-            }
-            else
-            {
-                //LOGD ("Estimated sample rate of ", estimatedActualSampleRate, " is out of bounds. Expected sample rate = ", expectedSampleRate);
-                return;
-            }
+    if (! isSynchronized)
+    {
+        const double estimatedGlobalStartTime = clockFit.getTimestamp (0);
 
-            //LOGD ("Stream ", streamKey, " synchronized with main stream. Sample rate: ", actualSampleRate, ", start time: ", globalStartTime);
-        }
-        else
+        if (std::abs (estimatedGlobalStartTime) >= 1.0)
         {
-            //LOGD ("At least 1 second must elapse before synchronization can be attempted.");
+            //LOGD ("Estimated global start time of ", estimatedGlobalStartTime, " is out of bounds. Ignoring.");
+            return;
         }
+
+        globalStartTime = estimatedGlobalStartTime;
+        isSynchronized = true;
     }
 
-    
+    actualSampleRate = estimatedActualSampleRate;
+    modelSampleNumber = clockFit.getCenterSampleNumber();
+    modelTimestamp = clockFit.getTimestamp (modelSampleNumber);
+    modelVersion++;
+
+    //LOGD ("Stream ", streamKey, " synchronized with main stream. Sample rate: ", actualSampleRate, ", start time: ", globalStartTime);
 }
 
 bool SyncStream::comparePulses (const SyncPulse& pulse1, const SyncPulse& pulse2)
@@ -345,18 +463,46 @@ Synchronizer::Synchronizer()
 {
 }
 
+SyncStream* Synchronizer::getStream (int streamHandle) const
+{
+    if (streamHandle < 0 || streamHandle >= dataStreamObjects.size())
+        return nullptr;
+
+    return dataStreamObjects.getUnchecked (streamHandle);
+}
+
+int Synchronizer::getStreamHandle (String streamKey) const
+{
+    auto it = streamHandles.find (streamKey);
+
+    if (it == streamHandles.end())
+        return -1;
+
+    return it->second;
+}
+
 void Synchronizer::reset()
 {
-    for (auto [id, stream] : streams)
+    const ScopedLock sl (synchronizerLock);
+
+    // events received before the reset belong to the previous pulses
+    eventFifo.finishedRead (eventFifo.getNumReady());
+
+    mainStreamHandle = getStreamHandle (mainStreamKey);
+
+    for (auto stream : dataStreamObjects)
         stream->reset (mainStreamKey);
 }
 
 void Synchronizer::prepareForUpdate()
 {
+    const ScopedLock sl (synchronizerLock);
+
     previousMainStreamKey = mainStreamKey;
     mainStreamKey = String();
+    mainStreamHandle = -1;
     dataStreamObjects.clear();
-    streams.clear();
+    streamHandles.clear();
     streamCount = 0;
 }
 
@@ -367,7 +513,7 @@ void Synchronizer::finishedUpdate()
         // if no main stream is set, set the first non-hardware-synced stream as the main stream
         for (auto stream : dataStreamObjects)
         {
-            if (! streamGeneratesTimestamps (stream->streamKey))
+            if (! (stream->generatesTimestamps && ! stream->overrideHardwareTimestamps))
             {
                 mainStreamKey = stream->streamKey;
                 LOGD ("No main stream set, setting ", mainStreamKey, " as the main stream");
@@ -379,28 +525,31 @@ void Synchronizer::finishedUpdate()
     reset();
 }
 
-void Synchronizer::addDataStream (String streamKey, float expectedSampleRate, int syncLine, bool generatesTimestamps)
+int Synchronizer::addDataStream (String streamKey, float expectedSampleRate, int syncLine, bool generatesTimestamps)
 {
     LOGD ("Synchronizer adding ", streamKey, " with sample rate ", expectedSampleRate);
 
-    //std::cout << "Main stream ID: " << mainStreamId << std::endl;
+    const ScopedLock sl (synchronizerLock);
 
     // if there's a stored value, and it appears again,
     // re-instantiate this as the main stream
     if (streamKey == previousMainStreamKey)
         mainStreamKey = previousMainStreamKey;
 
-    //std::cout << "Creating new Stream object" << std::endl;
-    dataStreamObjects.add (new SyncStream (streamKey, expectedSampleRate, this, generatesTimestamps));
-    streams[streamKey] = dataStreamObjects.getLast();
-    streams[streamKey]->syncLine = syncLine;
+    SyncStream* stream = dataStreamObjects.add (new SyncStream (streamKey, expectedSampleRate, this, generatesTimestamps));
+    stream->syncLine = syncLine;
+
+    const int streamHandle = dataStreamObjects.size() - 1;
+    streamHandles[streamKey] = streamHandle;
 
     streamCount++;
+
+    return streamHandle;
 }
 
 void Synchronizer::setMainDataStream (String streamKey)
 {
-    if (streamKey.isNotEmpty() && streams.count (streamKey) == 0)
+    if (streamKey.isNotEmpty() && streamHandles.count (streamKey) == 0)
     {
         LOGD ("Cannot set ", streamKey, " as main data stream. Stream not found.");
         return;
@@ -412,17 +561,37 @@ void Synchronizer::setMainDataStream (String streamKey)
 
 void Synchronizer::setSyncLine (String streamKey, int ttlLine)
 {
-    streams[streamKey]->syncLine = ttlLine;
+    SyncStream* stream = getStream (getStreamHandle (streamKey));
+
+    if (stream == nullptr)
+        return;
+
+    stream->syncLine = ttlLine;
 
     if (streamKey == mainStreamKey)
+    {
         reset();
+    }
     else
-        streams[streamKey]->reset (mainStreamKey);
+    {
+        const ScopedLock sl (synchronizerLock);
+        stream->reset (mainStreamKey);
+    }
 }
 
 int Synchronizer::getSyncLine (String streamKey)
 {
-    return streams[streamKey]->syncLine;
+    return getSyncLine (getStreamHandle (streamKey));
+}
+
+int Synchronizer::getSyncLine (int streamHandle) const
+{
+    SyncStream* stream = getStream (streamHandle);
+
+    if (stream == nullptr)
+        return -1;
+
+    return stream->syncLine;
 }
 
 void Synchronizer::startAcquisition()
@@ -446,24 +615,73 @@ void Synchronizer::addEvent (String streamKey,
                              int64 sampleNumber,
                              bool state)
 {
-    const ScopedLock sl (synchronizerLock);
+    addEvent (getStreamHandle (streamKey), ttlLine, sampleNumber, state);
+}
 
+// called on the audio thread; the event is passed to the timer thread
+void Synchronizer::addEvent (int streamHandle,
+                             int ttlLine,
+                             int64 sampleNumber,
+                             bool state)
+{
     if (streamCount == 1 || sampleNumber < 1000)
         return;
 
-    if (streams[streamKey]->syncLine == ttlLine)
+    SyncStream* stream = getStream (streamHandle);
+
+    if (stream == nullptr || stream->syncLine != ttlLine)
+        return;
+
+    int start1, size1, start2, size2;
+    eventFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    // if the timer thread falls behind, new events are dropped
+    if (size1 == 0)
+        return;
+
+    SyncEvent& event = pendingEvents[size_t (start1)];
+    event.streamHandle = streamHandle;
+    event.sampleNumber = sampleNumber;
+    event.state = state;
+    event.computerTimeMillis = timeSource();
+
+    eventFifo.finishedWrite (1);
+}
+
+void Synchronizer::processPendingEvents()
+{
+    int start1, size1, start2, size2;
+    eventFifo.prepareToRead (eventFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1 + size2; i++)
     {
-        streams[streamKey]->addEvent (sampleNumber, state);
+        const SyncEvent& event = pendingEvents[size_t (i < size1 ? start1 + i : start2 + i - size1)];
+
+        if (SyncStream* stream = getStream (event.streamHandle))
+            stream->addEvent (event.sampleNumber, event.state, event.computerTimeMillis);
     }
+
+    eventFifo.finishedRead (size1 + size2);
 }
 
 double Synchronizer::convertSampleNumberToTimestamp (String streamKey, int64 sampleNumber)
 {
-    if (streams[streamKey]->isSynchronized)
+    return convertSampleNumberToTimestamp (getStreamHandle (streamKey), sampleNumber);
+}
+
+double Synchronizer::convertSampleNumberToTimestamp (int streamHandle, int64 sampleNumber) const
+{
+    SyncStream* stream = getStream (streamHandle);
+
+    if (stream == nullptr)
+        return (double) -1.0f;
+
+    const SyncClock clock = stream->getClock();
+
+    if (clock.isSynchronized)
     {
-        return double(sampleNumber - streams[streamKey]->baselineMatchingPulse.localSampleNumber) 
-            / streams[streamKey]->actualSampleRate 
-            + streams[streamKey]->baselineMatchingPulse.globalTimestamp;
+        return double (sampleNumber - clock.baselineSampleNumber) / clock.sampleRate
+               + clock.baselineTimestamp;
     }
     else
     {
@@ -473,11 +691,22 @@ double Synchronizer::convertSampleNumberToTimestamp (String streamKey, int64 sam
 
 int64 Synchronizer::convertTimestampToSampleNumber (String streamKey, double timestamp)
 {
-    if (streams[streamKey]->isSynchronized)
+    return convertTimestampToSampleNumber (getStreamHandle (streamKey), timestamp);
+}
+
+int64 Synchronizer::convertTimestampToSampleNumber (int streamHandle, double timestamp) const
+{
+    SyncStream* stream = getStream (streamHandle);
+
+    if (stream == nullptr)
+        return -1;
+
+    const SyncClock clock = stream->getClock();
+
+    if (clock.isSynchronized)
     {
-        int64 t = int64 ((timestamp - streams[streamKey]->baselineMatchingPulse.globalTimestamp) 
-            * streams[streamKey]->actualSampleRate)
-                  + streams[streamKey]->baselineMatchingPulse.localSampleNumber;
+        int64 t = int64 ((timestamp - clock.baselineTimestamp) * clock.sampleRate)
+                  + clock.baselineSampleNumber;
 
         return t;
     }
@@ -489,18 +718,35 @@ int64 Synchronizer::convertTimestampToSampleNumber (String streamKey, double tim
 
 double Synchronizer::getStartTime (String streamKey)
 {
-	return streams[streamKey]->globalStartTime * 1000;
+    const ScopedLock sl (synchronizerLock);
+
+    SyncStream* stream = getStream (getStreamHandle (streamKey));
+
+    if (stream == nullptr)
+        return 0.0;
+
+    return stream->globalStartTime * 1000;
 }
 
 double Synchronizer::getLastSyncEvent (String streamKey)
 {
-    return streams[streamKey]->getLatestSyncTime();
+    const ScopedLock sl (synchronizerLock);
+
+    SyncStream* stream = getStream (getStreamHandle (streamKey));
+
+    if (stream == nullptr)
+        return -1.0;
+
+    return stream->getLatestSyncTime();
 }
 
 double Synchronizer::getAccuracy (String streamKey)
 {
+    const ScopedLock sl (synchronizerLock);
 
-    if(! streams[streamKey]->isSynchronized)
+    SyncStream* stream = getStream (getStreamHandle (streamKey));
+
+    if (stream == nullptr || ! stream->isSynchronized)
 		return 0.0;
     else
     {
@@ -508,24 +754,63 @@ double Synchronizer::getAccuracy (String streamKey)
 			return 0.0;
         else
         {
-            return streams[streamKey]->getSyncAccuracy();
+            return stream->getSyncAccuracy();
         }
         
     }
 
 }
 
+SyncAccuracy Synchronizer::getAccuracyStatistics (String streamKey)
+{
+    const ScopedLock sl (synchronizerLock);
+
+    SyncStream* stream = getStream (getStreamHandle (streamKey));
+
+    if (stream == nullptr || ! stream->isSynchronized || streamKey == mainStreamKey)
+        return SyncAccuracy();
+
+    return stream->getAccuracyStatistics();
+}
+
+SyncClock Synchronizer::getClock (int streamHandle) const
+{
+    SyncStream* stream = getStream (streamHandle);
+
+    if (stream == nullptr)
+        return SyncClock();
+
+    return stream->getClock();
+}
+
 bool Synchronizer::isStreamSynced (String streamKey)
 {
-    return streams[streamKey]->isSynchronized;
+    return isStreamSynced (getStreamHandle (streamKey));
+}
+
+bool Synchronizer::isStreamSynced (int streamHandle) const
+{
+    SyncStream* stream = getStream (streamHandle);
+
+    if (stream == nullptr)
+        return false;
+
+    return stream->getClock().isSynchronized;
 }
 
 bool Synchronizer::streamGeneratesTimestamps (String streamKey)
 {
-    if (streams.count (streamKey) == 0)
+    return streamGeneratesTimestamps (getStreamHandle (streamKey));
+}
+
+bool Synchronizer::streamGeneratesTimestamps (int streamHandle) const
+{
+    SyncStream* stream = getStream (streamHandle);
+
+    if (stream == nullptr)
         return false;
 
-    return streams[streamKey]->generatesTimestamps && ! streams[streamKey]->overrideHardwareTimestamps;
+    return stream->getClock().generatesTimestamps;
 }
 
 SyncStatus Synchronizer::getStatus (String streamKey)
@@ -542,18 +827,37 @@ SyncStatus Synchronizer::getStatus (String streamKey)
         return SyncStatus::SYNCING;
 }
 
+void Synchronizer::setTimeSource (TimeSource newTimeSource)
+{
+    jassert (! acquisitionIsActive);
+
+    timeSource = newTimeSource;
+}
+
 void Synchronizer::hiResTimerCallback()
 {
-    if (mainStreamKey.isEmpty())
-        return;
+    update();
+}
 
+void Synchronizer::update()
+{
     const ScopedLock sl (synchronizerLock);
 
-    for (auto [key, stream] : streams)
+    processPendingEvents();
+
+    SyncStream* mainStream = getStream (mainStreamHandle);
+
+    if (mainStream == nullptr)
+        return;
+
+    for (int streamHandle = 0; streamHandle < dataStreamObjects.size(); streamHandle++)
     {
-        if (key != mainStreamKey && ! streamGeneratesTimestamps (key))
+        SyncStream* stream = dataStreamObjects.getUnchecked (streamHandle);
+
+        if (streamHandle != mainStreamHandle && ! streamGeneratesTimestamps (streamHandle))
         {
-            stream->syncWith (streams[mainStreamKey]);
+            stream->syncWith (mainStream);
+            stream->publishClock();
         }
     }
 }
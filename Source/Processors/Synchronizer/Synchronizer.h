@@ -25,6 +25,7 @@
 #define SYNCHRONIZER_H_INCLUDED
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <map>
 #include <math.h>
@@ -70,6 +71,210 @@ struct SyncPulse
     double globalTimestamp = 0.0;
 };
 
+/**
+
+    Holds the most recent sync pulses of a stream in a fixed-size ring buffer
+
+    Index 0 is the latest pulse; once the buffer is full, adding
+    a pulse overwrites the oldest one, so no memory is allocated.
+
+*/
+class SyncPulseBuffer
+{
+public:
+    /** Constructor */
+    explicit SyncPulseBuffer (int capacity);
+
+    /** Adds a new latest pulse */
+    void add (const SyncPulse& pulse);
+
+    /** Removes all pulses */
+    void clear();
+
+    /** Number of pulses in the buffer */
+    int size() const { return numPulses; }
+
+    /** Returns the latest pulse */
+    SyncPulse& front() { return (*this)[0]; }
+
+    /** Returns a pulse, counting back from the latest one */
+    SyncPulse& operator[] (int index);
+    const SyncPulse& operator[] (int index) const;
+
+    /** Total number of pulses added since the last clear() */
+    int64 getTotalPulses() const { return totalPulses; }
+
+private:
+    std::vector<SyncPulse> pulses;
+    int latestIndex = -1;
+    int numPulses = 0;
+    int64 totalPulses = 0;
+};
+
+/**
+
+    Sliding-window least-squares fit of global timestamps
+    against the sample numbers of a stream
+
+    Running means and co-moments are updated as pairs enter
+    and leave the window, so adding a pair takes constant time
+    and the fit follows slow drift of the stream's clock.
+
+*/
+class PLUGIN_API ClockFit
+{
+public:
+    /** Constructor */
+    explicit ClockFit (int windowSize);
+
+    /** Removes all pairs */
+    void clear();
+
+    /** Adds a sample number / global timestamp pair, replacing the oldest one if the window is full */
+    void add (int64 sampleNumber, double timestamp);
+
+    /** Number of pairs in the window */
+    int size() const { return numPairs; }
+
+    /** Time (in seconds) between the oldest and latest pair */
+    double getTimeSpan() const;
+
+    /** Slope of the fit, in seconds per sample */
+    double getSlope() const;
+
+    /** Returns the fitted timestamp at a sample number */
+    double getTimestamp (int64 sampleNumber) const;
+
+    /** Returns the sample number at the center of the window */
+    int64 getCenterSampleNumber() const;
+
+    /** Root-mean-square residual of the fit, in seconds */
+    double getResidualRms() const;
+
+private:
+    void remove (double x, double y);
+
+    std::vector<std::pair<double, double>> pairs;
+    int oldestIndex = 0;
+    int numPairs = 0;
+
+    /** Sample numbers are stored relative to the first pair added after clear() */
+    int64 referenceSampleNumber = 0;
+
+    double meanX = 0.0;
+    double meanY = 0.0;
+    double cxx = 0.0;
+    double cxy = 0.0;
+    double cyy = 0.0;
+};
+
+/**
+
+    The parameters used to convert a stream's sample numbers to global timestamps
+
+    timestamp = baselineTimestamp + (sampleNumber - baselineSampleNumber) / sampleRate
+
+*/
+struct SyncClock
+{
+    /** true if the stream is synchronized */
+    bool isSynchronized = false;
+
+    /** true if the stream generates its own timestamps and they are not overridden */
+    bool generatesTimestamps = false;
+
+    /** Incremented each time the clock model changes */
+    uint32 version = 0;
+
+    /** Sample number at which the model is anchored */
+    int64 baselineSampleNumber = 0;
+
+    /** Global timestamp of the baseline sample number */
+    double baselineTimestamp = 0.0;
+
+    /** Computed sample rate of the stream */
+    double sampleRate = -1.0;
+};
+
+/**
+
+    Statistics on how well a stream is synchronized
+
+*/
+struct SyncAccuracy
+{
+    /** Difference between the estimated and actual time of the latest sync pulse (ms) */
+    double latestErrorMs = 0.0;
+
+    /** Root-mean-square residual of the clock fit (ms) */
+    double rmsErrorMs = 0.0;
+
+    /** Number of sync pulses in the clock fit */
+    int numPulses = 0;
+
+    /** Version of the clock model */
+    uint32 modelVersion = 0;
+};
+
+/**
+
+    Publishes a value from one writer thread, so that other threads
+    can read it without locking (a sequence lock)
+
+    Readers retry only if the value is changed while they read it,
+    which happens at most once per sync interval here.
+
+*/
+template <typename Type>
+class SeqLock
+{
+public:
+    /** Publishes a new value; must only be called by one thread at a time */
+    void store (const Type& value)
+    {
+        uint64 words[numWords] = {};
+        memcpy (words, &value, sizeof (Type));
+
+        const uint32 seq = sequence.load (std::memory_order_relaxed);
+
+        sequence.store (seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+
+        for (int i = 0; i < numWords; i++)
+            data[i].store (words[i], std::memory_order_relaxed);
+
+        sequence.store (seq + 2, std::memory_order_release);
+    }
+
+    /** Returns the latest published value */
+    Type load() const
+    {
+        uint64 words[numWords];
+        uint32 seq0, seq1;
+
+        do
+        {
+            seq0 = sequence.load (std::memory_order_acquire);
+
+            for (int i = 0; i < numWords; i++)
+                words[i] = data[i].load (std::memory_order_relaxed);
+
+            std::atomic_thread_fence (std::memory_order_acquire);
+            seq1 = sequence.load (std::memory_order_relaxed);
+        } while ((seq0 & 1) != 0 || seq0 != seq1);
+
+        Type value;
+        memcpy (&value, words, sizeof (Type));
+        return value;
+    }
+
+private:
+    static constexpr int numWords = int ((sizeof (Type) + sizeof (uint64) - 1) / sizeof (uint64));
+
+    std::atomic<uint32> sequence { 0 };
+    std::atomic<uint64> data[numWords] {};
+};
+
 /**
  *
  * Represents an incoming data stream
@@ -87,8 +292,15 @@ public:
     /** True if this is the main stream */
     bool isMainStream;
 
-    /** Adds a sync event with a particular sample number and state*/
-    void addEvent (int64 sampleNumber, bool state);
+    /** Adds a sync event with a particular sample number and state,
+        received at a particular computer time */
+    void addEvent (int64 sampleNumber, bool state, int64 computerTimeMillis);
+
+    /** Publishes the current clock parameters to the audio thread */
+    void publishClock();
+
+    /** Returns the latest published clock parameters (wait-free) */
+    SyncClock getClock() const { return clock.load(); }
 
     /** Global start time of this stream */
     double globalStartTime;
@@ -99,6 +311,9 @@ public:
     /** Returns difference between actual and expected sync times */
     double getSyncAccuracy();
 
+    /** Returns the accuracy statistics of the clock fit */
+    SyncAccuracy getAccuracyStatistics();
+
     /** Synchronize this stream with another one */
     void syncWith (const SyncStream* mainStream);
 
@@ -129,27 +344,27 @@ public:
     /** true if the synchronizer overrides hardware timestamps */
     bool overrideHardwareTimestamps = false;
 
+    /** Determines the maximum size of the sync pulse buffer */
+    const int MAX_PULSES_IN_BUFFER = 10;
+
     /** The sync pulses for this stream 
     
-    The latest pulse is added to the beginning of the vector
-    Expired pulses are removed from the end
+    The latest pulse is at index 0
+    Expired pulses are overwritten
     */
-	std::vector<SyncPulse> pulses;
-
-    /** Baseline matching the global stream */
-    SyncPulse baselineMatchingPulse;
+    SyncPulseBuffer pulses { MAX_PULSES_IN_BUFFER };
 
-    /** Next pulse to become the baseline matching pulse */
-    SyncPulse nextMatchingPulse;
+    /** Number of matching pulses used to fit the clock model */
+    const int MAX_PULSES_IN_FIT = 120;
 
-    /** Time interval (in seconds) for updating initial sample rate estimate */
-    const float INITIAL_SAMPLE_RATE_UPDATE_INTERVAL_S = 5;
+    /** Pulses that differ from the fitted clock by more than this are treated as outliers */
+    const double MAX_RESIDUAL_MS = 5;
 
-    /** Time interval (in seconds) for subsequent updating sample rate estimate */
-    const float SAMPLE_RATE_UPDATE_INTERVAL_S = 10;
+    /** Consecutive outliers after which the clock is assumed to have changed, and the fit restarts */
+    const int MAX_CONSECUTIVE_OUTLIERS = 3;
 
-    /** Determines the maximum size of the sync pulse buffer */
-    const int MAX_PULSES_IN_BUFFER = 10;
+    /** Minimum number of matching pulses before outliers are rejected */
+    const int MIN_PULSES_FOR_OUTLIER_REJECTION = 4;
 
     /** Threshold for calling pulses synchronous */
     const int MAX_TIME_DIFFERENCE_MS = 85;
@@ -166,6 +381,24 @@ private:
     double latestGlobalSyncTime = 0.0;
     int64 latestSyncMillis = -1;
 
+    /** Number of pulses added before the latest matching pulse (-1 if none);
+        earlier pulses are not compared again */
+    int64 latestMatchedPulse = -1;
+
+    /** Adds a pulse matched with the main stream to the clock fit, and updates the clock model */
+    void addMatchingPulse (const SyncPulse& pulse);
+
+    /** Fit of global timestamps against the sample numbers of matching pulses */
+    ClockFit clockFit { MAX_PULSES_IN_FIT };
+    int consecutiveOutliers = 0;
+
+    /** The clock model: timestamp = modelTimestamp + (sampleNumber - modelSampleNumber) / actualSampleRate */
+    int64 modelSampleNumber = 0;
+    double modelTimestamp = 0.0;
+    uint32 modelVersion = 0;
+
+    SeqLock<SyncClock> clock;
+
     Synchronizer* synchronizer;
 };
 
@@ -193,6 +426,14 @@ enum PLUGIN_API SyncStatus
     interval (e.g. 1 Hz). This interval does not have
     to be regular, however.
 
+    Streams can be referred to by key, or by the integer
+    handle returned by addDataStream(), which is valid until
+    the next call to prepareForUpdate(). The functions that
+    take a handle are safe to call from the audio thread:
+    sync events are passed to the timer thread through a
+    lock-free FIFO, and clock parameters are read without
+    locking.
+
 */
 class PLUGIN_API Synchronizer : public HighResolutionTimer
 {
@@ -201,13 +442,21 @@ public:
     Synchronizer();
 
     /** Destructor */
-    ~Synchronizer() {}
+    ~Synchronizer() { stopTimer(); }
 
     /** Converts an int64 sample number to a double timestamp */
     double convertSampleNumberToTimestamp (String streamKey, int64 sampleNumber);
+    double convertSampleNumberToTimestamp (int streamHandle, int64 sampleNumber) const;
 
     /** Converts a double timestamp to an int64 sample number */
     int64 convertTimestampToSampleNumber (String streamKey, double timestamp);
+    int64 convertTimestampToSampleNumber (int streamHandle, double timestamp) const;
+
+    /** Returns the handle of a stream, or -1 if it does not exist */
+    int getStreamHandle (String streamKey) const;
+
+    /** Returns the handle of the main stream, or -1 if there is none */
+    int getMainStreamHandle() const { return mainStreamHandle; }
 
     /** Returns offset (relative start time) for stream in ms */
     double getStartTime (String streamKey);
@@ -218,14 +467,21 @@ public:
     /** Get the accuracy of synchronization (difference between expected and actual event time) */
     double getAccuracy (String streamKey);
 
+    /** Get the accuracy statistics of the clock fit for a stream */
+    SyncAccuracy getAccuracyStatistics (String streamKey);
+
+    /** Returns the latest clock model of a stream (wait-free) */
+    SyncClock getClock (int streamHandle) const;
+
     /** Resets all values when acquisition is re-started */
     void reset();
 
     /** Sets main stream ID to 0 and stream count to 0*/
     void prepareForUpdate();
 
-    /** Adds a new data stream with an expected sample rate, a synchronization line, and a flag indicating whether it generates its own timestamps */
-    void addDataStream (String streamKey, float expectedSampleRate, int synLine = 0, bool generatesTimestamps = false);
+    /** Adds a new data stream with an expected sample rate, a synchronization line, and a flag indicating whether it generates its own timestamps;
+        returns the stream's handle */
+    int addDataStream (String streamKey, float expectedSampleRate, int synLine = 0, bool generatesTimestamps = false);
 
     /** Checks if there is only one stream */
     void finishedUpdate();
@@ -238,22 +494,40 @@ public:
 
     /** Returns the TTL line to use for synchronization (0-based indexing)*/
     int getSyncLine (String streamKey);
+    int getSyncLine (int streamHandle) const;
 
     /** Returns true if a stream is synchronized */
     bool isStreamSynced (String streamKey);
+    bool isStreamSynced (int streamHandle) const;
 
     /** Returns true if the stream genrates its own timestamps and overriding hardware timestamps is disabled */
     bool streamGeneratesTimestamps (String streamKey);
+    bool streamGeneratesTimestamps (int streamHandle) const;
 
     /** Returns the status (OFF / SYNCING / SYNCED) of a given stream*/
     SyncStatus getStatus (String streamKey);
 
     /** Adds an event for a stream ID / line combination */
     void addEvent (String streamKey, int ttlLine, int64 sampleNumber, bool state);
+    void addEvent (int streamHandle, int ttlLine, int64 sampleNumber, bool state);
 
     /** Signals start of acquisition */
     void startAcquisition();
 
+    /** A function that returns the computer time in milliseconds */
+    using TimeSource = int64 (*)();
+
+    /** Sets the clock used to time the arrival of sync events (Time::currentTimeMillis() by default);
+        must not be changed while acquisition is active */
+    void setTimeSource (TimeSource timeSource);
+
+    /** Returns the current time of the clock used to time sync events, in milliseconds */
+    int64 getCurrentTimeMillis() const { return timeSource(); }
+
+    /** Passes pending sync events to their streams and updates the clock models; called
+        by the timer once per second while acquisition is active */
+    void update();
+
     /** Signals start of acquisition */
     void stopAcquisition();
 
@@ -264,16 +538,42 @@ public:
     int streamCount = 0;
 
 private:
+    /** A sync event on its way from the audio thread to the timer thread */
+    struct SyncEvent
+    {
+        int streamHandle;
+        int64 sampleNumber;
+        bool state;
+        int64 computerTimeMillis;
+    };
+
+    /** Maximum number of sync events waiting for the timer thread */
+    static const int MAX_PENDING_EVENTS = 1024;
+
     int eventCount = 0;
     bool acquisitionIsActive = false;
 
+    TimeSource timeSource = &Time::currentTimeMillis;
+
     void hiResTimerCallback();
 
+    /** Passes pending sync events to their streams; called with the lock held */
+    void processPendingEvents();
+
+    /** Returns the stream for a handle, or nullptr */
+    SyncStream* getStream (int streamHandle) const;
+
+    /** Protects stream state on the message and timer threads; never taken on the audio thread */
     CriticalSection synchronizerLock;
 
-    std::map<String, SyncStream*> streams;
+    std::map<String, int> streamHandles;
     OwnedArray<SyncStream> dataStreamObjects;
 
+    std::atomic<int> mainStreamHandle { -1 };
+
+    AbstractFifo eventFifo { MAX_PENDING_EVENTS };
+    std::vector<SyncEvent> pendingEvents { MAX_PENDING_EVENTS };
+
 };
 
 /**
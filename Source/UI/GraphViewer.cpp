@@ -74,6 +74,8 @@ GraphViewer::GraphViewer()
 {
     setBufferedToImage (true);
     graphViewport = std::make_unique<GraphViewport> (this);
+
+    startTimer (500);
 }
 
 void GraphViewer::updateBoundaries()
@@ -503,6 +505,15 @@ void GraphViewer::loadStateFromXml (XmlElement* xml)
     }
 }
 
+void GraphViewer::timerCallback()
+{
+    if (! CoreServices::getAcquisitionStatus())
+        return;
+
+    for (auto node : availableNodes)
+        node->updateProfile();
+}
+
 /// ------------------------------------------------------
 
 DataStreamInfo::DataStreamInfo (DataStream* stream_, GenericEditor* editor, GraphNode* node_)
@@ -768,7 +779,7 @@ void DataStreamButton::paintButton (Graphics& g, bool isHighlighted, bool isDown
 /// ------------------------------------------------------
 
 GraphNode::GraphNode (GenericEditor* ed, GraphViewer* g)
-    : editor (ed), processor (ed->getProcessor()), gv (g), isMouseOver (false), stillNeeded (true), nodeWidth (NODE_WIDTH)
+    : editor (ed), processor (ed->getProcessor()), gv (g), isMouseOver (false), stillNeeded (true), nodeWidth (NODE_WIDTH), hasOverruns (false)
 {
     nodeId = processor->getNodeId();
     horzShift = 0;
@@ -1158,6 +1169,24 @@ void GraphNode::restorePanels()
         info->restorePanels();
 }
 
+void GraphNode::updateProfile()
+{
+    if (processor->isEmpty())
+        return;
+
+    const ProcessorProfiler::Statistics statistics = processor->getProfiler().getStatistics();
+
+    const String newText = statistics.numBlocks > 0 ? String (statistics.p99Ms, 2) + " ms" : String();
+    const bool newOverruns = statistics.numOverruns > 0;
+
+    if (newText != profileText || newOverruns != hasOverruns)
+    {
+        profileText = newText;
+        hasOverruns = newOverruns;
+        repaint (0, 0, getWidth(), 20);
+    }
+}
+
 void GraphNode::verticalShift (int pixels)
 {
     setBounds (getX(), getY() + pixels, getWidth(), getHeight());
@@ -1236,9 +1265,20 @@ void GraphNode::paint (Graphics& g)
 
         g.setColour (findColour (ThemeColours::defaultText));
         g.drawText (String (nodeId), 1, 1, 23, 20, Justification::centred, true);
+        int profileWidth = 0;
+
+        if (profileText.isNotEmpty())
+        {
+            // 99th percentile of the block execution time, in red once a block has overrun the audio callback
+            g.setFont (FontOptions ("Fira Code", "Regular", 11.0f));
+            profileWidth = 65;
+            g.setColour (hasOverruns ? Colours::red : Colours::white.withAlpha (0.7f));
+            g.drawText (profileText, getWidth() - profileWidth - 5, 1, profileWidth, 20, Justification::right, true);
+        }
+
         g.setColour (Colours::white);
         g.setFont (nodeNameFont);
-        g.drawText (getName().toUpperCase(), 30, 1, getWidth() - 30, 20, Justification::left, true);
+        g.drawText (getName().toUpperCase(), 30, 1, getWidth() - 30 - profileWidth, 20, Justification::left, true);
     }
 }
 
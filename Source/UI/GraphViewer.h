@@ -250,6 +250,9 @@ public:
     /** Restores panel states */
     void restorePanels();
 
+    /** Updates the execution time shown in the header, repainting if it has changed */
+    void updateProfile();
+
     /** True if processor still exists */
     bool stillNeeded;
 
@@ -291,6 +294,9 @@ private:
     int verticalOffset;
 
     FontOptions nodeNameFont;
+
+    String profileText;
+    bool hasOverruns;
 };
 
 /**
@@ -336,14 +342,15 @@ private:
 @see UIComponent, DataViewport, ProcessorGraph, EditorViewport
 
 */
-class GraphViewer : public Component
+class GraphViewer : public Component,
+                    public Timer
 {
 public:
     /** Constructor */
     GraphViewer();
 
     /** Destructor */
-    ~GraphViewer() {}
+    ~GraphViewer() { stopTimer(); }
 
     /** Draws the GraphViewer.*/
     void paint (Graphics& g) override;
@@ -388,6 +395,9 @@ public:
     /** Load settings. */
     void loadStateFromXml (XmlElement*);
 
+    /** Updates the execution times shown by each node during acquisition */
+    void timerCallback() override;
+
 private:
     void connectNodes (int, int, Graphics&);
 
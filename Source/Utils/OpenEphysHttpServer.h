@@ -53,15 +53,28 @@ using json = nlohmann::json;
  *          returns an XML string with the current configuration of the GUI
  *
  * - GET /api/status : 
- *          returns a JSON string with the GUI's current mode (IDLE, ACQUIRE, RECORD)
+ *          returns a JSON string with the GUI's current mode (IDLE, ACQUIRE, RECORD),
+ *          whether acquisition runs offline, and the achieved x-realtime factor
  * 
  * - PUT /api/status : 
- *          sets the GUI's mode
- *          e.g.: {"mode" : "ACQUIRE"}
+ *          sets the GUI's mode, and optionally whether to render offline (as fast as possible)
+ *          and the number of samples per offline block (the audio device's buffer size by default)
+ *          e.g.: {"mode" : "ACQUIRE"} or {"mode" : "RECORD", "offline" : true, "block_size" : 8192}
+ *          (fails with status 409 if "offline" is given while acquisition is active)
  * 
  * - GET /api/cpu :
  *         returns a JSON string with the average proportion of available CPU being spent inside the audio callbacks
  *
+ * - GET /api/profile :
+ *         returns a JSON string with the execution time of each processor's blocks since acquisition started
+ *         (mean, median, 99th percentile and maximum in ms, and the number of blocks that overran the audio callback),
+ *         and the heap allocations made while processing (when built with OE_TRACK_AUDIO_ALLOCATIONS);
+ *         "parallel" lists the branches of the signal chain that run concurrently, with the execution time of each
+ *
+ * - PUT /api/profile :
+ *         enables or disables parallel processing of independent branches of the signal chain
+ *         e.g.: {"parallel" : false}
+ *
  * - GET /api/audio/devices :
  *        returns a JSON string with the available audio devices
  *
@@ -132,6 +145,10 @@ using json = nlohmann::json;
  * - PUT /api/redo :
  *          redoes the last action
  *
+ * - PUT /api/processors/<processor_id>/parameters :
+ *          sets several parameters at once, updating the signal chain a single time,
+ *          e.g.: {"parameters" : {"low_cut" : 300, "high_cut" : 6000}}
+ *
  * - PUT /api/processors/<processor_id>/parameters/<parameter_name> :
  *          sets a parameter's value, e.g.: {"value" : 0.5}
  *
@@ -168,6 +185,8 @@ public:
         svr_->Put ("/api/status", [this] (const httplib::Request& req, httplib::Response& res)
                    {
             std::string desired_mode;
+            int offline = -1;
+            int blockSize = 0;
 
             LOGD("Received PUT request with content: ", req.body);
             try {
@@ -177,6 +196,12 @@ public:
                 LOGD("Successfully parsed body");
                 desired_mode = request_json["mode"];
                 LOGD("Found 'mode': ", desired_mode);
+
+                if (request_json.contains("offline"))
+                    offline = request_json["offline"].get<bool>() ? 1 : 0;
+
+                if (request_json.contains("block_size"))
+                    blockSize = request_json["block_size"].get<int>();
             }
             catch (json::exception& e) {
                 LOGD("Hit exception: ", String(e.what()));
@@ -185,6 +210,22 @@ public:
                 return;
             }
 
+            if (offline >= 0 && desired_mode != "IDLE") {
+                std::promise<bool> signalModeSet;
+                std::future<bool> signalModeSetFuture = signalModeSet.get_future();
+
+                MessageManager::callAsync([this, offline, blockSize, &signalModeSet] {
+                    signalModeSet.set_value(AccessClass::getAudioComponent()->setOfflineRendering(offline == 1, blockSize));
+                });
+
+                // the rendering mode can't change while acquisition is active
+                if (!signalModeSetFuture.get()) {
+                    res.set_content("Cannot change rendering mode while acquisition is active", "text/plain");
+                    res.status = 409;
+                    return;
+                }
+            }
+
             if (desired_mode == "RECORD" && !CoreServices::getRecordingStatus()) {
                 std::promise<void> signalRecordingStarted;
                 std::future<void> signalRecordingStartedFuture = signalRecordingStarted.get_future();
@@ -249,6 +290,38 @@ public:
 
             res.set_content(ret.dump(), "application/json"); });
 
+        svr_->Get ("/api/profile", [this] (const httplib::Request&, httplib::Response& res)
+                   {
+            Array<GenericProcessor*> processors = graph_->getListOfProcessors();
+
+            std::vector<json> processor_profiles_json;
+            for (const auto& processor : processors) {
+                json processor_profile_json;
+                processor_profile_to_json(processor, &processor_profile_json);
+                processor_profiles_json.push_back(processor_profile_json);
+            }
+            json ret;
+            ret["processors"] = processor_profiles_json;
+            parallel_renderer_to_json(graph_, &ret["parallel"]);
+
+            res.set_content(ret.dump(), "application/json"); });
+
+        svr_->Put ("/api/profile", [this] (const httplib::Request& req, httplib::Response& res)
+                   {
+            try {
+                json request_json = json::parse(req.body);
+                graph_->setParallelProcessing(request_json["parallel"].get<bool>());
+            }
+            catch (json::exception& e) {
+                res.set_content(e.what(), "text/plain");
+                res.status = 400;
+                return;
+            }
+
+            json ret;
+            parallel_renderer_to_json(graph_, &ret["parallel"]);
+            res.set_content(ret.dump(), "application/json"); });
+
         svr_->Get ("/api/audio/devices", [this] (const httplib::Request&, httplib::Response& res)
                    {
             json ret;
@@ -1051,6 +1124,113 @@ public:
             ret["info"] = return_msg.toStdString();
             res.set_content(ret.dump(), "application/json"); });
 
+        svr_->Put (R"(/api/processors/([0-9]+)/parameters)",
+                   [this] (const httplib::Request& req, httplib::Response& res)
+                   {
+                       auto processor = find_processor (req.matches[1]);
+                       if (processor == nullptr)
+                       {
+                           res.status = 404;
+                           return;
+                       }
+
+                       json request_json;
+                       try
+                       {
+                           request_json = json::parse (req.body);
+                       }
+                       catch (json::exception& e)
+                       {
+                           LOGD ("Failed to parse request body.");
+                           res.set_content (e.what(), "text/plain");
+                           res.status = 400;
+                           return;
+                       }
+
+                       if (! request_json.contains ("parameters") || ! request_json["parameters"].is_object())
+                       {
+                           res.set_content ("Request must contain a parameters object.", "text/plain");
+                           res.status = 400;
+                           return;
+                       }
+
+                       // check every value before changing any of them
+                       std::vector<std::pair<Parameter*, var>> changes;
+
+                       for (auto& item : request_json["parameters"].items())
+                       {
+                           auto parameter = find_parameter (processor, item.key());
+
+                           if (parameter == nullptr)
+                           {
+                               res.set_content ("Parameter " + item.key() + " not found.", "text/plain");
+                               res.status = 404;
+                               return;
+                           }
+
+                           if (parameter->shouldDeactivateDuringAcquisition()
+                               && CoreServices::getAcquisitionStatus())
+                           {
+                               res.set_content ("Cannot change " + item.key() + " while acquisition is active.", "text/plain");
+                               res.status = 400;
+                               return;
+                           }
+
+                           var val;
+
+                           try
+                           {
+                               val = json_to_var (item.value());
+                           }
+                           catch (json::exception& e)
+                           {
+                               res.set_content (e.what(), "text/plain");
+                               res.status = 400;
+                               return;
+                           }
+
+                           if (val.isUndefined())
+                           {
+                               res.set_content ("Value of " + item.key() + " could not be converted.", "text/plain");
+                               res.status = 400;
+                               return;
+                           }
+
+                           changes.push_back ({ parameter, val });
+                       }
+
+                       std::promise<void> parametersChanged;
+                       std::future<void> parametersChangedFuture = parametersChanged.get_future();
+
+                       MessageManager::callAsync ([this, &changes, &parametersChanged]
+                                                  {
+                                                      // the signal chain is updated once, after the last change
+                                                      graph_->beginBatchUpdate();
+
+                                                      for (auto& change : changes)
+                                                          change.first->setNextValue (change.second);
+
+                                                      graph_->endBatchUpdate();
+                                                      parametersChanged.set_value(); // Signal that parameters have been changed
+                                                  });
+
+                       // Wait for parameters to be changed
+                       parametersChangedFuture.wait();
+
+                       std::vector<json> parameters_json;
+
+                       for (auto& change : changes)
+                       {
+                           json parameter_json;
+                           parameter_to_json (change.first, &parameter_json);
+                           parameters_json.push_back (parameter_json);
+                       }
+
+                       json ret;
+                       ret["parameters"] = parameters_json;
+                       res.set_content (ret.dump(), "application/json");
+                   });
+
         svr_->Put (R"(/api/processors/([0-9]+)/parameters/([A-Za-z0-9_\.\-]+))",
                    [this] (const httplib::Request& req, httplib::Response& res)
                    {
@@ -1434,6 +1614,10 @@ private:
         {
             (*ret)["mode"] = "IDLE";
         }
+
+        (*ret)["offline"] = AccessClass::getAudioComponent()->isOfflineRendering();
+        (*ret)["block_size"] = AccessClass::getAudioComponent()->getOfflineBlockSize();
+        (*ret)["realtime_factor"] = AccessClass::getAudioComponent()->getRealtimeFactor();
     }
 
     inline static void parameter_to_json (Parameter* parameter, json* parameter_json)
@@ -1518,6 +1702,54 @@ private:
         }
     }
 
+    inline static void processor_profile_to_json (GenericProcessor* processor, json* processor_json)
+    {
+        const ProcessorProfiler::Statistics statistics = processor->getProfiler().getStatistics();
+
+        (*processor_json)["id"] = processor->getNodeId();
+        (*processor_json)["name"] = processor->getName().toStdString();
+        (*processor_json)["blocks"] = statistics.numBlocks;
+        (*processor_json)["mean_ms"] = statistics.meanMs;
+        (*processor_json)["p50_ms"] = statistics.p50Ms;
+        (*processor_json)["p99_ms"] = statistics.p99Ms;
+        (*processor_json)["max_ms"] = statistics.maxMs;
+        (*processor_json)["deadline_ms"] = statistics.deadlineMs;
+        (*processor_json)["overruns"] = statistics.numOverruns;
+        (*processor_json)["allocations"] = statistics.numAllocations;
+        (*processor_json)["allocating_blocks"] = statistics.numAllocatingBlocks;
+    }
+
+    inline static void parallel_renderer_to_json (const ProcessorGraph* graph, json* parallel_json)
+    {
+        const ParallelGraphRenderer& renderer = graph->getParallelRenderer();
+
+        (*parallel_json)["enabled"] = graph->isParallelProcessingEnabled();
+        (*parallel_json)["active"] = graph->isParallelProcessingEnabled() && renderer.canRunInParallel();
+        (*parallel_json)["threads"] = renderer.getNumThreads();
+
+        std::vector<json> branches_json;
+
+        for (const auto& branch : renderer.getBranchInfo())
+        {
+            json branch_json;
+            std::vector<int> node_ids;
+
+            for (int nodeId : branch.nodeIds)
+                node_ids.push_back (nodeId);
+
+            branch_json["processors"] = node_ids;
+            branch_json["level"] = branch.level;
+            branch_json["blocks"] = branch.statistics.numBlocks;
+            branch_json["p50_ms"] = branch.statistics.p50Ms;
+            branch_json["p99_ms"] = branch.statistics.p99Ms;
+            branch_json["max_ms"] = branch.statistics.maxMs;
+            branch_json["overruns"] = branch.statistics.numOverruns;
+            branches_json.push_back (branch_json);
+        }
+
+        (*parallel_json)["branches"] = branches_json;
+    }
+
     inline static void stream_latency_to_json (const GenericProcessor* processor, const DataStream* stream, json* stream_json)
     {
         (*stream_json)["name"] = stream->getName().toStdString();
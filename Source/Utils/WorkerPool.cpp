@@ -0,0 +1,231 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "WorkerPool.h"
+
+#if JUCE_INTEL
+#include <immintrin.h>
+#endif
+
+namespace
+{
+/** Maximum time spent spinning before a thread goes to sleep */
+const double spinSeconds = 100e-6;
+
+/** Threads of all pools in the process, including the threads that call run() */
+std::atomic<int> numPoolThreads { 0 };
+
+/** Tells the CPU that the calling thread is in a spin loop */
+inline void spinPause()
+{
+#if JUCE_INTEL
+    _mm_pause();
+#elif JUCE_ARM && (defined(__aarch64__) || defined(__arm__)) && ! JUCE_MSVC
+    __asm__ __volatile__ ("yield");
+#endif
+}
+
+/** Spins until condition() returns true or the spin time runs out; returns the last result of condition() */
+template <typename Condition>
+bool spinUntil (Condition&& condition)
+{
+    const int64 endTicks = Time::getHighResolutionTicks() + Time::secondsToHighResolutionTicks (spinSeconds);
+
+    while (! condition())
+    {
+        for (int i = 0; i < 64; i++)
+            spinPause();
+
+        if (Time::getHighResolutionTicks() > endTicks)
+            return condition();
+    }
+
+    return true;
+}
+} // namespace
+
+class WorkerPool::Worker : public Thread
+{
+public:
+    Worker (WorkerPool& pool_, int index_)
+        : Thread (pool_.name + " " + String (index_)),
+          pool (pool_),
+          index (index_),
+          lastBatch (pool_.batch.load())
+    {
+    }
+
+    void run() override
+    {
+        while (pool.waitForBatch (lastBatch))
+        {
+            lastBatch = pool.batch.load (std::memory_order_acquire);
+
+            pool.runTasks (index);
+            pool.workerFinished();
+        }
+    }
+
+private:
+    WorkerPool& pool;
+    const int index;
+    uint32 lastBatch;
+};
+
+WorkerPool::WorkerPool (const String& name_, int numThreads)
+    : name (name_),
+      numCpus (SystemStats::getNumCpus())
+{
+    startWorkers (numThreads);
+}
+
+WorkerPool::~WorkerPool()
+{
+    stopWorkers();
+}
+
+void WorkerPool::setNumThreads (int numThreads)
+{
+    if (numThreads == getNumThreads())
+        return;
+
+    stopWorkers();
+    startWorkers (numThreads);
+}
+
+void WorkerPool::startWorkers (int numThreads)
+{
+    exiting = false;
+
+    for (int index = 1; index < numThreads; index++)
+    {
+        Worker* worker = workers.add (new Worker (*this, index));
+        worker->startThread (Thread::Priority::high);
+    }
+
+    numPoolThreads += getNumThreads();
+}
+
+void WorkerPool::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock (batchMutex);
+        exiting = true;
+    }
+
+    batchStarted.notify_all();
+
+    for (auto worker : workers)
+        worker->stopThread (1000);
+
+    numPoolThreads -= getNumThreads();
+
+    workers.clear();
+}
+
+bool WorkerPool::shouldSpin() const
+{
+    return numPoolThreads.load (std::memory_order_relaxed) <= numCpus;
+}
+
+void WorkerPool::run (int numTasks, TaskFunction task, void* context)
+{
+    jassert (task != nullptr);
+
+    if (workers.size() == 0 || numTasks <= 1)
+    {
+        for (int i = 0; i < numTasks; i++)
+            task (context, i);
+
+        return;
+    }
+
+    currentTask = task;
+    currentContext = context;
+    currentNumTasks = numTasks;
+
+    runningWorkers.store (workers.size());
+    batch.fetch_add (1);
+
+    if (sleepingWorkers.load() > 0)
+    {
+        // taking the lock ensures sleeping workers are waiting before they are notified
+        {
+            std::lock_guard<std::mutex> lock (batchMutex);
+        }
+
+        batchStarted.notify_all();
+    }
+
+    runTasks (0);
+
+    if (shouldSpin() && spinUntil ([this]
+                                   { return runningWorkers.load (std::memory_order_acquire) == 0; }))
+        return;
+
+    std::unique_lock<std::mutex> lock (doneMutex);
+
+    callerSleeping = true;
+    batchDone.wait (lock, [this]
+                    { return runningWorkers.load() == 0; });
+    callerSleeping = false;
+}
+
+void WorkerPool::runTasks (int threadIndex) const
+{
+    const int numThreads = workers.size() + 1;
+
+    for (int i = threadIndex; i < currentNumTasks; i += numThreads)
+        currentTask (currentContext, i);
+}
+
+void WorkerPool::workerFinished()
+{
+    if (runningWorkers.fetch_sub (1) == 1 && callerSleeping.load())
+    {
+        {
+            std::lock_guard<std::mutex> lock (doneMutex);
+        }
+
+        batchDone.notify_one();
+    }
+}
+
+bool WorkerPool::waitForBatch (uint32 lastBatch)
+{
+    auto batchStartedOrExiting = [this, lastBatch]
+    {
+        return batch.load() != lastBatch || exiting.load();
+    };
+
+    if (! (shouldSpin() && spinUntil (batchStartedOrExiting)))
+    {
+        std::unique_lock<std::mutex> lock (batchMutex);
+
+        sleepingWorkers++;
+        batchStarted.wait (lock, batchStartedOrExiting);
+        sleepingWorkers--;
+    }
+
+    return ! exiting.load();
+}
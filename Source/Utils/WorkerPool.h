@@ -0,0 +1,148 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef WORKERPOOL_H_INCLUDED
+#define WORKERPOOL_H_INCLUDED
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+#include "../Processors/PluginManager/OpenEphysPlugin.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+/**
+
+    A set of persistent threads for splitting a processor's work
+    across CPU cores within one block.
+
+    parallelFor (numTasks, function) calls function (taskIndex) for every task,
+    and returns once all of them have finished. Tasks are assigned statically:
+    the calling thread runs tasks 0, N, 2N..., and worker k runs tasks k, k + N...
+    (where N is the number of threads), so a processor that creates one task per
+    thread and balances them ahead of time (e.g. in updateSettings()) gets the
+    same split of work in every block.
+
+    Starting and finishing a batch does not allocate or take locks unless a
+    thread has to sleep: threads spin for up to 100 us waiting for the next
+    batch (or for the workers to finish), then block on a condition variable
+    (a futex on Linux). Spinning is disabled while the pools in the process
+    have more threads in total than there are CPU cores, so that several pools
+    don't keep each other's threads waiting for a core.
+
+    Workers run at high priority; they are not pinned to cores, so the scheduler
+    can spread the threads of all pools (and the audio thread) across the CPUs.
+
+    Usage:
+    @code
+    // in updateSettings()
+    workerPool.setNumThreads (4);
+
+    // in process()
+    auto filterPartition = [&] (int partition) { ... };
+    workerPool.parallelFor (4, filterPartition);
+    @endcode
+
+*/
+class PLUGIN_API WorkerPool
+{
+public:
+    /** Function run for each task */
+    typedef void (*TaskFunction) (void* context, int taskIndex);
+
+    /** Creates a pool that runs tasks on numThreads threads, including the calling thread */
+    WorkerPool (const String& name, int numThreads = 1);
+
+    /** Stops all worker threads */
+    ~WorkerPool();
+
+    /** Changes the number of threads. Must not be called while tasks are running. */
+    void setNumThreads (int numThreads);
+
+    /** Returns the number of threads used to run tasks, including the calling thread */
+    int getNumThreads() const { return workers.size() + 1; }
+
+    /** Calls function (taskIndex) for every task in [0, numTasks), and waits for all of them to finish */
+    template <typename Function>
+    void parallelFor (int numTasks, Function& function)
+    {
+        run (numTasks, &invoke<Function>, &function);
+    }
+
+    /** Calls task (context, taskIndex) for every task in [0, numTasks), and waits for all of them to finish */
+    void run (int numTasks, TaskFunction task, void* context);
+
+private:
+    class Worker;
+
+    template <typename Function>
+    static void invoke (void* context, int taskIndex)
+    {
+        (*static_cast<Function*> (context)) (taskIndex);
+    }
+
+    /** Runs the tasks assigned to one thread of the current batch */
+    void runTasks (int threadIndex) const;
+
+    /** Called by a worker when it has finished its tasks */
+    void workerFinished();
+
+    /** Called by a worker to wait for a batch newer than lastBatch; returns false if the worker should exit */
+    bool waitForBatch (uint32 lastBatch);
+
+    /** Starts workers (numThreads - 1 of them) */
+    void startWorkers (int numThreads);
+
+    /** Stops and deletes all workers */
+    void stopWorkers();
+
+    /** Returns true if threads may spin while waiting, i.e. if the threads of all pools fit on the CPU cores */
+    bool shouldSpin() const;
+
+    const String name;
+
+    OwnedArray<Worker> workers;
+
+    TaskFunction currentTask { nullptr };
+    void* currentContext { nullptr };
+    int currentNumTasks { 0 };
+
+    std::atomic<uint32> batch { 0 };
+    std::atomic<int> runningWorkers { 0 };
+    std::atomic<bool> exiting { false };
+
+    std::atomic<int> sleepingWorkers { 0 };
+    std::atomic<bool> callerSleeping { false };
+
+    std::mutex batchMutex;
+    std::condition_variable batchStarted;
+
+    std::mutex doneMutex;
+    std::condition_variable batchDone;
+
+    const int numCpus;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerPool);
+};
+
+#endif // WORKERPOOL_H_INCLUDED
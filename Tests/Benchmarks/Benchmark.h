@@ -0,0 +1,59 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <JuceHeader.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+/*
+Helpers shared by the benchmarks in this folder. Benchmarks run as regular
+tests (so they stay compiled and checked), and print their timings to stdout.
+*/
+namespace Benchmark
+{
+/** Calls fn repeatedly for at least minSeconds, and returns the average duration of one call in seconds */
+template <typename Function>
+double timePerCall (Function&& fn, double minSeconds = 0.05)
+{
+    using Clock = std::chrono::steady_clock;
+
+    fn(); // warm up caches and lazy initialisation
+
+    int64 numCalls = 0;
+    const auto start = Clock::now();
+    std::chrono::duration<double> elapsed (0);
+
+    do
+    {
+        fn();
+        numCalls++;
+        elapsed = Clock::now() - start;
+    } while (elapsed.count() < minSeconds);
+
+    return elapsed.count() / double (numCalls);
+}
+
+/** Prints a single result line */
+inline void report (const String& name, const String& configuration, double secondsPerCall, double bytesPerCall)
+{
+    std::cout << "[ BENCHMARK ] " << std::left << std::setw (32) << name
+              << std::setw (20) << configuration
+              << std::right << std::fixed << std::setprecision (2)
+              << std::setw (12) << secondsPerCall * 1.0e6 << " us"
+              << std::setw (12) << bytesPerCall / secondsPerCall / (1024.0 * 1024.0) << " MB/s"
+              << std::endl;
+}
+/** Prints a single result line, for operations without a data rate */
+inline void report (const String& name, const String& configuration, double secondsPerCall)
+{
+    std::cout << "[ BENCHMARK ] " << std::left << std::setw (32) << name
+              << std::setw (20) << configuration
+              << std::right << std::fixed << std::setprecision (2)
+              << std::setw (12) << secondsPerCall * 1.0e3 << " ms"
+              << std::endl;
+}
+} // namespace Benchmark
+
+#endif
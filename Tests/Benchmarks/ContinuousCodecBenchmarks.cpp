@@ -0,0 +1,50 @@
+#include "gtest/gtest.h"
+
+#include <Processors/RecordNode/CompressedFormat/ContinuousCodec.h>
+
+#include "Benchmark.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+/*
+Encodes and decodes one chunk of a 384-channel probe recording (a slow
+oscillation plus Gaussian noise of ~4 uV at 0.195 uV / bit), and reports
+the throughput of each direction and the compression ratio.
+*/
+TEST (ContinuousCodecBenchmark, ProbeChunk)
+{
+    const int numChannels = 384;
+    const int numSamples = 1024;
+
+    std::mt19937 rng (1);
+    std::normal_distribution<float> noise (0.0f, 20.0f);
+
+    std::vector<int16> samples (numChannels * numSamples);
+
+    for (int i = 0; i < numSamples; i++)
+        for (int chan = 0; chan < numChannels; chan++)
+            samples[i * numChannels + chan] = int16 (std::lround (300.0 * std::sin (0.002 * i + 0.1 * chan) + noise (rng)));
+
+    std::vector<uint8> encoded (ContinuousCodec::getMaxEncodedSize (numChannels, numSamples));
+    std::vector<int16> decoded (samples.size());
+
+    size_t encodedSize = 0;
+
+    const double rawBytes = double (samples.size() * sizeof (int16));
+
+    const double encodeTime = Benchmark::timePerCall ([&]
+                                                      { encodedSize = ContinuousCodec::encodeChunk (samples.data(), numChannels, numSamples, encoded.data()); });
+
+    const double decodeTime = Benchmark::timePerCall ([&]
+                                                      { ContinuousCodec::decodeChunk (encoded.data(), encodedSize, decoded.data(), numChannels, numSamples); });
+
+    Benchmark::report ("ContinuousCodec encode", "384 ch", encodeTime, rawBytes);
+    Benchmark::report ("ContinuousCodec decode", "384 ch", decodeTime, rawBytes);
+
+    std::cout << "[ BENCHMARK ] Compression ratio: " << rawBytes / double (encodedSize) << std::endl;
+
+    EXPECT_EQ (decoded, samples);
+    EXPECT_LT (double (encodedSize), rawBytes);
+}
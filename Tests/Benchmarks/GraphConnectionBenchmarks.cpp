@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+
+#include <ProcessorHeaders.h>
+#include <Processors/ProcessorGraph/ChannelRouting.h>
+#include <TestFixtures.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+const int numStreams = 4;
+
+class PassThroughProcessor : public GenericProcessor
+{
+public:
+    PassThroughProcessor() : GenericProcessor ("Pass Through", true)
+    {
+    }
+
+    void process (AudioBuffer<float>&) override {}
+};
+
+class GraphConnectionBenchmark : public testing::TestWithParam<int>
+{
+protected:
+    void SetUp() override
+    {
+        numChannels = GetParam();
+
+        FakeSourceNodeParams params;
+        params.channels = numChannels / numStreams;
+        params.streams = numStreams;
+
+        tester = std::make_unique<ProcessorTester> (TestSourceNodeBuilder (params));
+        processor = tester->createProcessor<PassThroughProcessor> (Plugin::Processor::FILTER);
+
+        // an unprepared graph skips building its render sequence
+        tester->processorGraph->prepareToPlay (30000.0, 1024);
+    }
+
+    void TearDown() override
+    {
+        tester->processorGraph->releaseResources();
+    }
+
+    /** The connections as made before: a search for each channel, and a graph rebuild for each connection */
+    void connectChannelByChannel()
+    {
+        ProcessorGraph* graph = tester->processorGraph.get();
+        GenericProcessor* source = tester->getSourceNode();
+
+        const AudioProcessorGraph::NodeID sourceId (source->getNodeId());
+        const AudioProcessorGraph::NodeID destId (processor->getNodeId());
+
+        graph->disconnectNode (destId);
+
+        for (int chan = 0; chan < source->getNumOutputs(); chan++)
+        {
+            const int destChannel = processor->getIndexOfMatchingChannel (source->getContinuousChannel (chan));
+
+            if (destChannel > -1)
+                graph->addConnection ({ { sourceId, chan }, { destId, destChannel } });
+        }
+    }
+
+    int numChannels;
+    std::unique_ptr<ProcessorTester> tester;
+    PassThroughProcessor* processor;
+};
+} // namespace
+
+/*
+Measures the time to route the channels of 4 streams from a source to
+the next processor and rebuild the graph, for 1k, 4k and 8k channels.
+The stream routing matches a per-channel search.
+*/
+TEST_P (GraphConnectionBenchmark, RebuildGraph)
+{
+    const String configuration = String (numChannels) + " channels";
+
+    GenericProcessor* source = tester->getSourceNode();
+    ASSERT_EQ (source->getNumOutputs(), numChannels);
+
+    ChannelRouting routing = ChannelRouting::between (source, processor);
+
+    EXPECT_EQ (routing.getNumChannels(), numChannels);
+    EXPECT_EQ (routing.getRanges().size(), 1);
+
+    for (const auto& range : routing.getRanges())
+    {
+        for (int i = 0; i < range.numChannels; i++)
+        {
+            ASSERT_EQ (processor->getIndexOfMatchingChannel (source->getContinuousChannel (range.sourceChannel + i)),
+                       range.destChannel + i);
+        }
+    }
+
+    double seconds = Benchmark::timePerCall ([&]
+                                             {
+                                                 for (int chan = 0; chan < source->getNumOutputs(); chan++)
+                                                     processor->getIndexOfMatchingChannel (source->getContinuousChannel (chan));
+                                             });
+    Benchmark::report ("Per-channel search", configuration, seconds);
+
+    seconds = Benchmark::timePerCall ([&]
+                                      { routing = ChannelRouting::between (source, processor); });
+    Benchmark::report ("Stream routing", configuration, seconds);
+
+    seconds = Benchmark::timePerCall ([&]
+                                      { tester->processorGraph->updateConnections(); });
+    Benchmark::report ("updateConnections", configuration, seconds);
+
+    EXPECT_TRUE (tester->processorGraph->isConnected (AudioProcessorGraph::Connection {
+        { AudioProcessorGraph::NodeID (source->getNodeId()), numChannels - 1 },
+        { AudioProcessorGraph::NodeID (processor->getNodeId()), numChannels - 1 } }));
+
+    // rebuilding after every connection grows quadratically (about 2 minutes
+    // for 4096 channels), so it's only timed for the smallest graph
+    if (numChannels <= 1024)
+    {
+        seconds = Benchmark::timePerCall ([&]
+                                          { connectChannelByChannel(); },
+                                          0.0);
+        Benchmark::report ("Rebuild per connection", configuration, seconds);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P (Channels, GraphConnectionBenchmark, testing::Values (1024, 4096, 8192));
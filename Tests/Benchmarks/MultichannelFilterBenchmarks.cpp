@@ -0,0 +1,161 @@
+#include "gtest/gtest.h"
+
+#include <Processors/Dsp/Dsp.h>
+
+#include "Benchmark.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+const int samplesPerBlock = 1024;
+const double sampleRate = 30000.0;
+
+typedef Dsp::Butterworth::Design::BandPass<2> BandPassDesign;
+
+/** The filter used by the Bandpass Filter plugin before the multichannel engine */
+typedef Dsp::SmoothedFilterDesign<BandPassDesign, 1, Dsp::DirectFormII> PerChannelFilter;
+
+/** Per-channel filter with the same realization as the multichannel engine */
+typedef Dsp::SmoothedFilterDesign<BandPassDesign, 1, Dsp::TransposedDirectFormII> PerChannelReferenceFilter;
+
+Dsp::Params getBandPassParams()
+{
+    Dsp::Params params;
+    params[0] = sampleRate; // sample rate
+    params[1] = 2; // order
+    params[2] = (6000.0 + 300.0) / 2; // center frequency
+    params[3] = 6000.0 - 300.0; // bandwidth
+    return params;
+}
+
+/** Fills a buffer with white noise */
+void fillWithNoise (AudioBuffer<float>& buffer, unsigned int seed)
+{
+    std::mt19937 rng (seed);
+    std::normal_distribution<float> distribution (0.0f, 100.0f);
+
+    for (int chan = 0; chan < buffer.getNumChannels(); chan++)
+        for (int i = 0; i < buffer.getNumSamples(); i++)
+            buffer.setSample (chan, i, distribution (rng));
+}
+
+template <typename FilterType>
+OwnedArray<Dsp::Filter> createPerChannelFilters (int numChannels)
+{
+    OwnedArray<Dsp::Filter> filters;
+
+    for (int chan = 0; chan < numChannels; chan++)
+    {
+        filters.add (new FilterType (1));
+        filters.getLast()->setParams (getBandPassParams());
+    }
+
+    return filters;
+}
+
+void processPerChannel (OwnedArray<Dsp::Filter>& filters, AudioBuffer<float>& buffer)
+{
+    for (int chan = 0; chan < filters.size(); chan++)
+    {
+        float* ptr = buffer.getWritePointer (chan);
+        filters[chan]->process (buffer.getNumSamples(), &ptr);
+    }
+}
+
+void expectSameSamples (const AudioBuffer<float>& output, const AudioBuffer<float>& expected)
+{
+    for (int chan = 0; chan < output.getNumChannels(); chan++)
+    {
+        for (int i = 0; i < output.getNumSamples(); i++)
+        {
+            const float reference = expected.getSample (chan, i);
+            ASSERT_NEAR (output.getSample (chan, i), reference, 1.0e-5f * (1.0f + std::abs (reference)))
+                << "channel " << chan << ", sample " << i;
+        }
+    }
+}
+
+class MultichannelFilterBenchmark : public testing::TestWithParam<int>
+{
+};
+} // namespace
+
+/*
+The multichannel engine matches per-channel Transposed Direct Form II
+filters, for channel counts that are not a multiple of the group size,
+block sizes that are not a multiple of 4, and channel ranges that are
+processed separately.
+*/
+TEST (MultichannelFilterTest, MatchesPerChannelFilters)
+{
+    const int numChannels = 13;
+
+    OwnedArray<Dsp::Filter> reference = createPerChannelFilters<PerChannelReferenceFilter> (numChannels);
+
+    Dsp::MultichannelFilterDesign<BandPassDesign> filter (numChannels);
+    filter.setParams (getBandPassParams());
+
+    EXPECT_EQ (filter.getNumChannels(), numChannels);
+
+    unsigned int seed = 1;
+
+    for (int blockSize : { 1000, 7, 1, 64, 333 })
+    {
+        AudioBuffer<float> expected (numChannels, blockSize);
+        fillWithNoise (expected, seed++);
+
+        AudioBuffer<float> output (expected);
+
+        processPerChannel (reference, expected);
+
+        // process the channels in two ranges, as the Bandpass Filter threads do
+        filter.process (blockSize, output.getArrayOfWritePointers(), 0, 5);
+        filter.process (blockSize, output.getArrayOfWritePointers(), 5, numChannels - 5);
+
+        expectSameSamples (output, expected);
+    }
+}
+
+/*
+Compares the per-channel filters used before (one Direct Form II cascade
+per channel) with the multichannel engine, at 32 to 1024 channels.
+*/
+TEST_P (MultichannelFilterBenchmark, FilterBlock)
+{
+    const int numChannels = GetParam();
+    const String configuration = String (numChannels) + " channels";
+    const double bytesPerCall = double (numChannels) * samplesPerBlock * sizeof (float);
+
+    AudioBuffer<float> input (numChannels, samplesPerBlock);
+    fillWithNoise (input, (unsigned int) numChannels);
+
+    AudioBuffer<float> buffer (numChannels, samplesPerBlock);
+
+    OwnedArray<Dsp::Filter> perChannel = createPerChannelFilters<PerChannelFilter> (numChannels);
+
+    double seconds = Benchmark::timePerCall ([&]
+                                             {
+        buffer.makeCopyOf (input, true);
+        processPerChannel (perChannel, buffer); });
+    Benchmark::report ("Per-channel cascade", configuration, seconds, bytesPerCall);
+
+    Dsp::MultichannelFilterDesign<BandPassDesign> multichannel (numChannels);
+    multichannel.setParams (getBandPassParams());
+
+    seconds = Benchmark::timePerCall ([&]
+                                      {
+        buffer.makeCopyOf (input, true);
+        multichannel.process (samplesPerBlock, buffer.getArrayOfWritePointers()); });
+    Benchmark::report (String ("Multichannel (") + Dsp::MultichannelCascade::getKernelName() + ")", configuration, seconds, bytesPerCall);
+
+    std::cout << "[ BENCHMARK ] " << String (seconds > 0 ? double (numChannels) * samplesPerBlock / seconds / 1.0e6 : 0.0, 1)
+              << " M samples/s with the multichannel engine" << std::endl;
+
+    // the output stays in range
+    for (int chan = 0; chan < numChannels; chan++)
+        EXPECT_LT (buffer.getMagnitude (chan, 0, samplesPerBlock), 1000.0f);
+}
+
+INSTANTIATE_TEST_SUITE_P (ChannelCounts, MultichannelFilterBenchmark, testing::Values (32, 128, 384, 1024));
@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+
+#include <Processors/RecordNode/SampleConverter.h>
+
+#include "Benchmark.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+const int samplesPerBlock = 1024;
+
+class SampleConverterBenchmark : public testing::TestWithParam<int>
+{
+protected:
+    void SetUp() override
+    {
+        numChannels = GetParam();
+
+        std::mt19937 rng (numChannels);
+        std::normal_distribution<float> distribution (0.0f, 200.0f);
+
+        input.setSize (numChannels, samplesPerBlock);
+
+        for (int chan = 0; chan < numChannels; chan++)
+        {
+            for (int i = 0; i < samplesPerBlock; i++)
+                input.setSample (chan, i, distribution (rng));
+
+            scales.push_back (1.0f / 0.195f);
+        }
+
+        output.resize (numChannels * samplesPerBlock);
+        expected.resize (numChannels * samplesPerBlock);
+
+        scaledBuffer.resize (samplesPerBlock);
+        planarBuffer.resize (numChannels * samplesPerBlock);
+    }
+
+    /** The conversion as done before the fused kernel: scale and convert each
+        channel separately, then interleave the planar int16 data */
+    void convertThreePass()
+    {
+        for (int chan = 0; chan < numChannels; chan++)
+        {
+            const double multFactor = 1 / (float (0x7fff) * 0.195f);
+            FloatVectorOperations::copyWithMultiply (scaledBuffer.data(), input.getReadPointer (chan), multFactor, samplesPerBlock);
+            AudioDataConverters::convertFloatToInt16LE (scaledBuffer.data(), planarBuffer.data() + chan * samplesPerBlock, samplesPerBlock);
+        }
+
+        int16* dest = output.data();
+
+        for (int i = 0; i < samplesPerBlock; i++)
+        {
+            for (int chan = 0; chan < numChannels; chan++)
+                *(dest++) = planarBuffer[chan * samplesPerBlock + i];
+        }
+    }
+
+    double getInputBytes() const
+    {
+        return double (numChannels) * samplesPerBlock * sizeof (float);
+    }
+
+    int numChannels;
+    AudioBuffer<float> input;
+    std::vector<float> scales;
+    std::vector<int16> output;
+    std::vector<int16> expected;
+
+    std::vector<float> scaledBuffer;
+    std::vector<int16> planarBuffer;
+};
+} // namespace
+
+/*
+Compares the fused scale / convert / interleave kernel used by the Binary
+format against the scalar implementation and the previous three-pass path,
+for typical probe channel counts.
+*/
+TEST_P (SampleConverterBenchmark, ConvertToInt16Interleaved)
+{
+    const float* const* source = input.getArrayOfReadPointers();
+    const String configuration = String (numChannels) + " ch x " + String (samplesPerBlock);
+
+    SampleConverter::convertToInt16InterleavedScalar (source, 0, scales.data(), numChannels, samplesPerBlock, expected.data());
+
+    double seconds = Benchmark::timePerCall ([&]
+                                             { convertThreePass(); });
+    Benchmark::report ("Three-pass", configuration, seconds, getInputBytes());
+
+    for (size_t i = 0; i < expected.size(); i++)
+        ASSERT_NEAR (output[i], expected[i], 1);
+
+    seconds = Benchmark::timePerCall ([&]
+                                      { SampleConverter::convertToInt16InterleavedScalar (source, 0, scales.data(), numChannels, samplesPerBlock, output.data()); });
+    Benchmark::report ("Fused (Scalar)", configuration, seconds, getInputBytes());
+
+    seconds = Benchmark::timePerCall ([&]
+                                      { SampleConverter::convertToInt16Interleaved (source, 0, scales.data(), numChannels, samplesPerBlock, output.data()); });
+    Benchmark::report ("Fused (" + SampleConverter::getKernelName() + ")", configuration, seconds, getInputBytes());
+
+    EXPECT_EQ (output, expected);
+}
+
+INSTANTIATE_TEST_SUITE_P (ChannelCounts, SampleConverterBenchmark, testing::Values (64, 384, 1536));
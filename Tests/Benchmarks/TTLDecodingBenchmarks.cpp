@@ -0,0 +1,162 @@
+#include "gtest/gtest.h"
+
+#include <Processors/Events/Event.h>
+#include <Processors/Events/TTLWordDecoder.h>
+#include <Processors/Settings/DataStream.h>
+#include <Processors/Settings/EventChannel.h>
+
+#include "Benchmark.h"
+
+#include <vector>
+
+namespace
+{
+const int samplesPerBlock = 1024;
+
+// the TTL word changes every 16 samples (about 1 kHz toggling at 30 kHz)
+const int samplesPerToggle = 16;
+
+class TTLDecodingBenchmark : public testing::TestWithParam<int>
+{
+protected:
+    void SetUp() override
+    {
+        numLines = GetParam();
+
+        dataStream = std::make_unique<DataStream> (DataStream::Settings {
+            "Data Stream",
+            "Data Stream Description",
+            "Data Stream Identifier",
+            30000.0f });
+
+        eventChannel = std::make_unique<EventChannel> (EventChannel::Settings {
+            EventChannel::Type::TTL,
+            "TTL Channel",
+            "TTL Channel Description",
+            "ttl.channel",
+            dataStream.get(),
+            64 });
+
+        const uint64 toggledLines = numLines == 64 ? ~uint64 (0) : (uint64 (1) << numLines) - 1;
+
+        // the block starts and ends with all lines low, so every call sees the same transitions
+        for (int i = 0; i < samplesPerBlock; i++)
+            words.push_back ((((i + samplesPerToggle / 2) / samplesPerToggle) & 1) ? toggledLines : 0);
+    }
+
+    /** The decoding as done before: compare every sample, and create, serialize
+        and copy a TTLEvent object for each changed line */
+    void decodeWithEventObjects (MidiBuffer& buffer)
+    {
+        buffer.clear();
+
+        uint64 lastCode = 0;
+
+        for (int sample = 0; sample < samplesPerBlock; sample++)
+        {
+            const uint64 currentCode = words[sample];
+
+            if (lastCode != currentCode)
+            {
+                Array<TTLEventPtr> events = TTLEvent::createTTLEvent (eventChannel.get(), sample, currentCode);
+
+                for (auto& event : events)
+                {
+                    size_t size = event->getChannelInfo()->getDataSize() + event->getChannelInfo()->getTotalEventMetadataSize() + EVENT_BASE_SIZE;
+                    HeapBlock<char> data (size);
+                    event->serialize (data, size);
+                    buffer.addEvent (data, int (size), sample);
+                }
+
+                lastCode = currentCode;
+            }
+        }
+    }
+
+    void decodeWords (MidiBuffer& buffer)
+    {
+        buffer.clear();
+
+        uint64 lastCode = 0;
+        EventChannel* channel = eventChannel.get();
+
+        for (int sample = TTLWordDecoder::findNextChange (words.data(), 0, samplesPerBlock, lastCode);
+             sample < samplesPerBlock;
+             sample = TTLWordDecoder::findNextChange (words.data(), sample + 1, samplesPerBlock, lastCode))
+        {
+            lastCode = words[sample];
+
+            TTLWordDecoder::addLineChanges (buffer, channel, sample, sample, channel->getTTLWord(), lastCode, [channel] (int line, bool state)
+                                            { channel->setLineState (line, state); });
+        }
+    }
+
+    int numLines;
+    std::unique_ptr<DataStream> dataStream;
+    std::unique_ptr<EventChannel> eventChannel;
+    std::vector<uint64> words;
+};
+} // namespace
+
+/*
+The change search finds the same samples as a scalar scan, for every
+alignment of the start sample.
+*/
+TEST (TTLWordDecoderTest, FindsSameChangesAsScalar)
+{
+    std::vector<uint64> words (100, 0x5);
+
+    for (int changed : { 0, 1, 3, 4, 7, 8, 31, 63, 99 })
+    {
+        words[changed] = 0x5 | (uint64 (1) << 40);
+
+        for (int start = 0; start < 100; start++)
+        {
+            EXPECT_EQ (TTLWordDecoder::findNextChange (words.data(), start, 100, 0x5),
+                       TTLWordDecoder::findNextChangeScalar (words.data(), start, 100, 0x5));
+        }
+
+        words[changed] = 0x5;
+    }
+
+    EXPECT_EQ (TTLWordDecoder::findNextChange (words.data(), 0, 100, 0x5), 100);
+}
+
+/*
+Compares direct serialization of TTL words against creating a TTLEvent for
+each changed line, for 1, 16 and 64 toggling lines. Both produce identical packets.
+*/
+TEST_P (TTLDecodingBenchmark, DecodeBlock)
+{
+    const String configuration = String (numLines) + " lines";
+    const double bytesPerCall = double (samplesPerBlock) * sizeof (uint64);
+
+    MidiBuffer expected;
+    MidiBuffer output;
+
+    double seconds = Benchmark::timePerCall ([&]
+                                             { decodeWithEventObjects (expected); });
+    Benchmark::report ("TTLEvent objects", configuration, seconds, bytesPerCall);
+
+    seconds = Benchmark::timePerCall ([&]
+                                      { decodeWords (output); });
+    Benchmark::report ("Direct (" + TTLWordDecoder::getKernelName() + ")", configuration, seconds, bytesPerCall);
+
+    ASSERT_EQ (output.getNumEvents(), expected.getNumEvents());
+    EXPECT_EQ (output.getNumEvents(), (samplesPerBlock / samplesPerToggle) * numLines);
+
+    auto expectedEvent = expected.cbegin();
+
+    for (const auto event : output)
+    {
+        const auto reference = *expectedEvent;
+
+        ASSERT_EQ (event.numBytes, reference.numBytes);
+        EXPECT_EQ (event.samplePosition, reference.samplePosition);
+        EXPECT_EQ (memcmp (event.data, reference.data, size_t (event.numBytes)), 0);
+
+        ++expectedEvent;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P (ToggledLines, TTLDecodingBenchmark, testing::Values (1, 16, 64));
@@ -0,0 +1,170 @@
+#include "gtest/gtest.h"
+
+#include <Processors/ProcessorGraph/ChannelRouting.h>
+#include <ProcessorHeaders.h>
+#include <TestFixtures.h>
+
+/*
+Channels that follow on from the last range in both the source
+and the destination extend it; anything else starts a new range.
+*/
+TEST (ChannelRoutingTest, MergesConsecutiveChannels)
+{
+    ChannelRouting routing;
+
+    for (int chan = 0; chan < 64; chan++)
+        routing.add (chan, chan);
+
+    ASSERT_EQ (routing.getRanges().size(), 1);
+    EXPECT_EQ (routing.getRanges()[0].numChannels, 64);
+
+    routing.add (64, 64, 32);
+    routing.add (100, 96, 4); // gap in the source
+    routing.add (104, 101);   // gap in the destination
+    routing.add (105, 102, 0);
+
+    ASSERT_EQ (routing.getRanges().size(), 3);
+    EXPECT_EQ (routing.getRanges()[0].numChannels, 96);
+    EXPECT_EQ (routing.getRanges()[1].sourceChannel, 100);
+    EXPECT_EQ (routing.getRanges()[1].destChannel, 96);
+    EXPECT_EQ (routing.getRanges()[1].numChannels, 4);
+    EXPECT_EQ (routing.getRanges()[2].destChannel, 101);
+    EXPECT_EQ (routing.getNumChannels(), 101);
+
+    routing.clear();
+    EXPECT_TRUE (routing.getRanges().empty());
+    EXPECT_EQ (routing.getNumChannels(), 0);
+}
+
+/*
+A reordered channel map is routed one channel at a time.
+*/
+TEST (ChannelRoutingTest, KeepsReorderedChannelsSeparate)
+{
+    ChannelRouting routing;
+
+    for (int chan = 0; chan < 8; chan++)
+        routing.add (chan, 7 - chan);
+
+    EXPECT_EQ (routing.getRanges().size(), 8);
+    EXPECT_EQ (routing.getNumChannels(), 8);
+}
+
+namespace
+{
+/** Optionally reverses the channels of its first stream, dropping the last one */
+class RearrangingProcessor : public GenericProcessor
+{
+public:
+    RearrangingProcessor() : GenericProcessor ("Rearranging Processor", true)
+    {
+    }
+
+    void process (AudioBuffer<float>&) override {}
+
+    void updateSettings() override
+    {
+        if (! rearrange || dataStreams.isEmpty())
+            return;
+
+        DataStream* stream = dataStreams.getFirst();
+        const Array<ContinuousChannel*> channels = stream->getContinuousChannels();
+        const int numKept = channels.size() - 1;
+
+        stream->clearContinuousChannels();
+
+        for (int i = numKept - 1; i >= 0; i--)
+            stream->addChannel (channels[i]);
+
+        // the stream's channels come first in the processor's channel list
+        for (int i = 0; i < numKept / 2; i++)
+            continuousChannels.swap (i, numKept - 1 - i);
+
+        continuousChannels.removeObject (channels.getLast());
+    }
+
+    bool rearrange = false;
+};
+
+class ChannelRoutingBetweenTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        FakeSourceNodeParams params;
+        params.channels = 4;
+        params.streams = 2;
+
+        tester = std::make_unique<ProcessorTester> (TestSourceNodeBuilder (params));
+        processor = tester->createProcessor<RearrangingProcessor> (Plugin::Processor::FILTER);
+    }
+
+    std::unique_ptr<ProcessorTester> tester;
+    RearrangingProcessor* processor;
+};
+} // namespace
+
+/*
+A processor that passes every stream on unchanged is fed by a single
+range covering the channels of all streams.
+*/
+TEST_F (ChannelRoutingBetweenTest, RoutesUnchangedStreamsAsOneRange)
+{
+    ASSERT_EQ (processor->getDataStreams().size(), 2);
+    ASSERT_EQ (processor->getTotalContinuousChannels(), 8);
+
+    const ChannelRouting routing = ChannelRouting::between (tester->getSourceNode(), processor);
+
+    ASSERT_EQ (routing.getRanges().size(), 1);
+    EXPECT_EQ (routing.getRanges()[0].sourceChannel, 0);
+    EXPECT_EQ (routing.getRanges()[0].destChannel, 0);
+    EXPECT_EQ (routing.getRanges()[0].numChannels, 8);
+    EXPECT_EQ (routing.getNumChannels(), 8);
+
+    EXPECT_TRUE (ChannelRouting::between (nullptr, processor).getRanges().empty());
+    EXPECT_TRUE (ChannelRouting::between (tester->getSourceNode(), nullptr).getRanges().empty());
+}
+
+/*
+Channels of a stream that the destination reordered are routed to their new
+positions, dropped channels are left out, and the unchanged stream after
+them is still routed as one range.
+*/
+TEST_F (ChannelRoutingBetweenTest, RoutesReorderedAndDroppedChannels)
+{
+    processor->rearrange = true;
+    tester->processorGraph->updateSettings (processor);
+
+    ASSERT_EQ (processor->getDataStreams()[0]->getChannelCount(), 3);
+    ASSERT_EQ (processor->getTotalContinuousChannels(), 7);
+
+    const ChannelRouting routing = ChannelRouting::between (tester->getSourceNode(), processor);
+
+    const std::vector<ChannelRouting::Range>& ranges = routing.getRanges();
+
+    ASSERT_EQ (ranges.size(), 4);
+
+    // first stream: channels 0 - 2 reversed, channel 3 dropped
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ (ranges[size_t (i)].sourceChannel, i);
+        EXPECT_EQ (ranges[size_t (i)].destChannel, 2 - i);
+        EXPECT_EQ (ranges[size_t (i)].numChannels, 1);
+    }
+
+    // second stream: shifted down by the dropped channel
+    EXPECT_EQ (ranges[3].sourceChannel, 4);
+    EXPECT_EQ (ranges[3].destChannel, 3);
+    EXPECT_EQ (ranges[3].numChannels, 4);
+
+    EXPECT_EQ (routing.getNumChannels(), 7);
+
+    for (const auto& range : ranges)
+    {
+        for (int i = 0; i < range.numChannels; i++)
+        {
+            EXPECT_EQ (processor->getContinuousChannel (range.destChannel + i)->getUniqueId(),
+                       tester->getSourceNode()->getContinuousChannel (range.sourceChannel + i)->getUniqueId());
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+
+#include <Processors/RecordNode/CompressedFormat/ContinuousCodec.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+class ContinuousCodecTests : public testing::Test
+{
+protected:
+    /** Encodes and decodes a chunk, and checks that the samples are unchanged. Returns the encoded size. */
+    size_t roundTrip (const std::vector<int16>& samples, int numChannels)
+    {
+        const int numSamples = int (samples.size()) / numChannels;
+
+        std::vector<uint8> encoded (ContinuousCodec::getMaxEncodedSize (numChannels, numSamples));
+        const size_t encodedSize = ContinuousCodec::encodeChunk (samples.data(), numChannels, numSamples, encoded.data());
+
+        EXPECT_LE (encodedSize, encoded.size());
+
+        std::vector<int16> decoded (samples.size(), 0);
+        EXPECT_EQ (ContinuousCodec::decodeChunk (encoded.data(), encodedSize, decoded.data(), numChannels, numSamples), numSamples);
+        EXPECT_EQ (decoded, samples);
+
+        return encodedSize;
+    }
+};
+
+/*
+Smooth signals with a little noise are restored exactly, and take much less space than raw int16.
+*/
+TEST_F (ContinuousCodecTests, CompressesSmoothSignals)
+{
+    const int numChannels = 16;
+    const int numSamples = 4096;
+
+    std::mt19937 rng (42);
+    std::normal_distribution<float> noise (0.0f, 8.0f);
+
+    std::vector<int16> samples (numChannels * numSamples);
+
+    for (int i = 0; i < numSamples; i++)
+        for (int chan = 0; chan < numChannels; chan++)
+            samples[i * numChannels + chan] = int16 (std::lround (2000.0 * std::sin (0.01 * i + chan) + noise (rng)));
+
+    const size_t encodedSize = roundTrip (samples, numChannels);
+
+    EXPECT_LT (encodedSize * 2, samples.size() * sizeof (int16));
+}
+
+/*
+Full-scale white noise and extreme values (which need escaped residuals) are restored exactly,
+and take little more space than the raw samples.
+*/
+TEST_F (ContinuousCodecTests, RestoresWorstCaseData)
+{
+    const int numChannels = 5;
+    const int numSamples = 1000;
+
+    std::mt19937 rng (7);
+    std::uniform_int_distribution<int> fullScale (-32768, 32767);
+
+    std::vector<int16> samples (numChannels * numSamples);
+
+    for (auto& sample : samples)
+        sample = int16 (fullScale (rng));
+
+    for (int i = 0; i < numSamples; i++)
+        samples[i * numChannels] = (i % 2 == 0) ? 32767 : -32768;
+
+    const size_t encodedSize = roundTrip (samples, numChannels);
+
+    EXPECT_LE (encodedSize, samples.size() * sizeof (int16) + sizeof (ContinuousCodec::ChunkHeader) + numChannels);
+}
+
+/*
+Very short chunks (shorter than the predictor order) and silent channels are supported.
+*/
+TEST_F (ContinuousCodecTests, HandlesShortAndSilentChunks)
+{
+    for (int numSamples = 1; numSamples < 5; numSamples++)
+    {
+        std::vector<int16> samples (3 * numSamples, 0);
+
+        for (int i = 0; i < numSamples; i++)
+            samples[i * 3 + 1] = int16 (-100 * i);
+
+        roundTrip (samples, 3);
+    }
+}
+
+/*
+Truncated chunks, and chunks with an unexpected channel count, are rejected.
+*/
+TEST_F (ContinuousCodecTests, RejectsInvalidChunks)
+{
+    std::vector<int16> samples (4 * 256);
+
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = int16 (i * 37);
+
+    std::vector<uint8> encoded (ContinuousCodec::getMaxEncodedSize (4, 256));
+    const size_t encodedSize = ContinuousCodec::encodeChunk (samples.data(), 4, 256, encoded.data());
+
+    std::vector<int16> decoded (samples.size());
+
+    EXPECT_EQ (ContinuousCodec::decodeChunk (encoded.data(), encodedSize - 1, decoded.data(), 4, 256), -1);
+    EXPECT_EQ (ContinuousCodec::decodeChunk (encoded.data(), encodedSize, decoded.data(), 3, 256), -1);
+    EXPECT_EQ (ContinuousCodec::decodeChunk (encoded.data(), encodedSize, decoded.data(), 4, 255), -1);
+
+    ContinuousCodec::ChunkHeader header;
+    EXPECT_TRUE (ContinuousCodec::readChunkHeader (encoded.data(), encodedSize, header));
+    EXPECT_EQ (header.numSamples, 256);
+    EXPECT_EQ (header.numChannels, 4);
+    EXPECT_EQ (header.payloadSize + sizeof (header), encodedSize);
+}
@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+
+#include <Processors/RecordNode/DataQueue.h>
+#include <ProcessorHeaders.h>
+
+#include <vector>
+
+namespace
+{
+/** Value written for a sample of a recorded channel */
+float getSampleValue (int channel, int64 sampleNumber)
+{
+    return float (channel * 100000 + sampleNumber);
+}
+
+/** Reads everything queued for a stream, checking the samples, sample numbers and timestamps */
+void readStream (DataQueue& queue, int streamIndex, int64& nextSampleNumber, double sampleRate)
+{
+    CircularBufferIndexes indexes;
+    int64 sampleNumber;
+
+    queue.startReadStream (streamIndex, indexes, sampleNumber, 0);
+
+    const int numSamples = indexes.size1 + indexes.size2;
+
+    if (numSamples > 0)
+        EXPECT_EQ (sampleNumber, nextSampleNumber) << "stream " << streamIndex;
+
+    const AudioBuffer<float>& buffer = queue.getStreamBufferReference (streamIndex);
+    const SynchronizedTimestampBuffer& timestamps = queue.getTimestampBufferReference (streamIndex);
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        const int index = i < indexes.size1 ? indexes.index1 + i : indexes.index2 + i - indexes.size1;
+        const int64 expectedSampleNumber = nextSampleNumber + i;
+
+        for (int chan = 0; chan < queue.getNumChannelsForStream (streamIndex); chan++)
+        {
+            ASSERT_EQ (buffer.getSample (chan, index), getSampleValue (queue.getFirstChannelForStream (streamIndex) + chan, expectedSampleNumber))
+                << "stream " << streamIndex << ", sample " << expectedSampleNumber;
+        }
+
+        ASSERT_NEAR (timestamps.getSample (0, index), double (expectedSampleNumber) / sampleRate, 1.0e-9)
+            << "stream " << streamIndex << ", sample " << expectedSampleNumber;
+    }
+
+    queue.stopReadStream (streamIndex);
+
+    nextSampleNumber += numSamples;
+}
+} // namespace
+
+/*
+A 30 kHz stream that fills every block and a 2.5 kHz stream that delivers
+its samples in bursts of a whole block, queued with buffers sized by their
+sample rates, are both read back completely and in order.
+*/
+TEST (DataQueueTest, QueuesStreamsWithDifferentRates)
+{
+    const int blockSize = 1024;
+    const int numBlocks = 16;
+    const double blockSampleRate = 30000.0;
+    const double sampleRates[] = { 30000.0, 2500.0 };
+
+    const Array<int> channelCounts = { 2, 1 };
+    const Array<int> blockSizes = { GenericProcessor::getStreamBlockSize (float (sampleRates[0]), blockSampleRate, blockSize),
+                                    GenericProcessor::getStreamBlockSize (float (sampleRates[1]), blockSampleRate, blockSize) };
+
+    ASSERT_EQ (blockSizes[0], blockSize);
+    ASSERT_LT (blockSizes[1], blockSize / 4);
+
+    DataQueue queue (blockSize, numBlocks);
+    queue.setStreamChannelCounts (channelCounts, blockSizes);
+
+    ASSERT_EQ (queue.getNumStreams(), 2);
+    ASSERT_EQ (queue.getFirstChannelForStream (1), 2);
+
+    AudioBuffer<float> buffer (3, blockSize);
+
+    int64 writtenSampleNumbers[] = { 0, 0 };
+    int64 readSampleNumbers[] = { 0, 0 };
+
+    const int numWrites = 120;
+
+    for (int block = 0; block < numWrites; block++)
+    {
+        // the slow stream delivers 12 blocks' worth of its samples at once
+        const int numSamples[] = { blockSize, block % 12 == 11 ? blockSize : 0 };
+
+        int firstChannel = 0;
+
+        for (int stream = 0; stream < 2; stream++)
+        {
+            std::vector<int> sourceChannels;
+
+            for (int chan = 0; chan < channelCounts[stream]; chan++)
+            {
+                sourceChannels.push_back (firstChannel + chan);
+
+                for (int i = 0; i < numSamples[stream]; i++)
+                    buffer.setSample (firstChannel + chan, i, getSampleValue (firstChannel + chan, writtenSampleNumbers[stream] + i));
+            }
+
+            if (numSamples[stream] > 0)
+            {
+                const float usage = queue.writeStream (buffer,
+                                                       stream,
+                                                       sourceChannels.data(),
+                                                       numSamples[stream],
+                                                       writtenSampleNumbers[stream],
+                                                       double (writtenSampleNumbers[stream]) / sampleRates[stream],
+                                                       1.0 / sampleRates[stream]);
+
+                EXPECT_LT (usage, 1.0f) << "stream " << stream << ", block " << block;
+            }
+
+            writtenSampleNumbers[stream] += numSamples[stream];
+            firstChannel += channelCounts[stream];
+        }
+
+        // the record thread falls a few blocks behind
+        if (block % 4 == 3)
+        {
+            for (int stream = 0; stream < 2; stream++)
+                readStream (queue, stream, readSampleNumbers[stream], sampleRates[stream]);
+        }
+    }
+
+    for (int stream = 0; stream < 2; stream++)
+    {
+        readStream (queue, stream, readSampleNumbers[stream], sampleRates[stream]);
+
+        EXPECT_EQ (readSampleNumbers[stream], writtenSampleNumbers[stream]) << "stream " << stream;
+    }
+
+    EXPECT_EQ (writtenSampleNumbers[1], int64 (numWrites / 12) * blockSize);
+}
@@ -0,0 +1,62 @@
+#include "gtest/gtest.h"
+
+#include <Processors/FileReader/FileSource.h>
+
+namespace
+{
+void addEvent (EventInfo& info, int64 sampleNumber, int16 channel)
+{
+    info.channels.push_back (channel);
+    info.channelStates.push_back (1);
+    info.sampleNumbers.push_back (sampleNumber);
+    info.text.push_back (String (channel));
+}
+} // namespace
+
+/*
+Sorting reorders every column together, and keeps events with the
+same sample number in their original order.
+*/
+TEST (EventInfoTest, SortsAllColumnsBySampleNumber)
+{
+    EventInfo info;
+    addEvent (info, 30, 0);
+    addEvent (info, 10, 1);
+    addEvent (info, 20, 2);
+    addEvent (info, 10, 3);
+
+    info.sortBySampleNumber();
+
+    ASSERT_EQ (info.size(), 4);
+
+    const int64 expectedSampleNumbers[] = { 10, 10, 20, 30 };
+    const int16 expectedChannels[] = { 1, 3, 2, 0 };
+
+    for (size_t i = 0; i < info.size(); i++)
+    {
+        EXPECT_EQ (info.sampleNumbers[i], expectedSampleNumbers[i]);
+        EXPECT_EQ (info.channels[i], expectedChannels[i]);
+        EXPECT_EQ (info.text[i], String (expectedChannels[i]));
+    }
+}
+
+/*
+findFirstEvent returns the first event at or after a sample number,
+or size() when every event is earlier.
+*/
+TEST (EventInfoTest, FindsFirstEventInRange)
+{
+    EventInfo info;
+
+    for (int i = 0; i < 100; i++)
+        addEvent (info, i * 10, int16 (i % 8));
+
+    EXPECT_EQ (info.findFirstEvent (-5), 0);
+    EXPECT_EQ (info.findFirstEvent (0), 0);
+    EXPECT_EQ (info.findFirstEvent (1), 1);
+    EXPECT_EQ (info.findFirstEvent (500), 50);
+    EXPECT_EQ (info.findFirstEvent (991), 100);
+
+    EventInfo empty;
+    EXPECT_EQ (empty.findFirstEvent (0), 0);
+}
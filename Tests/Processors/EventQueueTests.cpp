@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+
+#include <Processors/RecordNode/EventQueue.h>
+
+#include <vector>
+
+/*
+Packets written to the Event Queue are read back in order, with their
+sample numbers, extra values and contents unchanged.
+*/
+TEST (EventQueueTest, ReadsBackInOrder)
+{
+    EventQueue queue (1024);
+
+    for (int i = 0; i < 5; i++)
+    {
+        uint8 data[10];
+        memset (data, i, sizeof (data));
+        ASSERT_TRUE (queue.addEvent (data, sizeof (data), 100 + i, i));
+    }
+
+    EXPECT_EQ (queue.getRemainingEvents(), 5);
+
+    int count = 0;
+    int numRead = queue.readEvents (0, [&] (const uint8* data, size_t size, int64 sampleNumber, int extra)
+                                    {
+        EXPECT_EQ (size, 10);
+        EXPECT_EQ (sampleNumber, 100 + count);
+        EXPECT_EQ (extra, count);
+
+        for (size_t i = 0; i < size; i++)
+            EXPECT_EQ (data[i], count);
+
+        count++; });
+
+    EXPECT_EQ (numRead, 5);
+    EXPECT_EQ (queue.getRemainingEvents(), 0);
+    EXPECT_EQ (queue.getNumDroppedEvents(), 0);
+}
+
+/*
+Reading is limited by the maximum number of events requested.
+*/
+TEST (EventQueueTest, RespectsMaxEvents)
+{
+    EventQueue queue (1024);
+
+    uint8 data[4] = { 0, 1, 2, 3 };
+
+    for (int i = 0; i < 6; i++)
+        queue.addEvent (data, sizeof (data), i);
+
+    std::vector<int64> sampleNumbers;
+    auto collect = [&] (const uint8*, size_t, int64 sampleNumber, int)
+    { sampleNumbers.push_back (sampleNumber); };
+
+    EXPECT_EQ (queue.readEvents (4, collect), 4);
+    EXPECT_EQ (queue.getRemainingEvents(), 2);
+    EXPECT_EQ (queue.readEvents (4, collect), 2);
+
+    ASSERT_EQ (sampleNumbers.size(), 6);
+    for (int i = 0; i < 6; i++)
+        EXPECT_EQ (sampleNumbers[i], i);
+}
+
+/*
+Records that would cross the end of the buffer are moved to its start,
+and are read back intact.
+*/
+TEST (EventQueueTest, WrapsAround)
+{
+    // Each 40-byte packet takes 64 bytes (16-byte header + 48 bytes of padded data)
+    EventQueue queue (256);
+
+    uint8 data[40];
+    int64 nextWritten = 0;
+    int64 nextRead = 0;
+
+    for (int iteration = 0; iteration < 50; iteration++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            memset (data, int (nextWritten & 0xFF), sizeof (data));
+            ASSERT_TRUE (queue.addEvent (data, sizeof (data), nextWritten));
+            nextWritten++;
+        }
+
+        queue.readEvents (0, [&] (const uint8* packet, size_t size, int64 sampleNumber, int)
+                          {
+            EXPECT_EQ (size, sizeof (data));
+            EXPECT_EQ (sampleNumber, nextRead);
+            EXPECT_EQ (packet[0], nextRead & 0xFF);
+            EXPECT_EQ (packet[size - 1], nextRead & 0xFF);
+            nextRead++; });
+    }
+
+    EXPECT_EQ (nextRead, nextWritten);
+    EXPECT_EQ (queue.getNumDroppedEvents(), 0);
+}
+
+/*
+When the queue is full, new packets are dropped and counted rather than
+overwriting unread data.
+*/
+TEST (EventQueueTest, CountsOverflow)
+{
+    EventQueue queue (128);
+
+    uint8 data[16] = {};
+
+    // 32 bytes per record: four fit
+    for (int i = 0; i < 6; i++)
+        queue.addEvent (data, sizeof (data), i);
+
+    EXPECT_EQ (queue.getRemainingEvents(), 4);
+    EXPECT_EQ (queue.getNumDroppedEvents(), 2);
+    EXPECT_EQ (queue.getNumDroppedBytes(), 32);
+    EXPECT_FLOAT_EQ (queue.getUsage(), 1.0f);
+
+    EXPECT_EQ (queue.prepareToWrite (sizeof (data)), nullptr);
+    EXPECT_EQ (queue.getNumDroppedEvents(), 3);
+
+    int64 lastSampleNumber = -1;
+    queue.readEvents (0, [&] (const uint8*, size_t, int64 sampleNumber, int)
+                      { lastSampleNumber = sampleNumber; });
+
+    EXPECT_EQ (lastSampleNumber, 3);
+
+    queue.reset();
+
+    EXPECT_EQ (queue.getNumDroppedEvents(), 0);
+    EXPECT_EQ (queue.getRemainingEvents(), 0);
+}
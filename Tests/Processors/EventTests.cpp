@@ -197,6 +197,65 @@ TEST_F(EventTests, SerializeDeserializeEvent)
     }
 }
 
+/*
+A spike packet written in place should hold the same bytes as a serialized
+Spike, and a view of those bytes should return the same values.
+*/
+TEST_F(EventTests, SpikePacketMatchesSerializedSpike)
+{
+    SpikeChannel spikeChannel(SpikeChannel::Settings{
+        SpikeChannel::Type::SINGLE, "Spike", "Spike", "identifier.spike", { 0 }, 2, 3
+    });
+    spikeChannel.setDataStream(dataStream.get(), false);
+    spikeChannel.setLocalIndex(0);
+    spikeChannel.addProcessor(processor.get());
+
+    const int numSamples = spikeChannel.getTotalSamples();
+
+    Spike::Buffer spikeBuffer(&spikeChannel);
+    Spike::Packet packet(&spikeChannel);
+
+    packet.setHeader(1234);
+    packet.setThreshold(0, -50.0f);
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        spikeBuffer.set(0, i, float(i) - 2.5f);
+        packet.set(0, i, float(i) - 2.5f);
+    }
+
+    SpikePtr spike = Spike::createSpike(&spikeChannel, 1234, Array<float>({ -50.0f }), spikeBuffer);
+
+    size_t size = SPIKE_BASE_SIZE + spikeChannel.getDataSize() + spikeChannel.getNumChannels() * sizeof(float);
+    HeapBlock<uint8> buffer(size, true);
+
+    spike->serialize(buffer, size);
+
+    ASSERT_EQ(packet.getSize(), size);
+    EXPECT_EQ(memcmp(packet.getRawData(), buffer.getData(), size), 0);
+
+    Spike::View view(packet.getRawData(), &spikeChannel);
+
+    EXPECT_TRUE(view.isValid());
+    EXPECT_EQ(view.getSize(), size);
+    EXPECT_EQ(view.getSampleNumber(), 1234);
+    EXPECT_EQ(view.getThreshold(0), -50.0f);
+
+    for (int i = 0; i < numSamples; i++)
+        EXPECT_EQ(view.getSample(0, i), float(i) - 2.5f);
+
+    std::vector<float> samples(numSamples);
+    view.copyChannelData(0, samples.data());
+    EXPECT_EQ(samples[numSamples - 1], float(numSamples - 1) - 2.5f);
+
+    SpikePtr deserializedSpike = Spike::deserialize(view);
+
+    ASSERT_NE(deserializedSpike, nullptr);
+    EXPECT_EQ(deserializedSpike->getSampleNumber(), 1234);
+    EXPECT_EQ(deserializedSpike->getThreshold(0), -50.0f);
+    EXPECT_EQ(deserializedSpike->getDataPointer(0)[numSamples - 1], float(numSamples - 1) - 2.5f);
+}
+
 /*
 TTLEvent should return the correct state.
 */
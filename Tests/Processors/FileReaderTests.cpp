@@ -0,0 +1,251 @@
+#include "gtest/gtest.h"
+
+#include <Processors/FileReader/PlaybackStream.h>
+
+namespace
+{
+/** Plays back a stream on the shared clock, as the File Reader does with a full cache */
+struct SimulatedStream
+{
+    double sampleRate;
+    int64 samplesPlayed = 0;
+    int64 samplesInBuffer = 0;
+
+    void playBlock (int64 deviceSamplesPlayed, double deviceSampleRate, int blockSize)
+    {
+        int samplesToPlay;
+        int64 samplesToSkip;
+
+        PlaybackStream::getSamplesDue (deviceSamplesPlayed, deviceSampleRate, sampleRate, samplesPlayed, blockSize, samplesToPlay, samplesToSkip);
+
+        ASSERT_LE (samplesToPlay, blockSize);
+        ASSERT_GE (samplesToSkip, 0);
+
+        samplesPlayed += samplesToPlay + samplesToSkip;
+        samplesInBuffer += samplesToPlay;
+    }
+};
+/** Returns the value a cached stream holds for a sample number on a channel */
+float getSampleValue (int64 sampleNumber, int channel)
+{
+    return channel == 0 ? float (sampleNumber) : -float (sampleNumber);
+}
+
+/** A playback stream whose cache is filled with its own sample numbers, as if read from a file */
+struct CachedStream
+{
+    CachedStream (float sampleRate, int numChannels, int64 numSamples, int blockSize, double deviceSampleRate)
+    {
+        stream.sampleRate = sampleRate;
+        stream.numChannels = numChannels;
+        stream.numSamples = numSamples;
+        stream.startSample = 0;
+        stream.stopSample = numSamples;
+
+        stream.allocateCache (blockSize, deviceSampleRate);
+        stream.resetPlayback (0);
+        fill();
+    }
+
+    /** Fills the cache, looping at the end of the playback range, as the background thread does */
+    void fill()
+    {
+        stream.fillCache ([this] (float* dest, int numSamples)
+                          {
+            for (int i = 0; i < numSamples; i++)
+            {
+                if (stream.readPosition >= stream.stopSample)
+                    stream.readPosition = stream.startSample;
+
+                for (int ch = 0; ch < stream.numChannels; ch++)
+                    dest[i * stream.numChannels + ch] = getSampleValue (stream.readPosition, ch);
+
+                stream.readPosition++;
+            }
+
+            return numSamples; });
+    }
+
+    PlaybackStream stream;
+};
+} // namespace
+
+/*
+Two streams, one slower and one faster than the audio device, both stay
+in time with the device clock. The faster stream can't fit all of its
+samples into each block, so the rest are skipped instead of adding up.
+*/
+TEST (FileReaderTest, TwoStreamsFollowDeviceClock)
+{
+    const double deviceSampleRate = 44100.0;
+    const int blockSize = 1024;
+
+    SimulatedStream slowStream { 30000.0 };
+    SimulatedStream fastStream { 96000.0 };
+
+    int64 deviceSamplesPlayed = 0;
+
+    for (int block = 0; block < 1000; block++)
+    {
+        deviceSamplesPlayed += blockSize;
+
+        slowStream.playBlock (deviceSamplesPlayed, deviceSampleRate, blockSize);
+        fastStream.playBlock (deviceSamplesPlayed, deviceSampleRate, blockSize);
+
+        for (auto* stream : { &slowStream, &fastStream })
+        {
+            const int64 samplesDue = int64 (double (deviceSamplesPlayed) * stream->sampleRate / deviceSampleRate);
+
+            ASSERT_EQ (stream->samplesPlayed, samplesDue) << stream->sampleRate << " Hz, block " << block;
+        }
+    }
+
+    // the slower stream delivers every sample, the faster one fills every block
+    EXPECT_EQ (slowStream.samplesInBuffer, slowStream.samplesPlayed);
+    EXPECT_EQ (fastStream.samplesInBuffer, int64 (1000) * blockSize);
+}
+
+/*
+A stream that fell behind (for example after its cache ran short) plays
+as much of the backlog as fits into the block, and only skips the rest.
+*/
+TEST (FileReaderTest, CatchesUpWithinOneBlock)
+{
+    int samplesToPlay;
+    int64 samplesToSkip;
+
+    // 30 kHz at 44.1 kHz: 696 samples are due after one block, 1393 after two
+    PlaybackStream::getSamplesDue (2048, 44100.0, 30000.0, 200, 1024, samplesToPlay, samplesToSkip);
+
+    EXPECT_EQ (samplesToPlay, 1024);
+    EXPECT_EQ (samplesToSkip, 1393 - 200 - 1024);
+
+    PlaybackStream::getSamplesDue (2048, 44100.0, 30000.0, 696, 1024, samplesToPlay, samplesToSkip);
+
+    EXPECT_EQ (samplesToPlay, 1393 - 696);
+    EXPECT_EQ (samplesToSkip, 0);
+
+    // a stream that is ahead of the clock waits
+    PlaybackStream::getSamplesDue (1024, 44100.0, 30000.0, 800, 1024, samplesToPlay, samplesToSkip);
+
+    EXPECT_EQ (samplesToPlay, 0);
+    EXPECT_EQ (samplesToSkip, 0);
+}
+
+/*
+Two streams at different rates, played through their caches, receive the
+sample numbers that are due at the device clock in every block, without
+gaps or repeats, and loop at the end of their playback range.
+*/
+TEST (FileReaderTest, CachedStreamsStayAligned)
+{
+    const double deviceSampleRate = 44100.0;
+    const int blockSize = 512;
+
+    std::vector<std::unique_ptr<CachedStream>> streams;
+    streams.push_back (std::make_unique<CachedStream> (30000.0f, 2, 10000000, blockSize, deviceSampleRate));
+    streams.push_back (std::make_unique<CachedStream> (10000.0f, 1, 25000, blockSize, deviceSampleRate));
+
+    AudioBuffer<float> buffer (3, blockSize);
+    std::vector<int64> nextSample (streams.size(), 0);
+
+    int64 deviceSamplesPlayed = 0;
+
+    for (int blockIndex = 0; blockIndex < 2000; blockIndex++)
+    {
+        deviceSamplesPlayed += blockSize;
+        buffer.clear();
+
+        int firstChannel = 0;
+
+        for (size_t s = 0; s < streams.size(); s++)
+        {
+            PlaybackStream& stream = streams[s]->stream;
+
+            int samplesToPlay;
+            int64 samplesToSkip;
+            stream.getSamplesDue (deviceSamplesPlayed, deviceSampleRate, blockSize, samplesToPlay, samplesToSkip);
+
+            const PlaybackStream::Block block = stream.play (buffer, firstChannel, samplesToPlay, samplesToSkip, true);
+
+            ASSERT_EQ (block.numSamples, samplesToPlay) << stream.sampleRate << " Hz, block " << blockIndex;
+            ASSERT_EQ (block.numSkipped, 0) << stream.sampleRate << " Hz, block " << blockIndex;
+            ASSERT_EQ (block.startSample, nextSample[s]) << stream.sampleRate << " Hz, block " << blockIndex;
+
+            for (int i = 0; i < block.numSamples; i++)
+            {
+                for (int ch = 0; ch < stream.numChannels; ch++)
+                {
+                    ASSERT_EQ (buffer.getSample (firstChannel + ch, i), getSampleValue (nextSample[s], ch))
+                        << stream.sampleRate << " Hz, block " << blockIndex << ", sample " << i;
+                }
+
+                if (++nextSample[s] == stream.stopSample)
+                    nextSample[s] = stream.startSample;
+            }
+
+            // both streams have played exactly the samples that are due at the device clock
+            ASSERT_EQ (stream.samplesPlayed, int64 (double (deviceSamplesPlayed) * stream.sampleRate / deviceSampleRate));
+
+            firstChannel += stream.numChannels;
+        }
+
+        for (auto& stream : streams)
+            stream->fill();
+    }
+
+    // the 10 kHz stream has looped
+    EXPECT_GT (streams[1]->stream.samplesPlayed, streams[1]->stream.stopSample);
+}
+
+/*
+A stream sampled faster than the audio device fills every block, and skips
+the cached samples that don't fit, so the next block starts at the sample
+that is due then instead of lagging further behind.
+*/
+TEST (FileReaderTest, CachedFastStreamSkipsSamples)
+{
+    const double deviceSampleRate = 44100.0;
+    const int blockSize = 1024;
+
+    CachedStream cached (96000.0f, 1, 100000000, blockSize, deviceSampleRate);
+    PlaybackStream& stream = cached.stream;
+
+    AudioBuffer<float> buffer (1, blockSize);
+
+    int64 deviceSamplesPlayed = 0;
+    int64 totalSkipped = 0;
+
+    for (int blockIndex = 0; blockIndex < 1000; blockIndex++)
+    {
+        const int64 samplesDueBefore = int64 (double (deviceSamplesPlayed) * stream.sampleRate / deviceSampleRate);
+
+        deviceSamplesPlayed += blockSize;
+
+        int samplesToPlay;
+        int64 samplesToSkip;
+        stream.getSamplesDue (deviceSamplesPlayed, deviceSampleRate, blockSize, samplesToPlay, samplesToSkip);
+
+        const PlaybackStream::Block block = stream.play (buffer, 0, samplesToPlay, samplesToSkip, true);
+
+        ASSERT_EQ (block.numSamples, blockSize) << "block " << blockIndex;
+        ASSERT_EQ (block.numSkipped, samplesToSkip) << "block " << blockIndex;
+        ASSERT_GT (block.numSkipped, 0) << "block " << blockIndex;
+
+        // each block starts with the first sample due in it
+        ASSERT_EQ (block.startSample, samplesDueBefore) << "block " << blockIndex;
+
+        for (int i = 0; i < blockSize; i++)
+            ASSERT_EQ (buffer.getSample (0, i), getSampleValue (block.startSample + i, 0)) << "block " << blockIndex << ", sample " << i;
+
+        totalSkipped += block.numSkipped;
+
+        cached.fill();
+    }
+
+    const int64 samplesDue = int64 (double (deviceSamplesPlayed) * stream.sampleRate / deviceSampleRate);
+
+    EXPECT_EQ (stream.samplesPlayed, samplesDue);
+    EXPECT_EQ (stream.playbackPosition, samplesDue);
+    EXPECT_EQ (totalSkipped, samplesDue - int64 (1000) * blockSize);
+}
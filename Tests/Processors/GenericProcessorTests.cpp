@@ -136,4 +136,22 @@ TEST_F (GenericProcessorTests, UnitTest_AddBooleanParameter)
     EXPECT_EQ (processor->getParameter ("param")->getName(), name);
     EXPECT_EQ (processor->getParameter ("param")->getDisplayName(), displayName);
     EXPECT_EQ (processor->getParameter ("param")->getDescription(), description);
-}
\ No newline at end of file
+}
+/*
+A stream's block size is twice the samples it delivers in a block at its
+sample rate, at least 64 samples and no more than the processor's block size.
+*/
+TEST_F (GenericProcessorTests, UnitTest_StreamBlockSize)
+{
+    // 256 samples of the 20 kHz stream arrive in each 1024-sample block at 80 kHz
+    processor->setRateAndBufferSizeDetails (80000.0, 1024);
+    EXPECT_EQ (processor->getStreamBlockSize (StreamIndex (0)), 512);
+
+    EXPECT_EQ (GenericProcessor::getStreamBlockSize (30000.0f, 44100.0, 1024), 1024);
+    EXPECT_EQ (GenericProcessor::getStreamBlockSize (2500.0f, 44100.0, 1024), 118);
+    EXPECT_EQ (GenericProcessor::getStreamBlockSize (2500.0f, 44100.0, 8192), 930);
+    EXPECT_EQ (GenericProcessor::getStreamBlockSize (1.0f, 44100.0, 1024), 64);
+    EXPECT_EQ (GenericProcessor::getStreamBlockSize (1.0f, 44100.0, 32), 32);
+    EXPECT_EQ (GenericProcessor::getStreamBlockSize (0.0f, 44100.0, 1024), 1024);
+    EXPECT_EQ (GenericProcessor::getStreamBlockSize (2500.0f, 44100.0, 0), 0);
+}
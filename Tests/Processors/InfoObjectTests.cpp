@@ -134,4 +134,144 @@ TEST_F (InfoObjectTests, CopyConstructorTest)
     EXPECT_EQ (copy.getSourceNodeName(), sourceNodeName);
     EXPECT_EQ (copy.processorChain.size(), 1);
     EXPECT_FALSE (copy.isLocal());
-}
\ No newline at end of file
+}
+// Test that a copy keeps the history and processor chain, and that adding to it leaves the original unchanged
+TEST_F (InfoObjectTests, CopyExtendsHistoryTest)
+{
+    MockGenericProcessor processor2 ("Processor2");
+
+    infoObject->addProcessor (processor);
+
+    MockInfoObject copy (*infoObject);
+    copy.addProcessor (&processor2);
+
+    EXPECT_EQ (copy.getHistoryString(), "Processor1 -> Processor2");
+    EXPECT_EQ (copy.processorChain.size(), 2);
+    EXPECT_EQ (copy.processorChain.getFirst(), processor);
+    EXPECT_EQ (copy.processorChain[1], &processor2);
+    EXPECT_EQ (copy.processorChain.getLast(), &processor2);
+    EXPECT_EQ (copy.processorChain[2], nullptr);
+
+    EXPECT_EQ (infoObject->getHistoryString(), "Processor1");
+    EXPECT_EQ (infoObject->processorChain.size(), 1);
+    EXPECT_EQ (infoObject->processorChain.getLast(), processor);
+}
+
+// Test that the processor chain can be searched and iterated like an array
+TEST_F (InfoObjectTests, ProcessorChainArrayInterfaceTest)
+{
+    MockGenericProcessor processor2 ("Processor2");
+    MockGenericProcessor processor3 ("Processor3");
+
+    EXPECT_EQ (infoObject->processorChain.begin(), infoObject->processorChain.end());
+    EXPECT_EQ (infoObject->processorChain.indexOf (processor), -1);
+
+    infoObject->addProcessor (processor);
+    infoObject->addProcessor (&processor2);
+    infoObject->addProcessor (processor);
+
+    EXPECT_TRUE (infoObject->processorChain.contains (processor));
+    EXPECT_TRUE (infoObject->processorChain.contains (&processor2));
+    EXPECT_FALSE (infoObject->processorChain.contains (&processor3));
+
+    EXPECT_EQ (infoObject->processorChain.indexOf (processor), 0);
+    EXPECT_EQ (infoObject->processorChain.indexOf (&processor2), 1);
+    EXPECT_EQ (infoObject->processorChain.indexOf (&processor3), -1);
+
+    Array<GenericProcessor*> processors;
+
+    for (auto chainProcessor : infoObject->processorChain)
+        processors.add (chainProcessor);
+
+    ASSERT_EQ (processors.size(), 3);
+    EXPECT_EQ (processors[0], processor);
+    EXPECT_EQ (processors[1], &processor2);
+    EXPECT_EQ (processors[2], processor);
+
+    EXPECT_TRUE (infoObject->processorChain.toArray() == processors);
+}
+
+// Test that objects with different histories stay separate when they pass through the same processors
+TEST_F (InfoObjectTests, SeparateHistoriesTest)
+{
+    MockGenericProcessor processor2 ("Processor2");
+    MockInfoObject other (InfoObject::Type::CONTINUOUS_CHANNEL);
+
+    infoObject->addProcessor (processor);
+    other.addProcessor (&processor2);
+
+    MockInfoObject copy (*infoObject);
+    MockInfoObject otherCopy (other);
+
+    copy.addProcessor (&processor2);
+    otherCopy.addProcessor (&processor2);
+    infoObject->addProcessor (&processor2);
+
+    EXPECT_EQ (copy.getHistoryString(), "Processor1 -> Processor2");
+    EXPECT_EQ (infoObject->getHistoryString(), "Processor1 -> Processor2");
+    EXPECT_EQ (otherCopy.getHistoryString(), "Processor2 -> Processor2");
+    EXPECT_EQ (otherCopy.processorChain.getFirst(), &processor2);
+    EXPECT_EQ (copy.processorChain.getFirst(), processor);
+}
+
+// Test that histories and processor chains have equal hashes only if they hold the same entries
+TEST_F (InfoObjectTests, HistoryAndChainHashTest)
+{
+    MockGenericProcessor processor2 ("Processor2");
+    MockInfoObject other (InfoObject::Type::CONTINUOUS_CHANNEL);
+
+    processor->setNodeId (101);
+    processor2.setNodeId (102);
+
+    EXPECT_EQ (infoObject->getHistoryHash(), 0);
+    EXPECT_EQ (infoObject->processorChain.getHash(), 0);
+
+    infoObject->addProcessor (processor);
+    infoObject->addProcessor (&processor2);
+
+    other.addProcessor (&processor2);
+    other.addProcessor (processor);
+
+    EXPECT_NE (infoObject->getHistoryHash(), other.getHistoryHash());
+    EXPECT_NE (infoObject->processorChain.getHash(), other.processorChain.getHash());
+
+    MockInfoObject copy (*infoObject);
+
+    EXPECT_EQ (copy.getHistoryHash(), infoObject->getHistoryHash());
+    EXPECT_EQ (copy.processorChain.getHash(), infoObject->processorChain.getHash());
+
+    // the same entries added to a different object give the same hashes
+    MockInfoObject same (InfoObject::Type::CONTINUOUS_CHANNEL);
+    same.addProcessor (processor);
+    same.addProcessor (&processor2);
+
+    EXPECT_EQ (same.getHistoryHash(), infoObject->getHistoryHash());
+    EXPECT_EQ (same.processorChain.getHash(), infoObject->processorChain.getHash());
+
+    copy.addProcessor (&processor2);
+
+    EXPECT_NE (copy.getHistoryHash(), infoObject->getHistoryHash());
+    EXPECT_NE (copy.processorChain.getHash(), infoObject->processorChain.getHash());
+}
+
+// Test that adding metadata to a copy leaves the original unchanged
+TEST_F (InfoObjectTests, CopyMetadataTest)
+{
+    infoObject->addMetadata (MetadataDescriptor (MetadataDescriptor::INT32, 1, "gain", "Channel gain", "channel.gain"),
+                             MetadataValue (MetadataDescriptor::INT32, 1));
+
+    MockInfoObject copy (*infoObject);
+
+    EXPECT_EQ (copy.getMetadataCount(), 1);
+    EXPECT_EQ (copy.getMetadataDescriptor (0), infoObject->getMetadataDescriptor (0));
+    EXPECT_TRUE (copy.hasSameMetadata (*infoObject));
+
+    copy.addMetadata (MetadataDescriptor (MetadataDescriptor::FLOAT, 3, "position", "Electrode position", "channel.position"),
+                      MetadataValue (MetadataDescriptor::FLOAT, 3));
+
+    EXPECT_EQ (copy.getMetadataCount(), 2);
+    EXPECT_EQ (copy.findMetadata (MetadataDescriptor::FLOAT, 3, "channel.position"), 1);
+    EXPECT_EQ (infoObject->getMetadataCount(), 1);
+    EXPECT_EQ (infoObject->getMetadataDescriptor (1), nullptr);
+    EXPECT_FALSE (copy.hasSameMetadata (*infoObject));
+}
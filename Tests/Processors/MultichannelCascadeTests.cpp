@@ -0,0 +1,164 @@
+#include "gtest/gtest.h"
+
+#include <Processors/Dsp/Dsp.h>
+
+#include <random>
+
+namespace
+{
+using Dsp::KernelType;
+
+const double sampleRate = 30000.0;
+
+/** Returns a cascade with the stages of a 4th order band-pass filter */
+Dsp::MultichannelCascade makeCascade (int numChannels)
+{
+    Dsp::Butterworth::Design::BandPass<2> design;
+
+    Dsp::Params params;
+    params[0] = sampleRate; // sample rate
+    params[1] = 2; // order
+    params[2] = (6000.0 + 300.0) / 2; // center frequency
+    params[3] = 6000.0 - 300.0; // bandwidth
+    design.setParams (params);
+
+    Dsp::MultichannelCascade cascade;
+    cascade.setNumChannels (numChannels);
+    cascade.setStages (design);
+    return cascade;
+}
+
+/** Fills a buffer with white noise */
+void fillWithNoise (AudioBuffer<float>& buffer, unsigned int seed)
+{
+    std::mt19937 rng (seed);
+    std::normal_distribution<float> distribution (0.0f, 100.0f);
+
+    for (int chan = 0; chan < buffer.getNumChannels(); chan++)
+    {
+        for (int i = 0; i < buffer.getNumSamples(); i++)
+            buffer.setSample (chan, i, distribution (rng));
+    }
+}
+
+std::string getKernelName (const testing::TestParamInfo<KernelType>& info)
+{
+    return Dsp::getKernelTypeName (info.param);
+}
+
+class MultichannelCascadeTest : public testing::TestWithParam<KernelType>
+{
+protected:
+    void SetUp() override
+    {
+        if (! Dsp::MultichannelCascade::isKernelSupported (GetParam()))
+            GTEST_SKIP() << "Kernel not supported on this CPU";
+    }
+
+    /** Checks that the kernel under test produced the same samples as the scalar kernel */
+    void expectSameSamples (const AudioBuffer<float>& output, const AudioBuffer<float>& expected, int blockSize)
+    {
+        for (int chan = 0; chan < output.getNumChannels(); chan++)
+        {
+            for (int i = 0; i < output.getNumSamples(); i++)
+            {
+                const float reference = expected.getSample (chan, i);
+                ASSERT_NEAR (output.getSample (chan, i), reference, 1.0e-5f * (1.0f + std::abs (reference)))
+                    << output.getNumChannels() << " channels, block of " << blockSize
+                    << ", channel " << chan << ", sample " << i;
+            }
+        }
+    }
+};
+} // namespace
+
+/*
+Every kernel matches the scalar cascade, for channel counts that don't fill
+whole groups and block sizes that aren't multiples of 4. The state carries
+over from one block to the next.
+*/
+TEST_P (MultichannelCascadeTest, MatchesScalarForOddSizes)
+{
+    for (int numChannels : { 1, 3, 4, 5, 8, 13, 17, 64 })
+    {
+        Dsp::MultichannelCascade cascade = makeCascade (numChannels);
+        Dsp::MultichannelCascade reference = makeCascade (numChannels);
+
+        unsigned int seed = 1;
+
+        for (int blockSize : { 1000, 7, 1, 2, 64, 333 })
+        {
+            AudioBuffer<float> expected (numChannels, blockSize);
+            fillWithNoise (expected, seed++);
+
+            AudioBuffer<float> output (expected);
+
+            cascade.process (GetParam(), blockSize, output.getArrayOfWritePointers(), 0, numChannels);
+            reference.process (KernelType::Scalar, blockSize, expected.getArrayOfWritePointers(), 0, numChannels);
+
+            expectSameSamples (output, expected, blockSize);
+        }
+    }
+}
+
+/*
+Channel ranges that start inside a group, as the Bandpass Filter threads
+may process them, give the same result as filtering all channels at once.
+*/
+TEST_P (MultichannelCascadeTest, MatchesScalarForChannelRanges)
+{
+    const int numChannels = 23;
+
+    Dsp::MultichannelCascade cascade = makeCascade (numChannels);
+    Dsp::MultichannelCascade reference = makeCascade (numChannels);
+
+    unsigned int seed = 1;
+
+    for (int blockSize : { 512, 13, 1 })
+    {
+        AudioBuffer<float> expected (numChannels, blockSize);
+        fillWithNoise (expected, seed++);
+
+        AudioBuffer<float> output (expected);
+
+        cascade.process (GetParam(), blockSize, output.getArrayOfWritePointers(), 0, 3);
+        cascade.process (GetParam(), blockSize, output.getArrayOfWritePointers(), 3, 11);
+        cascade.process (GetParam(), blockSize, output.getArrayOfWritePointers(), 14, numChannels - 14);
+
+        reference.process (KernelType::Scalar, blockSize, expected.getArrayOfWritePointers(), 0, numChannels);
+
+        expectSameSamples (output, expected, blockSize);
+    }
+}
+
+/*
+After a reset, every kernel starts again from silence.
+*/
+TEST_P (MultichannelCascadeTest, MatchesScalarAfterReset)
+{
+    const int numChannels = 9;
+    const int blockSize = 101;
+
+    Dsp::MultichannelCascade cascade = makeCascade (numChannels);
+    Dsp::MultichannelCascade reference = makeCascade (numChannels);
+
+    AudioBuffer<float> output (numChannels, blockSize);
+    fillWithNoise (output, 1);
+    cascade.process (GetParam(), blockSize, output.getArrayOfWritePointers(), 0, numChannels);
+
+    cascade.reset();
+
+    AudioBuffer<float> expected (numChannels, blockSize);
+    fillWithNoise (expected, 2);
+    output.makeCopyOf (expected);
+
+    cascade.process (GetParam(), blockSize, output.getArrayOfWritePointers(), 0, numChannels);
+    reference.process (KernelType::Scalar, blockSize, expected.getArrayOfWritePointers(), 0, numChannels);
+
+    expectSameSamples (output, expected, blockSize);
+}
+
+INSTANTIATE_TEST_SUITE_P (Kernels,
+                          MultichannelCascadeTest,
+                          testing::Values (KernelType::Scalar, KernelType::SSE2, KernelType::AVX2, KernelType::NEON),
+                          getKernelName);
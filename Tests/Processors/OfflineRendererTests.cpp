@@ -0,0 +1,48 @@
+#include "gtest/gtest.h"
+
+#include <Audio/AudioComponent.h>
+#include <Processors/MessageCenter/MessageCenter.h>
+#include <ProcessorHeaders.h>
+#include <TestFixtures.h>
+
+/*
+Offline rendering processes the signal chain without an audio device,
+and the rendering mode can't be changed while it is active.
+*/
+TEST (OfflineRendererTest, RendersWithoutAudioDevice)
+{
+    ProcessorTester tester (TestSourceNodeBuilder (FakeSourceNodeParams {}));
+
+    // the test processors have no editors to show their latencies
+    for (auto processor : tester.processorGraph->getListOfProcessors())
+        processor->setHeadlessMode (true);
+
+    tester.processorGraph->getMessageCenter()->setHeadlessMode (true);
+
+    AudioComponent* audioComponent = tester.audioComponent.get();
+    audioComponent->connectToProcessorGraph (tester.processorGraph.get());
+
+    ASSERT_TRUE (audioComponent->setOfflineRendering (true, 512));
+    ASSERT_EQ (audioComponent->getOfflineBlockSize(), 512);
+
+    ASSERT_TRUE (audioComponent->beginCallbacks());
+    EXPECT_TRUE (audioComponent->callbacksAreActive());
+
+    EXPECT_FALSE (audioComponent->setOfflineRendering (false));
+    EXPECT_TRUE (audioComponent->isOfflineRendering());
+
+    const int64 startTime = Time::currentTimeMillis();
+
+    while (audioComponent->getRealtimeFactor() <= 0.0 && Time::currentTimeMillis() - startTime < 5000)
+        Thread::sleep (1);
+
+    audioComponent->endCallbacks();
+
+    EXPECT_FALSE (audioComponent->callbacksAreActive());
+    EXPECT_GT (audioComponent->getRealtimeFactor(), 0.0);
+
+    EXPECT_TRUE (audioComponent->setOfflineRendering (false));
+    EXPECT_FALSE (audioComponent->isOfflineRendering());
+
+    audioComponent->disconnectProcessorGraph();
+}
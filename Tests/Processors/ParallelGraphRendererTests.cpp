@@ -0,0 +1,364 @@
+#include "gtest/gtest.h"
+
+#include <Processors/ProcessorGraph/ParallelGraphRenderer.h>
+
+#include <algorithm>
+#include <memory>
+
+/*
+A linear chain of nodes is a single branch.
+*/
+TEST (ParallelGraphRendererTest, ChainIsOneBranch)
+{
+    const auto schedule = ParallelGraphRenderer::createSchedule (4, { { 0, 1 }, { 1, 2 }, { 2, 3 } });
+
+    ASSERT_EQ (schedule.branches.size(), 1);
+    EXPECT_EQ (schedule.branches[0], std::vector<int> ({ 0, 1, 2, 3 }));
+
+    ASSERT_EQ (schedule.levels.size(), 1);
+    EXPECT_EQ (schedule.getMaxLevelSize(), 1);
+}
+
+/*
+Two sources that each feed their own chain, joined by a merge node,
+form two branches of the same level, followed by the branch of the join.
+*/
+TEST (ParallelGraphRendererTest, IndependentChainsShareLevel)
+{
+    // 0 -> 1 -> 2 \
+    //              6 -> 7
+    // 3 -> 4 -> 5 /
+    const auto schedule = ParallelGraphRenderer::createSchedule (
+        8, { { 0, 1 }, { 1, 2 }, { 2, 6 }, { 3, 4 }, { 4, 5 }, { 5, 6 }, { 6, 7 } });
+
+    ASSERT_EQ (schedule.branches.size(), 3);
+    ASSERT_EQ (schedule.levels.size(), 2);
+    EXPECT_EQ (schedule.getMaxLevelSize(), 2);
+
+    ASSERT_EQ (schedule.levels[0].size(), 2);
+    ASSERT_EQ (schedule.levels[1].size(), 1);
+
+    std::vector<std::vector<int>> firstLevel;
+
+    for (int branch : schedule.levels[0])
+        firstLevel.push_back (schedule.branches[branch]);
+
+    std::sort (firstLevel.begin(), firstLevel.end());
+
+    EXPECT_EQ (firstLevel[0], std::vector<int> ({ 0, 1, 2 }));
+    EXPECT_EQ (firstLevel[1], std::vector<int> ({ 3, 4, 5 }));
+
+    EXPECT_EQ (schedule.branches[schedule.levels[1][0]], std::vector<int> ({ 6, 7 }));
+}
+
+/*
+A node that feeds two destinations ends its branch, and the
+destinations start branches that can run in parallel.
+*/
+TEST (ParallelGraphRendererTest, SplitStartsNewBranches)
+{
+    // 0 -> 1 -> 2
+    //       \-> 3 -> 4
+    const auto schedule = ParallelGraphRenderer::createSchedule (5, { { 0, 1 }, { 1, 2 }, { 1, 3 }, { 3, 4 } });
+
+    ASSERT_EQ (schedule.branches.size(), 3);
+    ASSERT_EQ (schedule.levels.size(), 2);
+
+    ASSERT_EQ (schedule.levels[0].size(), 1);
+    EXPECT_EQ (schedule.branches[schedule.levels[0][0]], std::vector<int> ({ 0, 1 }));
+
+    EXPECT_EQ (schedule.levels[1].size(), 2);
+}
+
+/*
+Every node appears in exactly one branch, after all of its sources.
+*/
+TEST (ParallelGraphRendererTest, BranchesRespectDependencies)
+{
+    const int numNodes = 7;
+    const std::vector<std::pair<int, int>> edges = { { 0, 2 }, { 1, 2 }, { 2, 3 }, { 2, 4 }, { 3, 5 }, { 4, 5 }, { 1, 6 } };
+
+    const auto schedule = ParallelGraphRenderer::createSchedule (numNodes, edges);
+
+    std::vector<int> levelOfNode (numNodes, -1);
+    std::vector<int> positionInBranch (numNodes, -1);
+    std::vector<int> branchOfNode (numNodes, -1);
+
+    for (int level = 0; level < int (schedule.levels.size()); level++)
+    {
+        for (int branch : schedule.levels[level])
+        {
+            for (int i = 0; i < int (schedule.branches[branch].size()); i++)
+            {
+                const int node = schedule.branches[branch][i];
+
+                ASSERT_EQ (levelOfNode[node], -1) << "node " << node << " scheduled twice";
+
+                levelOfNode[node] = level;
+                positionInBranch[node] = i;
+                branchOfNode[node] = branch;
+            }
+        }
+    }
+
+    for (int node = 0; node < numNodes; node++)
+        EXPECT_GE (levelOfNode[node], 0) << "node " << node << " not scheduled";
+
+    for (const auto& edge : edges)
+    {
+        if (branchOfNode[edge.first] == branchOfNode[edge.second])
+            EXPECT_LT (positionInBranch[edge.first], positionInBranch[edge.second]);
+        else
+            EXPECT_LT (levelOfNode[edge.first], levelOfNode[edge.second]);
+    }
+}
+
+/*
+A graph with a cycle can't be scheduled.
+*/
+TEST (ParallelGraphRendererTest, CycleGivesEmptySchedule)
+{
+    const auto schedule = ParallelGraphRenderer::createSchedule (3, { { 0, 1 }, { 1, 2 }, { 2, 0 } });
+
+    EXPECT_TRUE (schedule.branches.empty());
+    EXPECT_TRUE (schedule.levels.empty());
+    EXPECT_EQ (schedule.getMaxLevelSize(), 0);
+}
+
+namespace
+{
+/** Records the audio and events it receives, then changes the audio
+    and adds an event, both depending on the node and the block */
+class RecordingProcessor : public AudioProcessor
+{
+public:
+    RecordingProcessor (int numInputs, int numOutputs, float gain_, int tag_)
+        : AudioProcessor (getBuses (numInputs, numOutputs)),
+          gain (gain_),
+          tag (tag_)
+    {
+    }
+
+    static BusesProperties getBuses (int numInputs, int numOutputs)
+    {
+        BusesProperties buses;
+
+        if (numInputs > 0)
+            buses = buses.withInput ("Input", AudioChannelSet::discreteChannels (numInputs));
+
+        if (numOutputs > 0)
+            buses = buses.withOutput ("Output", AudioChannelSet::discreteChannels (numOutputs));
+
+        return buses;
+    }
+
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override
+    {
+        // channels without an input hold whatever their buffer last contained
+        for (int channel = getTotalNumInputChannels(); channel < buffer.getNumChannels(); channel++)
+            buffer.clear (channel, 0, buffer.getNumSamples());
+
+        // the graph's buffers refer to its own memory, which a copy would share
+        AudioBuffer<float> received;
+        received.makeCopyOf (buffer);
+        receivedAudio.push_back (std::move (received));
+        receivedMidi.push_back (midiMessages);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+        {
+            for (int i = 0; i < buffer.getNumSamples(); i++)
+                buffer.setSample (channel, i, buffer.getSample (channel, i) * gain + float (tag * 100 + channel + numBlocks) + 0.01f * float (i));
+        }
+
+        midiMessages.addEvent (MidiMessage::noteOn (1, tag, uint8 (1 + numBlocks % 100)), tag);
+
+        numBlocks++;
+    }
+
+    const String getName() const override { return "Recording Processor " + String (tag); }
+    void prepareToPlay (double, int) override {}
+    void releaseResources() override {}
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return true; }
+    bool producesMidi() const override { return true; }
+    AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram (int) override {}
+    const String getProgramName (int) override { return String(); }
+    void changeProgramName (int, const String&) override {}
+    void getStateInformation (MemoryBlock&) override {}
+    void setStateInformation (const void*, int) override {}
+
+    std::vector<AudioBuffer<float>> receivedAudio;
+    std::vector<MidiBuffer> receivedMidi;
+
+private:
+    const float gain;
+    const int tag;
+    int numBlocks = 0;
+};
+
+class ParallelGraphRenderingTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        MessageManager::getInstance();
+    }
+
+    void TearDown() override
+    {
+        MessageManager::deleteInstance();
+    }
+
+    static const int numOutputChannels = 2;
+    static const int blockSize = 64;
+    static constexpr double sampleRate = 30000.0;
+
+    /** Builds a graph in which a source feeds two branches (one with reordered and
+        partly unconnected channels) that are summed by a merge node:
+
+        1 -> 2 \
+          \      4 -> output
+           -> 3 /
+    */
+    static std::unique_ptr<AudioProcessorGraph> createBranchedGraph()
+    {
+        auto graph = std::make_unique<AudioProcessorGraph>();
+        graph->setPlayConfigDetails (0, numOutputChannels, sampleRate, blockSize);
+
+        using NodeID = AudioProcessorGraph::NodeID;
+
+        graph->addNode (std::make_unique<RecordingProcessor> (0, 4, 1.0f, 1), NodeID (1));
+        graph->addNode (std::make_unique<RecordingProcessor> (4, 4, 0.5f, 2), NodeID (2));
+        graph->addNode (std::make_unique<RecordingProcessor> (4, 4, 2.0f, 3), NodeID (3));
+        graph->addNode (std::make_unique<RecordingProcessor> (4, 4, 1.0f, 4), NodeID (4));
+        graph->addNode (std::make_unique<AudioProcessorGraph::AudioGraphIOProcessor> (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode), NodeID (5));
+
+        auto connect = [&graph] (int source, int sourceChannel, int destination, int destinationChannel)
+        {
+            EXPECT_TRUE (graph->addConnection ({ { NodeID (uint32 (source)), sourceChannel }, { NodeID (uint32 (destination)), destinationChannel } }));
+        };
+
+        const int midi = AudioProcessorGraph::midiChannelIndex;
+
+        for (int channel = 0; channel < 4; channel++)
+            connect (1, channel, 2, channel);
+
+        // channels 0 and 1 of node 3 are left unconnected
+        connect (1, 0, 3, 3);
+        connect (1, 1, 3, 2);
+
+        // node 4 sums node 3's channels 2 and 3 into channels 0 and 1 of node 2
+        for (int channel = 0; channel < 4; channel++)
+            connect (2, channel, 4, channel);
+
+        connect (3, 2, 4, 0);
+        connect (3, 3, 4, 1);
+
+        for (int channel = 0; channel < numOutputChannels; channel++)
+            connect (4, channel, 5, channel);
+
+        connect (1, midi, 2, midi);
+        connect (1, midi, 3, midi);
+        connect (2, midi, 4, midi);
+        connect (3, midi, 4, midi);
+
+        graph->prepareToPlay (sampleRate, blockSize);
+
+        return graph;
+    }
+
+    static RecordingProcessor* getProcessor (AudioProcessorGraph& graph, int nodeId)
+    {
+        return dynamic_cast<RecordingProcessor*> (graph.getNodeForId (AudioProcessorGraph::NodeID (uint32 (nodeId)))->getProcessor());
+    }
+
+    static void expectEqual (const AudioBuffer<float>& expected, const AudioBuffer<float>& actual, const std::string& what)
+    {
+        ASSERT_EQ (expected.getNumChannels(), actual.getNumChannels()) << what;
+        ASSERT_EQ (expected.getNumSamples(), actual.getNumSamples()) << what;
+
+        for (int channel = 0; channel < expected.getNumChannels(); channel++)
+        {
+            for (int i = 0; i < expected.getNumSamples(); i++)
+                ASSERT_EQ (expected.getSample (channel, i), actual.getSample (channel, i)) << what << ", channel " << channel << ", sample " << i;
+        }
+    }
+
+    static void expectEqual (const MidiBuffer& expected, const MidiBuffer& actual, const std::string& what)
+    {
+        ASSERT_EQ (expected.getNumEvents(), actual.getNumEvents()) << what;
+
+        auto actualEvent = actual.begin();
+
+        for (const auto metadata : expected)
+        {
+            const auto other = *actualEvent++;
+
+            EXPECT_EQ (metadata.samplePosition, other.samplePosition) << what;
+            ASSERT_EQ (metadata.numBytes, other.numBytes) << what;
+            EXPECT_EQ (memcmp (metadata.data, other.data, size_t (metadata.numBytes)), 0) << what;
+        }
+    }
+};
+} // namespace
+
+/*
+Rendering the branches of a graph in parallel gives every node the same
+audio and events as AudioProcessorGraph does: summed and cleared channels,
+reordered channels, and events merged from several sources.
+*/
+TEST_F (ParallelGraphRenderingTest, MatchesAudioProcessorGraph)
+{
+    auto serialGraph = createBranchedGraph();
+    auto parallelGraph = createBranchedGraph();
+
+    ParallelGraphRenderer renderer;
+    renderer.prepare (*parallelGraph, blockSize);
+
+    ASSERT_TRUE (renderer.canRunInParallel());
+
+    const int numBlocks = 5;
+
+    for (int block = 0; block < numBlocks; block++)
+    {
+        AudioBuffer<float> serialOutput (numOutputChannels, blockSize);
+        AudioBuffer<float> parallelOutput (numOutputChannels, blockSize);
+        serialOutput.clear();
+        parallelOutput.clear();
+
+        MidiBuffer serialMidi;
+        MidiBuffer parallelMidi;
+
+        serialGraph->processBlock (serialOutput, serialMidi);
+        ASSERT_TRUE (renderer.render (parallelOutput, parallelMidi));
+
+        const std::string blockName = "block " + std::to_string (block);
+
+        expectEqual (serialOutput, parallelOutput, "output, " + blockName);
+        expectEqual (serialMidi, parallelMidi, "output events, " + blockName);
+    }
+
+    for (int nodeId = 1; nodeId <= 4; nodeId++)
+    {
+        RecordingProcessor* serial = getProcessor (*serialGraph, nodeId);
+        RecordingProcessor* parallel = getProcessor (*parallelGraph, nodeId);
+
+        ASSERT_EQ (serial->receivedAudio.size(), size_t (numBlocks));
+        ASSERT_EQ (parallel->receivedAudio.size(), size_t (numBlocks));
+
+        for (int block = 0; block < numBlocks; block++)
+        {
+            const std::string what = "node " + std::to_string (nodeId) + ", block " + std::to_string (block);
+
+            expectEqual (serial->receivedAudio[size_t (block)], parallel->receivedAudio[size_t (block)], what);
+            expectEqual (serial->receivedMidi[size_t (block)], parallel->receivedMidi[size_t (block)], what);
+        }
+    }
+
+    // the merge node received the events of the source through both branches, and those of each branch
+    EXPECT_EQ (getProcessor (*parallelGraph, 4)->receivedMidi.back().getNumEvents(), 4);
+}
@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include <Audio/AudioComponent.h>
 #include <Processors/ProcessorGraph/ProcessorGraph.h>
+#include <ProcessorHeaders.h>
+#include <TestFixtures.h>
 #include <UI/ControlPanel.h>
 #include <modules/juce_gui_basics/juce_gui_basics.h>
 
@@ -162,3 +164,184 @@ TEST_F (ProcessorGraphTest, LoadFromXMLTest)
     ASSERT_EQ (bandpassFilter->getSourceNode(), fileReader);
     ASSERT_EQ (bandpassFilter->getDestNode(), nullptr);
 }
+
+namespace
+{
+class CountingProcessor : public GenericProcessor
+{
+public:
+    CountingProcessor() : GenericProcessor ("Counting Processor", true)
+    {
+    }
+
+    void process (AudioBuffer<float>&) override {}
+
+    void updateSettings() override
+    {
+        numUpdates++;
+
+        if (channelName.isNotEmpty() && continuousChannels.size() > 0)
+            continuousChannels[0]->setName (channelName);
+
+        if (channelGain != 0 && continuousChannels.size() > 0)
+        {
+            MetadataDescriptor descriptor (MetadataDescriptor::INT32, 1, "Gain", "Channel gain", "channel.gain");
+            MetadataValue value (descriptor);
+            value.setValue (channelGain);
+
+            continuousChannels[0]->addMetadata (descriptor, value);
+        }
+
+        if (channelDepth != 0.0f && continuousChannels.size() > 0)
+            continuousChannels[0]->position.y = channelDepth;
+    }
+
+    int numUpdates = 0;
+    String channelName;
+    int channelGain = 0;
+    float channelDepth = 0.0f;
+};
+
+class SignalChainUpdateTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        tester = std::make_unique<ProcessorTester> (TestSourceNodeBuilder (FakeSourceNodeParams {}));
+
+        // source -> first -> second -> third
+        first = tester->createProcessor<CountingProcessor> (Plugin::Processor::FILTER);
+        second = tester->createProcessor<CountingProcessor> (Plugin::Processor::FILTER);
+        third = tester->createProcessor<CountingProcessor> (Plugin::Processor::FILTER);
+
+        tester->getSourceNode()->setDestNode (first);
+        first->setDestNode (second);
+        second->setSourceNode (first);
+        second->setDestNode (third);
+        third->setSourceNode (second);
+
+        tester->processorGraph->updateSettings (second);
+
+        first->numUpdates = second->numUpdates = third->numUpdates = 0;
+    }
+
+    std::unique_ptr<ProcessorTester> tester;
+    CountingProcessor* first;
+    CountingProcessor* second;
+    CountingProcessor* third;
+};
+} // namespace
+
+/*
+A processor whose output is unchanged does not update the processors after it.
+*/
+TEST_F (SignalChainUpdateTest, StopsAtUnchangedOutput)
+{
+    tester->processorGraph->updateSettings (first);
+
+    EXPECT_EQ (first->numUpdates, 1);
+    EXPECT_FALSE (first->hasOutputLayoutChanged());
+    EXPECT_EQ (second->numUpdates, 0);
+    EXPECT_EQ (third->numUpdates, 0);
+}
+
+/*
+A changed channel is passed on to every processor downstream.
+*/
+TEST_F (SignalChainUpdateTest, PropagatesChangedOutput)
+{
+    first->channelName = "Renamed";
+    tester->processorGraph->updateSettings (first);
+
+    EXPECT_TRUE (first->hasOutputLayoutChanged());
+    EXPECT_EQ (second->numUpdates, 1);
+    EXPECT_EQ (third->numUpdates, 1);
+    EXPECT_EQ (third->getContinuousChannel (0)->getName(), "Renamed");
+
+    // updating again with the same name changes nothing
+    tester->processorGraph->updateSettings (first);
+
+    EXPECT_EQ (first->numUpdates, 2);
+    EXPECT_EQ (second->numUpdates, 1);
+}
+
+/*
+A change to a channel's metadata value is passed on, even though the
+channel keeps the same metadata fields.
+*/
+TEST_F (SignalChainUpdateTest, PropagatesChangedMetadata)
+{
+    first->channelGain = 10;
+    tester->processorGraph->updateSettings (first);
+
+    EXPECT_TRUE (first->hasOutputLayoutChanged());
+    EXPECT_EQ (third->numUpdates, 1);
+
+    first->channelGain = 20;
+    tester->processorGraph->updateSettings (first);
+
+    EXPECT_TRUE (first->hasOutputLayoutChanged());
+    EXPECT_EQ (third->numUpdates, 2);
+
+    const ContinuousChannel* channel = third->getContinuousChannel (0);
+    const int index = channel->findMetadata (MetadataDescriptor::INT32, 1, "channel.gain");
+
+    ASSERT_GE (index, 0);
+
+    int gain = 0;
+    channel->getMetadataValue (index)->getValue (gain);
+    EXPECT_EQ (gain, 20);
+}
+
+/*
+A change to a channel's position alone (e.g. remapped electrode depths)
+is passed on to every processor downstream.
+*/
+TEST_F (SignalChainUpdateTest, PropagatesChangedPosition)
+{
+    first->channelDepth = 100.0f;
+    tester->processorGraph->updateSettings (first);
+
+    EXPECT_TRUE (first->hasOutputLayoutChanged());
+    EXPECT_EQ (third->numUpdates, 1);
+    EXPECT_EQ (third->getContinuousChannel (0)->position.y, 100.0f);
+
+    tester->processorGraph->updateSettings (first);
+
+    EXPECT_FALSE (first->hasOutputLayoutChanged());
+    EXPECT_EQ (third->numUpdates, 1);
+
+    first->channelDepth = 200.0f;
+    tester->processorGraph->updateSettings (first);
+
+    EXPECT_TRUE (first->hasOutputLayoutChanged());
+    EXPECT_EQ (third->numUpdates, 2);
+    EXPECT_EQ (third->getContinuousChannel (0)->position.y, 200.0f);
+}
+
+/*
+Updates requested during a batch are made once, when the batch ends,
+with each processor updated after its source.
+*/
+TEST_F (SignalChainUpdateTest, CoalescesBatchUpdates)
+{
+    ProcessorGraph* graph = tester->processorGraph.get();
+
+    graph->beginBatchUpdate();
+
+    first->channelName = "Renamed";
+    graph->updateSettings (third);
+    graph->updateSettings (first);
+    graph->updateSettings (second);
+    graph->updateSettings (first);
+
+    EXPECT_EQ (first->numUpdates, 0);
+    EXPECT_EQ (third->numUpdates, 0);
+
+    graph->endBatchUpdate();
+
+    EXPECT_EQ (first->numUpdates, 1);
+    EXPECT_EQ (second->numUpdates, 1);
+    EXPECT_EQ (third->numUpdates, 1);
+    EXPECT_EQ (third->getContinuousChannel (0)->getName(), "Renamed");
+}
@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+
+#include <Processors/GenericProcessor/ProcessorProfiler.h>
+
+namespace
+{
+int64 millisecondsToTicks (double ms)
+{
+    return int64 (ms / 1000.0 * double (Time::getHighResolutionTicksPerSecond()));
+}
+} // namespace
+
+/*
+Bins are spaced logarithmically, and each bin's upper edge
+lies above every time that falls into it.
+*/
+TEST (ProcessorProfilerTest, BinsCoverExecutionTimes)
+{
+    EXPECT_EQ (ProcessorProfiler::getBin (0.0), 0);
+    EXPECT_EQ (ProcessorProfiler::getBin (0.5), 0);
+    EXPECT_EQ (ProcessorProfiler::getBin (1.0e12), ProcessorProfiler::numBins - 1);
+
+    for (double us = 1.0; us < 1.0e6; us *= 1.037)
+    {
+        const int bin = ProcessorProfiler::getBin (us);
+
+        EXPECT_LE (us, ProcessorProfiler::getBinUpperEdge (bin));
+        EXPECT_GT (us, ProcessorProfiler::getBinUpperEdge (bin - 1) * 0.999999);
+    }
+}
+
+/*
+Percentiles are accurate to within one bin, and blocks that
+take longer than their deadline are counted as overruns.
+*/
+TEST (ProcessorProfilerTest, ReportsPercentilesAndOverruns)
+{
+    ProcessorProfiler profiler;
+
+    EXPECT_EQ (profiler.getStatistics().numBlocks, 0);
+
+    const int64 deadline = millisecondsToTicks (10.0);
+
+    // 98 blocks of 1 ms, 2 blocks of 20 ms
+    for (int i = 0; i < 98; i++)
+        profiler.addBlock (millisecondsToTicks (1.0), deadline);
+
+    profiler.addBlock (millisecondsToTicks (20.0), deadline);
+    profiler.addBlock (millisecondsToTicks (20.0), deadline);
+
+    ProcessorProfiler::Statistics statistics = profiler.getStatistics();
+
+    EXPECT_EQ (statistics.numBlocks, 100);
+    EXPECT_EQ (statistics.numOverruns, 2);
+    EXPECT_NEAR (statistics.deadlineMs, 10.0, 0.01);
+    EXPECT_NEAR (statistics.meanMs, 1.38, 0.01);
+    EXPECT_NEAR (statistics.maxMs, 20.0, 0.01);
+    EXPECT_NEAR (statistics.p50Ms, 1.0, 0.1);
+    EXPECT_NEAR (statistics.p99Ms, 20.0, 0.01);
+
+    // the reset is applied before the next block
+    profiler.reset();
+    EXPECT_EQ (profiler.getStatistics().numBlocks, 0);
+
+    profiler.addBlock (millisecondsToTicks (2.0), deadline);
+
+    statistics = profiler.getStatistics();
+    EXPECT_EQ (statistics.numBlocks, 1);
+    EXPECT_EQ (statistics.numOverruns, 0);
+    EXPECT_NEAR (statistics.maxMs, 2.0, 0.01);
+}
+
+/*
+Allocations made through operator new are counted while a counter
+exists, when the allocation tracking build option is enabled.
+*/
+TEST (ProcessorProfilerTest, CountsAllocationsWhenTracked)
+{
+    int64 count;
+
+    {
+        ProcessorProfiler::AllocationCounter allocations;
+        std::unique_ptr<int> value (new int (1));
+        count = allocations.getCount();
+    }
+
+#if OE_TRACK_AUDIO_ALLOCATIONS
+    EXPECT_EQ (count, 1);
+#else
+    EXPECT_EQ (count, 0);
+#endif
+
+    ProcessorProfiler profiler;
+    profiler.addBlock (0, 0, 3);
+    profiler.addBlock (0, 0, 0);
+
+    EXPECT_EQ (profiler.getStatistics().numAllocations, 3);
+    EXPECT_EQ (profiler.getStatistics().numAllocatingBlocks, 1);
+}
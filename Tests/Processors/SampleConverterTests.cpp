@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+
+#include <Processors/RecordNode/SampleConverter.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+using Kernel = SampleConverter::Kernel;
+
+/** Fills numChannels x (offset + numSamples) samples, with some far outside the int16 range */
+AudioBuffer<float> makeInput (int numChannels, int numSamples, int seed)
+{
+    std::mt19937 rng (seed);
+    std::normal_distribution<float> distribution (0.0f, 5000.0f);
+
+    AudioBuffer<float> input (numChannels, numSamples);
+
+    for (int chan = 0; chan < numChannels; chan++)
+    {
+        for (int i = 0; i < numSamples; i++)
+            input.setSample (chan, i, distribution (rng));
+    }
+
+    return input;
+}
+
+std::string getKernelName (const testing::TestParamInfo<Kernel>& info)
+{
+    switch (info.param)
+    {
+        case Kernel::SSE2:
+            return "SSE2";
+        case Kernel::AVX2:
+            return "AVX2";
+        case Kernel::NEON:
+            return "NEON";
+        default:
+            return "Scalar";
+    }
+}
+
+class SampleConverterTest : public testing::TestWithParam<Kernel>
+{
+protected:
+    void SetUp() override
+    {
+        if (! SampleConverter::isKernelSupported (GetParam()))
+            GTEST_SKIP() << "Kernel not supported on this CPU";
+    }
+
+    /** Converts with the kernel under test and with the scalar kernel, and checks that the outputs match */
+    void compareWithScalar (const AudioBuffer<float>& input, int sourceOffset, const std::vector<float>& scales, int numSamples)
+    {
+        const int numChannels = input.getNumChannels();
+
+        std::vector<int16> output (size_t (numChannels * numSamples), 0x5555);
+        std::vector<int16> expected (size_t (numChannels * numSamples), 0x5555);
+
+        SampleConverter::convertToInt16Interleaved (GetParam(), input.getArrayOfReadPointers(), sourceOffset, scales.data(), numChannels, numSamples, output.data());
+        SampleConverter::convertToInt16InterleavedScalar (input.getArrayOfReadPointers(), sourceOffset, scales.data(), numChannels, numSamples, expected.data());
+
+        ASSERT_EQ (output, expected) << numChannels << " channels, " << numSamples << " samples, offset " << sourceOffset;
+    }
+};
+} // namespace
+
+/*
+Every kernel matches the scalar reference exactly, including channel and
+sample counts that don't fill whole 8 x 8 tiles.
+*/
+TEST_P (SampleConverterTest, MatchesScalarForOddSizes)
+{
+    for (int numChannels : { 1, 3, 7, 8, 9, 17, 64, 387 })
+    {
+        for (int numSamples : { 1, 5, 8, 13, 64, 101 })
+        {
+            const int sourceOffset = numSamples % 3;
+
+            AudioBuffer<float> input = makeInput (numChannels, sourceOffset + numSamples, numChannels * 1000 + numSamples);
+
+            std::vector<float> scales;
+
+            for (int chan = 0; chan < numChannels; chan++)
+                scales.push_back (chan % 2 == 0 ? 1.0f / 0.195f : 1.0f / 0.05f);
+
+            compareWithScalar (input, sourceOffset, scales, numSamples);
+        }
+    }
+}
+
+/*
+Samples beyond the int16 range saturate at +/- 32767, and values halfway
+between integers round the same way in every kernel.
+*/
+TEST_P (SampleConverterTest, SaturatesAndRounds)
+{
+    const std::vector<float> values = { 0.0f, 0.5f, 1.5f, 2.5f, -0.5f, -1.5f, 32766.5f, -32766.5f,
+                                        32767.0f, 32768.0f, -32768.0f, 1.0e6f, -1.0e6f, 1.0e30f, -1.0e30f };
+
+    const int numChannels = 11;
+    const int numSamples = int (values.size());
+
+    AudioBuffer<float> input (numChannels, numSamples);
+
+    for (int chan = 0; chan < numChannels; chan++)
+    {
+        for (int i = 0; i < numSamples; i++)
+            input.setSample (chan, i, values[size_t ((i + chan) % numSamples)]);
+    }
+
+    const std::vector<float> scales (size_t (numChannels), 1.0f);
+
+    compareWithScalar (input, 0, scales, numSamples);
+
+    std::vector<int16> output (size_t (numChannels * numSamples));
+
+    SampleConverter::convertToInt16Interleaved (GetParam(), input.getArrayOfReadPointers(), 0, scales.data(), numChannels, numSamples, output.data());
+
+    for (int chan = 0; chan < numChannels; chan++)
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            const float value = input.getSample (chan, i);
+            const int16 result = output[size_t (i * numChannels + chan)];
+
+            if (value >= 32767.0f)
+                EXPECT_EQ (result, 32767);
+            else if (value <= -32767.0f)
+                EXPECT_EQ (result, -32767);
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P (Kernels,
+                          SampleConverterTest,
+                          testing::Values (Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::NEON),
+                          getKernelName);
@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+
+#include <Processors/GenericProcessor/StreamBlockTable.h>
+
+/*
+Stream IDs map to consecutive indices, and IDs that are not
+in the table map to -1.
+*/
+TEST (StreamBlockTableTest, MapsStreamIdsToIndices)
+{
+    StreamBlockTable table;
+
+    EXPECT_EQ (table.size(), 0);
+    EXPECT_EQ (table.getIndex (0), -1);
+
+    table.setStreams ({ 12, 3, 250 });
+
+    EXPECT_EQ (table.size(), 3);
+    EXPECT_EQ (table.getIndex (12), 0);
+    EXPECT_EQ (table.getIndex (3), 1);
+    EXPECT_EQ (table.getIndex (250), 2);
+    EXPECT_EQ (table.getIndex (4), -1);
+    EXPECT_EQ (table.getIndex (251), -1);
+    EXPECT_EQ (table.getIndex (60000), -1);
+
+    EXPECT_EQ (table.getStreamId (0), 12);
+    EXPECT_EQ (table.getStreamId (2), 250);
+
+    table.clear();
+    EXPECT_EQ (table.size(), 0);
+    EXPECT_EQ (table.getIndex (12), -1);
+}
+
+/*
+Each field lives in its own cache-line aligned array, and values
+are cleared whenever the streams are set.
+*/
+TEST (StreamBlockTableTest, StoresValuesInAlignedArrays)
+{
+    StreamBlockTable table;
+    table.setStreams ({ 1, 2 });
+
+    EXPECT_EQ (reinterpret_cast<uintptr_t> (table.startSamples) % 64, 0u);
+    EXPECT_EQ (reinterpret_cast<uintptr_t> (table.startTimestamps) % 64, 0u);
+    EXPECT_EQ (reinterpret_cast<uintptr_t> (table.numSamplesInBlock) % 64, 0u);
+    EXPECT_EQ (reinterpret_cast<uintptr_t> (table.syncStreamIds) % 64, 0u);
+    EXPECT_EQ (reinterpret_cast<uintptr_t> (table.processStartTimes) % 64, 0u);
+
+    table.set (1, 3000, 0.1, 512, 1, 42);
+
+    EXPECT_EQ (table.startSamples[1], 3000);
+    EXPECT_DOUBLE_EQ (table.startTimestamps[1], 0.1);
+    EXPECT_EQ (table.numSamplesInBlock[1], 512u);
+    EXPECT_EQ (table.syncStreamIds[1], 1);
+    EXPECT_EQ (table.processStartTimes[1], 42);
+
+    EXPECT_EQ (table.startSamples[0], 0);
+    EXPECT_EQ (table.numSamplesInBlock[0], 0u);
+
+    table.setStreams ({ 2, 1 });
+    EXPECT_EQ (table.startSamples[1], 0);
+    EXPECT_EQ (table.getIndex (1), 1);
+}
@@ -0,0 +1,307 @@
+#include "gtest/gtest.h"
+
+#include <Processors/Synchronizer/Synchronizer.h>
+
+#include <random>
+
+namespace
+{
+/** The simulated computer time at which sync events arrive */
+int64 currentTimeMillis = 0;
+
+int64 getCurrentTimeMillis()
+{
+    return currentTimeMillis;
+}
+
+/** Adds a 100 ms sync pulse every second, from second firstPulse to lastPulse,
+    each arriving at the computer time of the pulse; sampleOffset is added to
+    the sample numbers of the pulses */
+void addPulses (Synchronizer& synchronizer, int streamHandle, double sampleRate, int firstPulse, int lastPulse, int64 sampleOffset = 0)
+{
+    for (int pulse = firstPulse; pulse <= lastPulse; pulse++)
+    {
+        const int64 onSample = int64 (pulse * sampleRate) + sampleOffset;
+
+        currentTimeMillis = int64 (pulse) * 1000;
+        synchronizer.addEvent (streamHandle, 0, onSample, true);
+
+        currentTimeMillis += 100;
+        synchronizer.addEvent (streamHandle, 0, onSample + int64 (0.1 * sampleRate), false);
+    }
+}
+} // namespace
+
+/*
+The sliding-window fit matches a least-squares fit of the pairs
+in the window, computed from scratch, as pairs enter and leave it.
+*/
+TEST (ClockFitTest, MatchesDirectFitOverWindow)
+{
+    const int windowSize = 10;
+    const double sampleRate = 30000.0;
+
+    ClockFit fit (windowSize);
+
+    std::mt19937 rng (1);
+    std::normal_distribution<double> jitter (0.0, 1.0e-4);
+
+    std::vector<std::pair<int64, double>> pairs;
+
+    for (int pulse = 0; pulse < 100; pulse++)
+    {
+        // a clock that drifts slowly, with jitter on each pulse
+        const double time = 3600.0 + pulse * 1.5;
+        const int64 sampleNumber = int64 (time * sampleRate * (1.0 + 1.0e-5 * pulse / 100.0));
+        const double timestamp = time + jitter (rng);
+
+        fit.add (sampleNumber, timestamp);
+        pairs.push_back ({ sampleNumber, timestamp });
+
+        const int n = jmin (int (pairs.size()), windowSize);
+        EXPECT_EQ (fit.size(), n);
+
+        if (n < 2)
+            continue;
+
+        double meanX = 0.0, meanY = 0.0;
+
+        for (size_t i = pairs.size() - n; i < pairs.size(); i++)
+        {
+            meanX += double (pairs[i].first - pairs[0].first) / n;
+            meanY += pairs[i].second / n;
+        }
+
+        double sxx = 0.0, sxy = 0.0;
+
+        for (size_t i = pairs.size() - n; i < pairs.size(); i++)
+        {
+            const double dx = double (pairs[i].first - pairs[0].first) - meanX;
+            sxx += dx * dx;
+            sxy += dx * (pairs[i].second - meanY);
+        }
+
+        const double slope = sxy / sxx;
+
+        ASSERT_NEAR (fit.getSlope() * sampleRate, slope * sampleRate, 1.0e-9) << "pulse " << pulse;
+        ASSERT_NEAR (fit.getTimestamp (sampleNumber), meanY + slope * (double (sampleNumber - pairs[0].first) - meanX), 1.0e-7);
+        ASSERT_NEAR (fit.getTimeSpan(), pairs.back().second - pairs[pairs.size() - n].second, 1.0e-9);
+    }
+
+    // the residual reflects the jitter
+    EXPECT_GT (fit.getResidualRms(), 1.0e-5);
+    EXPECT_LT (fit.getResidualRms(), 1.0e-3);
+
+    fit.clear();
+    EXPECT_EQ (fit.size(), 0);
+    EXPECT_EQ (fit.getTimeSpan(), 0.0);
+}
+
+/*
+Stream handles are assigned in the order streams are added, and the first
+stream becomes the main stream, which is synchronized to its own clock.
+*/
+TEST (SynchronizerTest, ResolvesStreamHandles)
+{
+    Synchronizer synchronizer;
+
+    synchronizer.prepareForUpdate();
+    EXPECT_EQ (synchronizer.addDataStream ("main", 30000.0f), 0);
+    EXPECT_EQ (synchronizer.addDataStream ("second", 20000.0f), 1);
+    synchronizer.finishedUpdate();
+
+    EXPECT_EQ (synchronizer.getStreamHandle ("main"), 0);
+    EXPECT_EQ (synchronizer.getStreamHandle ("second"), 1);
+    EXPECT_EQ (synchronizer.getStreamHandle ("missing"), -1);
+    EXPECT_EQ (synchronizer.getMainStreamHandle(), 0);
+
+    EXPECT_TRUE (synchronizer.isStreamSynced (0));
+    EXPECT_FALSE (synchronizer.isStreamSynced (1));
+    EXPECT_FALSE (synchronizer.isStreamSynced (-1));
+
+    EXPECT_DOUBLE_EQ (synchronizer.convertSampleNumberToTimestamp (0, 45000), 1.5);
+    EXPECT_DOUBLE_EQ (synchronizer.convertSampleNumberToTimestamp ("main", 45000), 1.5);
+    EXPECT_EQ (synchronizer.convertTimestampToSampleNumber (0, 1.5), 45000);
+
+    EXPECT_EQ (synchronizer.convertSampleNumberToTimestamp (1, 45000), -1.0);
+    EXPECT_EQ (synchronizer.convertSampleNumberToTimestamp (5, 45000), -1.0);
+
+    synchronizer.setMainDataStream ("second");
+    EXPECT_EQ (synchronizer.getMainStreamHandle(), 1);
+    EXPECT_TRUE (synchronizer.isStreamSynced (1));
+}
+
+/*
+Sync events added from the audio thread are matched when the synchronizer
+updates, and the clock of the second stream is published once it has been
+estimated.
+*/
+TEST (SynchronizerTest, SynchronizesStreamWithDifferentClock)
+{
+    const double mainSampleRate = 30000.0;
+    const double secondSampleRate = 30030.0; // runs 0.1% fast
+
+    Synchronizer synchronizer;
+    synchronizer.setTimeSource (&getCurrentTimeMillis);
+
+    synchronizer.prepareForUpdate();
+    const int mainStream = synchronizer.addDataStream ("main", float (mainSampleRate));
+    const int secondStream = synchronizer.addDataStream ("second", 30000.0f);
+    synchronizer.finishedUpdate();
+
+    addPulses (synchronizer, mainStream, mainSampleRate, 1, 6);
+    addPulses (synchronizer, secondStream, secondSampleRate, 1, 6);
+
+    synchronizer.update();
+
+    EXPECT_FALSE (synchronizer.isStreamSynced (secondStream));
+
+    addPulses (synchronizer, mainStream, mainSampleRate, 7, 12);
+    addPulses (synchronizer, secondStream, secondSampleRate, 7, 12);
+
+    synchronizer.update();
+
+    ASSERT_TRUE (synchronizer.isStreamSynced (secondStream));
+
+    EXPECT_NEAR (synchronizer.convertSampleNumberToTimestamp (secondStream, int64 (10 * secondSampleRate)), 10.0, 1.0e-3);
+    EXPECT_NEAR (double (synchronizer.convertTimestampToSampleNumber (secondStream, 10.0)), 10 * secondSampleRate, 1.0);
+
+    // the clock model is fitted to both matching pulses
+    const SyncClock clock = synchronizer.getClock (secondStream);
+    EXPECT_NEAR (clock.sampleRate, secondSampleRate, 1.0e-3);
+    EXPECT_GT (clock.version, 0u);
+
+    const SyncAccuracy accuracy = synchronizer.getAccuracyStatistics ("second");
+    EXPECT_EQ (accuracy.numPulses, 2);
+    EXPECT_NEAR (accuracy.latestErrorMs, 0.0, 1.0e-3);
+    EXPECT_NEAR (accuracy.rmsErrorMs, 0.0, 1.0e-3);
+}
+
+namespace
+{
+const double mainSampleRate = 30000.0;
+const double secondSampleRate = 30030.0; // runs 0.1% fast
+
+/** Adds one pulse to the main and second stream, then updates the synchronizer */
+void addPulse (Synchronizer& synchronizer, int pulse, int64 secondSampleOffset = 0)
+{
+    addPulses (synchronizer, 0, mainSampleRate, pulse, pulse);
+    addPulses (synchronizer, 1, secondSampleRate, pulse, pulse, secondSampleOffset);
+
+    synchronizer.update();
+}
+} // namespace
+
+/*
+A single pulse that is far from the fitted clock is left out of the
+fit, and the clock model stays the same until the next good pulse.
+*/
+TEST (SynchronizerTest, RejectsOutlierPulses)
+{
+    Synchronizer synchronizer;
+    synchronizer.setTimeSource (&getCurrentTimeMillis);
+
+    synchronizer.prepareForUpdate();
+    synchronizer.addDataStream ("main", float (mainSampleRate));
+    const int secondStream = synchronizer.addDataStream ("second", 30000.0f);
+    synchronizer.finishedUpdate();
+
+    // pulses are matched once four in a row agree, from the fourth pulse on
+    for (int pulse = 1; pulse <= 8; pulse++)
+        addPulse (synchronizer, pulse);
+
+    ASSERT_TRUE (synchronizer.isStreamSynced (secondStream));
+
+    const SyncClock clock = synchronizer.getClock (secondStream);
+
+    // 20 ms late
+    addPulse (synchronizer, 9, int64 (0.02 * secondSampleRate));
+
+    EXPECT_EQ (synchronizer.getClock (secondStream).version, clock.version);
+    EXPECT_NEAR (synchronizer.convertSampleNumberToTimestamp (secondStream, int64 (9 * secondSampleRate)), 9.0, 1.0e-3);
+
+    addPulse (synchronizer, 10);
+
+    EXPECT_GT (synchronizer.getClock (secondStream).version, clock.version);
+
+    const SyncAccuracy accuracy = synchronizer.getAccuracyStatistics ("second");
+    EXPECT_EQ (accuracy.numPulses, 6);
+    EXPECT_NEAR (accuracy.rmsErrorMs, 0.0, 1.0e-3);
+    EXPECT_NEAR (synchronizer.convertSampleNumberToTimestamp (secondStream, int64 (10 * secondSampleRate)), 10.0, 1.0e-3);
+}
+
+namespace
+{
+/** Syncs the second stream, makes its sample numbers jump, and checks that
+    the fit restarts on the new sample numbers */
+void checkFitRestartsAfterJump (int64 jump)
+{
+    Synchronizer synchronizer;
+    synchronizer.setTimeSource (&getCurrentTimeMillis);
+
+    synchronizer.prepareForUpdate();
+    synchronizer.addDataStream ("main", float (mainSampleRate));
+    const int secondStream = synchronizer.addDataStream ("second", 30000.0f);
+    synchronizer.finishedUpdate();
+
+    for (int pulse = 1; pulse <= 8; pulse++)
+        addPulse (synchronizer, pulse);
+
+    ASSERT_TRUE (synchronizer.isStreamSynced (secondStream));
+
+    const uint32 version = synchronizer.getClock (secondStream).version;
+
+    // The interval between the last pulse before the jump and the first one
+    // after it differs from the main stream's by the size of the jump, so that
+    // pulse never matches. A pulse is only matched along with the three before
+    // it, so the next three aren't matched either: pulse 13 is the first one
+    // compared with the fitted clock.
+    for (int pulse = 9; pulse <= 12; pulse++)
+        addPulse (synchronizer, pulse, jump);
+
+    EXPECT_EQ (synchronizer.getClock (secondStream).version, version);
+    EXPECT_EQ (synchronizer.getAccuracyStatistics ("second").numPulses, 5);
+
+    // the first two matched pulses are rejected as outliers
+    addPulse (synchronizer, 13, jump);
+    addPulse (synchronizer, 14, jump);
+
+    EXPECT_EQ (synchronizer.getClock (secondStream).version, version);
+    EXPECT_EQ (synchronizer.getAccuracyStatistics ("second").numPulses, 5);
+
+    // the third restarts the fit, which needs more than a second of pulses
+    addPulse (synchronizer, 15, jump);
+    addPulse (synchronizer, 16, jump);
+
+    EXPECT_EQ (synchronizer.getClock (secondStream).version, version);
+    EXPECT_EQ (synchronizer.getAccuracyStatistics ("second").numPulses, 2);
+
+    addPulse (synchronizer, 17, jump);
+
+    EXPECT_GT (synchronizer.getClock (secondStream).version, version);
+    EXPECT_TRUE (synchronizer.isStreamSynced (secondStream));
+
+    EXPECT_EQ (synchronizer.getAccuracyStatistics ("second").numPulses, 3);
+    EXPECT_NEAR (synchronizer.convertSampleNumberToTimestamp (secondStream, int64 (20 * secondSampleRate) + jump), 20.0, 1.0e-3);
+    EXPECT_NEAR (synchronizer.getClock (secondStream).sampleRate, secondSampleRate, 1.0e-2);
+}
+} // namespace
+
+/*
+When the clock of a stream jumps forward by several seconds (for example
+after its device restarted), consecutive outliers restart the fit, and
+the new clock model follows the stream's new sample numbers.
+*/
+TEST (SynchronizerTest, RestartsFitAfterForwardJump)
+{
+    checkFitRestartsAfterJump (int64 (5.0 * secondSampleRate));
+}
+
+/*
+When the sample numbers of a stream start again from 0 (half a second
+before its next pulse), the fit restarts in the same way.
+*/
+TEST (SynchronizerTest, RestartsFitAfterReset)
+{
+    checkFitRestartsAfterJump (-int64 (8.5 * secondSampleRate));
+}
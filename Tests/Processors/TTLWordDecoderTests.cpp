@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+
+#include <Processors/Events/TTLWordDecoder.h>
+
+#include <vector>
+
+namespace
+{
+using Kernel = TTLWordDecoder::Kernel;
+
+std::string getKernelName (const testing::TestParamInfo<Kernel>& info)
+{
+    switch (info.param)
+    {
+        case Kernel::SSE2:
+            return "SSE2";
+        case Kernel::AVX2:
+            return "AVX2";
+        case Kernel::NEON:
+            return "NEON";
+        default:
+            return "Scalar";
+    }
+}
+
+class TTLWordDecoderTest : public testing::TestWithParam<Kernel>
+{
+protected:
+    void SetUp() override
+    {
+        if (! TTLWordDecoder::isKernelSupported (GetParam()))
+            GTEST_SKIP() << "Kernel not supported on this CPU";
+    }
+
+    /** Checks the kernel under test against the scalar search for every start sample */
+    void compareWithScalar (const std::vector<uint64>& words, uint64 previousWord)
+    {
+        const int numSamples = int (words.size());
+
+        for (int start = 0; start <= numSamples; start++)
+        {
+            ASSERT_EQ (TTLWordDecoder::findNextChange (GetParam(), words.data(), start, numSamples, previousWord),
+                       TTLWordDecoder::findNextChangeScalar (words.data(), start, numSamples, previousWord))
+                << numSamples << " samples, starting at " << start;
+        }
+    }
+};
+} // namespace
+
+/*
+A single changed word is found at any position, for block lengths that
+aren't multiples of the vector width, including words that only differ
+in their upper or lower 32 bits.
+*/
+TEST_P (TTLWordDecoderTest, FindsChangeAtAnyPosition)
+{
+    const uint64 previousWord = 0x00000000FFFFFFFFull;
+
+    const uint64 changedWords[] = { 0x00000001FFFFFFFFull, // upper half only
+                                    0x00000000FFFFFFFEull, // lower half only
+                                    0x8000000000000000ull,
+                                    ~uint64 (0) };
+
+    for (int numSamples : { 1, 2, 3, 5, 7, 8, 9, 15, 17, 31, 33 })
+    {
+        std::vector<uint64> words (size_t (numSamples), previousWord);
+
+        compareWithScalar (words, previousWord);
+        EXPECT_EQ (TTLWordDecoder::findNextChange (GetParam(), words.data(), 0, numSamples, previousWord), numSamples);
+
+        for (uint64 changedWord : changedWords)
+        {
+            for (int changedSample = 0; changedSample < numSamples; changedSample++)
+            {
+                words[size_t (changedSample)] = changedWord;
+
+                compareWithScalar (words, previousWord);
+                ASSERT_EQ (TTLWordDecoder::findNextChange (GetParam(), words.data(), 0, numSamples, previousWord), changedSample);
+
+                words[size_t (changedSample)] = previousWord;
+            }
+        }
+    }
+}
+
+/*
+Words with every line high are compared like any other, and the first
+of several changes is returned.
+*/
+TEST_P (TTLWordDecoderTest, HandlesAllLinesHigh)
+{
+    const uint64 allHigh = ~uint64 (0);
+
+    std::vector<uint64> words (37, allHigh);
+
+    EXPECT_EQ (TTLWordDecoder::findNextChange (GetParam(), words.data(), 0, 37, allHigh), 37);
+    EXPECT_EQ (TTLWordDecoder::findNextChange (GetParam(), words.data(), 0, 37, 0), 0);
+
+    words[21] = allHigh >> 1;
+    words[29] = 0;
+
+    compareWithScalar (words, allHigh);
+    EXPECT_EQ (TTLWordDecoder::findNextChange (GetParam(), words.data(), 3, 37, allHigh), 21);
+    EXPECT_EQ (TTLWordDecoder::findNextChange (GetParam(), words.data(), 22, 37, allHigh), 29);
+}
+
+INSTANTIATE_TEST_SUITE_P (Kernels,
+                          TTLWordDecoderTest,
+                          testing::Values (Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::NEON),
+                          getKernelName);
@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+
+#include <Utils/WorkerPool.h>
+
+#include <atomic>
+#include <vector>
+
+/*
+Every task runs exactly once per batch, for any number of tasks,
+including more tasks than threads.
+*/
+TEST (WorkerPoolTest, RunsEveryTaskOnce)
+{
+    WorkerPool pool ("Test Pool", 4);
+
+    EXPECT_EQ (pool.getNumThreads(), 4);
+
+    for (int numTasks : { 0, 1, 3, 4, 5, 17 })
+    {
+        std::vector<std::atomic<int>> counts (static_cast<size_t> (numTasks));
+
+        auto task = [&] (int taskIndex)
+        { counts[size_t (taskIndex)]++; };
+
+        pool.parallelFor (numTasks, task);
+
+        for (auto& count : counts)
+            EXPECT_EQ (count.load(), 1);
+    }
+}
+
+/*
+Tasks are assigned to the same thread in every batch, and each
+thread writes its results before parallelFor returns.
+*/
+TEST (WorkerPoolTest, AssignsTasksStatically)
+{
+    WorkerPool pool ("Test Pool", 3);
+
+    const int numTasks = 6;
+    std::vector<Thread::ThreadID> firstThreads (numTasks);
+    std::vector<Thread::ThreadID> threads (numTasks);
+
+    auto recordFirstThreads = [&] (int taskIndex)
+    { firstThreads[size_t (taskIndex)] = Thread::getCurrentThreadId(); };
+
+    pool.parallelFor (numTasks, recordFirstThreads);
+
+    // task 0 runs on the calling thread
+    EXPECT_EQ (firstThreads[0], Thread::getCurrentThreadId());
+
+    for (int batch = 0; batch < 1000; batch++)
+    {
+        auto recordThreads = [&] (int taskIndex)
+        { threads[size_t (taskIndex)] = Thread::getCurrentThreadId(); };
+
+        pool.parallelFor (numTasks, recordThreads);
+
+        ASSERT_EQ (threads, firstThreads);
+    }
+}
+
+/*
+Batches complete whether the workers are spinning or have gone to sleep
+between them, and after the number of threads changes.
+*/
+TEST (WorkerPoolTest, WakesSleepingWorkers)
+{
+    WorkerPool pool ("Test Pool", 2);
+
+    std::atomic<int> total { 0 };
+
+    auto task = [&] (int taskIndex)
+    { total += taskIndex + 1; };
+
+    for (int batch = 0; batch < 5; batch++)
+    {
+        pool.parallelFor (2, task);
+        Thread::sleep (5);
+    }
+
+    EXPECT_EQ (total.load(), 15);
+
+    pool.setNumThreads (8);
+    EXPECT_EQ (pool.getNumThreads(), 8);
+
+    total = 0;
+
+    for (int batch = 0; batch < 100; batch++)
+        pool.parallelFor (8, task);
+
+    EXPECT_EQ (total.load(), 3600);
+
+    pool.setNumThreads (1);
+    EXPECT_EQ (pool.getNumThreads(), 1);
+
+    total = 0;
+    pool.parallelFor (8, task);
+
+    EXPECT_EQ (total.load(), 36);
+}
+
+/*
+Several pools with more threads in total than there are CPU cores
+(where threads sleep instead of spinning) still complete every batch.
+*/
+TEST (WorkerPoolTest, SharesCoresBetweenPools)
+{
+    const int numPools = SystemStats::getNumCpus() + 1;
+
+    OwnedArray<WorkerPool> pools;
+
+    for (int i = 0; i < numPools; i++)
+        pools.add (new WorkerPool ("Test Pool " + String (i), 2));
+
+    std::atomic<int> total { 0 };
+
+    auto task = [&] (int taskIndex)
+    { total += taskIndex + 1; };
+
+    for (int batch = 0; batch < 10; batch++)
+    {
+        for (auto pool : pools)
+            pool->parallelFor (4, task);
+    }
+
+    EXPECT_EQ (total.load(), 10 * numPools * 10);
+}